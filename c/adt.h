@@ -8,10 +8,17 @@
 #include "graph.h"
 #include "plot.h"
 
+#include "art/art.h"
 #include "avl/avl.h"
 #include "hashmaps/map.h"
+#include "heap/heap.h"
 #include "list/list.h"
+#include "pool/pool.h"
+#include "prbt/prbt.h"
+#include "queue/queue.h"
 #include "rbt/rbt.h"
+#include "skiplist/skiplist.h"
 #include "splay_tree/splay.h"
+#include "vector/vector.h"
 
 #endif /* __ADT_H_ */
\ No newline at end of file
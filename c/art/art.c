@@ -0,0 +1,696 @@
+/* Author: Marius Ingebrigtsen */
+/* Adaptive Radix Tree implementation (Leis, Kemper, Neumann; "The Adaptive Radix Tree", ICDE 2013).
+ * Keys include their NUL-terminator, so no key is a prefix of another and every key ends in a leaf.
+ * Leaves are tagged in lowest bit of child-pointer, so inner nodes need no separate leaf-children.
+ * Prefixes longer than MAXPREFIX store only their first bytes; remaining bytes are skipped optimistically
+ * by search, and read from a leaf below when insert must know them. */
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "art.h"
+
+#define MAXPREFIX	10		/* Prefix-bytes stored in inner node. */
+#define STACKSIZE	64		/* Initial depth of iterator-stack. */
+
+#define MIN(a, b) ( ((a) < (b)) ? (a) : (b) )
+
+#define IS_LEAF(node)	( ((uintptr_t)(node)) & 1 )
+#define AS_LEAF(node)	( (leaf_t*)(((uintptr_t)(node)) & ~(uintptr_t)1) )
+#define TAG_LEAF(leaf)	( (node_t*)(((uintptr_t)(leaf)) | 1) )
+
+typedef enum {
+	NODE4, NODE16, NODE48, NODE256
+} type_t;
+
+typedef struct leaf {
+	void			*item;
+	unsigned char	*key;
+	uint32_t		len;				/* Length of key with NUL-terminator. */
+} leaf_t;
+
+/* Header of every inner node. */
+typedef struct node {
+	uint8_t			type;
+	uint16_t		num;				/* Number of children. */
+	uint32_t		prefixlen;			/* Length of compressed path, of which first MAXPREFIX bytes are stored. */
+	unsigned char	prefix[MAXPREFIX];
+} node_t;
+
+/* Keys of Node4 and Node16 are sorted, and child 'i' belongs to 'keys[i]'. */
+typedef struct node4 {
+	node_t			node;
+	unsigned char	keys[4];
+	node_t			*children[4];
+} node4_t;
+
+typedef struct node16 {
+	node_t			node;
+	unsigned char	keys[16];
+	node_t			*children[16];
+} node16_t;
+
+/* 'index[byte]' is 1 + slot of child for byte, or 0 if no child. */
+typedef struct node48 {
+	node_t			node;
+	unsigned char	index[256];
+	node_t			*children[48];
+} node48_t;
+
+typedef struct node256 {
+	node_t			node;
+	node_t			*children[256];
+} node256_t;
+
+struct art {
+	node_t	*root;
+	int		size;
+};
+
+
+/* ART Create: */
+art_t *art_create(void) {
+	art_t *art;
+
+	art = calloc(1, sizeof(art_t));
+	if(art == NULL) {
+		fatal_error("Out of memory.");
+	}
+	return art;
+}
+
+/* ART Destroy: */
+/* Recursion is bounded by length of longest key. */
+static void node_destroy(node_t *node, freefunc_t freekey, freefunc_t freeitem) {
+	leaf_t *leaf;
+
+	if(node == NULL) {
+		return;
+	}
+	if(IS_LEAF(node)) {
+		leaf = AS_LEAF(node);
+
+		if(freekey != NULL) {
+			freekey(leaf->key);
+		}
+		if(freeitem != NULL) {
+			freeitem(leaf->item);
+		}
+		free(leaf);
+		return;
+	}
+
+	switch(node->type) {
+		case NODE4:
+			for(int i = 0; i < node->num; i++) {
+				node_destroy(((node4_t*)node)->children[i], freekey, freeitem);
+			}
+			break;
+		case NODE16:
+			for(int i = 0; i < node->num; i++) {
+				node_destroy(((node16_t*)node)->children[i], freekey, freeitem);
+			}
+			break;
+		case NODE48:
+			for(int i = 0; i < node->num; i++) {
+				node_destroy(((node48_t*)node)->children[i], freekey, freeitem);
+			}
+			break;
+		case NODE256:
+			for(int i = 0; i < 256; i++) {
+				node_destroy(((node256_t*)node)->children[i], freekey, freeitem);
+			}
+			break;
+	}
+	free(node);
+}
+
+void art_destroy(art_t *art, freefunc_t freekey, freefunc_t freeitem) {
+	node_destroy(art->root, freekey, freeitem);
+	free(art);
+}
+
+/* ART Size: */
+int art_size(art_t *art) {
+	return art->size;
+}
+
+/* ART Search: */
+static inline int leaf_matches(leaf_t *leaf, unsigned char *key, uint32_t len) {
+	return (leaf->len == len) && (memcmp(leaf->key, key, len) == 0);
+}
+
+/* Return link to child for 'byte', or NULL if none. */
+static node_t **find_child(node_t *node, unsigned char byte) {
+	node4_t		*n4;
+	node16_t	*n16;
+	node48_t	*n48;
+	node256_t	*n256;
+	int			bits;
+
+	switch(node->type) {
+		case NODE4:
+			n4 = (node4_t*)node;
+			for(int i = 0; i < node->num; i++) {
+				if(n4->keys[i] == byte) {
+					return &n4->children[i];
+				}
+			}
+			return NULL;
+
+		case NODE16:
+			n16 = (node16_t*)node;
+#ifdef __SSE2__
+			/* Compare all 16 keys at once; mask off unused slots. */
+			bits = _mm_movemask_epi8( _mm_cmpeq_epi8(_mm_set1_epi8((char)byte), _mm_loadu_si128((__m128i*)n16->keys)) );
+			bits &= (1 << node->num) - 1;
+			if(bits != 0) {
+				return &n16->children[__builtin_ctz(bits)];
+			}
+#else
+			(void)bits;
+			for(int i = 0; i < node->num; i++) {
+				if(n16->keys[i] == byte) {
+					return &n16->children[i];
+				}
+			}
+#endif
+			return NULL;
+
+		case NODE48:
+			n48 = (node48_t*)node;
+			if(n48->index[byte] != 0) {
+				return &n48->children[n48->index[byte] - 1];
+			}
+			return NULL;
+
+		case NODE256:
+			n256 = (node256_t*)node;
+			if(n256->children[byte] != NULL) {
+				return &n256->children[byte];
+			}
+			return NULL;
+	}
+	return NULL;
+}
+
+void *art_search(art_t *art, char *key) {
+	node_t		*node, **child;
+	leaf_t		*leaf;
+	uint32_t	len, depth, stored;
+
+	len		= strlen(key) + 1;
+	depth	= 0;
+	node	= art->root;
+
+	while(node != NULL) {
+		if(IS_LEAF(node)) {
+			leaf = AS_LEAF(node);
+
+			if(leaf_matches(leaf, (unsigned char*)key, len)) {
+				return leaf->item;
+			}
+			return NULL;
+		}
+		if(node->prefixlen > 0) {
+			/* Bytes of prefix beyond those stored are verified at leaf. */
+			stored = MIN(node->prefixlen, MAXPREFIX);
+
+			if( (depth + node->prefixlen >= len) || (memcmp(node->prefix, key + depth, stored) != 0) ) {
+				return NULL;
+			}
+			depth += node->prefixlen;
+		}
+		child = find_child(node, key[depth]);
+		if(child == NULL) {
+			return NULL;
+		}
+		node = *child;
+		depth++;
+	}
+	return NULL;
+}
+
+/* ART Insert: */
+static leaf_t *leaf_create(char *key, uint32_t len, void *item) {
+	leaf_t *leaf;
+
+	leaf = malloc(sizeof(leaf_t));
+	if(leaf == NULL) {
+		fatal_error("Out of memory.");
+	}
+	leaf->item	= item;
+	leaf->key	= (unsigned char*)key;
+	leaf->len	= len;
+
+	return leaf;
+}
+
+static node_t *node_create(type_t type) {
+	node_t	*node;
+	size_t	size;
+
+	switch(type) {
+		case NODE4:		size = sizeof(node4_t);		break;
+		case NODE16:	size = sizeof(node16_t);	break;
+		case NODE48:	size = sizeof(node48_t);	break;
+		default:		size = sizeof(node256_t);	break;
+	}
+	node = calloc(1, size);
+	if(node == NULL) {
+		fatal_error("Out of memory.");
+	}
+	node->type = type;
+
+	return node;
+}
+
+/* Copy header of 'old' into new node of next size, which takes its place at 'ref'. */
+static node_t *node_grow(node_t *old, node_t **ref) {
+	node_t *new;
+
+	new = node_create(old->type + 1);
+	new->num		= old->num;
+	new->prefixlen	= old->prefixlen;
+	memcpy(new->prefix, old->prefix, MIN(old->prefixlen, MAXPREFIX));
+
+	*ref = new;
+
+	return new;
+}
+
+/* Insert 'child' at sorted position among 'num' keys. */
+static inline void sorted_insert(unsigned char *keys, node_t **children, int num, unsigned char byte, node_t *child) {
+	int i;
+
+	for(i = 0; (i < num) && (keys[i] < byte); i++);
+
+	memmove(&keys[i + 1], &keys[i], num - i);
+	memmove(&children[i + 1], &children[i], sizeof(node_t*) * (num - i));
+	keys[i]		= byte;
+	children[i]	= child;
+}
+
+/* Add 'child' for 'byte' to 'node' at 'ref', growing node into next size when full. */
+static void add_child(node_t *node, node_t **ref, unsigned char byte, node_t *child) {
+	node4_t		*n4;
+	node16_t	*n16;
+	node48_t	*n48;
+	node256_t	*n256;
+	node_t		*new;
+
+	switch(node->type) {
+		case NODE4:
+			n4 = (node4_t*)node;
+			if(node->num < 4) {
+				sorted_insert(n4->keys, n4->children, node->num, byte, child);
+				node->num++;
+				return;
+			}
+			new = node_grow(node, ref);
+			memcpy(((node16_t*)new)->keys, n4->keys, 4);
+			memcpy(((node16_t*)new)->children, n4->children, sizeof(node_t*) * 4);
+			break;
+
+		case NODE16:
+			n16 = (node16_t*)node;
+			if(node->num < 16) {
+				sorted_insert(n16->keys, n16->children, node->num, byte, child);
+				node->num++;
+				return;
+			}
+			new = node_grow(node, ref);
+			for(int i = 0; i < 16; i++) {
+				((node48_t*)new)->index[n16->keys[i]] = i + 1;
+			}
+			memcpy(((node48_t*)new)->children, n16->children, sizeof(node_t*) * 16);
+			break;
+
+		case NODE48:
+			n48 = (node48_t*)node;
+			if(node->num < 48) {
+				/* Nodes never shrink, so slots are filled in order. */
+				n48->children[node->num]	= child;
+				n48->index[byte]			= node->num + 1;
+				node->num++;
+				return;
+			}
+			new = node_grow(node, ref);
+			for(int i = 0; i < 256; i++) {
+				if(n48->index[i] != 0) {
+					((node256_t*)new)->children[i] = n48->children[n48->index[i] - 1];
+				}
+			}
+			break;
+
+		default:
+			n256 = (node256_t*)node;
+			n256->children[byte] = child;
+			node->num++;
+			return;
+	}
+	free(node);
+	add_child(new, ref, byte, child);
+}
+
+/* Return leaf with smallest key below 'node'. */
+static leaf_t *node_minimum(node_t *node) {
+	int i;
+
+	while(!IS_LEAF(node)) {
+		switch(node->type) {
+			case NODE4:
+				node = ((node4_t*)node)->children[0];
+				break;
+			case NODE16:
+				node = ((node16_t*)node)->children[0];
+				break;
+			case NODE48:
+				for(i = 0; ((node48_t*)node)->index[i] == 0; i++);
+				node = ((node48_t*)node)->children[((node48_t*)node)->index[i] - 1];
+				break;
+			case NODE256:
+				for(i = 0; ((node256_t*)node)->children[i] == NULL; i++);
+				node = ((node256_t*)node)->children[i];
+				break;
+		}
+	}
+	return AS_LEAF(node);
+}
+
+/* Return number of bytes of prefix of 'node' equal to key from 'depth'.
+ * Bytes beyond those stored are read from smallest leaf below node; all leaves below share prefix. */
+static uint32_t prefix_mismatch(node_t *node, unsigned char *key, uint32_t len, uint32_t depth) {
+	leaf_t		*leaf;
+	uint32_t	max, i;
+
+	max = MIN( MIN(node->prefixlen, MAXPREFIX), len - depth );
+
+	for(i = 0; i < max; i++) {
+		if(node->prefix[i] != key[depth + i]) {
+			return i;
+		}
+	}
+	if(node->prefixlen > MAXPREFIX) {
+		leaf	= node_minimum(node);
+		max		= MIN(node->prefixlen, MIN(leaf->len, len) - depth);
+
+		for(; i < max; i++) {
+			if(leaf->key[depth + i] != key[depth + i]) {
+				return i;
+			}
+		}
+	}
+	return i;
+}
+
+/* Descend iteratively, following link to child by one byte of key per level.
+ * A new leaf either fills empty child-slot, splits an existing leaf with common bytes as prefix of new Node4,
+ * or splits compressed prefix of inner node where key departs from it. */
+int art_insert(art_t *art, char *key, void *item) {
+	node_t			**ref, *node, *new, **child;
+	leaf_t			*leaf, *min;
+	unsigned char	*bytes;
+	uint32_t		len, depth, common, mismatch;
+
+	bytes	= (unsigned char*)key;
+	len		= strlen(key) + 1;
+	depth	= 0;
+	ref		= &art->root;
+
+	for(;;) {
+		node = *ref;
+
+		if(node == NULL) {
+			*ref = TAG_LEAF(leaf_create(key, len, item));
+			break;
+		}
+
+		if(IS_LEAF(node)) {
+			leaf = AS_LEAF(node);
+
+			if(leaf_matches(leaf, bytes, len)) {
+				leaf->item = item;
+				return 0;
+			}
+			/* Keys differ before either terminator, as neither is a prefix of other. */
+			for(common = 0; leaf->key[depth + common] == bytes[depth + common]; common++);
+
+			new = node_create(NODE4);
+			new->prefixlen = common;
+			memcpy(new->prefix, bytes + depth, MIN(common, MAXPREFIX));
+
+			add_child(new, &new, leaf->key[depth + common], node);
+			add_child(new, &new, bytes[depth + common], TAG_LEAF(leaf_create(key, len, item)));
+			*ref = new;
+			break;
+		}
+
+		if(node->prefixlen > 0) {
+			mismatch = prefix_mismatch(node, bytes, len, depth);
+
+			if(mismatch < node->prefixlen) {
+				new = node_create(NODE4);
+				new->prefixlen = mismatch;
+				memcpy(new->prefix, node->prefix, MIN(mismatch, MAXPREFIX));
+
+				/* Old node keeps part of prefix after mismatching byte. */
+				if(node->prefixlen <= MAXPREFIX) {
+					add_child(new, &new, node->prefix[mismatch], node);
+					node->prefixlen -= mismatch + 1;
+					memmove(node->prefix, node->prefix + mismatch + 1, MIN(node->prefixlen, MAXPREFIX));
+				} else {
+					min = node_minimum(node);
+					add_child(new, &new, min->key[depth + mismatch], node);
+					node->prefixlen -= mismatch + 1;
+					memcpy(node->prefix, min->key + depth + mismatch + 1, MIN(node->prefixlen, MAXPREFIX));
+				}
+				add_child(new, &new, bytes[depth + mismatch], TAG_LEAF(leaf_create(key, len, item)));
+				*ref = new;
+				break;
+			}
+			depth += node->prefixlen;
+		}
+
+		child = find_child(node, bytes[depth]);
+		if(child == NULL) {
+			add_child(node, ref, bytes[depth], TAG_LEAF(leaf_create(key, len, item)));
+			break;
+		}
+		ref = child;
+		depth++;
+	}
+	art->size++;
+
+	return 1;
+}
+
+
+/* ART Iteration */
+/* Inner node on path with position of next child to visit; for Node48 and Node256 position is next byte. */
+typedef struct frame {
+	node_t	*node;
+	int		pos;
+} frame_t;
+
+/* Iterator Structure: */
+struct art_iterator {
+	node_t	*subtree;			/* Root of every key with prefix; NULL if none. */
+	frame_t	*stack;
+	int		top, capacity;
+	leaf_t	*current, *pending;		/* Leaf last returned, and leaf to return next. */
+};
+
+/* Return root of subtree holding every key starting with 'prefix', or NULL if there is none.
+ * Compressed prefixes are compared against a leaf below, as their bytes may not be stored in node. */
+static node_t *prefix_subtree(art_t *art, unsigned char *prefix, uint32_t len) {
+	node_t		*node, **child;
+	leaf_t		*leaf;
+	uint32_t	depth, max;
+
+	node	= art->root;
+	depth	= 0;
+
+	while(node != NULL) {
+		if(IS_LEAF(node)) {
+			leaf = AS_LEAF(node);
+
+			if( (leaf->len > len) && (memcmp(leaf->key, prefix, len) == 0) ) {
+				return node;
+			}
+			return NULL;
+		}
+		if(depth == len) {
+			return node;
+		}
+		if(node->prefixlen > 0) {
+			leaf	= node_minimum(node);
+			max		= MIN(node->prefixlen, len - depth);
+
+			if(memcmp(leaf->key + depth, prefix + depth, max) != 0) {
+				return NULL;
+			}
+			if(depth + node->prefixlen >= len) {
+				return node;
+			}
+			depth += node->prefixlen;
+		}
+		child = find_child(node, prefix[depth]);
+		if(child == NULL) {
+			return NULL;
+		}
+		node = *child;
+		depth++;
+	}
+	return NULL;
+}
+
+static void iterator_push(art_iterator_t *iterator, node_t *node) {
+	if(iterator->top == iterator->capacity) {
+		iterator->capacity *= 2;
+		iterator->stack = realloc(iterator->stack, sizeof(frame_t) * iterator->capacity);
+		if(iterator->stack == NULL) {
+			fatal_error("Out of memory.");
+		}
+	}
+	iterator->stack[iterator->top].node	= node;
+	iterator->stack[iterator->top].pos	= 0;
+	iterator->top++;
+}
+
+/* Return next child of inner node in frame in ascending order of bytes, and advance frame; NULL when exhausted. */
+static node_t *frame_next(frame_t *frame) {
+	node_t		*node;
+	node48_t	*n48;
+	node256_t	*n256;
+
+	node = frame->node;
+
+	switch(node->type) {
+		case NODE4:
+			if(frame->pos < node->num) {
+				return ((node4_t*)node)->children[frame->pos++];
+			}
+			return NULL;
+
+		case NODE16:
+			if(frame->pos < node->num) {
+				return ((node16_t*)node)->children[frame->pos++];
+			}
+			return NULL;
+
+		case NODE48:
+			n48 = (node48_t*)node;
+			for(; frame->pos < 256; frame->pos++) {
+				if(n48->index[frame->pos] != 0) {
+					return n48->children[n48->index[frame->pos++] - 1];
+				}
+			}
+			return NULL;
+
+		case NODE256:
+			n256 = (node256_t*)node;
+			for(; frame->pos < 256; frame->pos++) {
+				if(n256->children[frame->pos] != NULL) {
+					return n256->children[frame->pos++];
+				}
+			}
+			return NULL;
+	}
+	return NULL;
+}
+
+/* Return next leaf in order, or NULL when exhausted; descends into next child of deepest frame, popping exhausted frames. */
+static leaf_t *iterator_advance(art_iterator_t *iterator) {
+	frame_t	*frame;
+	node_t	*child;
+
+	while(iterator->top > 0) {
+		frame = &iterator->stack[iterator->top - 1];
+
+		if(IS_LEAF(frame->node)) {
+			iterator->top--;
+			return AS_LEAF(frame->node);
+		}
+		child = frame_next(frame);
+
+		if(child == NULL) {
+			iterator->top--;
+		} else {
+			iterator_push(iterator, child);
+		}
+	}
+	return NULL;
+}
+
+/* ART Create Iterator: */
+art_iterator_t *art_createiterator(art_t *art, char *prefix) {
+	art_iterator_t *iterator;
+
+	iterator = malloc(sizeof(art_iterator_t));
+	if(iterator == NULL) {
+		fatal_error("Out of memory.");
+	}
+	iterator->capacity	= STACKSIZE;
+	iterator->stack		= malloc(sizeof(frame_t) * iterator->capacity);
+	if(iterator->stack == NULL) {
+		fatal_error("Out of memory.");
+	}
+
+	if(prefix == NULL) {
+		prefix = "";
+	}
+	iterator->subtree = prefix_subtree(art, (unsigned char*)prefix, strlen(prefix));
+
+	art_resetiterator(iterator);
+
+	return iterator;
+}
+
+/* ART Destroy Iterator: */
+void art_destroyiterator(art_iterator_t *iterator) {
+	free(iterator->stack);
+	free(iterator);
+}
+
+/* ART Has Next: */
+int art_hasnext(art_iterator_t *iterator) {
+	if(iterator->pending == NULL) {
+		return 0;
+	}
+	return 1;
+}
+
+/* ART Next: */
+void *art_next(art_iterator_t *iterator) {
+	if(iterator->pending == NULL) {
+		return NULL;
+	}
+	iterator->current = iterator->pending;
+	iterator->pending = iterator_advance(iterator);
+
+	return iterator->current->item;
+}
+
+/* ART Current Key: */
+char *art_currentkey(art_iterator_t *iterator) {
+	if(iterator->current == NULL) {
+		return NULL;
+	}
+	return (char*)iterator->current->key;
+}
+
+/* ART Reset Iterator: */
+void art_resetiterator(art_iterator_t *iterator) {
+	iterator->top		= 0;
+	iterator->current	= NULL;
+
+	if(iterator->subtree != NULL) {
+		iterator_push(iterator, iterator->subtree);
+	}
+	iterator->pending = iterator_advance(iterator);
+}
@@ -0,0 +1,62 @@
+/* Author: Marius Ingebrigtsen */
+#ifndef __ART_H_
+#define __ART_H_
+
+#include "../common.h"
+
+/* Adaptive Radix Tree Structure (Leis et al.).
+ * Ordered map keyed by NUL-terminated byte strings, e.g. words or paths.
+ * Inner nodes branch on one byte of key and grow between 4, 16, 48 and 256 children as needed,
+ * and chains of single-child nodes are compressed into a prefix stored in node below.
+ * A lookup reads each byte of key once and compares key in whole only at leaf,
+ * in stead of one string-comparison per level as in comparison-based trees.
+ * NOTE: Keys are referred to, not copied, and must not change while in tree. */
+typedef struct art art_t;
+
+
+/* Return new ART. */
+art_t *art_create(void);
+
+/* Destroy ART.
+ * If function pointer is not NULL, then keys and items is destroyed using given function. */
+void art_destroy(art_t *art, freefunc_t freekey, freefunc_t freeitem);
+
+/* Return number of items in ART. */
+int art_size(art_t *art);
+
+/* Insert item with key.
+ * If key is already in ART, then item will overwrite existing value.
+ * Return 1 if inserted, 0 if overwritten. */
+int art_insert(art_t *art, char *key, void *item);
+
+/* Search ART using key and return item with key.
+ * Return NULL if item not in ART. */
+void *art_search(art_t *art, char *key);
+
+
+/* Iteration: */
+typedef struct art_iterator art_iterator_t;
+
+/* Return iterator over items with key starting with 'prefix', in ascending byte-order of keys.
+ * Pass NULL or empty string to iterate over every item.
+ * Iterator is invalid after insertion into ART. */
+art_iterator_t *art_createiterator(art_t *art, char *prefix);
+
+/* Deallocates iterator. */
+void art_destroyiterator(art_iterator_t *iterator);
+
+/* Return 0 if iterator is exhausted, 1 otherwise. */
+int art_hasnext(art_iterator_t *iterator);
+
+/* Return next item in sequence of iteration, and iterate iterator.
+ * Return NULL if iterator exhausted. */
+void *art_next(art_iterator_t *iterator);
+
+/* Return key of item last returned by 'art_next()'.
+ * Return NULL if 'art_next()' is not called since creation or reset. */
+char *art_currentkey(art_iterator_t *iterator);
+
+/* Sets iterator to start of iteration. */
+void art_resetiterator(art_iterator_t *iterator);
+
+#endif
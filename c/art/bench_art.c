@@ -0,0 +1,232 @@
+/* Author: Marius Ingebrigtsen */
+#include <string.h>
+
+#include "../common.h"
+#include "../bench.h"
+#include "../rbt/rbt.h"
+#include "../hashmaps/map.h"
+#include "../hashmaps/lookup3.h"
+#include "./art.h"
+
+#define START	1024		/* 2^10 */
+#define PREFIX	4			/* Longest prefix scanned is one less, for terminator. */
+
+/* String-keyed maps compared; rbt and map compare keys with strcmp. */
+typedef enum {
+	ART, RBT, MAP
+} impl_t;
+
+/* State of one trial, passed to setup, trial and teardown by harness. 'elem' is number of words, or length of prefix. */
+typedef struct trial {
+	impl_t	impl;
+	void	*adt;
+	char	**words;
+	int		elem, num;
+	long	visited;
+} trial_t;
+
+
+/* Return array of every word in every file below 'rootdir', in order of files, and number of words in 'n'. */
+static char **corpus_create(char *rootdir, int *n) {
+	char	**files, **words, **tokens;
+	int		numfiles, numtokens, size;
+
+	files = find_files(rootdir, &numfiles);
+
+	*n		= 0;
+	size	= 1024;
+	words	= malloc(sizeof(char*) * size);
+	if(words == NULL) {
+		fatal_error("Out of memory.");
+	}
+
+	for(int i = 0; i < numfiles; i++) {
+		tokens = tokenize_file(files[i], &numtokens);
+
+		for(int j = 0; j < numtokens; j++) {
+			if(*n == size) {
+				size *= 2;
+				words = realloc(words, sizeof(char*) * size);
+				if(words == NULL) {
+					fatal_error("Out of memory.");
+				}
+			}
+			words[(*n)++] = tokens[j];
+		}
+		free(tokens);
+	}
+	find_files_destroy(files);
+
+	return words;
+}
+
+static void *impl_create(impl_t impl) {
+	switch(impl) {
+		case ART:	return art_create();
+		case RBT:	return rbt_create( (cmpfunc_t)strcmp );
+		default:	return map_create( (cmpfunc_t)strcmp, (hashfunc_t)lookup3 );
+	}
+}
+
+static void impl_destroy(impl_t impl, void *adt) {
+	switch(impl) {
+		case ART:	art_destroy(adt, NULL, NULL);	break;
+		case RBT:	rbt_destroy(adt, NULL, NULL);	break;
+		default:	map_destroy(adt, NULL, NULL);	break;
+	}
+}
+
+static void impl_insert(impl_t impl, void *adt, char *word) {
+	switch(impl) {
+		case ART:	art_insert(adt, word, word);	break;
+		case RBT:	rbt_insert(adt, word, word);	break;
+		default:	map_put(adt, word, word);		break;
+	}
+}
+
+static void *impl_search(impl_t impl, void *adt, char *word) {
+	switch(impl) {
+		case ART:	return art_search(adt, word);
+		case RBT:	return rbt_search(adt, word);
+		default:	return map_get(adt, word);
+	}
+}
+
+static void setup_empty(trial_t *trial) {
+	trial->adt = impl_create(trial->impl);
+}
+
+static void setup_filled(trial_t *trial) {
+	setup_empty(trial);
+
+	for(int i = 0; i < trial->elem; i++) {
+		impl_insert(trial->impl, trial->adt, trial->words[i]);
+	}
+}
+
+/* Every word of corpus in ART, for prefix-scans. */
+static void setup_prefix(trial_t *trial) {
+	trial->adt = art_create();
+
+	for(int i = 0; i < trial->num; i++) {
+		art_insert(trial->adt, trial->words[i], trial->words[i]);
+	}
+	trial->visited = 0;
+}
+
+static void teardown(trial_t *trial) {
+	impl_destroy(trial->impl, trial->adt);
+}
+
+/* Insert first 'elem' words of corpus, in order of text, so frequent words are overwritten many times. */
+static void trial_insert(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		impl_insert(trial->impl, trial->adt, trial->words[i]);
+	}
+}
+
+/* Search for each of first 'elem' words of corpus, after inserting them; every search is a hit. */
+static void trial_search(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		if(impl_search(trial->impl, trial->adt, trial->words[i]) == NULL) {
+			fatal_error("Word; \'%s\', not found.", trial->words[i]);
+		}
+	}
+}
+
+/* Every word is used as prefix of 'elem' characters once, and all words with that prefix are scanned in order. */
+static void trial_prefix(trial_t *trial) {
+	art_iterator_t	*iterator;
+	char			prefix[PREFIX];
+
+	for(int i = 0; i < trial->num; i++) {
+		strncpy(prefix, trial->words[i], trial->elem);
+		prefix[trial->elem] = '\0';
+
+		iterator = art_createiterator(trial->adt, prefix);
+		while(art_next(iterator) != NULL) {
+			trial->visited++;
+		}
+		art_destroyiterator(iterator);
+	}
+}
+
+static void assert_corpus(char *bnch_file, impl_t impl, char **words, int num, int search) {
+	static const char	*names[] = { "ART", "RBT", "Map" };
+	bench_file_t		*file;
+	bench_stats_t		stats;
+	trial_t				trial;
+	char				*title, count[16];
+
+	snprintf(count, sizeof(count), "%d", num);
+	title	= concatenate_strings(5, names[impl], search ? " Search" : " Insert", " Benchmarks on ", count, " corpus words");
+	file	= bench_open(bnch_file, title);
+
+	trial.impl	= impl;
+	trial.words	= words;
+	trial.num	= num;
+
+	for(int elem = START; elem <= num; elem *= 2) {
+		trial.elem = elem;
+
+		bench_run(&stats, search ? (benchfunc_t)setup_filled : (benchfunc_t)setup_empty, search ? (benchfunc_t)trial_search : (benchfunc_t)trial_insert,
+				  (benchfunc_t)teardown, &trial, elem);
+		bench_write(file, elem, &stats);
+	}
+	bench_close(file);
+	free(title);
+}
+
+/* Only ART supports ordered prefix-scans; result is time per scan for each length of prefix.
+ * Number of words visited by scans of each length is printed. */
+static void assert_prefix(char *bnch_file, char **words, int num) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
+	char			*title, count[16];
+
+	snprintf(count, sizeof(count), "%d", num);
+	title	= concatenate_strings(3, "ART Prefix Scan Benchmarks on ", count, " corpus words; elements is length of prefix");
+	file	= bench_open(bnch_file, title);
+
+	trial.impl	= ART;
+	trial.words	= words;
+	trial.num	= num;
+
+	for(int len = 1; len < PREFIX; len++) {
+		trial.elem = len;
+
+		bench_run(&stats, (benchfunc_t)setup_prefix, (benchfunc_t)trial_prefix, (benchfunc_t)teardown, &trial, num);
+		bench_write(file, len, &stats);
+
+		printf("\tWords visited by scans of prefix-length \'%d\': %ld \n", len, trial.visited);
+	}
+	bench_close(file);
+	free(title);
+}
+
+int main(int argc, char **argv) {
+	char	**words;
+	int		num;
+
+	if(argc < 9) {
+		printf("Usage: %s <corpus-dir> <art-insert-file> <rbt-insert-file> <map-insert-file> <art-search-file> <rbt-search-file> <map-search-file> <prefix-file> \n", *argv);
+		return -1;
+	}
+	words = corpus_create(argv[1], &num);
+
+	for(impl_t impl = ART; impl <= MAP; impl++) {
+		assert_corpus(argv[2 + impl], impl, words, num, 0);
+	}
+	for(impl_t impl = ART; impl <= MAP; impl++) {
+		assert_corpus(argv[5 + impl], impl, words, num, 1);
+	}
+	assert_prefix(argv[8], words, num);
+
+	for(int i = 0; i < num; i++) {
+		free(words[i]);
+	}
+	free(words);
+
+	return 0;
+}
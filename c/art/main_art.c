@@ -0,0 +1,142 @@
+/* Author: Marius Ingebrigtsen */
+#include <string.h>
+
+#include "../common.h"
+#include "./art.h"
+
+/* Prefixes checked against scan of sorted keys; paths share long prefixes, which are compressed beyond bytes stored in node. */
+static char *prefixes[] = { "", "a", "co", "com", "comput", "algorithm", "x", "zz", "1", "q", "/", "/r", "/root/repo/c/", "/root/repo/c/art/", "/tmp/" };
+
+
+static int cmpstr(const void *a, const void *b) {
+	return strcmp(*(char**)a, *(char**)b);
+}
+
+/* Return array of every word in every file below 'rootdir', and number of words in 'n'. */
+static char **corpus_create(char *rootdir, int *n) {
+	char	**files, **words, **tokens;
+	int		numfiles, numtokens, size;
+
+	files = find_files(rootdir, &numfiles);
+
+	*n		= 0;
+	size	= 1024;
+	words	= malloc(sizeof(char*) * size);
+	if(words == NULL) {
+		fatal_error("Out of memory.");
+	}
+
+	for(int i = 0; i < numfiles; i++) {
+		tokens = tokenize_file(files[i], &numtokens);
+
+		for(int j = 0; j < numtokens; j++) {
+			if(*n == size) {
+				size *= 2;
+				words = realloc(words, sizeof(char*) * size);
+				if(words == NULL) {
+					fatal_error("Out of memory.");
+				}
+			}
+			words[(*n)++] = tokens[j];
+		}
+		free(tokens);
+	}
+	find_files_destroy(files);
+
+	return words;
+}
+
+/* Insert 'num' keys, with duplicates, and check size, search and prefix-iteration against sorted unique keys. */
+static void assert_keys(char *name, char **words, int num) {
+	art_t			*art;
+	art_iterator_t	*iterator;
+	char			**sorted, *item;
+	int				unique, inserted, expect, count;
+	size_t			len;
+
+	art = art_create();
+
+	inserted = 0;
+	for(int i = 0; i < num; i++) {
+		inserted += art_insert(art, words[i], words[i]);
+	}
+
+	/* Unique words in ascending byte-order. */
+	sorted = malloc(sizeof(char*) * (num + 1));
+	if(sorted == NULL) {
+		fatal_error("Out of memory.");
+	}
+	memcpy(sorted, words, sizeof(char*) * num);
+	qsort(sorted, num, sizeof(char*), cmpstr);
+
+	unique = 0;
+	for(int i = 0; i < num; i++) {
+		if( (unique == 0) || (strcmp(sorted[unique - 1], sorted[i]) != 0) ) {
+			sorted[unique++] = sorted[i];
+		}
+	}
+	if( (inserted != unique) || (art_size(art) != unique) ) {
+		fatal_error("Inserted %d, size %d, but %d unique keys. \n", inserted, art_size(art), unique);
+	}
+
+	for(int i = 0; i < num; i++) {
+		item = art_search(art, words[i]);
+		if( (item == NULL) || (strcmp(item, words[i]) != 0) ) {
+			fatal_error("Word; \'%s\', not found. \n", words[i]);
+		}
+	}
+	if( (art_search(art, "") != NULL) || (art_search(art, "not a word") != NULL) ) {
+		fatal_error("Found word not inserted. \n");
+	}
+
+	for(unsigned int p = 0; p < sizeof(prefixes) / sizeof(char*); p++) {
+		len = strlen(prefixes[p]);
+		iterator = art_createiterator(art, prefixes[p]);
+
+		/* First word with prefix in sorted words. */
+		for(expect = 0; (expect < unique) && (strncmp(sorted[expect], prefixes[p], len) < 0); expect++);
+
+		count = 0;
+		while(art_hasnext(iterator)) {
+			item = art_next(iterator);
+
+			if( (expect >= unique) || (strncmp(sorted[expect], prefixes[p], len) != 0) || (strcmp(item, sorted[expect]) != 0)
+				|| (strcmp(art_currentkey(iterator), item) != 0) ) {
+				fatal_error("Prefix \'%s\'; expected \'%s\', got \'%s\'. \n", prefixes[p], (expect < unique) ? sorted[expect] : "END", item);
+			}
+			expect++;
+			count++;
+		}
+		if( (expect < unique) && (strncmp(sorted[expect], prefixes[p], len) == 0) ) {
+			fatal_error("Prefix \'%s\'; iteration ended before \'%s\'. \n", prefixes[p], sorted[expect]);
+		}
+		art_destroyiterator(iterator);
+
+		if(count > 0) {
+			printf("%s with prefix \'%s\': %d. \n", name, prefixes[p], count);
+		}
+	}
+	printf("%d %s, %d unique, in order. \n", num, name, unique);
+
+	art_destroy(art, NULL, NULL);
+	free(sorted);
+}
+
+int main(int argc, char **argv) {
+	char	**words, **paths;
+	int		numwords, numpaths;
+
+	words = corpus_create( (argc > 1) ? argv[1] : ".", &numwords );
+	paths = find_files( (argc > 1) ? argv[1] : ".", &numpaths );
+
+	assert_keys("words", words, numwords);
+	assert_keys("paths", paths, numpaths);
+
+	for(int i = 0; i < numwords; i++) {
+		free(words[i]);
+	}
+	free(words);
+	find_files_destroy(paths);
+
+	return 0;
+}
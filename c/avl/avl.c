@@ -1,19 +1,31 @@
  /* Author: Marius Ingebrigtsen */
 
+#include <string.h>
+
 #include "avl.h"
 #include "../plot.h"
+#include "../mergesort.h"
+
+#define MAX(a, b) ( ((a) > (b)) ? (a) : (b) )
+
+/* Upper bound of AVL height for any number of nodes addressable in memory. */
+#define MAXHEIGHT 92
 
-#define MAX(a, b) (a > b) ? a : b
+/* Number of lookups interleaved by search_many. */
+#define SEARCH_GROUP	16
 
 typedef struct node node_t;
 struct node {
 	void	*key, *item;
-	node_t	*left, *right, *next;
+	node_t	*left, *right;
+	node_t	*next, *prev;	/* Iteration-sequence. */
 	int		subtree;
 };
 
 struct avl {
 	node_t		*root, *head;
+	node_t		**spine;			/* Path from root to largest node; finger for avl_append. Empty when invalid. */
+	int			spinelen, spinecap;
 	int			children;
 	cmpfunc_t	cmpfunc;
 };
@@ -33,56 +45,25 @@ avl_t *avl_create(cmpfunc_t cmpfunc) {
 }
 
 /* AVL Destroy: */
-static void _avl_destroy_key_item(node_t *current, freefunc_t freekey, freefunc_t freeitem) {
-	if(current == NULL) {
-		return;
-	}
-	_avl_destroy_key_item(current->left, freekey, freeitem);
-	_avl_destroy_key_item(current->right, freekey, freeitem);
-	freekey(current->key);
-	freeitem(current->item);
-	free(current);
-}
-
-static void _avl_destroy_key(node_t *current, freefunc_t freekey) {
-	if(current == NULL) {
-		return;
-	}
-	_avl_destroy_key(current->left, freekey);
-	_avl_destroy_key(current->right, freekey);
-	freekey(current->key);
-	free(current);
-}
+/* Every node is in iteration-sequence, so destruction walks sequence in stead of tree; no recursion on deep trees. */
+void avl_destroy(avl_t *avl, freefunc_t freekey, freefunc_t freeitem) {
+	node_t *current, *tmp;
 
-static void _avl_destroy_item(node_t *current, freefunc_t freeitem) {
-	if(current == NULL) {
-		return;
-	}
-	_avl_destroy_item(current->left, freeitem);
-	_avl_destroy_item(current->right, freeitem);
-	freeitem(current->item);
-	free(current);
-}
+	current = avl->head;
 
-static void _avl_destroy(node_t *current) {
-	if(current == NULL) {
-		return;
-	}
-	_avl_destroy(current->left);
-	_avl_destroy(current->right);
-	free(current);
-}
+	while(current != NULL) {
+		tmp		= current;
+		current	= current->next;
 
-void avl_destroy(avl_t *avl, freefunc_t freekey, freefunc_t freeitem) {
-	if( (freekey != NULL) && (freeitem != NULL) ) {
-		_avl_destroy_key_item(avl->root, freekey, freeitem);
-	} else if(freekey != NULL) {
-		_avl_destroy_key(avl->root, freekey);
-	} else if(freeitem != NULL) {
-		_avl_destroy_item(avl->root, freeitem);
-	} else {
-		_avl_destroy(avl->root);
+		if(freekey != NULL) {
+			freekey(tmp->key);
+		}
+		if(freeitem != NULL) {
+			freeitem(tmp->item);
+		}
+		free(tmp);
 	}
+	free(avl->spine);
 	free(avl);
 }
 
@@ -92,7 +73,8 @@ int avl_size(avl_t *avl) {
 }
 
 /* AVL Insertion: */
-static inline node_t *node_create(void *key, void *item, node_t *head) {
+/* Return new node, linked first in iteration-sequence. */
+static inline node_t *node_create(avl_t *avl, void *key, void *item) {
 	node_t *node;
 
 	node = malloc(sizeof(node_t));
@@ -103,8 +85,13 @@ static inline node_t *node_create(void *key, void *item, node_t *head) {
 	node->item		= item;
 	node->left		= node->right = NULL;
 	node->subtree	= 1;
+	node->prev		= NULL;
+	node->next		= avl->head;
 
-	node->next	= head;
+	if(avl->head != NULL) {
+		avl->head->prev = node;
+	}
+	avl->head = node;
 
 	return node;
 }
@@ -136,178 +123,454 @@ static inline int subtree_height(node_t *node) {
 	return node->subtree;
 }
 
-static node_t *_avl_insert(node_t *current, cmpfunc_t cmpfunc, void *key, void *item, node_t **head, int *inserted) {
-	int cmp, balance;
+static inline void subtree_update(node_t *node) {
+	node->subtree = MAX( subtree_height(node->left), subtree_height(node->right) ) + 1;
+}
 
-	if(current == NULL) {
-		*head = node_create(key, item, *head);
-		return *head;
+/* Rotate 'node' if its subtrees differ in height by two, and return new root of subtree. */
+static node_t *rebalance(node_t *node) {
+	int balance;
+
+	balance = subtree_height(node->left) - subtree_height(node->right);
+
+	if(balance > 1) {
+		/* LEFT-RIGHT CASE: */
+		if(subtree_height(node->left->left) < subtree_height(node->left->right)) {
+			node->left = rotate_left(node->left);
+			subtree_update(node->left->left);
+		}
+		/* LEFT-LEFT CASE: */
+		node = rotate_right(node);
+		subtree_update(node->right);
+		subtree_update(node);
 	}
-	cmp = cmpfunc(key, current->key);
+	else if(balance < -1) {
+		/* RIGHT-LEFT CASE: */
+		if(subtree_height(node->right->right) < subtree_height(node->right->left)) {
+			node->right = rotate_right(node->right);
+			subtree_update(node->right->right);
+		}
+		/* RIGHT-RIGHT CASE: */
+		node = rotate_left(node);
+		subtree_update(node->left);
+		subtree_update(node);
+	}
+	return node;
+}
 
-	if(cmp < 0) {
-		current->left = _avl_insert(current->left, cmpfunc, key, item, head, inserted);
+/* Walk 'top' links recorded on path back up, updating heights and rebalancing.
+ * Nodes above a subtree whose height is unchanged are unaffected, so walk stops there. */
+static void path_rebalance(node_t **path[], int top) {
+	node_t	**link, *current;
+	int		height;
+
+	while(top > 0) {
+		link	= path[--top];
+		current	= *link;
+		height	= current->subtree;
+
+		subtree_update(current);
+		*link = rebalance(current);
 
-		current->subtree = MAX( subtree_height(current->left), subtree_height(current->right) ) + 1;
+		if((*link)->subtree == height) {
+			break;
+		}
+	}
+}
 
-		balance = subtree_height(current->left) - subtree_height(current->right);
+/* Descend iteratively and record links on path, then walk path back up updating heights.
+ * A rotation restores height of subtree from before insertion, so walk stops there; or at first unchanged height. */
+int avl_insert(avl_t *avl, void *key, void *item) {
+	node_t	**path[MAXHEIGHT], **link, *current;
+	int		cmp, top;
 
-		if(balance > 1) {
-			cmp = cmpfunc(key, current->left->key);
+	avl->spinelen = 0;
 
-			/* LEFT-LEFT CASE: */
-			if(cmp < 0) {
-				current = rotate_right(current);
-				current->right->subtree = MAX( subtree_height(current->right->left), subtree_height(current->right->right) ) + 1;
-			}
-			/* LEFT-RIGHT CASE: */
-			else if(cmp > 0) {
-				current->left = rotate_left(current->left);
-				current->left->subtree = MAX( subtree_height(current->left->left), subtree_height(current->left->right) ) + 1;
-				current->left->left->subtree = MAX( subtree_height(current->left->left->left), subtree_height(current->left->left->right) ) + 1;
-			}
+	top		= 0;
+	link	= &avl->root;
+
+	while( (current = *link) != NULL ) {
+		cmp = avl->cmpfunc(key, current->key);
+
+		if(cmp == 0) {
+			current->item = item;
+			return 0;
 		}
+		path[top++] = link;
+		link = (cmp < 0) ? &current->left : &current->right;
 	}
-	else if(cmp > 0) {
-		current->right = _avl_insert(current->right, cmpfunc, key, item, head, inserted);
+	*link = node_create(avl, key, item);
+	avl->children++;
 
-		current->subtree = MAX( subtree_height(current->left), subtree_height(current->right) ) + 1;
+	path_rebalance(path, top);
 
-		balance = subtree_height(current->left) - subtree_height(current->right);
+	return 1;
+}
 
-		if(balance < -1) {
-			cmp = cmpfunc(key, current->right->key);
+/* AVL Append: */
+static void spine_push(avl_t *avl, node_t *node) {
+	if(avl->spinelen == avl->spinecap) {
+		avl->spinecap = (avl->spinecap == 0) ? 32 : avl->spinecap * 2;
+		avl->spine = realloc(avl->spine, sizeof(node_t*) * avl->spinecap);
+		if(avl->spine == NULL) {
+			fatal_error("Out of memory.");
+		}
+	}
+	avl->spine[avl->spinelen++] = node;
+}
 
-			/* RIGHT-RIGHT CASE: */
-			if(cmp > 0) {
-				current = rotate_left(current);
-				current->left->subtree = MAX( subtree_height(current->left->left), subtree_height(current->left->right) ) + 1;
-			}
-			/* RIGHT-LEFT CASE: */
-			else if(cmp < 0) {
-				current->right = rotate_right(current->right);
-				current->right->subtree = MAX( subtree_height(current->right->left), subtree_height(current->right->right) ) + 1;
-				current->right->right->subtree = MAX( subtree_height(current->right->right->left), subtree_height(current->right->right->right) ) + 1;
-			}
+int avl_append(avl_t *avl, void *key, void *item) {
+	node_t	*last, *current, *child;
+	int		cmp, height;
+
+	if(avl->root == NULL) {
+		return avl_insert(avl, key, item);
+	}
+	if(avl->spinelen == 0) {
+		for(current = avl->root; current != NULL; current = current->right) {
+			spine_push(avl, current);
 		}
 	}
-	else {
-		*inserted = 0;
-		current->item = item;
-		return current;
+	last = avl->spine[avl->spinelen - 1];
+	cmp = avl->cmpfunc(key, last->key);
+
+	if(cmp < 0) {
+		return avl_insert(avl, key, item);
+	} else if(cmp == 0) {
+		last->item = item;
+		return 0;
 	}
-	current->subtree = MAX( subtree_height(current->left), subtree_height(current->right) ) + 1;
+	last->right = node_create(avl, key, item);
+	spine_push(avl, last->right);
+	avl->children++;
 
-	return current;
-}
+	/* Update heights up along spine until unchanged; new node is rightmost, so only right-right case occurs. */
+	for(int i = avl->spinelen - 2; i >= 0; i--) {
+		current	= avl->spine[i];
+		height	= MAX( subtree_height(current->left), subtree_height(current->right) ) + 1;
 
-int avl_insert(avl_t *avl, void *key, void *item) {
-	int inserted;
+		if(height == current->subtree) {
+			break;
+		}
+		current->subtree = height;
 
-	inserted = 1;
+		if(subtree_height(current->left) - subtree_height(current->right) < -1) {
+			child = rotate_left(current);
+			current->subtree	= MAX( subtree_height(current->left), subtree_height(current->right) ) + 1;
+			child->subtree		= MAX( subtree_height(child->left), subtree_height(child->right) ) + 1;
 
-	avl->root = _avl_insert(avl->root, avl->cmpfunc, key, item, &avl->head, &inserted);
+			if(i == 0) {
+				avl->root = child;
+			} else {
+				avl->spine[i - 1]->right = child;
+			}
+			/* Rotated node leaves spine. */
+			memmove(&avl->spine[i], &avl->spine[i + 1], sizeof(node_t*) * (avl->spinelen - i - 1));
+			avl->spinelen--;
+			break;
+		}
+	}
 
-	if(inserted) {
-		avl->children++;
+	return 1;
+}
+
+/* AVL Remove & Pop: */
+/* Remove node from iteration-sequence. */
+static void sequence_unlink(avl_t *avl, node_t *node) {
+	if(node->prev != NULL) {
+		node->prev->next = node->next;
+	} else {
+		avl->head = node->next;
 	}
+	if(node->next != NULL) {
+		node->next->prev = node->prev;
+	}
+}
 
-	return inserted;
+static void node_destroy(node_t *node, freefunc_t freekey, freefunc_t freeitem) {
+	if(freekey != NULL) {
+		freekey(node->key);
+	}
+	if(freeitem != NULL) {
+		freeitem(node->item);
+	}
+	free(node);
 }
 
-/* AVL Search: */
-static void *_avl_search(node_t *current, cmpfunc_t cmpfunc, void *key) {
-	int cmp;
+/* Descend iteratively and record links on path; node with two children is replaced by its in-order successor,
+ * and path is extended down to successor. Walk path back up updating heights and rebalancing.
+ * Return node unlinked from tree and iteration-sequence; NULL if key not in AVL. */
+static node_t *avl_unlink(avl_t *avl, void *key) {
+	node_t	**path[MAXHEIGHT], **link, **sublink, *current, *successor;
+	int		cmp, top, below;
+
+	top		= 0;
+	link	= &avl->root;
 
+	while( (current = *link) != NULL ) {
+		cmp = avl->cmpfunc(key, current->key);
+
+		if(cmp == 0) {
+			break;
+		}
+		path[top++] = link;
+		link = (cmp < 0) ? &current->left : &current->right;
+	}
 	if(current == NULL) {
 		return NULL;
 	}
-	cmp = cmpfunc(key, current->key);
+	avl->spinelen = 0;
 
-	if(cmp < 0) {
-		return _avl_search(current->left, cmpfunc, key);
-	}
-	else if(cmp > 0) {
-		return _avl_search(current->right, cmpfunc, key);
+	if( (current->left == NULL) || (current->right == NULL) ) {
+		*link = (current->left != NULL) ? current->left : current->right;
 	}
 	else {
-		return current->item;
+		path[top++] = link;
+		below		= top;
+		sublink		= &current->right;
+
+		while((*sublink)->left != NULL) {
+			path[top++] = sublink;
+			sublink = &(*sublink)->left;
+		}
+		successor	= *sublink;
+		*sublink	= successor->right;
+
+		successor->left		= current->left;
+		successor->right	= current->right;
+		successor->subtree	= current->subtree;
+		*link				= successor;
+
+		/* First link below removed node now belongs to successor. */
+		if(below < top) {
+			path[below] = &successor->right;
+		}
 	}
-	return NULL;
+	path_rebalance(path, top);
+
+	sequence_unlink(avl, current);
+	avl->children--;
+
+	return current;
 }
 
-void *avl_search(avl_t *avl, void *key) {
-	return _avl_search(avl->root, avl->cmpfunc, key);
+int avl_remove(avl_t *avl, void *key, freefunc_t freekey, freefunc_t freeitem) {
+	node_t *removed;
+
+	removed = avl_unlink(avl, key);
+	if(removed == NULL) {
+		return 0;
+	}
+	node_destroy(removed, freekey, freeitem);
+
+	return 1;
 }
 
-/* AVL Sort: */
-static node_t *split(node_t *head) {
-	node_t *slow, *fast, *ndhead;
+void *avl_pop(avl_t *avl, void *key, freefunc_t freekey) {
+	node_t	*removed;
+	void	*item;
+
+	removed = avl_unlink(avl, key);
+	if(removed == NULL) {
+		return NULL;
+	}
+	item = removed->item;
+	node_destroy(removed, freekey, NULL);
 
-	slow = head;
-	fast = head->next;
+	return item;
+}
 
-	while( (fast != NULL) && (fast->next != NULL) ) {
-		slow = slow->next;
-		fast = fast->next->next;
+/* AVL Remove Range: */
+/* Return tree of nodes in 'left', 'middle' and 'right', where every key in 'left' is less than key of 'middle',
+ * and key of 'middle' is less than every key in 'right'.
+ * Descend taller tree to subtree as high as shorter tree and put 'middle' there; cost is difference in height. */
+static node_t *subtree_join(node_t *left, node_t *middle, node_t *right) {
+	if(subtree_height(left) > subtree_height(right) + 1) {
+		left->right = subtree_join(left->right, middle, right);
+		subtree_update(left);
+		return rebalance(left);
+	}
+	if(subtree_height(right) > subtree_height(left) + 1) {
+		right->left = subtree_join(left, middle, right->left);
+		subtree_update(right);
+		return rebalance(right);
 	}
-	ndhead = slow->next;
-	slow->next = NULL;
+	middle->left	= left;
+	middle->right	= right;
+	subtree_update(middle);
 
-	return ndhead;
+	return middle;
 }
 
-static node_t *merge(node_t *a, node_t *b, cmpfunc_t cmpfunc) {
-	node_t *head, *tail;
+/* Split tree at 'key' into 'left' with keys less than key, or less than or equal if 'inclusive', and 'right' with remaining keys.
+ * Each node on search-path is joined onto its side with subtree hanging off path; heights of joined trees increase,
+ * so cost of joins telescopes to O(log n). */
+static void subtree_split(avl_t *avl, node_t *root, void *key, int inclusive, node_t **left, node_t **right) {
+	node_t	*part;
+	int		cmp;
 
-	if(cmpfunc(a->key, b->key) < 0) {
-		head = a;
-		a = a->next;
-	} else {
-		head = b;
-		b = b->next;
-	}
-	tail = head;
-
-	while( (a != NULL) && (b != NULL) ) {
-		if(cmpfunc(a->key, b->key) < 0) {
-			tail->next = a;
-			a = a->next;
-		} else {
-			tail->next = b;
-			b = b->next;
-		}
-		tail = tail->next;
+	if(root == NULL) {
+		*left = *right = NULL;
+		return;
 	}
+	cmp = avl->cmpfunc(key, root->key);
 
-	if(a == NULL) {
-		tail->next = b;
+	if( (cmp > 0) || (inclusive && (cmp == 0)) ) {
+		subtree_split(avl, root->right, key, inclusive, &part, right);
+		*left = subtree_join(root->left, root, part);
 	} else {
-		tail->next = a;
+		subtree_split(avl, root->left, key, inclusive, left, &part);
+		*right = subtree_join(part, root, root->right);
+	}
+}
+
+/* Join trees where every key in 'left' is less than every key in 'right'; smallest node of 'right' is split off as middle. */
+static node_t *subtree_join_adjacent(avl_t *avl, node_t *left, node_t *right) {
+	node_t *middle;
+
+	if(right == NULL) {
+		return left;
 	}
+	for(middle = right; middle->left != NULL; middle = middle->left);
 
-	return head;
+	subtree_split(avl, right, middle->key, 1, &middle, &right);
+
+	return subtree_join(left, middle, right);
 }
 
-static node_t *_mergesort(node_t *head, cmpfunc_t cmpfunc) {
-	node_t *ndhead;
+/* Unlink and destroy every node in subtree, and return number of nodes. Subtree is balanced, so recursion is shallow. */
+static int subtree_destroy(avl_t *avl, node_t *root, freefunc_t freekey, freefunc_t freeitem) {
+	int num;
 
-	if( (head == NULL) || (head->next == NULL) ) {
-		return head;
+	if(root == NULL) {
+		return 0;
 	}
-	ndhead = split(head);
+	num = 1 + subtree_destroy(avl, root->left, freekey, freeitem) + subtree_destroy(avl, root->right, freekey, freeitem);
 
-	head = _mergesort(head, cmpfunc);
-	ndhead = _mergesort(ndhead, cmpfunc);
+	sequence_unlink(avl, root);
+	node_destroy(root, freekey, freeitem);
 
-	return merge(head, ndhead, cmpfunc);
+	return num;
 }
 
+int avl_remove_range(avl_t *avl, void *lo, void *hi, freefunc_t freekey, freefunc_t freeitem) {
+	node_t	*left, *middle, *right;
+	int		removed;
+
+	if( (avl->root == NULL) || (avl->cmpfunc(lo, hi) > 0) ) {
+		return 0;
+	}
+	avl->spinelen = 0;
+
+	subtree_split(avl, avl->root, lo, 0, &left, &middle);
+	subtree_split(avl, middle, hi, 1, &middle, &right);
+
+	removed = subtree_destroy(avl, middle, freekey, freeitem);
+
+	avl->root = subtree_join_adjacent(avl, left, right);
+	avl->children -= removed;
+
+	return removed;
+}
+
+/* AVL Search: */
+void *avl_search(avl_t *avl, void *key) {
+	node_t	*current;
+	int		cmp;
+
+	current = avl->root;
+
+	while(current != NULL) {
+		cmp = avl->cmpfunc(key, current->key);
+
+		if(cmp == 0) {
+			return current->item;
+		}
+		current = (cmp < 0) ? current->left : current->right;
+	}
+	return NULL;
+}
+
+/* AVL Search Many: */
+/* Lookups in group advance one step per turn in round-robin, and prefetch what their next turn reads;
+ * cache-misses of up to SEARCH_GROUP independent descents overlap in stead of stalling one after another.
+ * Each lookup alternates between loading key of node, and comparing and moving to child. */
+void avl_search_many(avl_t *avl, void **keys, void **items, int num) {
+	node_t	*current[SEARCH_GROUP];
+	int		index[SEARCH_GROUP];		/* Index of key searched for in slot, or -1 when slot is free. */
+	char	keyloaded[SEARCH_GROUP];
+	int		next, active, cmp;
+
+	if(avl->root == NULL) {
+		for(int i = 0; i < num; i++) {
+			items[i] = NULL;
+		}
+		return;
+	}
+	for(int s = 0; s < SEARCH_GROUP; s++) {
+		index[s] = -1;
+	}
+	next = active = 0;
+
+	while( (active > 0) || (next < num) ) {
+		for(int s = 0; s < SEARCH_GROUP; s++) {
+			if(index[s] < 0) {
+				if(next == num) {
+					continue;
+				}
+				/* Start next lookup at root. */
+				index[s]		= next;
+				items[next]		= NULL;
+				current[s]		= avl->root;
+				keyloaded[s]	= 0;
+				__builtin_prefetch(keys[next]);
+				next++;
+				active++;
+				continue;
+			}
+			if(!keyloaded[s]) {
+				__builtin_prefetch(current[s]->key);
+				keyloaded[s] = 1;
+				continue;
+			}
+			cmp = avl->cmpfunc(keys[index[s]], current[s]->key);
+
+			if(cmp == 0) {
+				items[index[s]] = current[s]->item;
+				index[s] = -1;
+				active--;
+				continue;
+			}
+			current[s] = (cmp < 0) ? current[s]->left : current[s]->right;
+
+			if(current[s] == NULL) {
+				index[s] = -1;
+				active--;
+				continue;
+			}
+			__builtin_prefetch(current[s]);
+			keyloaded[s] = 0;
+		}
+	}
+}
+
+/* AVL Sort: */
+MERGESORT_DEFINE(node_sort, node_t, next, key)
+
 void avl_sort(avl_t *avl) {
+	node_t *prev;
+
 	if(avl->children < 2) {
 		return;
 	}
-	avl->head = _mergesort(avl->head, avl->cmpfunc);
+	avl->head = node_sort(avl->head, avl->cmpfunc);
+
+	/* Mergesort only follows 'next'; restore 'prev'. */
+	prev = NULL;
+	for(node_t *current = avl->head; current != NULL; current = current->next) {
+		current->prev = prev;
+		prev = current;
+	}
 }
 
 /* AVL Print: */
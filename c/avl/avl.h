@@ -26,10 +26,38 @@ int avl_size(avl_t *avl);
  * Return 1 if insertion successfull, return 0 if key already in AVL. */
 int avl_insert(avl_t *avl, void *key, void *item);
 
+/* Insert item with key expected to be greater than every key in AVL, e.g. ascending keys. 
+ * Starts from finger at largest node in stead of root, so sequence of appends costs amortised O(1) per item. 
+ * If key is less than largest key, then item is inserted with avl_insert. 
+ * Return 1 if inserted, return 0 if key already in AVL. */
+int avl_append(avl_t *avl, void *key, void *item);
+
 /* Search AVL using key and return item with key. 
  * Return NULL if item not in AVL. */
 void *avl_search(avl_t *avl, void *key);
 
+/* Search AVL for each of 'num' keys, and store item with keys[i] in items[i], or NULL if key not in AVL. 
+ * Lookups are interleaved and prefetch their next node, so memory latency of independent descents overlaps; 
+ * for large trees faster than calling avl_search for each key. */
+void avl_search_many(avl_t *avl, void **keys, void **items, int num);
+
+/* Remove item associated with key, and rebalance. 
+ * Return 1 if removed, 0 if key not in AVL. 
+ * Optional function-pointers for deallocation of key and item, pass NULL to avoid deallocation. */
+int avl_remove(avl_t *avl, void *key, freefunc_t freekey, freefunc_t freeitem);
+
+/* Remove and return item associated with key. 
+ * Return NULL if key not in AVL. 
+ * Optional function-pointer for deallocation of key, pass NULL to avoid deallocation. */
+void *avl_pop(avl_t *avl, void *key, freefunc_t freekey);
+
+/* Remove every item with key from 'lo' to 'hi', both inclusive, e.g. a window of old timestamps. 
+ * Tree is split around interval and remaining parts joined, so cost is O(log n + k) for k removed items, 
+ * in stead of O(k log n) for k separate removes. 
+ * Return number of items removed. 
+ * Optional function-pointers for deallocation of keys and items, pass NULL to avoid deallocation. */
+int avl_remove_range(avl_t *avl, void *lo, void *hi, freefunc_t freekey, freefunc_t freeitem);
+
 /* Sort AVL iteration using cmpfunc to compare. 
  * If sorted after an iterator is created, iterator position in sequence may be changed. 
  * To fix this call avl_resertiterator(). */
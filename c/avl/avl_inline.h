@@ -0,0 +1,242 @@
+/* Author: Marius Ingebrigtsen */
+
+#ifndef __AVL_INLINE_H_
+#define __AVL_INLINE_H_
+
+#include "../common.h"
+
+/* Inline-Key AVL-Tree Generator.
+ * AVL_DEFINE(name, keytype) defines 'name_t', an AVL-tree with scalar keys of 'keytype' stored in the node,
+ * and compared directly with '<' in stead of through cmpfunc_t and a key-pointer.
+ * Intended for integer-keyed maps, where an indirect call and a dependent load per comparison
+ * is a multiple of the useful work.
+ *
+ * Generated functions, all 'static inline':
+ *
+ * name_t *name_create(void);
+ * void name_destroy(name_t *tree, freefunc_t freeitem);	Optional deallocation of items, pass NULL to avoid.
+ * int name_size(name_t *tree);
+ * int name_insert(name_t *tree, keytype key, void *item);	Return 1 if inserted, 0 if item overwritten.
+ * void *name_search(name_t *tree, keytype key);			Return NULL if key not in tree.
+ *
+ * name_iterator_t *name_createiterator(name_t *tree);		Iteration is in ascending order of keys.
+ * void name_destroyiterator(name_iterator_t *iterator);
+ * int name_hasnext(name_iterator_t *iterator);
+ * void *name_next(name_iterator_t *iterator);
+ * void name_resetiterator(name_iterator_t *iterator);
+ *
+ * Usage:
+ * '''
+ * AVL_DEFINE(avl_int, int)
+ *
+ * avl_int_t *avl = avl_int_create();
+ * avl_int_insert(avl, 42, item);
+ * '''
+ */
+
+/* Upper bound of AVL height for any number of nodes addressable in memory. */
+#define AVL_INLINE_MAXHEIGHT 92
+
+#define AVL_DEFINE(name, keytype)																\
+																								\
+typedef struct name##_node name##_node_t;														\
+struct name##_node {																			\
+	keytype			key;																		\
+	void			*item;																		\
+	name##_node_t	*link[2];																	\
+	signed char		balance;	/* Height of right subtree minus left. */						\
+};																								\
+																								\
+typedef struct name {																			\
+	name##_node_t	*root;																		\
+	int				children;																	\
+} name##_t;																						\
+																								\
+static inline name##_t *name##_create(void) {													\
+	name##_t *tree;																				\
+																								\
+	tree = calloc(1, sizeof(name##_t));															\
+	if(tree == NULL) {																			\
+		fatal_error("Out of memory.");															\
+	}																							\
+	return tree;																				\
+}																								\
+																								\
+/* Destroy without recursion by rotating left children up until none remain. */				\
+static inline void name##_destroy(name##_t *tree, freefunc_t freeitem) {						\
+	name##_node_t *current, *tmp;																\
+																								\
+	current = tree->root;																		\
+																								\
+	while(current != NULL) {																	\
+		if(current->link[0] != NULL) {															\
+			tmp					= current->link[0];												\
+			current->link[0]	= tmp->link[1];													\
+			tmp->link[1]		= current;														\
+			current				= tmp;															\
+		} else {																				\
+			tmp		= current;																	\
+			current	= current->link[1];															\
+			if(freeitem != NULL) {																\
+				freeitem(tmp->item);															\
+			}																					\
+			free(tmp);																			\
+		}																						\
+	}																							\
+	free(tree);																					\
+}																								\
+																								\
+static inline int name##_size(name##_t *tree) {													\
+	return tree->children;																		\
+}																								\
+																								\
+/* Rebalance 'top', which is two levels heavier in direction 'dir'. Return new subtree-root. */	\
+static inline name##_node_t *name##_rebalance(name##_node_t *top, int dir) {					\
+	name##_node_t	*child, *grand;																\
+	int				sign;																		\
+																								\
+	sign	= dir ? 1 : -1;																		\
+	child	= top->link[dir];																	\
+																								\
+	if(child->balance == sign) {																\
+		top->link[dir]		= child->link[!dir];												\
+		child->link[!dir]	= top;																\
+		top->balance		= child->balance = 0;												\
+		return child;																			\
+	}																							\
+	grand				= child->link[!dir];													\
+	child->link[!dir]	= grand->link[dir];														\
+	grand->link[dir]	= child;																\
+	top->link[dir]		= grand->link[!dir];													\
+	grand->link[!dir]	= top;																	\
+																								\
+	if(grand->balance == sign) {																\
+		top->balance	= -sign;																\
+		child->balance	= 0;																	\
+	} else if(grand->balance == 0) {															\
+		top->balance	= child->balance = 0;													\
+	} else {																					\
+		top->balance	= 0;																	\
+		child->balance	= sign;																	\
+	}																							\
+	grand->balance = 0;																			\
+																								\
+	return grand;																				\
+}																								\
+																								\
+static inline int name##_insert(name##_t *tree, keytype key, void *item) {						\
+	name##_node_t	**toplink, **link, *top, *current, *new;									\
+	unsigned char	dirs[AVL_INLINE_MAXHEIGHT];													\
+	int				dir, k, balance;															\
+																								\
+	/* Remember deepest node with non-zero balance on path; only it and nodes below change. */	\
+	toplink	= link = &tree->root;																\
+	k		= 0;																				\
+																								\
+	while( (current = *link) != NULL ) {														\
+		if(key == current->key) {																\
+			current->item = item;																\
+			return 0;																			\
+		}																						\
+		if(current->balance != 0) {																\
+			toplink	= link;																		\
+			k		= 0;																		\
+		}																						\
+		dirs[k++]	= dir = (current->key < key);												\
+		link		= &current->link[dir];														\
+	}																							\
+	new = malloc(sizeof(name##_node_t));														\
+	if(new == NULL) {																			\
+		fatal_error("Out of memory.");															\
+	}																							\
+	new->key		= key;																		\
+	new->item		= item;																		\
+	new->link[0]	= new->link[1] = NULL;														\
+	new->balance	= 0;																		\
+	*link			= new;																		\
+	tree->children++;																			\
+																								\
+	top = *toplink;																				\
+	if(top == new) {																			\
+		return 1;																				\
+	}																							\
+	balance = top->balance + (dirs[0] ? 1 : -1);												\
+																								\
+	for(current = top->link[dirs[0]], k = 1; current != new; current = current->link[dirs[k++]]) {	\
+		current->balance = dirs[k] ? 1 : -1;													\
+	}																							\
+	if( (balance == 2) || (balance == -2) ) {													\
+		*toplink = name##_rebalance(top, dirs[0]);												\
+	} else {																					\
+		top->balance = balance;																	\
+	}																							\
+	return 1;																					\
+}																								\
+																								\
+static inline void *name##_search(name##_t *tree, keytype key) {								\
+	name##_node_t *current;																		\
+																								\
+	current = tree->root;																		\
+																								\
+	while(current != NULL) {																	\
+		if(key == current->key) {																\
+			return current->item;																\
+		}																						\
+		current = current->link[current->key < key];											\
+	}																							\
+	return NULL;																				\
+}																								\
+																								\
+/* In-order iteration with explicit stack of left-spine. */									\
+typedef struct name##_iterator {																\
+	name##_t		*tree;																		\
+	name##_node_t	*stack[AVL_INLINE_MAXHEIGHT];												\
+	int				top;																		\
+} name##_iterator_t;																			\
+																								\
+static inline void name##_pushleft(name##_iterator_t *iterator, name##_node_t *current) {		\
+	while(current != NULL) {																	\
+		iterator->stack[iterator->top++] = current;												\
+		current = current->link[0];																\
+	}																							\
+}																								\
+																								\
+static inline void name##_resetiterator(name##_iterator_t *iterator) {							\
+	iterator->top = 0;																			\
+	name##_pushleft(iterator, iterator->tree->root);											\
+}																								\
+																								\
+static inline name##_iterator_t *name##_createiterator(name##_t *tree) {						\
+	name##_iterator_t *iterator;																\
+																								\
+	iterator = malloc(sizeof(name##_iterator_t));												\
+	if(iterator == NULL) {																		\
+		fatal_error("Out of memory.");															\
+	}																							\
+	iterator->tree = tree;																		\
+	name##_resetiterator(iterator);																\
+																								\
+	return iterator;																			\
+}																								\
+																								\
+static inline void name##_destroyiterator(name##_iterator_t *iterator) {						\
+	free(iterator);																				\
+}																								\
+																								\
+static inline int name##_hasnext(name##_iterator_t *iterator) {									\
+	return (iterator->top > 0) ? 1 : 0;															\
+}																								\
+																								\
+static inline void *name##_next(name##_iterator_t *iterator) {									\
+	name##_node_t *current;																		\
+																								\
+	if(iterator->top == 0) {																	\
+		return NULL;																			\
+	}																							\
+	current = iterator->stack[--iterator->top];													\
+	name##_pushleft(iterator, current->link[1]);												\
+																								\
+	return current->item;																		\
+}
+
+#endif
@@ -1,16 +1,27 @@
-#include <math.h>
 #include "../common.h"
-#include "../gettime.h"
+#include "../bench.h"
 #include "./avl.h"
+#include "./avl_inline.h"
 
 #define START 1024			/* 2^10 */
 #define MAXELEM 1048576 + 1	/* 2^20 + 1 */
-#define REPEAT 10
+
+AVL_DEFINE(avl_int, int)
 
 typedef struct data {
 	int *key, *item;
 } data_t;
 
+/* State of one trial, passed to setup, trial and teardown by harness.
+ * 'keys' are keys of 'data' in random order, and 'items' are items found for them. */
+typedef struct trial {
+	avl_t		*avl;
+	avl_int_t	*inline_avl;
+	data_t		*data;
+	void		**keys, **items;
+	int			elem;
+} trial_t;
+
 
 static int cmpint(int *a, int *b) {
 	return *a - *b;
@@ -32,206 +43,199 @@ static data_t *data_create(int num) {
 	return data;
 }
 
-static data_t *insert_data(avl_t *avl, int elem) {
-	data_t *data;
+static void setup_empty(trial_t *trial) {
+	trial->avl = avl_create( (cmpfunc_t)cmpint );
+	trial->data = data_create(trial->elem);
+}
 
-	data = data_create(elem);
+static void setup_filled(trial_t *trial) {
+	setup_empty(trial);
 
-	for(int i = 0; i < elem; i++) {
-		if(!avl_insert(avl, data[i].key, data[i].item)) {
+	for(int i = 0; i < trial->elem; i++) {
+		if(!avl_insert(trial->avl, trial->data[i].key, trial->data[i].item)) {
 			fatal_error("Duplicate insert.");
 		}
 	}
-	return data;
 }
 
-static void assert_inserts(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE	*f;
-	avl_t	*avl;
-	data_t	*data;
-
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Couldn't open file; %s. ", bnch_file);
-	}
-	fprintf(f, "# AVL Insert Benchmarks \n# Elements, Time (microsec. on average of %d trials with corresponding nr. of elements) \n", REPEAT);
+static void setup_shuffled(trial_t *trial) {
+	void	*tmp;
+	int		j;
 
-	average = 0;
+	setup_filled(trial);
 
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
-		
-		sum = 0;
-
-		for(int r = 0; r < REPEAT; r++) {
-
-			avl = avl_create( (cmpfunc_t)cmpint );
-			data = data_create(elem);
+	trial->keys = malloc(sizeof(void*) * trial->elem);
+	trial->items = malloc(sizeof(void*) * trial->elem);
+	if( (trial->keys == NULL) || (trial->items == NULL) ) {
+		fatal_error("Out of memory.");
+	}
+	for(int i = 0; i < trial->elem; i++) {
+		trial->keys[i] = trial->data[i].key;
+	}
+	for(int i = trial->elem - 1; i > 0; i--) {
+		j = rand() % (i + 1);
+		tmp = trial->keys[i];	trial->keys[i] = trial->keys[j];	trial->keys[j] = tmp;
+	}
+}
 
-			t1 = gettime();
-			for(int i = 0; i < elem; i++) {
-				avl_insert(avl, data[i].key, data[i].item);
-			}
-			t2 = gettime();
+static void setup_inline_empty(trial_t *trial) {
+	trial->inline_avl = avl_int_create();
+	trial->keys = malloc(sizeof(void*) * trial->elem);
+	if(trial->keys == NULL) {
+		fatal_error("Out of memory.");
+	}
+	for(int i = 0; i < trial->elem; i++) {
+		trial->keys[i] = new_integer(i);
+	}
+}
 
-			sum += t2 - t1;
+static void setup_inline_filled(trial_t *trial) {
+	setup_inline_empty(trial);
 
-			free(data);
-			avl_destroy(avl, free, free);
+	for(int i = 0; i < trial->elem; i++) {
+		if( !avl_int_insert(trial->inline_avl, i, trial->keys[i]) ) {
+			fatal_error("Duplicate insert.");
 		}
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
-		
-		average += sum / REPEAT;
 	}
-	num_elem_set = log2(MAXELEM) - log2(START);
-	fprintf(f, "\n# Overall average of %d trials for each set of elements: \n%d \n", REPEAT, (int)(average / num_elem_set));
-
-	fclose(f);
 }
 
-static void assert_searches(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE	*f;
-	avl_t	*avl;
-	data_t	*data;
+static void teardown(trial_t *trial) {
+	free(trial->data);
+	avl_destroy(trial->avl, free, free);
+}
 
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Couldn't open file; %s. ", bnch_file);
+static void teardown_shuffled(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		if(trial->items[i] == NULL) {
+			fatal_error("Value not found.");
+		}
 	}
-	fprintf(f, "# AVL Search Benchmarks \n# Elements, Time (microsec. on average of %d trials with corresponding nr. of elements) \n", REPEAT);
-
-	average = 0;
-
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
+	free(trial->keys);
+	free(trial->items);
+	teardown(trial);
+}
 
-		sum = 0;
+/* Keys removed from tree by trial are not freed by it, so free every key and item of data. */
+static void teardown_removed(trial_t *trial) {
+	avl_destroy(trial->avl, NULL, NULL);
 
-		avl = avl_create( (cmpfunc_t)cmpint );
-		data = insert_data(avl, elem);
+	for(int i = 0; i < trial->elem; i++) {
+		free(trial->data[i].key);
+		free(trial->data[i].item);
+	}
+	free(trial->data);
+}
 
-		for(int r = 0; r < REPEAT; r++) {	
+/* Inline tree holds items, not keys, so 'keys' is only freed, not its integers. */
+static void teardown_inline(trial_t *trial) {
+	free(trial->keys);
+	avl_int_destroy(trial->inline_avl, free);
+}
 
-			t1 = gettime();
-			for(int i = 0; i < elem; i++) {
-				if(avl_search(avl, data[i].key) == NULL) {
-					fatal_error("Value not found.");
-				}
-			}
-			t2 = gettime();
+static void trial_insert(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		avl_insert(trial->avl, trial->data[i].key, trial->data[i].item);
+	}
+}
 
-			sum += t2 - t1;
-			
+static void trial_search(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		if(avl_search(trial->avl, trial->data[i].key) == NULL) {
+			fatal_error("Value not found.");
 		}
-		free(data);
-		avl_destroy(avl, free, free);
-		
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
-
-		average += sum / REPEAT;
 	}
-	num_elem_set = log2(MAXELEM) - log2(START);
-	fprintf(f, "\n# Overall average of %d trials for each set of elements: \n%d \n", REPEAT, (int)(average / num_elem_set));
+}
 
-	fclose(f);
+static void trial_sort(trial_t *trial) {
+	avl_sort(trial->avl);
 }
 
-static void assert_sort(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE	*f;
-	avl_t	*avl;
-	data_t	*data;
+static void trial_iterator(trial_t *trial) {
+	avl_iterator_t *iterator = avl_createiterator(trial->avl);
 
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Couldn't open file; %s", bnch_file);
+	while(avl_next(iterator) != NULL) {
 	}
-	fprintf(f, "# AVL Sort Benchmarks \n# Elements, Time (microsec. on average of %d trials with corresponding nr. of elements) \n", REPEAT);
-
-	average = 0;
-
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
-
-		sum = 0;
-
-		for(int r = 0; r < REPEAT; r++) {
+	avl_destroyiterator(iterator);
+}
 
-			avl = avl_create( (cmpfunc_t)cmpint );
-			data = insert_data(avl, elem);
+/* Keys probed in random order, so each level of each descent is a likely cache-miss;
+ * avl_search descends once per key, avl_search_many interleaves descents. */
+static void trial_search_random(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		trial->items[i] = avl_search(trial->avl, trial->keys[i]);
+	}
+}
 
-			t1 = gettime();
-			avl_sort(avl);
-			t2 = gettime();
+static void trial_search_many(trial_t *trial) {
+	avl_search_many(trial->avl, trial->keys, trial->items, trial->elem);
+}
 
-			sum += t2 - t1;
+/* Inline-Key Benchmarks: */
+/* Same keys and order as above, but stored in node and compared directly. */
+static void trial_inline_insert(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		avl_int_insert(trial->inline_avl, i, trial->keys[i]);
+	}
+}
 
-			free(data);
-			avl_destroy(avl, free, free);
+static void trial_inline_search(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		if(avl_int_search(trial->inline_avl, i) == NULL) {
+			fatal_error("Value not found.");
 		}
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
-
-		average += sum / REPEAT;
 	}
-	num_elem_set = log2(MAXELEM) - log2(START);
-	fprintf(f, "\n# Overall average of %d trials for each set of elements: \n%d \n", REPEAT, (int)(average / num_elem_set));
 }
 
-static void assert_iterator(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE	*f;
-	avl_t	*avl;
-	data_t	*data;
-	avl_iterator_t *iterator;
-
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Couldn't open file; %s", bnch_file);
+/* Oldest quarter of keys expires at once, e.g. a window of timestamps;
+ * avl_remove once per key, against one avl_remove_range. Building tree is not timed. */
+static void trial_remove_quarter(trial_t *trial) {
+	for(int i = 0; i < trial->elem / 4; i++) {
+		avl_remove(trial->avl, trial->data[i].key, NULL, NULL);
 	}
-	fprintf(f, "# AVL Iterator Benchmarks \n# Elements, Time (microsec. on average of %d trials with corresponding nr. of elements) \n", REPEAT);
-
-	average = 0;
-
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
-
-		sum = 0;
+}
 
-		avl = avl_create( (cmpfunc_t)cmpint );
-		data = insert_data(avl, elem);
+static void trial_remove_range(trial_t *trial) {
+	int lo = 0, hi = trial->elem / 4 - 1;
 
-		for(int r = 0; r < REPEAT; r++) {
-			iterator = avl_createiterator(avl);
+	if(avl_remove_range(trial->avl, &lo, &hi, NULL, NULL) != hi - lo + 1) {
+		fatal_error("Wrong number of items removed.");
+	}
+}
 
-			t1 = gettime();
-			while(avl_next(iterator) != NULL) {
-			}
-			t2 = gettime();
+/* Time 'func' for every set of elements; 'quarter' if trial does an operation per oldest quarter of keys only. */
+static void assert_series(char *bnch_file, char *title, benchfunc_t setup, benchfunc_t func, benchfunc_t teardown, int quarter) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
 
-			sum += t2 - t1;
+	file = bench_open(bnch_file, title);
 
-			avl_destroyiterator(iterator);
-		}
-		free(data);
-		avl_destroy(avl, free, free);
-
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
+	for(int elem = START; elem < MAXELEM; elem *= 2) {
+		trial.elem = elem;
 
-		average += sum / REPEAT;
+		bench_run(&stats, setup, func, teardown, &trial, quarter ? elem / 4 : elem);
+		bench_write(file, elem, &stats);
 	}
-	num_elem_set = log2(MAXELEM) - log2(START);
-	fprintf(f, "\n# Overall average of %d trials for each set of elements: \n%d \n", REPEAT, (int)(average / num_elem_set));
+	bench_close(file);
 }
 
 int main(int argc, char **argv) {
 
-	if(argc < 5) {
-		printf("Usage: %s <insert-bench-file> <search-bench-file> <sort-bench-file> <iterator-bench-file> ", *argv);
+	if(argc < 11) {
+		printf("Usage: %s <insert-bench-file> <search-bench-file> <sort-bench-file> <iterator-bench-file> <inline-insert-bench-file> <inline-search-bench-file> <search-random-bench-file> <search-many-bench-file> <remove-quarter-bench-file> <remove-range-bench-file> \n", *argv);
 		return -1;
 	}
 
-	assert_inserts(argv[1]);
-	assert_searches(argv[2]);
-	assert_sort(argv[3]);
-	assert_iterator(argv[4]);
-	
+	assert_series(argv[1], "AVL Insert Benchmarks", (benchfunc_t)setup_empty, (benchfunc_t)trial_insert, (benchfunc_t)teardown, 0);
+	assert_series(argv[2], "AVL Search Benchmarks", (benchfunc_t)setup_filled, (benchfunc_t)trial_search, (benchfunc_t)teardown, 0);
+	assert_series(argv[3], "AVL Sort Benchmarks", (benchfunc_t)setup_filled, (benchfunc_t)trial_sort, (benchfunc_t)teardown, 0);
+	assert_series(argv[4], "AVL Iterator Benchmarks", (benchfunc_t)setup_filled, (benchfunc_t)trial_iterator, (benchfunc_t)teardown, 0);
+	assert_series(argv[5], "AVL Inline-Key Insert Benchmarks", (benchfunc_t)setup_inline_empty, (benchfunc_t)trial_inline_insert, (benchfunc_t)teardown_inline, 0);
+	assert_series(argv[6], "AVL Inline-Key Search Benchmarks", (benchfunc_t)setup_inline_filled, (benchfunc_t)trial_inline_search, (benchfunc_t)teardown_inline, 0);
+	assert_series(argv[7], "AVL Search Benchmarks, keys in random order", (benchfunc_t)setup_shuffled, (benchfunc_t)trial_search_random, (benchfunc_t)teardown_shuffled, 0);
+	assert_series(argv[8], "AVL Search Many Benchmarks, keys in random order", (benchfunc_t)setup_shuffled, (benchfunc_t)trial_search_many, (benchfunc_t)teardown_shuffled, 0);
+	assert_series(argv[9], "AVL Remove Benchmarks, oldest quarter of keys", (benchfunc_t)setup_filled, (benchfunc_t)trial_remove_quarter, (benchfunc_t)teardown_removed, 1);
+	assert_series(argv[10], "AVL Remove Range Benchmarks, oldest quarter of keys", (benchfunc_t)setup_filled, (benchfunc_t)trial_remove_range, (benchfunc_t)teardown_removed, 1);
+
 	return 0;
 }
\ No newline at end of file
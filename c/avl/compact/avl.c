@@ -0,0 +1,826 @@
+/* Author: Marius Ingebrigtsen */
+/* Compact AVL-Tree implementation.
+ * Nodes live in one pool and refer to each other with 32-bit indexes in stead of pointers,
+ * and the balance-factor is packed into two spare bits of 'prev'-index; a node is 32 bytes with no malloc-overhead.
+ * Insert is iterative (Knuth / libavl); only the directions below the deepest unbalanced node on the path are recorded.
+ * Split and join for range-removal carry height of each subtree along, as balance-factors only give relative heights.
+ * NOTE: Pool is re-allocated as it grows, so a node is always referred to by index and never by address. */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "../avl.h"
+#include "../../plot.h"
+
+#define NIL			0			/* Index of NULL-node. */
+#define FAKEROOT	1			/* Index of pseudo-root; parent of root while rebalancing. */
+#define INITSIZE	64			/* Initial number of nodes in pool. */
+#define MAXNODES	0x3fffffff	/* 2^30 - 1; largest index fitting in 'prev'. */
+#define MAXHEIGHT	48			/* Upper bound of AVL height for 2^30 nodes. */
+#define SEARCH_GROUP	16		/* Number of lookups interleaved by search_many. */
+
+#define MAX(a, b) ( ((a) > (b)) ? (a) : (b) )
+
+/* Access node in pool by index. Requires 'avl' in scope. */
+#define N(ref)		(avl->nodes[(ref)])
+
+typedef uint32_t ref_t;
+
+typedef struct node node_t;
+struct node {
+	void		*key, *item;
+	ref_t		link[2];		/* Left and right child. */
+	ref_t		next;			/* Iteration-sequence, or free-list when node is unused. */
+	uint32_t	prev : 30;
+	int32_t		balance : 2;	/* Height of right subtree minus left; -1, 0 or 1. */
+};
+
+struct avl {
+	node_t		*nodes;
+	ref_t		root, head, freelist;
+	uint32_t	used, capacity;
+	ref_t		*spine;			/* Path from root to largest node; finger for avl_append. Empty when invalid. */
+	int			spinelen, spinecap;
+	int			children;
+	cmpfunc_t	cmpfunc;
+};
+
+
+/* AVL Create: */
+avl_t *avl_create(cmpfunc_t cmpfunc) {
+	avl_t *avl;
+
+	avl = calloc(1, sizeof(avl_t));
+	if(avl == NULL) {
+		fatal_error("Out of memory.");
+	}
+	avl->nodes = calloc(INITSIZE, sizeof(node_t));
+	if(avl->nodes == NULL) {
+		fatal_error("Out of memory.");
+	}
+	avl->capacity	= INITSIZE;
+	avl->used		= FAKEROOT + 1;
+	avl->cmpfunc	= cmpfunc;
+
+	return avl;
+}
+
+/* AVL Destroy: */
+/* Every node in use is in iteration-sequence, so destruction walks sequence in stead of tree. */
+void avl_destroy(avl_t *avl, freefunc_t freekey, freefunc_t freeitem) {
+	for(ref_t current = avl->head; current != NIL; current = N(current).next) {
+		if(freekey != NULL) {
+			freekey(N(current).key);
+		}
+		if(freeitem != NULL) {
+			freeitem(N(current).item);
+		}
+	}
+	free(avl->nodes);
+	free(avl->spine);
+	free(avl);
+}
+
+/* AVL Size: */
+int avl_size(avl_t *avl) {
+	return avl->children;
+}
+
+/* AVL Insertion: */
+/* Return index of unused node, linked first in iteration-sequence. */
+static ref_t node_create(avl_t *avl, void *key, void *item) {
+	ref_t ref;
+
+	if(avl->freelist != NIL) {
+		ref = avl->freelist;
+		avl->freelist = N(ref).next;
+	} else {
+		if(avl->used >= avl->capacity) {
+			if(avl->capacity > MAXNODES / 2) {
+				fatal_error("Number of nodes exceeds limit of compact AVL.");
+			}
+			avl->capacity *= 2;
+			avl->nodes = realloc(avl->nodes, sizeof(node_t) * avl->capacity);
+			if(avl->nodes == NULL) {
+				fatal_error("Out of memory.");
+			}
+		}
+		ref = avl->used++;
+	}
+	N(ref).key		= key;
+	N(ref).item		= item;
+	N(ref).link[0]	= N(ref).link[1] = NIL;
+	N(ref).balance	= 0;
+	N(ref).prev		= NIL;
+	N(ref).next		= avl->head;
+
+	if(avl->head != NIL) {
+		N(avl->head).prev = ref;
+	}
+	avl->head = ref;
+
+	return ref;
+}
+
+/* Rebalance 'top', which is two levels heavier in direction 'dir'.
+ * Return new root of subtree. */
+static ref_t rebalance(avl_t *avl, ref_t top, int dir) {
+	ref_t	child, grand;
+	int		sign;
+
+	sign	= dir ? 1 : -1;
+	child	= N(top).link[dir];
+
+	/* Single Rotation: */
+	if(N(child).balance != -sign) {
+		N(top).link[dir]	= N(child).link[!dir];
+		N(child).link[!dir]	= top;
+
+		/* Balanced child only occurs after removal; subtree then keeps its height. */
+		if(N(child).balance == 0) {
+			N(top).balance		= sign;
+			N(child).balance	= -sign;
+		} else {
+			N(top).balance		= N(child).balance = 0;
+		}
+		return child;
+	}
+
+	/* Double Rotation: */
+	grand				= N(child).link[!dir];
+	N(child).link[!dir]	= N(grand).link[dir];
+	N(grand).link[dir]	= child;
+	N(top).link[dir]	= N(grand).link[!dir];
+	N(grand).link[!dir]	= top;
+
+	if(N(grand).balance == sign) {
+		N(top).balance		= -sign;
+		N(child).balance	= 0;
+	} else if(N(grand).balance == 0) {
+		N(top).balance		= N(child).balance = 0;
+	} else {
+		N(top).balance		= 0;
+		N(child).balance	= sign;
+	}
+	N(grand).balance = 0;
+
+	return grand;
+}
+
+int avl_insert(avl_t *avl, void *key, void *item) {
+	ref_t			parent, current, top, topparent, new;
+	unsigned char	dirs[MAXHEIGHT];
+	int				cmp, dir, k, balance;
+
+	avl->spinelen = 0;
+
+	if(avl->root == NIL) {
+		avl->root = node_create(avl, key, item);
+		avl->children++;
+		return 1;
+	}
+	N(FAKEROOT).link[0] = avl->root;
+
+	/* Descend, and remember deepest node with non-zero balance; 'top'.
+	 * Only 'top' and nodes below may change balance from this insertion. */
+	topparent	= FAKEROOT;
+	top			= avl->root;
+	dir			= 0;
+	k			= 0;
+
+	for(parent = FAKEROOT, current = avl->root; current != NIL; parent = current, current = N(current).link[dir]) {
+		cmp = avl->cmpfunc(key, N(current).key);
+
+		if(cmp == 0) {
+			N(current).item = item;
+			return 0;
+		}
+		if(N(current).balance != 0) {
+			topparent	= parent;
+			top			= current;
+			k			= 0;
+		}
+		dirs[k++] = dir = (cmp > 0);
+	}
+	new = node_create(avl, key, item);
+	N(parent).link[dir] = new;
+	avl->children++;
+
+	/* Update balance on path from 'top' down to new node. */
+	balance = N(top).balance + (dirs[0] ? 1 : -1);
+
+	for(current = N(top).link[dirs[0]], k = 1; current != new; current = N(current).link[dirs[k]], k++) {
+		N(current).balance = dirs[k] ? 1 : -1;
+	}
+
+	if( (balance == 2) || (balance == -2) ) {
+		N(topparent).link[N(topparent).link[1] == top] = rebalance(avl, top, dirs[0]);
+	} else {
+		N(top).balance = balance;
+	}
+	avl->root = N(FAKEROOT).link[0];
+
+	return 1;
+}
+
+/* AVL Append: */
+static void spine_push(avl_t *avl, ref_t ref) {
+	if(avl->spinelen == avl->spinecap) {
+		avl->spinecap = (avl->spinecap == 0) ? 32 : avl->spinecap * 2;
+		avl->spine = realloc(avl->spine, sizeof(ref_t) * avl->spinecap);
+		if(avl->spine == NULL) {
+			fatal_error("Out of memory.");
+		}
+	}
+	avl->spine[avl->spinelen++] = ref;
+}
+
+int avl_append(avl_t *avl, void *key, void *item) {
+	ref_t	last, current, new, top;
+	int		cmp;
+
+	if(avl->root == NIL) {
+		return avl_insert(avl, key, item);
+	}
+	if(avl->spinelen == 0) {
+		for(current = avl->root; current != NIL; current = N(current).link[1]) {
+			spine_push(avl, current);
+		}
+	}
+	last = avl->spine[avl->spinelen - 1];
+	cmp = avl->cmpfunc(key, N(last).key);
+
+	if(cmp < 0) {
+		return avl_insert(avl, key, item);
+	} else if(cmp == 0) {
+		N(last).item = item;
+		return 0;
+	}
+	new = node_create(avl, key, item);
+	N(last).link[1] = new;
+	spine_push(avl, new);
+	avl->children++;
+
+	/* Right subtree of each node up along spine grew, until one absorbs the growth.
+	 * New node is rightmost, so rebalance is always a single rotation. */
+	for(int i = avl->spinelen - 2; i >= 0; i--) {
+		current = avl->spine[i];
+
+		if(N(current).balance == -1) {
+			N(current).balance = 0;
+			break;
+		}
+		if(N(current).balance == 0) {
+			N(current).balance = 1;
+			continue;
+		}
+		top = rebalance(avl, current, 1);
+
+		if(i == 0) {
+			avl->root = top;
+		} else {
+			N(avl->spine[i - 1]).link[1] = top;
+		}
+		/* Rotated node leaves spine. */
+		memmove(&avl->spine[i], &avl->spine[i + 1], sizeof(ref_t) * (avl->spinelen - i - 1));
+		avl->spinelen--;
+		break;
+	}
+
+	return 1;
+}
+
+/* AVL Remove & Pop: */
+static void node_destroy(avl_t *avl, ref_t ref, freefunc_t freekey, freefunc_t freeitem) {
+	if(freekey != NULL) {
+		freekey(N(ref).key);
+	}
+	if(freeitem != NULL) {
+		freeitem(N(ref).item);
+	}
+	N(ref).next		= avl->freelist;
+	avl->freelist	= ref;
+}
+
+/* Remove node from iteration-sequence. */
+static void sequence_unlink(avl_t *avl, ref_t ref) {
+	if(N(ref).prev != NIL) {
+		N(N(ref).prev).next = N(ref).next;
+	} else {
+		avl->head = N(ref).next;
+	}
+	if(N(ref).next != NIL) {
+		N(N(ref).next).prev = N(ref).prev;
+	}
+}
+
+/* Descend and record path with directions; node with two children is replaced by its in-order successor,
+ * and path is extended down to successor. Walk path back up, where subtree in recorded direction lost one level;
+ * walk stops at node which absorbs the loss, or rotation of node with balanced child.
+ * Return node unlinked from tree and iteration-sequence; NIL if key not in AVL. */
+static ref_t avl_unlink(avl_t *avl, void *key) {
+	ref_t			path[MAXHEIGHT + 1], current, successor, top;
+	unsigned char	dirs[MAXHEIGHT + 1];
+	int				cmp, k, below, balance, dir;
+
+	N(FAKEROOT).link[0] = avl->root;
+
+	path[0]	= FAKEROOT;
+	dirs[0]	= 0;
+	k		= 1;
+
+	for(current = avl->root; current != NIL; current = N(current).link[dirs[k - 1]]) {
+		cmp = avl->cmpfunc(key, N(current).key);
+
+		if(cmp == 0) {
+			break;
+		}
+		path[k]		= current;
+		dirs[k++]	= (cmp > 0);
+	}
+	if(current == NIL) {
+		return NIL;
+	}
+	avl->spinelen = 0;
+
+	if( (N(current).link[0] == NIL) || (N(current).link[1] == NIL) ) {
+		N(path[k - 1]).link[dirs[k - 1]] = N(current).link[N(current).link[0] == NIL];
+	}
+	else {
+		below		= k;
+		path[k]		= current;
+		dirs[k++]	= 1;
+
+		for(successor = N(current).link[1]; N(successor).link[0] != NIL; successor = N(successor).link[0]) {
+			path[k]		= successor;
+			dirs[k++]	= 0;
+		}
+		N(path[k - 1]).link[dirs[k - 1]] = N(successor).link[1];
+
+		N(successor).link[0]	= N(current).link[0];
+		N(successor).link[1]	= N(current).link[1];
+		N(successor).balance	= N(current).balance;
+		N(path[below - 1]).link[dirs[below - 1]] = successor;
+		path[below] = successor;
+	}
+
+	while(--k > 0) {
+		balance = N(path[k]).balance + (dirs[k] ? -1 : 1);
+
+		if( (balance == 1) || (balance == -1) ) {
+			N(path[k]).balance = balance;
+			break;
+		}
+		if(balance == 0) {
+			N(path[k]).balance = 0;
+			continue;
+		}
+		dir = (balance > 0);
+		top = rebalance(avl, path[k], dir);
+		N(path[k - 1]).link[dirs[k - 1]] = top;
+
+		if(N(top).balance != 0) {
+			break;
+		}
+	}
+	avl->root = N(FAKEROOT).link[0];
+
+	sequence_unlink(avl, current);
+	avl->children--;
+
+	return current;
+}
+
+int avl_remove(avl_t *avl, void *key, freefunc_t freekey, freefunc_t freeitem) {
+	ref_t removed;
+
+	removed = avl_unlink(avl, key);
+	if(removed == NIL) {
+		return 0;
+	}
+	node_destroy(avl, removed, freekey, freeitem);
+
+	return 1;
+}
+
+void *avl_pop(avl_t *avl, void *key, freefunc_t freekey) {
+	ref_t	removed;
+	void	*item;
+
+	removed = avl_unlink(avl, key);
+	if(removed == NIL) {
+		return NULL;
+	}
+	item = N(removed).item;
+	node_destroy(avl, removed, freekey, NULL);
+
+	return item;
+}
+
+/* AVL Remove Range: */
+/* Return height of subtree in direction 'dir' of node 'ref' with height 'height'. */
+static inline int child_height(avl_t *avl, ref_t ref, int height, int dir) {
+	return height - 1 - (N(ref).balance == (dir ? -1 : 1));
+}
+
+static int tree_height(avl_t *avl, ref_t ref) {
+	int height;
+
+	for(height = 0; ref != NIL; height++) {
+		ref = N(ref).link[N(ref).balance >= 0];
+	}
+	return height;
+}
+
+/* Set balance of 'ref' from heights of its subtrees, and rotate if they differ by two.
+ * Return new root of subtree, and its height in 'height'. */
+static ref_t subtree_fix(avl_t *avl, ref_t ref, int hleft, int hright, int *height) {
+	ref_t	child, grand;
+	int		dir, sign, hlight, hchild, hinner, houter, hgrandin, hgrandout, hnode, hother;
+
+	if( (hright - hleft <= 1) && (hleft - hright <= 1) ) {
+		N(ref).balance	= hright - hleft;
+		*height			= MAX(hleft, hright) + 1;
+		return ref;
+	}
+	dir		= (hright > hleft);
+	sign	= dir ? 1 : -1;
+	hlight	= dir ? hleft : hright;
+	hchild	= dir ? hright : hleft;
+	child	= N(ref).link[dir];
+	houter	= child_height(avl, child, hchild, dir);
+	hinner	= child_height(avl, child, hchild, !dir);
+
+	/* Single Rotation: */
+	if(houter >= hinner) {
+		N(ref).link[dir]	= N(child).link[!dir];
+		N(child).link[!dir]	= ref;
+
+		hnode				= MAX(hlight, hinner) + 1;
+		N(ref).balance		= sign * (hinner - hlight);
+		N(child).balance	= sign * (houter - hnode);
+		*height				= MAX(hnode, houter) + 1;
+		return child;
+	}
+
+	/* Double Rotation: */
+	grand		= N(child).link[!dir];
+	hgrandout	= child_height(avl, grand, hinner, dir);
+	hgrandin	= child_height(avl, grand, hinner, !dir);
+
+	N(child).link[!dir]	= N(grand).link[dir];
+	N(grand).link[dir]	= child;
+	N(ref).link[dir]	= N(grand).link[!dir];
+	N(grand).link[!dir]	= ref;
+
+	hnode				= MAX(hlight, hgrandin) + 1;
+	hother				= MAX(hgrandout, houter) + 1;
+	N(ref).balance		= sign * (hgrandin - hlight);
+	N(child).balance	= sign * (houter - hgrandout);
+	N(grand).balance	= sign * (hother - hnode);
+	*height				= MAX(hnode, hother) + 1;
+	return grand;
+}
+
+/* Return tree of nodes in 'left', 'middle' and 'right', where every key in 'left' is less than key of 'middle',
+ * and key of 'middle' is less than every key in 'right'; height of joined tree is returned in 'height'.
+ * Descend taller tree to subtree as high as shorter tree and put 'middle' there; cost is difference in height. */
+static ref_t subtree_join(avl_t *avl, ref_t left, int hleft, ref_t middle, ref_t right, int hright, int *height) {
+	int hsub;
+
+	if(hleft > hright + 1) {
+		N(left).link[1] = subtree_join(avl, N(left).link[1], child_height(avl, left, hleft, 1), middle, right, hright, &hsub);
+		return subtree_fix(avl, left, child_height(avl, left, hleft, 0), hsub, height);
+	}
+	if(hright > hleft + 1) {
+		N(right).link[0] = subtree_join(avl, left, hleft, middle, N(right).link[0], child_height(avl, right, hright, 0), &hsub);
+		return subtree_fix(avl, right, hsub, child_height(avl, right, hright, 1), height);
+	}
+	N(middle).link[0]	= left;
+	N(middle).link[1]	= right;
+	N(middle).balance	= hright - hleft;
+	*height				= MAX(hleft, hright) + 1;
+
+	return middle;
+}
+
+/* Split tree at 'key' into 'left' with keys less than key, or less than or equal if 'inclusive', and 'right' with remaining keys.
+ * Each node on search-path is joined onto its side with subtree hanging off path; heights of joined trees increase,
+ * so cost of joins telescopes to O(log n). */
+static void subtree_split(avl_t *avl, ref_t root, int height, void *key, int inclusive, ref_t *left, int *hleft, ref_t *right, int *hright) {
+	ref_t	part;
+	int		hpart, cmp;
+
+	if(root == NIL) {
+		*left	= *right	= NIL;
+		*hleft	= *hright	= 0;
+		return;
+	}
+	cmp = avl->cmpfunc(key, N(root).key);
+
+	if( (cmp > 0) || (inclusive && (cmp == 0)) ) {
+		subtree_split(avl, N(root).link[1], child_height(avl, root, height, 1), key, inclusive, &part, &hpart, right, hright);
+		*left = subtree_join(avl, N(root).link[0], child_height(avl, root, height, 0), root, part, hpart, hleft);
+	} else {
+		subtree_split(avl, N(root).link[0], child_height(avl, root, height, 0), key, inclusive, left, hleft, &part, &hpart);
+		*right = subtree_join(avl, part, hpart, root, N(root).link[1], child_height(avl, root, height, 1), hright);
+	}
+}
+
+/* Join trees where every key in 'left' is less than every key in 'right'; smallest node of 'right' is split off as middle. */
+static ref_t subtree_join_adjacent(avl_t *avl, ref_t left, int hleft, ref_t right, int hright, int *height) {
+	ref_t	middle;
+	int		hmiddle;
+
+	if(right == NIL) {
+		*height = hleft;
+		return left;
+	}
+	for(middle = right; N(middle).link[0] != NIL; middle = N(middle).link[0]);
+
+	subtree_split(avl, right, hright, N(middle).key, 1, &middle, &hmiddle, &right, &hright);
+
+	return subtree_join(avl, left, hleft, middle, right, hright, height);
+}
+
+/* Unlink and destroy every node in subtree, and return number of nodes. Subtree is balanced, so recursion is shallow. */
+static int subtree_destroy(avl_t *avl, ref_t root, freefunc_t freekey, freefunc_t freeitem) {
+	int num;
+
+	if(root == NIL) {
+		return 0;
+	}
+	num = 1 + subtree_destroy(avl, N(root).link[0], freekey, freeitem) + subtree_destroy(avl, N(root).link[1], freekey, freeitem);
+
+	sequence_unlink(avl, root);
+	node_destroy(avl, root, freekey, freeitem);
+
+	return num;
+}
+
+int avl_remove_range(avl_t *avl, void *lo, void *hi, freefunc_t freekey, freefunc_t freeitem) {
+	ref_t	left, middle, right;
+	int		hleft, hmiddle, hright, height, removed;
+
+	if( (avl->root == NIL) || (avl->cmpfunc(lo, hi) > 0) ) {
+		return 0;
+	}
+	avl->spinelen = 0;
+
+	subtree_split(avl, avl->root, tree_height(avl, avl->root), lo, 0, &left, &hleft, &middle, &hmiddle);
+	subtree_split(avl, middle, hmiddle, hi, 1, &middle, &hmiddle, &right, &hright);
+
+	removed = subtree_destroy(avl, middle, freekey, freeitem);
+
+	avl->root = subtree_join_adjacent(avl, left, hleft, right, hright, &height);
+	avl->children -= removed;
+
+	return removed;
+}
+
+/* AVL Search: */
+void *avl_search(avl_t *avl, void *key) {
+	ref_t	current;
+	int		cmp;
+
+	current = avl->root;
+
+	while(current != NIL) {
+		cmp = avl->cmpfunc(key, N(current).key);
+
+		if(cmp == 0) {
+			return N(current).item;
+		}
+		current = N(current).link[cmp > 0];
+	}
+	return NULL;
+}
+
+/* AVL Search Many: */
+/* Lookups in group advance one step per turn in round-robin, and prefetch what their next turn reads;
+ * cache-misses of up to SEARCH_GROUP independent descents overlap in stead of stalling one after another.
+ * Each lookup alternates between loading key of node, and comparing and moving to child. */
+void avl_search_many(avl_t *avl, void **keys, void **items, int num) {
+	ref_t	current[SEARCH_GROUP];
+	int		index[SEARCH_GROUP];		/* Index of key searched for in slot, or -1 when slot is free. */
+	char	keyloaded[SEARCH_GROUP];
+	int		next, active, cmp;
+
+	if(avl->root == NIL) {
+		for(int i = 0; i < num; i++) {
+			items[i] = NULL;
+		}
+		return;
+	}
+	for(int s = 0; s < SEARCH_GROUP; s++) {
+		index[s] = -1;
+	}
+	next = active = 0;
+
+	while( (active > 0) || (next < num) ) {
+		for(int s = 0; s < SEARCH_GROUP; s++) {
+			if(index[s] < 0) {
+				if(next == num) {
+					continue;
+				}
+				/* Start next lookup at root. */
+				index[s]		= next;
+				items[next]		= NULL;
+				current[s]		= avl->root;
+				keyloaded[s]	= 0;
+				__builtin_prefetch(keys[next]);
+				next++;
+				active++;
+				continue;
+			}
+			if(!keyloaded[s]) {
+				__builtin_prefetch(N(current[s]).key);
+				keyloaded[s] = 1;
+				continue;
+			}
+			cmp = avl->cmpfunc(keys[index[s]], N(current[s]).key);
+
+			if(cmp == 0) {
+				items[index[s]] = N(current[s]).item;
+				index[s] = -1;
+				active--;
+				continue;
+			}
+			current[s] = N(current[s]).link[cmp > 0];
+
+			if(current[s] == NIL) {
+				index[s] = -1;
+				active--;
+				continue;
+			}
+			__builtin_prefetch(&N(current[s]));
+			keyloaded[s] = 0;
+		}
+	}
+}
+
+/* AVL Sort: */
+static ref_t split(avl_t *avl, ref_t head) {
+	ref_t slow, fast, ndhead;
+
+	slow = head;
+	fast = N(head).next;
+
+	while( (fast != NIL) && (N(fast).next != NIL) ) {
+		slow = N(slow).next;
+		fast = N(N(fast).next).next;
+	}
+	ndhead = N(slow).next;
+	N(slow).next = NIL;
+
+	return ndhead;
+}
+
+static ref_t merge(avl_t *avl, ref_t a, ref_t b) {
+	ref_t head, tail;
+
+	if(avl->cmpfunc(N(a).key, N(b).key) < 0) {
+		head = a;
+		a = N(a).next;
+	} else {
+		head = b;
+		b = N(b).next;
+	}
+	tail = head;
+
+	while( (a != NIL) && (b != NIL) ) {
+		if(avl->cmpfunc(N(a).key, N(b).key) < 0) {
+			N(tail).next = a;
+			a = N(a).next;
+		} else {
+			N(tail).next = b;
+			b = N(b).next;
+		}
+		tail = N(tail).next;
+	}
+
+	N(tail).next = (a == NIL) ? b : a;
+
+	return head;
+}
+
+static ref_t _mergesort(avl_t *avl, ref_t head) {
+	ref_t ndhead;
+
+	if( (head == NIL) || (N(head).next == NIL) ) {
+		return head;
+	}
+	ndhead = split(avl, head);
+
+	head = _mergesort(avl, head);
+	ndhead = _mergesort(avl, ndhead);
+
+	return merge(avl, head, ndhead);
+}
+
+void avl_sort(avl_t *avl) {
+	ref_t prev;
+
+	if(avl->children < 2) {
+		return;
+	}
+	avl->head = _mergesort(avl, avl->head);
+
+	/* Mergesort only follows 'next'; restore 'prev'. */
+	prev = NIL;
+	for(ref_t current = avl->head; current != NIL; current = N(current).next) {
+		N(current).prev = prev;
+		prev = current;
+	}
+}
+
+/* AVL Print: */
+static void _avl_print(avl_t *avl, ref_t current, plot_t *plot, strfunc_t strfunc) {
+	static long int NULL_ID = 2;
+	ref_t child;
+
+	if(current == NIL) {
+		return;
+	}
+
+	for(int dir = 0; dir < 2; dir++) {
+		child = N(current).link[dir];
+
+		if(child != NIL) {
+			plot_addlink2(plot, &N(current), &N(child), strfunc(N(current).item), strfunc(N(child).item), "white", "white");
+
+			_avl_print(avl, child, plot, strfunc);
+		} else {
+			plot_addlink2(plot, &N(current), (void*)NULL_ID++, strfunc(N(current).item), "NULL", "white", "white");
+		}
+	}
+}
+
+void avl_print(avl_t *avl, char *pdfname, strfunc_t strfunc) {
+	plot_t *plot;
+
+	plot = plot_create(pdfname);
+
+	_avl_print(avl, avl->root, plot, strfunc);
+
+	plot_doplot(plot);
+
+	plot_destroy(plot);
+}
+
+
+/* AVL Iteration */
+/* Iterator Structure: */
+struct avl_iterator {
+	avl_t	*avl;
+	ref_t	current;
+};
+
+/* AVL Create Iterator: */
+avl_iterator_t *avl_createiterator(avl_t *avl) {
+	avl_iterator_t *iterator;
+
+	iterator = malloc(sizeof(avl_iterator_t));
+	if(iterator == NULL) {
+		fatal_error("Out of memory.");
+	}
+	iterator->avl = avl;
+	iterator->current = avl->head;
+
+	return iterator;
+}
+
+/* AVL Destroy Iterator: */
+void avl_destroyiterator(avl_iterator_t *iterator) {
+	free(iterator);
+}
+
+/* AVL Has Next: */
+int avl_hasnext(avl_iterator_t *iterator) {
+	if(iterator->current == NIL) {
+		return 0;
+	}
+	return 1;
+}
+
+/* AVL Next: */
+void *avl_next(avl_iterator_t *iterator) {
+	avl_t	*avl;
+	void	*item;
+
+	if(iterator->current == NIL) {
+		return NULL;
+	}
+	avl = iterator->avl;
+
+	item = N(iterator->current).item;
+
+	iterator->current = N(iterator->current).next;
+
+	return item;
+}
+
+/* AVL Reset Iterator: */
+void avl_resetiterator(avl_iterator_t *iterator) {
+	iterator->current = iterator->avl->head;
+}
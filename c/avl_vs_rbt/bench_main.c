@@ -1,22 +1,42 @@
 /* Author: Marius Ingebrigtsen */
 
-#include <math.h>
-
 #include "../common.h"
-#include "../gettime.h"
+#include "../bench.h"
 #include "../graph.h"
 #include "../avl/avl.h"
 #include "../rbt/rbt.h"
 
 #define START 1024			/* 2^10 */
 #define MAXELEM 1048576 + 1	/* 2^20 + 1 */
-#define REPEAT 10
 
 typedef struct data {
 	int *key, *item;
 } data_t;
 
-typedef int (*insertfunc_t)(void *interface, void *key, void *item);
+/* Operations of tree benchmarked, so AVL and RBT share same trials. */
+typedef struct tree_ops {
+	char	*name;
+	void	*(*create)(cmpfunc_t cmpfunc);
+	int		(*insert)(void *tree, void *key, void *item);
+	void	*(*search)(void *tree, void *key);
+	void	(*destroy)(void *tree, freefunc_t freekey, freefunc_t freeitem);
+} tree_ops_t;
+
+/* State of one trial, passed to setup, trial and teardown by harness. */
+typedef struct trial {
+	tree_ops_t	*ops;
+	void		*tree;
+	data_t		*data;
+	int			elem;
+} trial_t;
+
+static tree_ops_t avl_ops = {
+	"AVL", (void*)avl_create, (void*)avl_insert, (void*)avl_search, (void*)avl_destroy
+};
+
+static tree_ops_t rbt_ops = {
+	"RBT", (void*)rbt_create, (void*)rbt_insert, (void*)rbt_search, (void*)rbt_destroy
+};
 
 
 static int cmpint(int *a, int *b) {
@@ -39,216 +59,80 @@ static data_t *data_create(int num) {
 	return data;
 }
 
-static data_t *insert_avl_data(avl_t *avl, int elem) {
-	data_t *data;
-
-	data = data_create(elem);
-
-	for(int i = 0; i < elem; i++) {
-		if(!avl_insert(avl, data[i].key, data[i].item)) {
-			fatal_error("Duplicate insert.");
-		}
-	}
-	return data;
+static void setup_empty(trial_t *trial) {
+	trial->tree = trial->ops->create( (cmpfunc_t)cmpint );
+	trial->data = data_create(trial->elem);
 }
 
-static data_t *insert_rbt_data(rbt_t *rbt, int elem) {
-	data_t *data;
-
-	data = data_create(elem);
+static void setup_filled(trial_t *trial) {
+	setup_empty(trial);
 
-	for(int i = 0; i < elem; i++) {
-		if(!rbt_insert(rbt, data[i].key, data[i].item)) {
+	for(int i = 0; i < trial->elem; i++) {
+		if(!trial->ops->insert(trial->tree, trial->data[i].key, trial->data[i].item)) {
 			fatal_error("Duplicate insert.");
 		}
 	}
-	return data;
 }
 
-static void assert_avl_inserts(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE	*f;
-	avl_t	*avl;
-	data_t	*data;
-
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Couldn't open file; %s. ", bnch_file);
-	}
-	fprintf(f, "# AVL Insert Benchmarks \n# Elements, Time (microsec. on average of %d trials with corresponding nr. of elements) \n", REPEAT);
-
-	average = 0;
-
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
-		
-		sum = 0;
-
-		for(int r = 0; r < REPEAT; r++) {
-
-			printf("AVL-Insert: elements \'%d\' - repeat \'%d\'\n", elem, r+1);
-
-			avl = avl_create( (cmpfunc_t)cmpint );
-			data = data_create(elem);
-
-			t1 = gettime();
-			for(int i = 0; i < elem; i++) {
-				avl_insert(avl, data[i].key, data[i].item);
-			}
-			t2 = gettime();
-
-			sum += t2 - t1;
-
-			free(data);
-			avl_destroy(avl, free, free);
-		}
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
-		
-		average += sum / REPEAT;
-	}
-	num_elem_set = ceil(log2(MAXELEM) - log2(START));
-	fprintf(f, "\n# Overall average of %d trials for each set of elements: \n# %d \n", REPEAT, (int)(average / num_elem_set));
-
-	fclose(f);
+static void teardown(trial_t *trial) {
+	free(trial->data);
+	trial->ops->destroy(trial->tree, free, free);
 }
 
-static void assert_rbt_inserts(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE	*f;
-	rbt_t	*rbt;
-	data_t	*data;
-
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Could not open file; \"%s\"",  bnch_file);
+static void trial_insert(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		trial->ops->insert(trial->tree, trial->data[i].key, trial->data[i].item);
 	}
-	fprintf(f, "# RBT Insert Benchmarks \n# Elements, Time (microsec. on average of %d trials with corresponding nr. of elements) \n", REPEAT);
-
-	average = 0;
-
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
-		
-		sum = 0;
-
-		for(int r = 0; r < REPEAT; r++) {
-
-			printf("RBT-Insert: elements \'%d\' - repeat \'%d\'\n", elem, r+1);
-
-			rbt = rbt_create( (cmpfunc_t)cmpint );
-			data = data_create(elem);
-
-			t1 = gettime();
-			for(int i = 0; i < elem; i++) {
-				rbt_insert(rbt, data[i].key, data[i].item);
-			}
-			t2 = gettime();
-
-			sum += t2 - t1;
+}
 
-			free(data);
-			rbt_destroy(rbt, free, free);
+static void trial_search(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		if(trial->ops->search(trial->tree, trial->data[i].key) == NULL) {
+			fatal_error("Value not found.");
 		}
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
-		
-		average += sum / REPEAT;
 	}
-	num_elem_set = ceil(log2(MAXELEM) - log2(START));
-	fprintf(f, "\n# Overall average of %d trials for each set of elements: \n# %d \n", REPEAT, (int)(average / num_elem_set));
-
-	fclose(f);
 }
 
-static void assert_avl_search(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE	*f;
-	avl_t	*avl;
-	data_t	*data;
+static void assert_inserts(tree_ops_t *ops, char *bnch_file) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
+	char			*title;
 
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Could not create file; %s.", bnch_file);
-	}
-	fprintf(f, "# AVL Search Benchmarks \n# Elements, Time (microsec. on average of %d trials with corresponding nr. of elements) \n", REPEAT);
+	title	= concatenate_strings(2, ops->name, " Insert Benchmarks");
+	file	= bench_open(bnch_file, title);
 
-	average = 0;
+	trial.ops = ops;
 
 	for(int elem = START; elem < MAXELEM; elem *= 2) {
+		trial.elem = elem;
 
-		sum = 0;
-
-		for(int r = 0; r < REPEAT; r++) {
-
-			printf("AVL-Search: elements \'%d\' - repeat \'%d\'\n", elem, r+1);
-
-			avl = avl_create( (cmpfunc_t)cmpint );
-			data = insert_avl_data(avl, elem);
-
-			t1 = gettime();
-			for(int i = 0; i < elem; i++) {
-				if(avl_search(avl, data[i].key) == NULL) {
-					fatal_error("Value not found.");
-				}
-			}
-			t2 = gettime();
-
-			sum += t2 - t1;
-
-			free(data);
-			avl_destroy(avl, free, free);
-		}
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT));
-
-		average += sum / REPEAT;
+		bench_run(&stats, (benchfunc_t)setup_empty, (benchfunc_t)trial_insert, (benchfunc_t)teardown, &trial, elem);
+		bench_write(file, elem, &stats);
 	}
-	num_elem_set = ceil(log2(MAXELEM) - log2(START));
-
-	fprintf(f, "\n# Overall average of %d trials for each set of elements: \n# %d \n", REPEAT, (int)(average / num_elem_set));
+	bench_close(file);
+	free(title);
 }
 
-static void assert_rbt_search(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE	*f;
-	rbt_t	*rbt;
-	data_t	*data;
+static void assert_search(tree_ops_t *ops, char *bnch_file) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
+	char			*title;
 
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Could not create file; %s.", bnch_file);
-	}
-	fprintf(f, "# RBT Search Benchmarks \n# Elements, Time (microsec. on average of %d trials with corresponding nr. of elements) \n", REPEAT);
+	title	= concatenate_strings(2, ops->name, " Search Benchmarks");
+	file	= bench_open(bnch_file, title);
 
-	average = 0;
+	trial.ops = ops;
 
 	for(int elem = START; elem < MAXELEM; elem *= 2) {
+		trial.elem = elem;
 
-		sum = 0;
-
-		for(int r = 0; r < REPEAT; r++) {
-
-			printf("RBT-Search: elements \'%d\' - repeat \'%d\'\n", elem, r+1);
-
-			rbt = rbt_create( (cmpfunc_t)cmpint );
-			data = insert_rbt_data(rbt, elem);
-
-			t1 = gettime();
-			for(int i = 0; i < elem; i++) {
-				if(rbt_search(rbt, data[i].key) == NULL) {
-					fatal_error("Value not found.");
-				}
-			}
-			t2 = gettime();
-
-			sum += t2 - t1;
-
-			free(data);
-			rbt_destroy(rbt, free, free);
-		}
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT));
-
-		average += sum / REPEAT;
+		bench_run(&stats, (benchfunc_t)setup_filled, (benchfunc_t)trial_search, (benchfunc_t)teardown, &trial, elem);
+		bench_write(file, elem, &stats);
 	}
-	num_elem_set = ceil(log2(MAXELEM) - log2(START));
-
-	fprintf(f, "\n# Overall average of %d trials for each set of elements: \n# %d \n", REPEAT, (int)(average / num_elem_set));
+	bench_close(file);
+	free(title);
 }
 
 static void create_graph(char *insert_avl, char *insert_rbt, char *search_avl, char *search_rbt) {
@@ -257,21 +141,21 @@ static void create_graph(char *insert_avl, char *insert_rbt, char *search_avl, c
 
 	g = graph_create("AVL_vs_RBT_Insert");
 
-	graph_axislabel(g, "Elements", "Microsec.");
+	graph_axislabel(g, "Elements", "Nanosec. per operation (median)");
 
-	data[0].csf		= insert_avl;
+	data[0].csv		= insert_avl;
 	data[0].name	= "AVL-Insert";
 
-	data[1].csf		= insert_rbt;
+	data[1].csv		= insert_rbt;
 	data[1].name	= "RBT-Insert";
 
 	graph_newplot(g, "AVL- vs. RBT-Insert", data, 2);
 
-	data[0].csf		= search_avl;
-	data[0].name	= "AVL-Insert";
+	data[0].csv		= search_avl;
+	data[0].name	= "AVL-Search";
 
-	data[1].csf		= search_rbt;
-	data[1].name	= "RBT-Insert";
+	data[1].csv		= search_rbt;
+	data[1].name	= "RBT-Search";
 
 	graph_newplot(g, "AVL- vs. RBT-Search", data, 2);
 
@@ -288,16 +172,16 @@ int main(int argc, char **argv) {
 	}
 
 	printf("\nAsserting AVL-Insert...\n");
-	assert_avl_inserts(argv[1]);
+	assert_inserts(&avl_ops, argv[1]);
 
 	printf("\nAsserting RBT-Insert...\n");
-	assert_rbt_inserts(argv[2]);
+	assert_inserts(&rbt_ops, argv[2]);
 
 	printf("\nAsserting AVL-Search...\n");
-	assert_avl_search(argv[3]);
+	assert_search(&avl_ops, argv[3]);
 
 	printf("\nAsserting RBT-Search...\n");
-	assert_rbt_search(argv[4]);
+	assert_search(&rbt_ops, argv[4]);
 
 	printf("\nConstructing graph...\n");
 	create_graph(argv[1], argv[2], argv[3], argv[4]);
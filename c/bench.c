@@ -0,0 +1,283 @@
+/* Author: Marius Ingebrigtsen */
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+
+#define REPEAT	10
+#define WARMUP	1
+
+/* Results-file Structure: */
+struct bench_file {
+	FILE	*f;
+	char	*title;
+	double	sum;
+	int		json, rows;
+};
+
+/* Configuration, read from environment on first run. 'perf' is NULL if hardware events are not counted. */
+static int		configured = 0, repeat = REPEAT, warmup = WARMUP;
+static perf_t	*perf = NULL;
+
+/* Counts of threads created by current trial, summed by 'bench_thread_stop()'; -1 once a thread is not counted. */
+static pthread_mutex_t	lock = PTHREAD_MUTEX_INITIALIZER;
+static perf_counts_t	threads;
+
+
+/* Bench Time: */
+unsigned long long bench_time(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Bench Configure: */
+static int env_integer(const char *name, int otherwise) {
+	char *value = getenv(name);
+
+	return ( (value != NULL) && (*value != '\0') ) ? atoi(value) : otherwise;
+}
+
+static void bench_configure(void) {
+	cpu_set_t	set;
+	int			cpu;
+
+	configured	= 1;
+	repeat		= env_integer("BENCH_REPEAT", REPEAT);
+	warmup		= env_integer("BENCH_WARMUP", WARMUP);
+	cpu			= env_integer("BENCH_CPU", -1);
+
+	if(repeat < 1) {
+		fatal_error("BENCH_REPEAT must be at least 1; \'%d\'. ", repeat);
+	}
+	warmup = (warmup < 0) ? 0 : warmup;
+
+	if(cpu >= 0) {
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		if(sched_setaffinity(0, sizeof(set), &set) != 0) {
+			fatal_error("Couldn't pin to processor \'%d\'. ", cpu);
+		}
+	}
+
+	if(env_integer("BENCH_COUNTERS", 1)) {
+		perf = perf_create();
+		if(perf == NULL) {
+			fprintf(stderr, "Hardware counters unavailable; benchmarking without. \n");
+		}
+	}
+}
+
+int bench_repeat(void) {
+	if(!configured) {
+		bench_configure();
+	}
+	return repeat;
+}
+
+/* Bench Statistics: */
+static int cmpdouble(const void *a, const void *b) {
+	double x = *(const double*)a, y = *(const double*)b;
+
+	return (x > y) - (x < y);
+}
+
+void bench_stats(double *samples, int num, bench_stats_t *stats) {
+	double sum = 0, dev = 0;
+
+	qsort(samples, num, sizeof(double), cmpdouble);
+
+	for(int i = 0; i < num; i++) {
+		sum += samples[i];
+	}
+	stats->mean = sum / num;
+
+	for(int i = 0; i < num; i++) {
+		dev += (samples[i] - stats->mean) * (samples[i] - stats->mean);
+	}
+	stats->stddev	= (num > 1) ? sqrt(dev / (num - 1)) : 0;
+	stats->median	= (num % 2) ? samples[num / 2] : (samples[num / 2 - 1] + samples[num / 2]) / 2;
+	stats->p99		= samples[(int)ceil(0.99 * num) - 1];	/* Nearest rank. */
+	stats->min		= samples[0];
+	stats->trials	= num;
+
+	for(perf_event_t e = 0; e < PERF_NUMEVENTS; e++) {
+		stats->counters[e] = -1;
+	}
+}
+
+/* Bench Thread Start: */
+perf_t *bench_thread_start(void) {
+	perf_t *counters;
+
+	if(perf == NULL) {
+		return NULL;
+	}
+	counters = perf_create();
+	if(counters != NULL) {
+		perf_start(counters);
+	}
+	else {
+		pthread_mutex_lock(&lock);
+		for(perf_event_t e = 0; e < PERF_NUMEVENTS; e++) {
+			threads.count[e] = -1;
+		}
+		pthread_mutex_unlock(&lock);
+	}
+	return counters;
+}
+
+/* Bench Thread Stop: */
+void bench_thread_stop(perf_t *counters) {
+	perf_counts_t counts;
+
+	if(counters == NULL) {
+		return;
+	}
+	perf_stop(counters, &counts);
+	perf_destroy(counters);
+
+	pthread_mutex_lock(&lock);
+	for(perf_event_t e = 0; e < PERF_NUMEVENTS; e++) {
+		threads.count[e] = ( (threads.count[e] < 0) || (counts.count[e] < 0) ) ? -1 : threads.count[e] + counts.count[e];
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+/* Bench Run: */
+void bench_run(bench_stats_t *stats, benchfunc_t setup, benchfunc_t trial, benchfunc_t teardown, void *arg, long ops) {
+	unsigned long long t1, t2;
+	perf_counts_t	counts;
+	double			*samples, sum[PERF_NUMEVENTS];
+
+	if(!configured) {
+		bench_configure();
+	}
+	samples = malloc(sizeof(double) * repeat);
+	if(samples == NULL) {
+		fatal_error("Out of memory.");
+	}
+	for(perf_event_t e = 0; e < PERF_NUMEVENTS; e++) {
+		sum[e] = 0;
+	}
+
+	for(int r = -warmup; r < repeat; r++) {
+		if(setup != NULL) {
+			setup(arg);
+		}
+		if(perf != NULL) {
+			memset(&threads, 0, sizeof(perf_counts_t));
+			perf_start(perf);
+		}
+		t1 = bench_time();
+		trial(arg);
+		t2 = bench_time();
+
+		if(perf != NULL) {
+			perf_stop(perf, &counts);
+		}
+		if(r >= 0) {
+			samples[r] = (double)(t2 - t1) / ops;
+
+			for(perf_event_t e = 0; (perf != NULL) && (e < PERF_NUMEVENTS); e++) {	/* Not counted in any trial spoils sum. */
+				sum[e] = ( (sum[e] < 0) || (counts.count[e] < 0) || (threads.count[e] < 0) ) ? -1 : sum[e] + counts.count[e] + threads.count[e];
+			}
+		}
+		if(teardown != NULL) {
+			teardown(arg);
+		}
+	}
+	bench_stats(samples, repeat, stats);
+
+	for(perf_event_t e = 0; (perf != NULL) && (e < PERF_NUMEVENTS); e++) {
+		stats->counters[e] = (sum[e] < 0) ? -1 : sum[e] / ((double)ops * repeat);
+	}
+	free(samples);
+}
+
+/* Bench Open: */
+bench_file_t *bench_open(const char *path, const char *title) {
+	bench_file_t	*file;
+	size_t			len = strlen(path);
+
+	file = calloc(1, sizeof(bench_file_t));
+	if(file == NULL) {
+		fatal_error("Out of memory.");
+	}
+	file->f = fopen(path, "w");
+	if(file->f == NULL) {
+		fatal_error("Couldn't open file; %s. ", path);
+	}
+	file->title	= strdup(title);
+	file->json	= (len >= 5) && (strcmp(path + len - 5, ".json") == 0);
+
+	if(file->json) {
+		fprintf(file->f, "{\n\t\"title\": \"%s\",\n\t\"unit\": \"ns/op\",\n\t\"trials\": %d,\n\t\"results\": [", title, bench_repeat());
+	}
+	else {
+		fprintf(file->f, "# %s \n# Elements, Median, Mean, 99th Percentile, Standard Deviation, Minimum (nanosec. per operation of %d trials)", title, bench_repeat());
+
+		for(perf_event_t e = 0; (perf != NULL) && (e < PERF_NUMEVENTS); e++) {
+			fprintf(file->f, ", %s", perf_name(e));
+		}
+		fprintf(file->f, "%s \n", (perf != NULL) ? " (per operation; -1 if not counted)" : "");
+	}
+	return file;
+}
+
+/* Bench Write: */
+void bench_write(bench_file_t *file, long x, bench_stats_t *stats) {
+	if(file->json) {
+		fprintf(file->f, "%s\n\t\t{ \"elements\": %ld, \"median\": %.2f, \"mean\": %.2f, \"p99\": %.2f, \"stddev\": %.2f, \"min\": %.2f",
+				(file->rows > 0) ? "," : "", x, stats->median, stats->mean, stats->p99, stats->stddev, stats->min);
+
+		for(perf_event_t e = 0; (perf != NULL) && (e < PERF_NUMEVENTS); e++) {
+			fprintf(file->f, ", \"%s\": %.3f", perf_name(e), stats->counters[e]);
+		}
+		fprintf(file->f, " }");
+	}
+	else {
+		fprintf(file->f, "%ld, %.2f, %.2f, %.2f, %.2f, %.2f", x, stats->median, stats->mean, stats->p99, stats->stddev, stats->min);
+
+		for(perf_event_t e = 0; (perf != NULL) && (e < PERF_NUMEVENTS); e++) {
+			fprintf(file->f, ", %.3f", stats->counters[e]);
+		}
+		fprintf(file->f, "\n");
+	}
+	fflush(file->f);
+
+	printf("%s: elements \'%ld\' - median %.2f, p99 %.2f, stddev %.2f nanosec. per operation \n", file->title, x, stats->median, stats->p99, stats->stddev);
+
+	for(perf_event_t e = 0; (perf != NULL) && (e < PERF_NUMEVENTS); e++) {
+		if(stats->counters[e] >= 0) {
+			printf("\t%s: %.3f per operation \n", perf_name(e), stats->counters[e]);
+		}
+	}
+
+	file->sum += stats->median;
+	file->rows++;
+}
+
+/* Bench Close: */
+void bench_close(bench_file_t *file) {
+	double average = (file->rows > 0) ? file->sum / file->rows : 0;
+
+	if(file->json) {
+		fprintf(file->f, "\n\t],\n\t\"average\": %.2f\n}\n", average);
+	}
+	else {
+		fprintf(file->f, "\n# Overall average of medians for each set of elements: \n# %.2f \n", average);
+	}
+	if(fclose(file->f) != 0) {
+		fatal_error("Could not close results-file of \'%s\'. ", file->title);
+	}
+	free(file->title);
+	free(file);
+}
@@ -0,0 +1,72 @@
+/* Author: Marius Ingebrigtsen */
+#ifndef __BENCH_H_
+#define __BENCH_H_
+
+#include "common.h"
+#include "perf.h"
+
+/* Benchmark Harness.
+ * A timed function is run for some warmup trials, then for some repeated trials, each timed in nanoseconds by
+ * 'CLOCK_MONOTONIC_RAW', which is not slewed by NTP, and divided by number of operations done by trial.
+ * Timing a trial of many operations, rather than each operation, measures operations far shorter than the timer resolution.
+ * Trials are reported by median, mean, 99th percentile, standard deviation and minimum, so outliers are seen, not averaged away.
+ *
+ * Harness is configured by environment variables, read on first run:
+ * BENCH_REPEAT   - Number of timed trials; 10 by default.
+ * BENCH_WARMUP   - Number of untimed trials before timed trials; 1 by default.
+ * BENCH_CPU      - Processor to pin benchmark to, so it doesn't migrate between caches; not pinned by default.
+ *                  Threads created after pinning inherit it, so leave unset for parallel benchmarks.
+ * BENCH_COUNTERS - Set to 0 to opt not to count hardware events of trials with 'perf.h'; counted by default, if available.
+ *                  Counters are started before and stopped after clock is read, so they don't add to time of trial.
+ *                  Counters count calling thread only; threads created by trial are counted by 'bench_thread_start()'. */
+
+/* Function-pointer for setup, trial or teardown, called with argument given to 'bench_run()'. */
+typedef void (*benchfunc_t)(void *arg);
+
+/* Statistics of trials, in nanoseconds per operation.
+ * 'counters' are hardware events per operation of timed trials, indexed by 'perf_event_t'; -1 if not counted. */
+typedef struct bench_stats {
+	double	median, mean, p99, stddev, min;
+	double	counters[PERF_NUMEVENTS];
+	int		trials;
+} bench_stats_t;
+
+/* Results-file of one series. */
+typedef struct bench_file bench_file_t;
+
+
+/* Return current time in nanoseconds. */
+unsigned long long bench_time(void);
+
+/* Return number of timed trials per run. */
+int bench_repeat(void);
+
+/* Compute statistics of 'num' samples into 'stats', with no counters. Samples are sorted. */
+void bench_stats(double *samples, int num, bench_stats_t *stats);
+
+/* Run 'trial(arg)' for warmup and timed trials, and put statistics into 'stats'.
+ * 'setup(arg)' is called before and 'teardown(arg)' after every trial, untimed; pass NULL to opt not to.
+ * 'ops' is number of operations done by one trial, and time of trial is divided by it. */
+void bench_run(bench_stats_t *stats, benchfunc_t setup, benchfunc_t trial, benchfunc_t teardown, void *arg, long ops);
+
+/* Open and start counters of calling thread, if harness counts; call first in thread created by trial.
+ * Return NULL if not counted. Opening counters is a few system calls, timed as part of trial. */
+perf_t *bench_thread_start(void);
+
+/* Stop and close counters of 'bench_thread_start()', and add counts to those of current trial; call last in thread.
+ * Thread must stop before trial returns, i.e. be joined by it. Trial is not counted if any of its threads failed to open counters. */
+void bench_thread_stop(perf_t *counters);
+
+/* Create results-file at path for series with title, and write header.
+ * File is JSON if path ends with ".json"; else comma-separated values, one row per set of elements:
+ * Elements, Median, Mean, 99th Percentile, Standard Deviation, Minimum, followed by hardware events per operation if counted.
+ * Median is 2nd column, so 'graph.c' plots median with no further arguments. */
+bench_file_t *bench_open(const char *path, const char *title);
+
+/* Write statistics of set of 'x' elements to results-file, and print them. */
+void bench_write(bench_file_t *file, long x, bench_stats_t *stats);
+
+/* Write overall average of medians, and close results-file. */
+void bench_close(bench_file_t *file);
+
+#endif
@@ -1,6 +1,7 @@
 /* Author: Marius Ingebrigtsen */
 
 #include "common.h"
+#include "vector/vector.h"
 
 #include <string.h>
 #include <math.h>
@@ -10,9 +11,6 @@
 #include <sys/stat.h>
 #include <dirent.h>
 
-/* Init-calloc size for tokenize_file(). */
-#define INITSIZE 1024
-
 /* Typedef's for general and use in source file. */
 typedef struct dirent dirent_t;
 typedef struct stat stat_t;
@@ -36,22 +34,17 @@ void fatal_error(char *errmsg, ...) {
 
 char **tokenize_file(const char *file, int *n) {
 	FILE *f;
-	char **words, word[128+1];
-	int i, size;
+	vector_t *words;
+	char *w, word[128+1];
+	int i;
 
 	f = fopen(file, "r");
 	if(f == NULL) {
 		fatal_error("Couldn't open file; \'%s\'. ", file);
 	}
 
-	/* Allocate initial size, with possible resizal. */
-	size = INITSIZE;
-	words = calloc(size, sizeof(char*));
-	if(words == NULL) {
-		fatal_error("Out of memory.");
-	}
-
-	/* Append words into array. */
+	/* Append words into vector. */
+	words = vector_create(NULL);
 	for(i = 0; !feof(f); i++) {
 		/* Ignore other than [a-zA-Z0-9]. */
 		fscanf(f, "%*[^a-zA-Z0-9]");
@@ -69,55 +62,26 @@ char **tokenize_file(const char *file, int *n) {
 			*c = (char)tolower(*c);
 		}
 
-		/* Dynamically reallocate array. */
-		if(i >= size) {
-			size *= 2;
-			words = realloc(words, sizeof(char*) * size);
-			if(words == NULL) {
-				fatal_error("Out of memory.");
-			}
-		}
-
-		/* Assign word into array. */
-		words[i] = strdup(word);
-		if(words[i] == NULL) {
+		/* Assign word into vector. */
+		w = strdup(word);
+		if(w == NULL) {
 			fatal_error("Out of memory.");
 		}
+		vector_append(words, w);
 	}
 	if(fclose(f) < 0) {
 		fatal_error("Unable to close file; \'%s\'. ", file);
 	}
 
-	/* Resize array to fit number of words, plus NULL terminator. */
-	words = realloc(words, sizeof(char*) * (i+1));
-	if(words == NULL) {
-		fatal_error("Out of memory.");
-	}
-	/* NULL terminate array. */
-	words[i] = NULL;
+	/* NULL terminate array, which is released shrunk to fit. */
+	vector_append(words, NULL);
 
 	/* Assign number of words if option taken. */
 	if(n != NULL) {
 		*n = i;
 	}
 
-	return words;
-
-	/* Count number of words in 'file'. */
-	/* Initialize word-count; for as long as end-of-file is not reached; increment word-count. */
-	for(i = 0; !feof(f); i++) {
-		fscanf(f, "%*[^a-zA-Z0-9]");/* Read and increment file-pointer until characters [a-zA-Z0-9] are encountered. */
-		fscanf(f, "%*[a-zA-Z0-9]");	/* Read upto 128 characters, or until other than [a-zA-Z0-9] is encountered. Ignore all and only increment file-pointer. */
-	}
-	/* Allocate return-array. 
-	 * i-number of char*'s, +1 for NULL terminator. */
-	words = calloc(sizeof(char*), i + 1); 
-	if(words == NULL) {
-		fatal_error("Out of memory.");
-	}
-
-	/* Reset file-pointer to start of file. */
-	rewind(f);
+	return (char**)vector_release(words);
 }
 
 void tokenize_destroy(char **words) {
@@ -165,8 +129,8 @@ static int isdir(const dirent_t *dir) {
 	return 0;
 }
 
-static int _find_files(char ***files, int entries, const char *reldir) {
-	int		numfiles, numdirs, i, end;
+static void _find_files(vector_t *files, const char *reldir) {
+	int		numfiles, numdirs, i;
 	char	*path;
 	dirent_t**filelist, **dirlist;
 
@@ -187,26 +151,13 @@ static int _find_files(char ***files, int entries, const char *reldir) {
 		fatal_error("Unable to scan directory; \'%s\', in function \'%s\'. ", reldir, __func__);
 	}
 
-	/* Allocate space for new file-entries. */
-	if(numfiles > 0) {
-		*files = realloc(*files, sizeof(char*) * (entries + numfiles));
-		if(*files == NULL) {
-			fatal_error("Unable to re-allocate memory in function %s. ", __func__);
-		}
-	}
-
-	/* Append files found in directory, and increment entry count. 
-	 * 'i' is index for 'filelist'.
-	 * 'entries' used for indexing 'files'. */
-	for(i = 0, end = entries + numfiles;
-		entries < end;
-		i++, entries++) {
+	/* Append files found in directory; vector grows geometrically, in stead of by 'numfiles' for each directory. */
+	for(i = 0; i < numfiles; i++) {
 		
 		/* dir + 1 to skip initial '.'-character. */
 		path = concatenate_strings(3, reldir + 1, "/", filelist[i]->d_name);
 	
-		/* Beware: '[i]' occurs before '*'! */
-		(*files)[entries] = path;
+		vector_append(files, path);
 
 		/* Deallocate entry struct made by scandir. 
 		 * NOTE: 'filelist[i]->d_name' is not allocated memory, but static string of file- or folder-name. */
@@ -225,7 +176,7 @@ static int _find_files(char ***files, int entries, const char *reldir) {
 		if(chdir(dirlist[i]->d_name) < 0) {
 			fatal_error("Unable to change cwd to directory; \'%s\', in function; \'%s\'. \n", dirlist[i]->d_name, __func__);
 		}
-		entries = _find_files(files, entries, path);
+		_find_files(files, path);
 		if(chdir("..") < 0) {
 			fatal_error("Unable to revert cwd back to parent directory from cwd; \'%s\', in function; \'%s\'. \n", dirlist[i]->d_name, __func__);
 		}
@@ -234,69 +185,52 @@ static int _find_files(char ***files, int entries, const char *reldir) {
 		free(dirlist[i]);
 	}
 	free(dirlist);
-
-	return entries;
 }
 
 char **recursive_find_files(const char *rootdir, int *n) {
-	char **files, cwd[512];
-	int entries;
+	vector_t *files;
+	char cwd[512];
 
 	/* Store cwd for switching back later. */
 	if(getcwd(cwd, sizeof(cwd)) == NULL) {
 		fatal_error("Unable to fetch current working directory in function: %s", __func__);
 	}
 
-	entries = 0;
-	/* Initialize empty return-array for dynamic reallocation. */
-	files = calloc(entries, sizeof(char*));
-	if(files == NULL) {
-		fatal_error("Out of memory in function %s. ", __func__);
-	}
+	files = vector_create(NULL);
 
 	/* Change working directory to argument path. */
 	if(chdir(rootdir) < 0) {
 		fatal_error("Unable to change directory to; \'%s\'. \n", rootdir);
 	}
 
-	/* Traverse directories, add all files to array, and return number of entries. */
-	entries = _find_files(&files, entries, ".");
-
-	/* Make space for NULL terminator. */
-	files = realloc(files, sizeof(char*) * (entries + 1));
-	if(files == NULL) {
-		fatal_error("Unable to reallocate memory to size %d. ", sizeof(char*) * (entries + 1));
-	}
-	files[entries] = NULL;
+	/* Traverse directories, and add all files to vector. */
+	_find_files(files, ".");
 
 	/* Assign number of entries if optional argument provided. */
 	if(n != NULL) {
-		*n = entries;
+		*n = vector_size(files);
 	}
+	vector_append(files, NULL);
 
 	/* Reset working directory as was. */
 	if(chdir(cwd) < 0) {
 		fatal_error("Unable to revert cwd from \'%s\' back to \'%s\'. \n", rootdir, cwd);
 	}
 	
-	return files;
+	return (char**)vector_release(files);
 }
 
 char **find_files(const char *rootdir, int *n) {
-	char	**files, *cmd, *line;
+	vector_t *files;
+	char	*cmd, *line;
 	FILE	*f;
-	int		entries, i;
+	int		i;
 	size_t	len;
 
-	/* Initialize return-array with one-slot for dynamic reallocation. */
-	entries = INITSIZE;
-	files = calloc(entries, sizeof(char*));
-	if(files == NULL) {
-		fatal_error("Out of memory in function; \'%s\'. \n", __func__);
-	}
+	files = vector_create(NULL);
 
-	/* Allocate command message. +25 is for static characters in 'sprintf' below. */
-	cmd = calloc(strlen(rootdir) + 25, sizeof(char));
+	/* Allocate command message; static characters of 'sprintf' below, including NUL-terminator. */
+	cmd = calloc(strlen(rootdir) + sizeof("/usr/bin/find  -not -type d"), sizeof(char));
 	if(cmd == NULL) {
 		fatal_error("Out of memory in function; \'%s\'. \n", __func__);
 	}
@@ -327,27 +261,11 @@ char **find_files(const char *rootdir, int *n) {
 		/* Set newline to zero. */
 		line[len-1] = '\0';
 
-		/* Re-size array dynamically. */
-		if(i >= entries) {
-			entries *= 2;
-			files = realloc(files, sizeof(char*) * entries);
-			if(files == NULL) {
-				fatal_error("Out of memory in function; \'%s\'. ", __func__);
-			}
-		}
-
-		/* Assign path to return-array. */
-		files[i] = line;
-		if(files[i] == NULL) {
-			fatal_error("Out of memory in function; \'%s\'. ", __func__);
-		}
-	}
-	/* Fix array sizeof exactly to number of entries plus one for NULL terminator. */
-	files = realloc(files, sizeof(char*) * (i+1));
-	if(files == NULL) {
-		fatal_error("Out of memory in function; \'%s\'. ", __func__);
+		/* Append path to vector. */
+		vector_append(files, line);
 	}
-	files[i] = NULL;
+	/* NULL terminate array, which is released shrunk to fit. */
+	vector_append(files, NULL);
 
 	/* Close file-stream process. */
 	if(pclose(f) != 0) {
@@ -360,7 +278,7 @@ char **find_files(const char *rootdir, int *n) {
 		*n = i;
 	}
 
-	return files;
+	return (char**)vector_release(files);
 }
 
 void find_files_destroy(char **files) {
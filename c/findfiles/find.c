@@ -6,6 +6,9 @@
 #include "../common.h"
 #include "index.h"
 
+/* Results printed for a query; only these are sorted by score. */
+#define RESULTS	20
+
 
 static index_t *make_indexer(const char *rootdir) {
 	index_t	*index;
@@ -169,7 +172,7 @@ static void find(index_t *index, list_t *query) {
 	query_result_t *r;
 	char *errmsg;
 
-	res = index_query(index, query, &errmsg);
+	res = index_query(index, query, RESULTS, &errmsg);
 	if(res == NULL) {
 		printf("ERROR: %s\n", errmsg);
 		return;
@@ -177,11 +180,16 @@ static void find(index_t *index, list_t *query) {
 	
 	iter = list_createiterator(res);
 
-	while( (r = list_next(iter)) ) {
-		printf("File: %s, Score: %f \n", r->path, r->score);
+	for(int i = 0; (r = list_next(iter)); i++) {
+		if(i < RESULTS) {
+			printf("File: %s, Score: %f \n", r->path, r->score);
+		}
 		free(r->path);
 		free(r);
 	}
+	if(list_size(res) > RESULTS) {
+		printf("... and %d more files. \n", list_size(res) - RESULTS);
+	}
 
 	list_destroyiterator(iter);
 	list_destroy(res, NULL);
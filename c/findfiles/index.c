@@ -4,6 +4,8 @@
 #include "set.h"
 #include "lookup3.h"
 #include "query.h"
+#include "../vector/vector.h"
+#include "../quicksort/quicksort.h"
 
 #include <string.h>
 #include <math.h>
@@ -311,6 +313,12 @@ static double tf_idf(index_t *index, list_t *query, char *path, int evaluation_s
 	return tf(index, query, path) * idf(index->corpus, evaluation_size);
 }
 
+/* Results of higher score go first; comparison inlined by 'QUICKSORT_DEFINE()'. */
+#define SCORE_BEFORE(a, b)	( (a)->score > (b)->score )
+
+QUICKSORT_DEFINE(result_sort, query_result_t*, SCORE_BEFORE)
+QUICKSELECT_DEFINE(result_sort, query_result_t*, SCORE_BEFORE)
+
 /* Cmpfunc for sorting query_result_t-list by score, starting higest and decending. */
 static int compare_score(query_result_t *a, query_result_t *b) {
 	if(a->score == b->score) {
@@ -320,13 +328,14 @@ static int compare_score(query_result_t *a, query_result_t *b) {
 	return (a->score < b->score) ? 1 : -1;
 }
 
-static list_t *process_query(index_t *index, set_t *evaluation, list_t *query) {
+static list_t *process_query(index_t *index, set_t *evaluation, list_t *query, int best) {
 	list_t			*query_result;
+	vector_t		*results;
 	set_iterator_t	*iterator;
 	query_result_t	*result;
 	char			*path;
 
-	query_result = list_create( (cmpfunc_t)compare_score );
+	results = vector_create( (cmpfunc_t)compare_score );
 
 	iterator = set_createiterator(evaluation);
 
@@ -341,14 +350,24 @@ static list_t *process_query(index_t *index, set_t *evaluation, list_t *query) {
 		result->path	= strdup(path);
 		result->score	= tf_idf(index, query, path, set_size(evaluation));
 
-		list_addlast(query_result, result);
+		vector_append(results, result);
 	}
 	set_destroyiterator(iterator);
 
+	/* Select 'best' highest scores in linear time, and sort only those. */
+	result_sort_partial_sort( (query_result_t**)vector_array(results), vector_size(results), best );
+
+	query_result = list_create( (cmpfunc_t)compare_score );
+
+	for(int i = 0; i < vector_size(results); i++) {
+		list_addlast(query_result, vector_get(results, i));
+	}
+	vector_destroy(results, NULL);
+
 	return query_result;
 }
 
-list_t *index_query(index_t *index, list_t *query, char **errmsg) {
+list_t *index_query(index_t *index, list_t *query, int best, char **errmsg) {
 	query_t	*parser;
 	set_t	*evaluation;
 	list_t	*query_result;
@@ -374,9 +393,7 @@ list_t *index_query(index_t *index, list_t *query, char **errmsg) {
 		goto error;
 	}
 
-	query_result = process_query(index, evaluation, query);	/* Create list of query_result_t with paths and their calculated tf-idf's. */
-
-	list_sort(query_result);
+	query_result = process_query(index, evaluation, query, best);	/* Create list of query_result_t with paths and their calculated tf-idf's, 'best' first. */
 
 	query_destroy(parser);
 	setlist_delete(delete_list);
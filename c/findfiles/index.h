@@ -42,6 +42,8 @@ void index_print(index_t *index, list_t *words);
 
 /* Perform query on 'index'. 
  * If successful, return-value is list of 'query_result_t*'-items. 
+ * First 'best' items are those of highest score, in descending order; 
+ * the rest follow in no particular order, as they are not sorted. 
  * If query triggers an error, an error-message is put into 'errmsg' 
  * and return-value is NULL. 
  * Each item in return-list contains file-path to matching query, 
@@ -52,6 +54,6 @@ void index_print(index_t *index, list_t *words);
  * These will not be deallocated in 'index_destroy()' and is 
  * responsibility of ADT-user. 
  */
-list_t *index_query(index_t *index, list_t *query, char **errmsg);
+list_t *index_query(index_t *index, list_t *query, int best, char **errmsg);
 
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 /* Author: Marius Ingebrigtsen */
 /* Set-implementation is a Red-Black Tree. */
 #include "set.h"
+#include "../mergesort.h"
 
 
 typedef enum color color_t;
@@ -329,65 +330,10 @@ set_t *set_copy(set_t *set, copyfunc_t copyfunc) {
 }
 
 /* Set Sort: */
-static node_t *split(node_t *head) {
-	node_t *slow, *fast, *ndhead;
-
-	slow = head;
-	fast = head->next;
-
-	while( (fast != NULL) && (fast->next != NULL) ) {
-		slow = slow->next;
-		fast = fast->next->next;
-	}
-	ndhead = slow->next;
-	slow->next = NULL;
-	return ndhead;
-}
-
-static node_t *merge(node_t *a, node_t *b, cmpfunc_t cmpfunc) {
-	node_t	*head, *tail;
-
-	if(cmpfunc(a->item, b->item) < 0) {
-		head = tail = a;
-		a = a->next;
-	} else {
-		head = tail = b;
-		b = b->next;
-	}
-
-	while( (a != NULL) && (b != NULL) ) {
-		if(cmpfunc(a->item, b->item) < 0) {
-			tail->next = a;
-			a = a->next;
-		} else {
-			tail->next = b;
-			b = b->next;
-		}
-		tail = tail->next;
-	}
-
-	if(a != NULL) {
-		tail->next = a;
-	} else if(b != NULL) {
-		tail->next = b;
-	}
-	return head;
-}
-
-static node_t *_set_mergesort(node_t *head, cmpfunc_t cmpfunc) {
-	node_t *ndhead;
-
-	if(head == NULL || head->next == NULL) {
-		return head;
-	}
-	ndhead	= split(head);
-	head	= _set_mergesort(head, cmpfunc);
-	ndhead	= _set_mergesort(ndhead, cmpfunc);
-	return merge(head, ndhead, cmpfunc);
-}
+MERGESORT_DEFINE(node_sort, node_t, next, item)
 
 void set_sort(set_t *set) {
-	set->head = _set_mergesort(set->head, set->cmpfunc);
+	set->head = node_sort(set->head, set->cmpfunc);
 }
 
 
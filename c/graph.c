@@ -137,6 +137,7 @@ static void gplot_write(FILE *f, gplot_t *gplot) {
 
 void graph_dograph(graph_t *graph) {
 	char cmd[256];
+	int  err;
 
 	graph->f = fopen(graph->file, "w");
 	if(graph->f == NULL) {
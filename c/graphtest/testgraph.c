@@ -69,7 +69,7 @@ static void create_graph(char **paths, int num, char *title) {
 	graph_axislabel(g, "Power", "Base**Power");
 
 	for(int i = 0; i < num; i++) {
-		data[i].csf = paths[i];
+		data[i].csv = paths[i];
 		data[i].name = paths[i];
 	}
 	graph_newplot(g, "Exponent from 1 to 4", data, num);
@@ -1,6 +1,6 @@
 /* Author: Marius Ingebrigtsen */
 #include "../common.h"
-#include "../gettime.h"
+#include "../bench.h"
 #include "map.h"
 #include "lookup3.h"
 
@@ -14,6 +14,13 @@ typedef struct data {
 	char *value;
 } data_t;
 
+/* State of one trial, passed to setup, trial and teardown by harness. */
+typedef struct trial {
+	map_t	*map;
+	data_t	*data;
+	int		elements;
+} trial_t;
+
 
 static int cmpint(int *a, int *b) {
 	return *a - *b;
@@ -35,94 +42,57 @@ static data_t *data_create(int num) {
 	return data;
 }
 
-static void bench_map_put(FILE *f, char *impl) {
-	data_t 	*data;
-	map_t	*map;
-	unsigned long long t1, t2, time, average;
-
-	fprintf(f, "# Time for putting number of elements into hashmap for %s-implementation \n# Elements, Time \n", impl);
-
-	for(int elements = START; elements < MAXENTRIES; elements *= 2) {
-
-		data = data_create(elements);
+static void setup_empty(trial_t *trial) {
+	trial->map	= map_create( (cmpfunc_t)cmpint, (hashfunc_t)lookup3 );
+	trial->data	= data_create(trial->elements);
+}
 
-		map = map_create( (cmpfunc_t)cmpint, (hashfunc_t)lookup3 );
+static void setup_filled(trial_t *trial) {
+	setup_empty(trial);
 
-		time = 0;
+	for(int i = 0; i < trial->elements; i++) {
+		map_put(trial->map, trial->data[i].key, trial->data[i].value);
+	}
+}
 
-		printf("Benching for \'%d\'-elements. \n", elements);
-		t1 = gettime();
-		for(int elem = 0; elem < elements; elem++) {
+static void teardown(trial_t *trial) {
+	map_destroy(trial->map, free, free);
+	free(trial->data);
+}
 
-			map_put(map, data[elem].key, data[elem].value);
+static void trial_put(trial_t *trial) {
+	for(int elem = 0; elem < trial->elements; elem++) {
+		map_put(trial->map, trial->data[elem].key, trial->data[elem].value);
+	}
+}
 
+static void trial_get(trial_t *trial) {
+	for(int elem = 0; elem < trial->elements; elem++) {
+		if(map_get(trial->map, trial->data[elem].key) == NULL) {
+			fatal_error("Map error; key miss. \n");
 		}
-		t2 = gettime();
-
-		time = t2 - t1;
-		printf("Benching for \'%d\'-elements. \n", elements);
-		printf("Time for benching \'%d\'-elements; \'%llu\'. \n", elements, time);
-
-		fprintf(f, "%d, %d\n", elements, (int)time);
-
-		average += time;
-
-		map_destroy(map, free, free);
-
-		free(data);
 	}
-	average /= MAXENTRIES;
-
-	printf("Average Time For all elements: %d\n", (int)average);
 }
 
-static void bench_map_get(FILE *f, char *impl) {
-	unsigned long long t1, t2, time, average;
-	map_t *map;
-	data_t *data;
+/* Time 'trial' for every set of elements; 'setup' fills map for trials that don't put. */
+static void bench_map(char *result_path, char *title, benchfunc_t setup, benchfunc_t func) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
 
-	fprintf(f, "# Time for putting number of elements into hashmap for %s-implementation \n# Elements, Time \n", impl);
+	file = bench_open(result_path, title);
 
 	for(int elements = START; elements < MAXENTRIES; elements *= 2) {
+		trial.elements = elements;
 
-		map = map_create( (cmpfunc_t)cmpint, (hashfunc_t)lookup3 );
-
-		data = data_create(elements);
-
-		for(int i = 0; i < elements; i++) {
-			map_put(map, data[i].key, data[i].value);
-		}
-
-		printf("Benching for \'%d\'-elements. \n", elements);
-		t1 = gettime();
-		for(int elem = 0; elem < elements; elem++) {
-
-			if(map_get(map, data[elem].key) == NULL) {
-				fatal_error("Map error; key miss. \n");
-			}
-
-		}
-		t2 = gettime();
-
-		time = t2 - t1;
-		printf("Time for benching \'%d\'-elements; \'%llu\'. \n", elements, time);
-
-		fprintf(f, "%d, %d\n", elements, (int)time);
-
-		average += time;
-
-		free(data);
-
-		map_destroy(map, free, free);
+		bench_run(&stats, setup, func, (benchfunc_t)teardown, &trial, elements);
+		bench_write(file, elements, &stats);
 	}
-	average /= MAXENTRIES;
-
-	printf("Average Time For all elements: %d\n", (int)average);
+	bench_close(file);
 }
 
 int main(int argc, char **argv) {
-	FILE	*f;
-	char	*result_path, *implementation;
+	char	*result_path, *implementation, *title;
 	int		benchmark_indicator;
 
 	if(argc < 4) {
@@ -133,19 +103,18 @@ int main(int argc, char **argv) {
 	benchmark_indicator	= atoi( argv[2] );
 	implementation		= argv[3];
 
-	f = fopen(result_path, "w");
-	if(f == NULL) {
-		fatal_error("Couldn't open file; \'%s\'. \n", result_path);
-	}
-
 	if(benchmark_indicator == 1) {
-		bench_map_put(f, implementation);
+		title = concatenate_strings(3, "Time for putting number of elements into hashmap for ", implementation, "-implementation");
+		bench_map(result_path, title, (benchfunc_t)setup_empty, (benchfunc_t)trial_put);
 	}
 	else if(benchmark_indicator == 2) {
-		bench_map_get(f, implementation);
+		title = concatenate_strings(3, "Time for getting number of elements from hashmap for ", implementation, "-implementation");
+		bench_map(result_path, title, (benchfunc_t)setup_filled, (benchfunc_t)trial_get);
 	}
-
-	fclose(f);
+	else {
+		fatal_error("Indication must be 1 (put) or 2 (get); \'%d\'. \n", benchmark_indicator);
+	}
+	free(title);
 
 	return 0;
 }
\ No newline at end of file
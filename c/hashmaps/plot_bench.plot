@@ -2,7 +2,7 @@ set terminal pdf
 set output "map_bnch.pdf"
 set autoscale
 set xlabel "# Elements"
-set ylabel "Micro Sec."
+set ylabel "Nanosec. per operation (median)"
 set key left
 
 set title "Map Benchmark: Chained vs. Linear"
@@ -0,0 +1,169 @@
+/* Author: Marius Ingebrigtsen */
+#include "../common.h"
+#include "../bench.h"
+#include "../list/list.h"
+#include "./heap.h"
+
+#define START	1024			/* 2^10 */
+#define MAXELEM	1048576 + 1		/* 2^20 + 1 */
+#define TOPK	100
+
+/* State of one trial, passed to setup, trial and teardown by harness.
+ * Top-k selection keeps 'TOPK' greatest of 'elem' items, in descending order, in 'top'. */
+typedef struct trial {
+	int		**items, *top[TOPK];
+	int		elem, k;
+	heap_t	*heap;
+} trial_t;
+
+
+static int cmpint(int *a, int *b) {
+	return (*a > *b) - (*a < *b);
+}
+
+/* Reverse order, so lowest item of heap is greatest integer. */
+static int cmpint_reverse(int *a, int *b) {
+	return (*b > *a) - (*b < *a);
+}
+
+static int **items_create(int num) {
+	int **items;
+
+	items = calloc(num, sizeof(int*));
+	if(items == NULL) {
+		fatal_error("Out of memory.");
+	}
+	for(int i = 0; i < num; i++) {
+		items[i] = new_integer(rand());
+	}
+	return items;
+}
+
+/* Sort whole list descending, and take first 'TOPK'. */
+static int topk_list(int **items, int elem, int **top) {
+	list_t	*list = list_create( (cmpfunc_t)cmpint_reverse );
+	int		k;
+
+	for(int i = 0; i < elem; i++) {
+		list_addlast(list, items[i]);
+	}
+	list_sort(list);
+	for(k = 0; (k < TOPK) && (k < elem); k++) {
+		top[k] = list_popfirst(list);
+	}
+	list_destroy(list, NULL);
+
+	return k;
+}
+
+/* Keep 'TOPK' greatest in min-heap, replacing its lowest by each greater item; O(n log k). */
+static int topk_heap(int **items, int elem, int **top) {
+	heap_t	*heap = heap_create( (cmpfunc_t)cmpint );
+	int		k;
+
+	for(int i = 0; i < elem; i++) {
+		if(heap_size(heap) < TOPK) {
+			heap_push(heap, items[i]);
+		}
+		else if(*items[i] > *(int*)heap_peek(heap)) {
+			heap_replace(heap, items[i]);
+		}
+	}
+	for(k = heap_size(heap); k > 0; k--) {
+		top[k - 1] = heap_pop(heap);
+	}
+	k = (elem < TOPK) ? elem : TOPK;
+	heap_destroy(heap, NULL);
+
+	return k;
+}
+
+/* Heapify every item into max-heap in O(n), and pop 'TOPK'. */
+static int topk_heapify(int **items, int elem, int **top) {
+	heap_t	*heap = heap_heapify( (cmpfunc_t)cmpint_reverse, (void**)items, elem );
+	int		k;
+
+	for(k = 0; (k < TOPK) && (k < elem); k++) {
+		top[k] = heap_pop(heap);
+	}
+	heap_destroy(heap, NULL);
+
+	return k;
+}
+
+static void setup_items(trial_t *trial) {
+	trial->items = items_create(trial->elem);
+	trial->k = 0;
+}
+
+static void setup_heap(trial_t *trial) {
+	setup_items(trial);
+	trial->heap = heap_create( (cmpfunc_t)cmpint );
+}
+
+static void teardown(trial_t *trial) {
+	for(int i = 1; i < trial->k; i++) {
+		if(*trial->top[i - 1] < *trial->top[i]) {
+			fatal_error("Top-k not in descending order. ");
+		}
+	}
+	for(int i = 0; i < trial->elem; i++) {
+		free(trial->items[i]);
+	}
+	free(trial->items);
+}
+
+static void teardown_heap(trial_t *trial) {
+	heap_destroy(trial->heap, NULL);
+	teardown(trial);
+}
+
+static void trial_topk_list(trial_t *trial) {
+	trial->k = topk_list(trial->items, trial->elem, trial->top);
+}
+
+static void trial_topk_heap(trial_t *trial) {
+	trial->k = topk_heap(trial->items, trial->elem, trial->top);
+}
+
+static void trial_topk_heapify(trial_t *trial) {
+	trial->k = topk_heapify(trial->items, trial->elem, trial->top);
+}
+
+/* Push and pop every item, i.e. heapsort through push/pop, as for a scheduler draining its queue. */
+static void trial_push_pop(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		heap_push(trial->heap, trial->items[i]);
+	}
+	while(heap_pop(trial->heap) != NULL);
+}
+
+static void assert_series(char *bnch_file, char *title, benchfunc_t setup, benchfunc_t func, benchfunc_t teardown) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
+
+	file = bench_open(bnch_file, title);
+
+	for(int elem = START; elem < MAXELEM; elem *= 2) {
+		trial.elem = elem;
+
+		bench_run(&stats, setup, func, teardown, &trial, elem);
+		bench_write(file, elem, &stats);
+	}
+	bench_close(file);
+}
+
+int main(int argc, char **argv) {
+	if(argc < 5) {
+		printf("Usage: %s <topk-list-bench-file> <topk-heap-bench-file> <topk-heapify-bench-file> <push-pop-bench-file> \n", *argv);
+		return -1;
+	}
+
+	assert_series(argv[1], "Top-100 Selection Benchmarks, List-Sort", (benchfunc_t)setup_items, (benchfunc_t)trial_topk_list, (benchfunc_t)teardown);
+	assert_series(argv[2], "Top-100 Selection Benchmarks, Heap", (benchfunc_t)setup_items, (benchfunc_t)trial_topk_heap, (benchfunc_t)teardown);
+	assert_series(argv[3], "Top-100 Selection Benchmarks, Heapify", (benchfunc_t)setup_items, (benchfunc_t)trial_topk_heapify, (benchfunc_t)teardown);
+	assert_series(argv[4], "Heap Push & Pop Benchmarks", (benchfunc_t)setup_heap, (benchfunc_t)trial_push_pop, (benchfunc_t)teardown_heap);
+
+	return 0;
+}
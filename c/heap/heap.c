@@ -0,0 +1,229 @@
+/* Author: Marius Ingebrigtsen */
+#include <string.h>
+
+#include "heap.h"
+
+/* Children of node 'i' are 'CHILD(i)' to 'CHILD(i) + ARITY - 1'. */
+#define ARITY		4
+#define CHILD(i)	(ARITY * (i) + 1)
+#define PARENT(i)	(((i) - 1) / ARITY)
+#define INITSIZE	16
+
+/* Indexed heap keeps handle of each item in 'handles', parallel to 'items',
+ * and position in 'items' of each handle in 'position'. Handles of popped items are reused. */
+struct heap {
+	void		**items;
+	int			num_items, capacity;
+	cmpfunc_t	cmpfunc;
+	int			*handles, *position;
+	int			*free, num_free, num_handles;
+};
+
+
+/* Heap Create: */
+static heap_t *create(cmpfunc_t cmpfunc, int capacity, int indexed) {
+	heap_t *heap;
+
+	heap = calloc(1, sizeof(heap_t));
+	if(heap == NULL) {
+		fatal_error("Out of memory.");
+	}
+	heap->capacity	= (capacity > INITSIZE) ? capacity : INITSIZE;
+	heap->cmpfunc	= cmpfunc;
+	heap->items		= malloc(sizeof(void*) * heap->capacity);
+	if(heap->items == NULL) {
+		fatal_error("Out of memory.");
+	}
+
+	if(indexed) {
+		heap->handles	= malloc(sizeof(int) * heap->capacity);
+		heap->position	= malloc(sizeof(int) * heap->capacity);
+		heap->free		= malloc(sizeof(int) * heap->capacity);
+		if( (heap->handles == NULL) || (heap->position == NULL) || (heap->free == NULL) ) {
+			fatal_error("Out of memory.");
+		}
+	}
+	return heap;
+}
+
+heap_t *heap_create(cmpfunc_t cmpfunc) {
+	return create(cmpfunc, INITSIZE, 0);
+}
+
+heap_t *heap_create_indexed(cmpfunc_t cmpfunc) {
+	return create(cmpfunc, INITSIZE, 1);
+}
+
+/* Heap Destroy: */
+void heap_destroy(heap_t *heap, freefunc_t freefunc) {
+	if(freefunc != NULL) {
+		for(int i = 0; i < heap->num_items; i++) {
+			freefunc(heap->items[i]);
+		}
+	}
+	free(heap->items);
+	free(heap->handles);
+	free(heap->position);
+	free(heap->free);
+	free(heap);
+}
+
+/* Heap Size: */
+int heap_size(heap_t *heap) {
+	return heap->num_items;
+}
+
+/* Heap Sift: */
+/* Place item, and its handle if indexed, at position 'i'. */
+static inline void place(heap_t *heap, int i, void *item, int handle) {
+	heap->items[i] = item;
+	if(heap->handles != NULL) {
+		heap->handles[i]		= handle;
+		heap->position[handle]	= i;
+	}
+}
+
+/* Move item at 'i' up past greater parents.
+ * Parents are moved down into hole, and item written once at end. */
+static void sift_up(heap_t *heap, int i) {
+	void	*item = heap->items[i];
+	int		handle = (heap->handles != NULL) ? heap->handles[i] : -1, parent;
+
+	while(i > 0) {
+		parent = PARENT(i);
+		if(heap->cmpfunc(item, heap->items[parent]) >= 0) {
+			break;
+		}
+		place(heap, i, heap->items[parent], (handle >= 0) ? heap->handles[parent] : -1);
+		i = parent;
+	}
+	place(heap, i, item, handle);
+}
+
+/* Place 'item' at hole 'i', and move it down past lesser children. */
+static void sift_down(heap_t *heap, int i, void *item, int handle) {
+	void	**items = heap->items;
+	int		child, last, min;
+
+	while( (child = CHILD(i)) < heap->num_items ) {
+		last = (child + ARITY < heap->num_items) ? child + ARITY : heap->num_items;
+
+		/* Lowest of up to 'ARITY' adjacent children. */
+		min = child;
+		for(child++; child < last; child++) {
+			if(heap->cmpfunc(items[child], items[min]) < 0) {
+				min = child;
+			}
+		}
+		if(heap->cmpfunc(items[min], item) >= 0) {
+			break;
+		}
+		place(heap, i, items[min], (handle >= 0) ? heap->handles[min] : -1);
+		i = min;
+	}
+	place(heap, i, item, handle);
+}
+
+/* Heap Heapify: */
+/* Sift down every parent, from last to root; most nodes are near bottom and move at most a few levels. */
+heap_t *heap_heapify(cmpfunc_t cmpfunc, void **items, int num) {
+	heap_t *heap;
+
+	heap = create(cmpfunc, num, 0);
+	memcpy(heap->items, items, sizeof(void*) * num);
+	heap->num_items = num;
+
+	for(int i = PARENT(num - 1); (num > 1) && (i >= 0); i--) {
+		sift_down(heap, i, heap->items[i], -1);
+	}
+	return heap;
+}
+
+/* Heap Push: */
+static void grow(heap_t *heap) {
+	heap->capacity *= 2;
+	heap->items = realloc(heap->items, sizeof(void*) * heap->capacity);
+	if(heap->items == NULL) {
+		fatal_error("Out of memory.");
+	}
+	if(heap->handles != NULL) {
+		heap->handles	= realloc(heap->handles, sizeof(int) * heap->capacity);
+		heap->position	= realloc(heap->position, sizeof(int) * heap->capacity);
+		heap->free		= realloc(heap->free, sizeof(int) * heap->capacity);
+		if( (heap->handles == NULL) || (heap->position == NULL) || (heap->free == NULL) ) {
+			fatal_error("Out of memory.");
+		}
+	}
+}
+
+int heap_push(heap_t *heap, void *item) {
+	int handle = -1;
+
+	if(heap->num_items == heap->capacity) {
+		grow(heap);
+	}
+	if(heap->handles != NULL) {
+		handle = (heap->num_free > 0) ? heap->free[--heap->num_free] : heap->num_handles++;
+	}
+	place(heap, heap->num_items, item, handle);
+	sift_up(heap, heap->num_items++);
+
+	return handle;
+}
+
+/* Heap Pop, Peek & Replace: */
+void *heap_pop(heap_t *heap) {
+	void	*item;
+	int		last;
+
+	if(heap->num_items == 0) {
+		return NULL;
+	}
+	item = heap->items[0];
+	if(heap->handles != NULL) {
+		heap->position[heap->handles[0]]	= -1;
+		heap->free[heap->num_free++]		= heap->handles[0];
+	}
+
+	/* Last item fills hole at root. */
+	last = --heap->num_items;
+	if(last > 0) {
+		sift_down(heap, 0, heap->items[last], (heap->handles != NULL) ? heap->handles[last] : -1);
+	}
+	return item;
+}
+
+void *heap_peek(heap_t *heap) {
+	if(heap->num_items == 0) {
+		return NULL;
+	}
+	return heap->items[0];
+}
+
+void *heap_replace(heap_t *heap, void *item) {
+	void *top;
+
+	if(heap->handles != NULL) {
+		fatal_error("heap_replace on indexed heap. ");
+	}
+	if(heap->num_items == 0) {
+		heap_push(heap, item);
+		return NULL;
+	}
+	top = heap->items[0];
+	sift_down(heap, 0, item, -1);
+
+	return top;
+}
+
+/* Heap Decrease: */
+void heap_decrease(heap_t *heap, int handle, void *item) {
+	int i;
+
+	if( (heap->handles == NULL) || (handle < 0) || (handle >= heap->num_handles) || (heap->position[handle] < 0) ) {
+		fatal_error("Handle; \'%d\', not in indexed heap. ", handle);
+	}
+	i = heap->position[handle];
+	heap->items[i] = item;
+	sift_up(heap, i);
+}
@@ -0,0 +1,52 @@
+/* Author: Marius Ingebrigtsen */
+#ifndef __HEAP_H_
+#define __HEAP_H_
+
+#include "../common.h"
+
+/* Heap Structure.
+ * Priority queue stored in one array as a 4-ary heap, lowest item first according to 'cmpfunc'.
+ * Four children of a node are adjacent in memory, so heap is half as deep as a binary heap,
+ * and a pop compares children on the same cache-line in stead of following one per level. */
+typedef struct heap heap_t;
+
+
+/* Return new, empty heap. */
+heap_t *heap_create(cmpfunc_t cmpfunc);
+
+/* Return new, empty, indexed heap.
+ * Each item pushed gets a handle, which stays valid until item is popped,
+ * so priority of an item in heap can be lowered with 'heap_decrease()', e.g. in Dijkstra's algorithm. */
+heap_t *heap_create_indexed(cmpfunc_t cmpfunc);
+
+/* Return new heap of 'num' items from array, built in O(n) time in stead of O(n log n) for 'num' pushes.
+ * Array is copied, and is not changed. */
+heap_t *heap_heapify(cmpfunc_t cmpfunc, void **items, int num);
+
+/* Destroy heap. Optional function-pointer for deallocating items in heap.
+ * Pass NULL as argument if items are not to be deallocated. */
+void heap_destroy(heap_t *heap, freefunc_t freefunc);
+
+/* Return number of items in heap. */
+int heap_size(heap_t *heap);
+
+/* Add item to heap.
+ * Return handle of item if heap is indexed, -1 otherwise. */
+int heap_push(heap_t *heap, void *item);
+
+/* Remove and return lowest item in heap. NULL returned if heap is empty. */
+void *heap_pop(heap_t *heap);
+
+/* Return lowest item in heap, without removing it. NULL returned if heap is empty. */
+void *heap_peek(heap_t *heap);
+
+/* Remove and return lowest item in heap, and add 'item', with one pass down heap in stead of a pop and a push.
+ * E.g. top-k selection, where lowest of k best items is replaced by a better one.
+ * If heap is empty, then item is added and NULL returned. Not for indexed heaps. */
+void *heap_replace(heap_t *heap, void *item);
+
+/* Replace item with 'handle' in indexed heap by 'item', which must not compare greater, and restore order.
+ * Item may be the same, if its priority is lowered in place. */
+void heap_decrease(heap_t *heap, int handle, void *item);
+
+#endif
@@ -0,0 +1,157 @@
+/* Author: Marius Ingebrigtsen */
+#include "../common.h"
+#include "./heap.h"
+
+
+static int cmpint(int *a, int *b) {
+	return (*a > *b) - (*a < *b);
+}
+
+static int *data_create(int num) {
+	int *data;
+
+	data = malloc(sizeof(int) * num);
+	if(data == NULL) {
+		fatal_error("Out of memory.");
+	}
+	for(int i = 0; i < num; i++) {
+		data[i] = rand() % (num + 1);
+	}
+	return data;
+}
+
+/* Pop every item of heap and check items come in ascending order. */
+static void assert_order(heap_t *heap, int num, char *title) {
+	int *item, *prev = NULL, count = 0;
+
+	if(heap_size(heap) != num) {
+		fatal_error("%s; size \'%d\', expected \'%d\'. \n", title, heap_size(heap), num);
+	}
+	while( (item = heap_pop(heap)) != NULL ) {
+		if( (prev != NULL) && (*prev > *item) ) {
+			fatal_error("%s; \'%d\' popped after \'%d\'. \n", title, *item, *prev);
+		}
+		prev = item;
+		count++;
+	}
+	if( (count != num) || (heap_peek(heap) != NULL) ) {
+		fatal_error("%s; popped \'%d\', expected \'%d\'. \n", title, count, num);
+	}
+	printf("%s; %d items in order. \n", title, num);
+}
+
+static void assert_push(int *data, int num) {
+	heap_t *heap = heap_create( (cmpfunc_t)cmpint );
+
+	for(int i = 0; i < num; i++) {
+		heap_push(heap, &data[i]);
+		if(*(int*)heap_peek(heap) > data[i]) {
+			fatal_error("Peek greater than item pushed. \n");
+		}
+	}
+	assert_order(heap, num, "Push");
+	heap_destroy(heap, NULL);
+}
+
+static void assert_heapify(int *data, int num) {
+	int		**items;
+	heap_t	*heap;
+
+	items = malloc(sizeof(int*) * (num + 1));
+	if(items == NULL) {
+		fatal_error("Out of memory.");
+	}
+	for(int i = 0; i < num; i++) {
+		items[i] = &data[i];
+	}
+	heap = heap_heapify( (cmpfunc_t)cmpint, (void**)items, num );
+	assert_order(heap, num, "Heapify");
+	heap_destroy(heap, NULL);
+	free(items);
+}
+
+/* Keep 'k' greatest items with heap_replace, and check against count of greater items. */
+static void assert_topk(int *data, int num, int k) {
+	heap_t	*heap = heap_create( (cmpfunc_t)cmpint );
+	int		*lowest, greater = 0;
+
+	for(int i = 0; i < num; i++) {
+		if(heap_size(heap) < k) {
+			heap_push(heap, &data[i]);
+		}
+		else if(data[i] > *(int*)heap_peek(heap)) {
+			heap_replace(heap, &data[i]);
+		}
+	}
+	lowest = heap_peek(heap);
+	for(int i = 0; (lowest != NULL) && (i < num); i++) {
+		greater += (data[i] > *lowest);
+	}
+	if( (heap_size(heap) != ((num < k) ? num : k)) || (greater >= k) ) {
+		fatal_error("Top-%d; \'%d\' items greater than lowest in heap. \n", k, greater);
+	}
+	assert_order(heap, (num < k) ? num : k, "Top-k");
+	heap_destroy(heap, NULL);
+}
+
+/* Interleave pushes, pops and decreases of random items still in heap. */
+static void assert_decrease(int *data, int num) {
+	heap_t	*heap = heap_create_indexed( (cmpfunc_t)cmpint );
+	int		*handles, *item, prev, popped = 0, pushed = 0, h;
+
+	handles = malloc(sizeof(int) * (num + 1));
+	if(handles == NULL) {
+		fatal_error("Out of memory.");
+	}
+	prev = -num;
+	while(popped < num) {
+		if( (pushed < num) && (rand() % 3 != 0) ) {	/* Not below last popped, so pops stay ascending. */
+			data[pushed] = (data[pushed] < prev) ? prev : data[pushed];
+			handles[pushed] = heap_push(heap, &data[pushed]);
+			pushed++;
+		}
+		else if(rand() % 2 == 0) {	/* Lower random item still in heap, but not below last popped. */
+			h = rand() % (pushed + 1);
+			if( (h < pushed) && (handles[h] >= 0) && (data[h] > prev) ) {
+				data[h] -= rand() % (data[h] - prev + 1);
+				heap_decrease(heap, handles[h], &data[h]);
+			}
+		}
+		else if( (item = heap_pop(heap)) != NULL ) {
+			if(*item < prev) {
+				fatal_error("Decrease; \'%d\' popped after \'%d\'. \n", *item, prev);
+			}
+			prev = *item;
+			handles[item - data] = -1;
+			popped++;
+		}
+	}
+	if(heap_size(heap) != 0) {
+		fatal_error("Decrease; size \'%d\' after every item popped. \n", heap_size(heap));
+	}
+	printf("Decrease; %d items in order. \n", num);
+
+	heap_destroy(heap, NULL);
+	free(handles);
+}
+
+int main(int argc, char **argv) {
+	int *data, num;
+
+	if(argc < 2) {
+		printf("Usage: %s <value> \n", *argv);
+		return -1;
+	}
+	num = atoi(argv[1]);
+
+	data = data_create(num);
+
+	assert_push(data, num);
+	assert_heapify(data, num);
+	assert_topk(data, num, 100);
+	assert_decrease(data, num);
+
+	free(data);
+
+	return 0;
+}
@@ -0,0 +1,141 @@
+/* Author: Marius Ingebrigtsen */
+#include "../common.h"
+#include "../bench.h"
+#include "list.h"
+
+#define START	1024			/* 2^10 */
+#define MAXELEM	1048576 + 1		/* 2^20 + 1 */
+#define LOOKUPS	256				/* Contains per trial; each scans list, so not one per element. */
+
+/* State of one trial, passed to setup, trial and teardown by harness. */
+typedef struct trial {
+	list_t	*list;
+	int		*data, elem;
+	long	sum;
+} trial_t;
+
+/* Series of benchmark; 'lookups' series time 'LOOKUPS' operations per trial, other series one per element. */
+typedef struct series {
+	char		*name, *title;
+	benchfunc_t	setup, trial, teardown;
+	int			lookups;
+} series_t;
+
+
+static int cmpint(int *a, int *b) {
+	return (*a > *b) - (*a < *b);
+}
+
+static void setup_data(trial_t *trial) {
+	trial->data = malloc(sizeof(int) * trial->elem);
+	if(trial->data == NULL) {
+		fatal_error("Out of memory.");
+	}
+	for(int i = 0; i < trial->elem; i++) {
+		trial->data[i] = rand();
+	}
+	trial->list = NULL;
+	trial->sum	= 0;
+}
+
+static void setup_filled(trial_t *trial) {
+	setup_data(trial);
+
+	trial->list = list_create( (cmpfunc_t)cmpint );
+	for(int i = 0; i < trial->elem; i++) {
+		list_addlast(trial->list, &trial->data[i]);
+	}
+}
+
+/* Sorted list is iterated in order of keys, not of allocation, so linked nodes are scattered in memory. */
+static void setup_sorted(trial_t *trial) {
+	setup_filled(trial);
+	list_sort(trial->list);
+}
+
+static void teardown(trial_t *trial) {
+	if(trial->list != NULL) {
+		list_destroy(trial->list, NULL);
+	}
+	free(trial->data);
+}
+
+static void trial_append(trial_t *trial) {
+	trial->list = list_create( (cmpfunc_t)cmpint );
+	for(int i = 0; i < trial->elem; i++) {
+		list_addlast(trial->list, &trial->data[i]);
+	}
+}
+
+static void trial_iterate(trial_t *trial) {
+	list_iterator_t *iterator = list_createiterator(trial->list);
+
+	while(list_hasnext(iterator)) {
+		trial->sum += *(int*)list_next(iterator);
+	}
+	list_destroyiterator(iterator);
+}
+
+/* Half of lookups hit, at random positions, and half miss, scanning whole list. */
+static void trial_contains(trial_t *trial) {
+	int key;
+
+	for(int i = 0; i < LOOKUPS; i++) {
+		key = (i % 2) ? trial->data[rand() % trial->elem] : -1;
+		trial->sum += list_contains(trial->list, &key);
+	}
+}
+
+static void trial_sort(trial_t *trial) {
+	list_sort(trial->list);
+}
+
+static void trial_destroy(trial_t *trial) {
+	list_destroy(trial->list, NULL);
+	trial->list = NULL;
+}
+
+static series_t series[] = {
+	{ "append",		"Append",					(benchfunc_t)setup_data,	(benchfunc_t)trial_append,		(benchfunc_t)teardown, 0 },
+	{ "iterate",	"Iterate",					(benchfunc_t)setup_filled,	(benchfunc_t)trial_iterate,		(benchfunc_t)teardown, 0 },
+	{ "sorted",		"Iterate after Sort",		(benchfunc_t)setup_sorted,	(benchfunc_t)trial_iterate,		(benchfunc_t)teardown, 0 },
+	{ "contains",	"Contains",					(benchfunc_t)setup_filled,	(benchfunc_t)trial_contains,	(benchfunc_t)teardown, 1 },
+	{ "sort",		"Sort",						(benchfunc_t)setup_filled,	(benchfunc_t)trial_sort,		(benchfunc_t)teardown, 0 },
+	{ "destroy",	"Destroy",					(benchfunc_t)setup_filled,	(benchfunc_t)trial_destroy,		(benchfunc_t)teardown, 0 }
+};
+
+static void bench_series(series_t *s, char *implementation, char *results) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
+	char			*path, *title;
+
+	path	= concatenate_strings(6, results, "/", implementation, "_", s->name, ".txt");
+	title	= concatenate_strings(3, s->title, " Benchmarks of ", implementation);
+	file	= bench_open(path, title);
+
+	for(int elem = START; elem < MAXELEM; elem *= 2) {
+		trial.elem = elem;
+
+		bench_run(&stats, s->setup, s->trial, s->teardown, &trial, s->lookups ? LOOKUPS : elem);
+		bench_write(file, elem, &stats);
+	}
+	bench_close(file);
+	free(path);
+	free(title);
+}
+
+int main(int argc, char **argv) {
+	if(argc < 3) {
+		printf("Usage: %s <implementation> <results-directory> \n", *argv);
+		return -1;
+	}
+
+	for(size_t i = 0; i < sizeof(series) / sizeof(series_t); i++) {
+		printf("\nAsserting %s...\n", series[i].title);
+		bench_series(&series[i], argv[1], argv[2]);
+	}
+	printf("Done.\n");
+
+	return 0;
+}
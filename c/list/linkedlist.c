@@ -1,5 +1,6 @@
 /* Author: Marius Ingebrigtsen */
 #include "list.h"
+#include "../mergesort.h"
 
 
 typedef struct node node_t;
@@ -111,7 +112,7 @@ void *list_remove(list_t *list, void *item) {
 		return list_popfirst(list);
 	}
 	else if( (list->tail != NULL) && 
-			 (list->cmpfunc(list->head->item, item) == 0) ) {	/* If last element in list is 'item'. */
+			 (list->cmpfunc(list->tail->item, item) == 0) ) {	/* If last element in list is 'item'. */
 		return list_poplast(list);
 	}
 	else if(list->num_items <= 2) {	/* If 'head' and 'tail' are all items in list. */
@@ -121,7 +122,8 @@ void *list_remove(list_t *list, void *item) {
 	
 	while(current->next != NULL) {	/* Loop terminates when 'current' is 'tail'. */
 		if(list->cmpfunc(item, current->item) == 0) {
-			
+			item = current->item;
+
 			current->previous->next = current->next;		/* At this point 'current' is assured to not be either head or tail. */
 			current->next->previous = current->previous;	/* So previous and next will never be NULL. */
 
@@ -146,6 +148,8 @@ void *list_popfirst(list_t *list) {
 	list->num_items--;
 	if(list->head == NULL) {
 		list->tail = NULL;
+	} else {
+		list->head->previous = NULL;
 	}return item;
 }
 
@@ -159,6 +163,8 @@ void *list_poplast(list_t *list) {
 	list->num_items--;
 	if(list->tail == NULL) {
 		list->head = NULL;
+	} else {
+		list->tail->next = NULL;
 	}return item;
 }
 
@@ -190,54 +196,19 @@ void list_print(list_t *list, list_printfunc_t printfunc) {
 }
 
 /* List Sort: */
-static node_t *split(node_t *head) {
-	node_t *slow, *fast, *ndhead;
-	slow = head;
-	fast = head->next;
-	while(fast != NULL && fast->next != NULL) {
-		slow = slow->next;
-		fast = fast->next->next;
-	}ndhead = slow->next;
-	slow->next = NULL;
-	return ndhead;
-}
+MERGESORT_DEFINE(node_sort, node_t, next, item)
 
-static node_t *merge(node_t *A, node_t *B, cmpfunc_t cmpfunc) {
-	node_t *head, *tail;
-	if(cmpfunc(A->item, B->item) < 0) {
-		head = tail = A;
-		A = A->next;
-	}else {
-		head = tail = B;
-		B = B->next;
-	}while(A != NULL && B != NULL) {
-		if(cmpfunc(A->item, B->item) < 0) {
-			tail->next = A;
-			tail = A;
-			A = A->next;
-		}else {
-			tail->next = B;
-			tail = B;
-			B = B->next;
-		}
-	}if(A != NULL) {
-		tail->next = A;
-	}else if(B != NULL) {
-		tail->next = B;
-	}return head;
-}
+void list_sort(list_t *list) {
+	node_t *previous = NULL;
 
-static node_t *_mergesort(node_t *head, cmpfunc_t cmpfunc) {
-	if(head == NULL || head->next == NULL) {
-		return head;
-	}node_t *ndhead = split(head);
-	head			= _mergesort(head, cmpfunc);
-	ndhead			= _mergesort(ndhead, cmpfunc);
-	return merge(head, ndhead, cmpfunc);
-}
+	list->head = node_sort(list->head, list->cmpfunc);
 
-void list_sort(list_t *list) {
-	list->head = _mergesort(list->head, list->cmpfunc);
+	/* Mergesort only follows 'next'; restore 'previous' and 'tail'. */
+	for(node_t *current = list->head; current != NULL; current = current->next) {
+		current->previous = previous;
+		previous = current;
+	}
+	list->tail = previous;
 }
 
 
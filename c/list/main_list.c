@@ -0,0 +1,226 @@
+/* Author: Marius Ingebrigtsen */
+#include <string.h>
+
+#include "../common.h"
+#include "list.h"
+
+#define KEYS	64	/* Keys drawn from [0, KEYS), so lists hold duplicates, and sort is seen to be stable. */
+
+/* Item of list; compared by 'key' only, so items of equal key are told apart by address. */
+typedef struct item {
+	int key;
+} item_t;
+
+/* Model of list; 'model[first..last)' are items of list in order, with room to grow either way.
+ * Items added are taken in turn from 'items', so no item is in list twice. */
+static item_t	**model, *items;
+static int		first, last, next, num;
+
+
+static int cmpkey(item_t *a, item_t *b) {
+	return (a->key > b->key) - (a->key < b->key);
+}
+
+/* Check size, and iteration forwards and backwards, against model. */
+static void assert_model(list_t *list, char *title) {
+	list_iterator_t *iterator = list_createiterator(list);
+	int				i;
+
+	if(list_size(list) != last - first) {
+		fatal_error("%s; size \'%d\', expected \'%d\'. \n", title, list_size(list), last - first);
+	}
+	for(i = first; list_hasnext(iterator); i++) {
+		if( (i == last) || (list_current(iterator) != model[i]) || (list_next(iterator) != model[i]) ) {
+			fatal_error("%s; item \'%d\' of iteration differs. \n", title, i - first);
+		}
+	}
+	if( (i != last) || (list_next(iterator) != NULL) ) {
+		fatal_error("%s; iteration ended at \'%d\' of \'%d\'. \n", title, i - first, last - first);
+	}
+
+	list_setiterator_end(iterator);
+	for(i = last - 1; list_hasnext(iterator); i--) {
+		if( (i < first) || (list_previous(iterator) != model[i]) ) {
+			fatal_error("%s; item \'%d\' of backward iteration differs. \n", title, i - first);
+		}
+	}
+	if(i != first - 1) {
+		fatal_error("%s; backward iteration ended at \'%d\'. \n", title, i - first);
+	}
+
+	list_resetiterator(iterator);
+	if(list_current(iterator) != ((first < last) ? model[first] : NULL)) {
+		fatal_error("%s; reset iterator not at first item. \n", title);
+	}
+	list_destroyiterator(iterator);
+}
+
+static void apply_add(list_t *list, int front) {
+	item_t *item = &items[next];
+
+	next = (next + 1) % (3 * num);
+
+	if(front) {
+		list_addfirst(list, item);
+		model[--first] = item;
+	} else {
+		list_addlast(list, item);
+		model[last++] = item;
+	}
+}
+
+static void apply_pop(list_t *list, int front) {
+	item_t *item, *expect = (first < last) ? model[front ? first : last - 1] : NULL;
+
+	item = front ? list_popfirst(list) : list_poplast(list);
+	if(item != expect) {
+		fatal_error("Pop-%s; wrong item. \n", front ? "first" : "last");
+	}
+	if(expect != NULL) {
+		front ? first++ : last--;
+	}
+}
+
+/* Remove item of random key; any item of key may be removed, but one must be if key is in model. */
+static void apply_remove(list_t *list) {
+	item_t	key = { rand() % KEYS }, *item;
+	int		i, found = 0;
+
+	for(i = first; (i < last) && !found; i++) {
+		found = (model[i]->key == key.key);
+	}
+	if(list_contains(list, &key) != found) {
+		fatal_error("Contains; key \'%d\' returned \'%d\'. \n", key.key, !found);
+	}
+
+	item = list_remove(list, &key);
+	if( (item == NULL) != !found ) {
+		fatal_error("Remove; key \'%d\' %s. \n", key.key, found ? "not removed" : "removed, but not in list");
+	}
+	if(item == NULL) {
+		return;
+	}
+	for(i = first; (i < last) && (model[i] != item); i++);
+	if( (i == last) || (item->key != key.key) ) {
+		fatal_error("Remove; key \'%d\' returned item not in list. \n", key.key);
+	}
+	memmove(&model[i], &model[i + 1], sizeof(item_t*) * (last - i - 1));
+	last--;
+}
+
+/* Random adds and pops at both ends, with removes from anywhere. */
+static void assert_ends(list_t *list, int ops) {
+	for(int op = 0; op < ops; op++) {
+		switch(rand() % 7) {	/* More adds than pops and removes, so list grows over many chunks. */
+			case 0:
+			case 1:	apply_add(list, 1);		break;
+			case 2:
+			case 3:	apply_add(list, 0);		break;
+			case 4:	apply_pop(list, 1);		break;
+			case 5:	apply_pop(list, 0);		break;
+			default:apply_remove(list);		break;
+		}
+		if(op % 64 == 0) {
+			assert_model(list, "Ends");
+		}
+	}
+	assert_model(list, "Ends");
+	printf("Ends; %d operations, %d items left. \n", ops, last - first);
+}
+
+/* Add to list, then remove from it until empty, so sparse chunks of unrolled list are merged. */
+static void assert_remove(list_t *list, int fill) {
+	for(int i = 0; i < fill; i++) {
+		apply_add(list, rand() % 2);
+	}
+	assert_model(list, "Fill");
+	fill = last - first;
+
+	for(int op = 0; first < last; op++) {
+		apply_remove(list);
+		if(op % 16 == 0) {
+			assert_model(list, "Remove");
+		}
+	}
+	assert_model(list, "Remove");
+	if( (list_popfirst(list) != NULL) || (list_poplast(list) != NULL) ) {
+		fatal_error("Remove; pop of empty list returned item. \n");
+	}
+	printf("Remove; %d items removed. \n", fill);
+}
+
+/* Stable counting sort of model by key; order sorted list is expected to have. */
+static void sort_model(void) {
+	item_t	**sorted;
+	int		count[KEYS + 1] = { 0 };
+
+	sorted = malloc(sizeof(item_t*) * (last - first + 1));
+	if(sorted == NULL) {
+		fatal_error("Out of memory.");
+	}
+	for(int i = first; i < last; i++) {
+		count[model[i]->key + 1]++;
+	}
+	for(int k = 1; k <= KEYS; k++) {
+		count[k] += count[k - 1];
+	}
+	for(int i = first; i < last; i++) {
+		sorted[count[model[i]->key]++] = model[i];
+	}
+	memcpy(&model[first], sorted, sizeof(item_t*) * (last - first));
+	free(sorted);
+}
+
+/* Sort list, and check it is ordered by key, with items of equal key in order they had. */
+static void assert_sort(list_t *list, int fill) {
+	for(int i = 0; i < fill; i++) {
+		apply_add(list, rand() % 2);
+	}
+	list_sort(list);
+
+	sort_model();
+	assert_model(list, "Sort");
+
+	for(int i = 0; i < KEYS; i++) {	/* Sorted list is still a list. */
+		apply_add(list, rand() % 2);
+		apply_pop(list, rand() % 2);
+		apply_remove(list);
+	}
+	assert_model(list, "Sort");
+	printf("Sort; %d items in order. \n", fill);
+}
+
+int main(int argc, char **argv) {
+	list_t	*list;
+	int		ops;
+
+	if(argc < 2) {
+		printf("Usage: %s <value> \n", *argv);
+		return -1;
+	}
+	ops = atoi(argv[1]);
+	num = (ops < KEYS) ? KEYS : ops;
+
+	/* Model needs room for every add of every phase to be at either end. */
+	model	= malloc(sizeof(item_t*) * (6 * num + 1));
+	items	= malloc(sizeof(item_t) * 3 * num);
+	if( (model == NULL) || (items == NULL) ) {
+		fatal_error("Out of memory.");
+	}
+	for(int i = 0; i < 3 * num; i++) {
+		items[i].key = rand() % KEYS;
+	}
+
+	list = list_create( (cmpfunc_t)cmpkey );
+
+	first = last = 3 * num;
+	assert_ends(list, ops);
+	assert_remove(list, num / 4);
+	assert_sort(list, num);
+
+	list_destroy(list, NULL);
+	free(model);
+	free(items);
+
+	return 0;
+}
@@ -0,0 +1,363 @@
+/* Author: Marius Ingebrigtsen */
+#include <string.h>
+
+#include "list.h"
+
+/* Unrolled list: doubly linked chunks of up to CHUNKSIZE item-pointers,
+ * so iteration, contains and sort mostly read contiguous memory, with one allocation per CHUNKSIZE items.
+ * Items of chunk occupy window 'items[lo]' to 'items[hi - 1]',
+ * so adding or popping at either end of list never shifts items. No chunk in list is empty. */
+#define CHUNKSIZE	32
+
+typedef struct chunk chunk_t;
+struct chunk {
+	chunk_t	*next, *previous;
+	int		lo, hi;
+	void	*items[CHUNKSIZE];
+};
+
+struct list {
+	chunk_t		*head, *tail;
+	int			num_items;
+	cmpfunc_t	cmpfunc;
+};
+
+
+/* List Create: */
+list_t *list_create(cmpfunc_t cmpfunc) {
+	list_t *list = malloc(sizeof(list_t));
+	if(list == NULL) {
+		fatal_error("Out of memory.");
+	}
+	list->head		= list->tail = NULL;
+	list->num_items	= 0;
+	list->cmpfunc	= cmpfunc;
+	return list;
+}
+
+/* List Compare Funciton: */
+void list_cmpfunc(list_t *list, cmpfunc_t cmpfunc) {
+	list->cmpfunc = cmpfunc;
+}
+
+/* List Destroy: */
+void list_destroy(list_t *list, freefunc_t freefunc) {
+	chunk_t *current, *tmp;
+
+	current = list->head;
+	while(current != NULL) {
+		if(freefunc != NULL) {
+			for(int i = current->lo; i < current->hi; i++) {
+				freefunc(current->items[i]);
+			}
+		}
+		tmp		= current;
+		current	= current->next;
+		free(tmp);
+	}
+	free(list);
+}
+
+/* List Size: */
+int list_size(list_t *list) {
+	return list->num_items;
+}
+
+/* List Add-First & Add-Last: */
+/* Return new chunk with empty window at 'pos'. */
+static inline chunk_t *create_chunk(int pos) {
+	chunk_t *chunk = malloc(sizeof(chunk_t));
+	if(chunk == NULL) {
+		fatal_error("Out of memory.");
+	}
+	chunk->next	= chunk->previous = NULL;
+	chunk->lo	= chunk->hi = pos;
+	return chunk;
+}
+
+/* Unlink chunk from list and free it. */
+static void destroy_chunk(list_t *list, chunk_t *chunk) {
+	if(chunk->previous != NULL) {
+		chunk->previous->next = chunk->next;
+	} else {
+		list->head = chunk->next;
+	}
+	if(chunk->next != NULL) {
+		chunk->next->previous = chunk->previous;
+	} else {
+		list->tail = chunk->previous;
+	}
+	free(chunk);
+}
+
+void list_addfirst(list_t *list, void *item) {
+	chunk_t *chunk = list->head;
+
+	if( (chunk != NULL) && (chunk->lo == 0) && (chunk->hi < CHUNKSIZE) ) {	/* Room only at end; shift window to end of chunk. */
+		memmove(&chunk->items[CHUNKSIZE - chunk->hi], chunk->items, sizeof(void*) * chunk->hi);
+		chunk->lo = CHUNKSIZE - chunk->hi;
+		chunk->hi = CHUNKSIZE;
+	}
+	else if( (chunk == NULL) || (chunk->lo == 0) ) {	/* Full or no chunk; new chunk filled from end, so further add-firsts don't shift. */
+		chunk = create_chunk(CHUNKSIZE);
+		chunk->next = list->head;
+		if(list->head != NULL) {
+			list->head->previous = chunk;
+		} else {
+			list->tail = chunk;
+		}
+		list->head = chunk;
+	}
+	chunk->items[--chunk->lo] = item;
+	list->num_items++;
+}
+
+void list_addlast(list_t *list, void *item) {
+	chunk_t *chunk = list->tail;
+
+	if( (chunk != NULL) && (chunk->hi == CHUNKSIZE) && (chunk->lo > 0) ) {	/* Room only at start; shift window to start of chunk. */
+		memmove(chunk->items, &chunk->items[chunk->lo], sizeof(void*) * (chunk->hi - chunk->lo));
+		chunk->hi -= chunk->lo;
+		chunk->lo = 0;
+	}
+	else if( (chunk == NULL) || (chunk->hi == CHUNKSIZE) ) {
+		chunk = create_chunk(0);
+		chunk->previous = list->tail;
+		if(list->tail != NULL) {
+			list->tail->next = chunk;
+		} else {
+			list->head = chunk;
+		}
+		list->tail = chunk;
+	}
+	chunk->items[chunk->hi++] = item;
+	list->num_items++;
+}
+
+/* List Remove, Pop-First & Pop-Last: */
+void *list_remove(list_t *list, void *item) {
+	chunk_t	*chunk, *next;
+	void	*removed;
+
+	for(chunk = list->head; chunk != NULL; chunk = chunk->next) {
+		for(int i = chunk->lo; i < chunk->hi; i++) {
+			if(list->cmpfunc(chunk->items[i], item) != 0) {
+				continue;
+			}
+			removed = chunk->items[i];
+			memmove(&chunk->items[i], &chunk->items[i + 1], sizeof(void*) * (chunk->hi - i - 1));
+			chunk->hi--;
+			list->num_items--;
+
+			if(chunk->lo == chunk->hi) {
+				destroy_chunk(list, chunk);
+			}
+			else if( ((next = chunk->next) != NULL) &&
+					 ((chunk->hi - chunk->lo) + (next->hi - next->lo) <= CHUNKSIZE / 2) ) {	/* Merge sparse neighbours, so chunks stay at least quarter full. */
+				memmove(chunk->items, &chunk->items[chunk->lo], sizeof(void*) * (chunk->hi - chunk->lo));
+				chunk->hi -= chunk->lo;
+				chunk->lo = 0;
+				memcpy(&chunk->items[chunk->hi], &next->items[next->lo], sizeof(void*) * (next->hi - next->lo));
+				chunk->hi += next->hi - next->lo;
+				destroy_chunk(list, next);
+			}
+			return removed;
+		}
+	}
+	return NULL;
+}
+
+void *list_popfirst(list_t *list) {
+	chunk_t	*chunk = list->head;
+	void	*item;
+
+	if(chunk == NULL) {
+		return NULL;
+	}
+	item = chunk->items[chunk->lo++];
+	if(chunk->lo == chunk->hi) {
+		destroy_chunk(list, chunk);
+	}
+	list->num_items--;
+	return item;
+}
+
+void *list_poplast(list_t *list) {
+	chunk_t	*chunk = list->tail;
+	void	*item;
+
+	if(chunk == NULL) {
+		return NULL;
+	}
+	item = chunk->items[--chunk->hi];
+	if(chunk->lo == chunk->hi) {
+		destroy_chunk(list, chunk);
+	}
+	list->num_items--;
+	return item;
+}
+
+/* List Contains: */
+int list_contains(list_t *list, void *item) {
+	for(chunk_t *chunk = list->head; chunk != NULL; chunk = chunk->next) {
+		for(int i = chunk->lo; i < chunk->hi; i++) {
+			if(list->cmpfunc(chunk->items[i], item) == 0) {
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* List Print: */
+void list_print(list_t *list, list_printfunc_t printfunc) {
+	for(chunk_t *chunk = list->head; chunk != NULL; chunk = chunk->next) {
+		for(int i = chunk->lo; i < chunk->hi; i++) {
+			printfunc(chunk->items[i]);
+		}
+	}
+}
+
+/* List Sort: */
+/* Merge sorted runs 'src[lo..mid)' and 'src[mid..hi)' into 'dst[lo..hi)'. Equal items keep their order. */
+static void merge(void **src, void **dst, int lo, int mid, int hi, cmpfunc_t cmpfunc) {
+	int a = lo, b = mid, k = lo;
+
+	while( (a < mid) && (b < hi) ) {
+		dst[k++] = (cmpfunc(src[b], src[a]) < 0) ? src[b++] : src[a++];
+	}
+	while(a < mid) {
+		dst[k++] = src[a++];
+	}
+	while(b < hi) {
+		dst[k++] = src[b++];
+	}
+}
+
+/* Items are gathered into one array and sorted bottom-up, alternating between two arrays,
+ * then written back into chunks filled from start, which also compacts list. */
+void list_sort(list_t *list) {
+	chunk_t	*chunk, *next;
+	void	**items, **tmp, **swap;
+	int		n = list->num_items, k;
+
+	if(n < 2) {
+		return;
+	}
+	items	= malloc(sizeof(void*) * n);
+	tmp		= malloc(sizeof(void*) * n);
+	if( (items == NULL) || (tmp == NULL) ) {
+		fatal_error("Out of memory.");
+	}
+
+	k = 0;
+	for(chunk = list->head; chunk != NULL; chunk = chunk->next) {
+		memcpy(&items[k], &chunk->items[chunk->lo], sizeof(void*) * (chunk->hi - chunk->lo));
+		k += chunk->hi - chunk->lo;
+	}
+
+	for(int width = 1; width < n; width *= 2) {
+		for(int lo = 0; lo < n; lo += 2 * width) {
+			int mid	= (lo + width < n) ? lo + width : n;
+			int hi	= (lo + 2 * width < n) ? lo + 2 * width : n;
+			merge(items, tmp, lo, mid, hi, list->cmpfunc);
+		}
+		swap = items; items = tmp; tmp = swap;
+	}
+
+	k = 0;
+	for(chunk = list->head; k < n; chunk = chunk->next) {
+		chunk->lo = 0;
+		chunk->hi = (n - k < CHUNKSIZE) ? n - k : CHUNKSIZE;
+		memcpy(chunk->items, &items[k], sizeof(void*) * chunk->hi);
+		k += chunk->hi;
+		list->tail = chunk;
+	}
+	for(; chunk != NULL; chunk = next) {	/* Free chunks left empty by compaction. */
+		next = chunk->next;
+		free(chunk);
+	}
+	list->tail->next = NULL;
+
+	free(items);
+	free(tmp);
+}
+
+
+/* List Iterator: */
+struct list_iterator {
+	list_t 	*list;
+	chunk_t	*chunk;
+	int		pos;
+};
+
+list_iterator_t *list_createiterator(list_t *list) {
+	list_iterator_t *iterator;
+
+	iterator = malloc(sizeof(list_iterator_t));
+	if(iterator == NULL) {
+		fatal_error("Out of memory.");
+	}
+	iterator->list = list;
+	list_resetiterator(iterator);
+
+	return iterator;
+}
+
+void list_destroyiterator(list_iterator_t *iterator) {
+	free(iterator);
+}
+
+int list_hasnext(list_iterator_t *iterator) {
+	if(iterator->chunk == NULL) {
+		return 0;
+	}
+	return 1;
+}
+
+void *list_next(list_iterator_t *iterator) {
+	void *item;
+
+	if(iterator->chunk == NULL) {
+		return NULL;
+	}
+	item = iterator->chunk->items[iterator->pos++];
+	if(iterator->pos == iterator->chunk->hi) {
+		iterator->chunk = iterator->chunk->next;
+		iterator->pos	= (iterator->chunk != NULL) ? iterator->chunk->lo : 0;
+	}
+
+	return item;
+}
+
+void *list_previous(list_iterator_t *iterator) {
+	void *item;
+
+	if(iterator->chunk == NULL) {
+		return NULL;
+	}
+	item = iterator->chunk->items[iterator->pos--];
+	if(iterator->pos < iterator->chunk->lo) {
+		iterator->chunk = iterator->chunk->previous;
+		iterator->pos	= (iterator->chunk != NULL) ? iterator->chunk->hi - 1 : 0;
+	}
+
+	return item;
+}
+
+void *list_current(list_iterator_t *iterator) {
+	if(iterator->chunk == NULL) {
+		return NULL;
+	}
+	return iterator->chunk->items[iterator->pos];
+}
+
+void list_resetiterator(list_iterator_t *iterator) {
+	iterator->chunk	= iterator->list->head;
+	iterator->pos	= (iterator->chunk != NULL) ? iterator->chunk->lo : 0;
+}
+
+void list_setiterator_end(list_iterator_t *iterator) {
+	iterator->chunk	= iterator->list->tail;
+	iterator->pos	= (iterator->chunk != NULL) ? iterator->chunk->hi - 1 : 0;
+}
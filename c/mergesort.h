@@ -0,0 +1,133 @@
+/* Author: Marius Ingebrigtsen */
+#ifndef __MERGESORT_H_
+#define __MERGESORT_H_
+
+#include "common.h"
+
+/* Runs shorter than this are extended by insertion before merging, as merging many short runs costs more. */
+#define MERGESORT_MINRUN	8
+/* Run-stack depth; lengths on stack grow at least as Fibonacci numbers downwards, so this covers any list of 'int' length. */
+#define MERGESORT_STACK		64
+
+
+/* Define 'static type *name(type *head, cmpfunc_t cmpfunc)', sorting singly linked nodes of 'type',
+ * linked by pointer-field 'next' and ordered by 'cmpfunc' on field 'key'. Return new head; last node links to NULL.
+ * 
+ * Bottom-up natural mergesort: list is taken apart into ascending runs already in it,
+ * descending runs are reversed, and runs are merged on a stack, as in timsort, without recursion.
+ * A sorted or reverse-sorted list is one run, and sorted in O(n); otherwise O(n log n). Stable.
+ * Only 'next' is followed; links backwards, and tail, must be restored by caller. */
+#define MERGESORT_DEFINE(name, type, next, key)										\
+																					\
+static type *name##_merge(type *a, type *b, cmpfunc_t cmpfunc) {					\
+	type *head, **tail = &head;														\
+																					\
+	while( (a != NULL) && (b != NULL) ) {											\
+		if(cmpfunc(b->key, a->key) < 0) {											\
+			*tail	= b;															\
+			tail	= &b->next;														\
+			b		= b->next;														\
+		} else {																	\
+			*tail	= a;															\
+			tail	= &a->next;														\
+			a		= a->next;														\
+		}																			\
+	}																				\
+	*tail = (a != NULL) ? a : b;													\
+																					\
+	return head;																	\
+}																					\
+																					\
+/* Merge runs 'i' and 'i + 1' of stack. */											\
+static void name##_merge_at(type **runs, int *lengths, int *top, int i, cmpfunc_t cmpfunc) {	\
+	runs[i]		= name##_merge(runs[i], runs[i + 1], cmpfunc);						\
+	lengths[i]	+= lengths[i + 1];													\
+	if(i + 2 < *top) {																\
+		runs[i + 1]		= runs[i + 2];												\
+		lengths[i + 1]	= lengths[i + 2];											\
+	}																				\
+	(*top)--;																		\
+}																					\
+																					\
+/* Merge runs on stack until lengths grow at least as fast as Fibonacci numbers downwards (timsort),	\
+ * so stack stays shallow, and runs merged are of about equal length. */			\
+static void name##_collapse(type **runs, int *lengths, int *top, cmpfunc_t cmpfunc) {	\
+	int i;																			\
+																					\
+	while(*top > 1) {																\
+		i = *top - 2;																\
+		if( ((i > 0) && (lengths[i - 1] <= lengths[i] + lengths[i + 1])) ||		\
+			((i > 1) && (lengths[i - 2] <= lengths[i - 1] + lengths[i])) ) {		\
+			if(lengths[i - 1] < lengths[i + 1]) {									\
+				i--;																\
+			}																		\
+		}																			\
+		else if(lengths[i] > lengths[i + 1]) {										\
+			return;																	\
+		}																			\
+		name##_merge_at(runs, lengths, top, i, cmpfunc);							\
+	}																				\
+}																					\
+																					\
+static type *name(type *head, cmpfunc_t cmpfunc) {									\
+	type	*runs[MERGESORT_STACK], *run, *last, *node, *p;							\
+	int		lengths[MERGESORT_STACK], top = 0, num;									\
+																					\
+	while(head != NULL) {															\
+		/* Take next run off list; strictly descending run is reversed while taken. */	\
+		run = last = head;															\
+		head = head->next;															\
+		num = 1;																	\
+		if( (head != NULL) && (cmpfunc(head->key, run->key) < 0) ) {				\
+			while( (head != NULL) && (cmpfunc(head->key, run->key) < 0) ) {			\
+				node		= head;													\
+				head		= head->next;											\
+				node->next	= run;													\
+				run			= node;													\
+				num++;																\
+			}																		\
+		} else {																	\
+			while( (head != NULL) && (cmpfunc(head->key, last->key) >= 0) ) {		\
+				last = head;														\
+				head = head->next;													\
+				num++;																\
+			}																		\
+		}																			\
+		last->next = NULL;															\
+																					\
+		/* Extend short run by insertion; after equal keys, so still stable. */		\
+		while( (num < MERGESORT_MINRUN) && (head != NULL) ) {						\
+			node = head;															\
+			head = head->next;														\
+			if(cmpfunc(node->key, last->key) >= 0) {								\
+				last->next	= node;													\
+				last		= node;													\
+				node->next	= NULL;													\
+			}																		\
+			else if(cmpfunc(node->key, run->key) < 0) {								\
+				node->next	= run;													\
+				run			= node;													\
+			}																		\
+			else {																	\
+				for(p = run; cmpfunc(node->key, p->next->key) >= 0; p = p->next);	\
+				node->next	= p->next;												\
+				p->next		= node;													\
+			}																		\
+			num++;																	\
+		}																			\
+																					\
+		runs[top]		= run;														\
+		lengths[top]	= num;														\
+		top++;																		\
+		name##_collapse(runs, lengths, &top, cmpfunc);								\
+	}																				\
+																					\
+	run = NULL;																		\
+	while(top > 0) {																\
+		top--;																		\
+		run = (run == NULL) ? runs[top] : name##_merge(runs[top], run, cmpfunc);	\
+	}																				\
+	return run;																		\
+}
+
+#endif
@@ -0,0 +1,121 @@
+/* Author: Marius Ingebrigtsen */
+#define _GNU_SOURCE
+
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "perf.h"
+
+/* Cache-event configuration; cache, operation and result. */
+#define CACHE_EVENT(cache, op, result) ( (cache) | ((op) << 8) | ((result) << 16) )
+
+/* Perf Structure:
+ * 'leader' is descriptor of first counter opened; every other counter is opened in its group. */
+struct perf {
+	int	fd[PERF_NUMEVENTS], leader;
+	int	index[PERF_NUMEVENTS];	/* Position of counter in group read, -1 if not opened. */
+	int	num;
+};
+
+/* Group read, with 'PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING'. */
+typedef struct group_read {
+	unsigned long long nr, enabled, running, value[PERF_NUMEVENTS];
+} group_read_t;
+
+static const struct {
+	const char			*name;
+	unsigned int		type;
+	unsigned long long	config;
+} events[PERF_NUMEVENTS] = {
+	{ "Cycles",			PERF_TYPE_HARDWARE,	PERF_COUNT_HW_CPU_CYCLES },
+	{ "Instructions",	PERF_TYPE_HARDWARE,	PERF_COUNT_HW_INSTRUCTIONS },
+	{ "L1D Misses",		PERF_TYPE_HW_CACHE,	CACHE_EVENT(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+	{ "LLC Misses",		PERF_TYPE_HARDWARE,	PERF_COUNT_HW_CACHE_MISSES },
+	{ "dTLB Misses",	PERF_TYPE_HW_CACHE,	CACHE_EVENT(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+	{ "Branch Misses",	PERF_TYPE_HARDWARE,	PERF_COUNT_HW_BRANCH_MISSES }
+};
+
+
+/* Perf Create: */
+static int event_open(perf_event_t event, int leader) {
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size			= sizeof(attr);
+	attr.type			= events[event].type;
+	attr.config			= events[event].config;
+	attr.disabled		= (leader == -1);	/* Group is enabled and disabled by its leader. */
+	attr.exclude_kernel	= 1;
+	attr.exclude_hv		= 1;
+	attr.read_format	= PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	return syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+}
+
+perf_t *perf_create(void) {
+	perf_t *perf;
+
+	perf = malloc(sizeof(perf_t));
+	if(perf == NULL) {
+		fatal_error("Out of memory.");
+	}
+	perf->leader	= -1;
+	perf->num		= 0;
+
+	for(perf_event_t e = 0; e < PERF_NUMEVENTS; e++) {
+		perf->fd[e]		= event_open(e, perf->leader);
+		perf->index[e]	= -1;
+
+		if(perf->fd[e] >= 0) {
+			perf->leader	= (perf->leader == -1) ? perf->fd[e] : perf->leader;
+			perf->index[e]	= perf->num++;
+		}
+	}
+	if(perf->num == 0) {
+		free(perf);
+		return NULL;
+	}
+	return perf;
+}
+
+/* Perf Destroy: */
+void perf_destroy(perf_t *perf) {
+	for(perf_event_t e = 0; e < PERF_NUMEVENTS; e++) {
+		if(perf->fd[e] >= 0) {
+			close(perf->fd[e]);
+		}
+	}
+	free(perf);
+}
+
+/* Perf Start: */
+void perf_start(perf_t *perf) {
+	ioctl(perf->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(perf->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+/* Perf Stop: */
+void perf_stop(perf_t *perf, perf_counts_t *counts) {
+	group_read_t	group;
+	double			scale;
+
+	ioctl(perf->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+	if(read(perf->leader, &group, sizeof(group)) < (ssize_t)(sizeof(unsigned long long) * (3 + perf->num))) {
+		fatal_error("Couldn't read performance counters.");
+	}
+	/* Group never scheduled has no counts to scale. */
+	scale = (group.running > 0) ? (double)group.enabled / group.running : -1;
+
+	for(perf_event_t e = 0; e < PERF_NUMEVENTS; e++) {
+		counts->count[e] = ( (perf->index[e] >= 0) && (scale > 0) ) ? group.value[perf->index[e]] * scale : -1;
+	}
+}
+
+/* Perf Name: */
+const char *perf_name(perf_event_t event) {
+	return events[event].name;
+}
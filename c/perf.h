@@ -0,0 +1,42 @@
+/* Author: Marius Ingebrigtsen */
+#ifndef __PERF_H_
+#define __PERF_H_
+
+#include "common.h"
+
+/* Hardware Performance Counters.
+ * Counters are opened by 'perf_event_open()' as one group, so all are counted over exactly the same instructions,
+ * and count user-space of calling thread only; threads it creates are not counted.
+ * If processor multiplexes group with other events, counts are scaled up by time enabled over time running.
+ * Counters not supported by processor or virtual machine, or denied by 'perf_event_paranoid', are left out, not fatal. */
+typedef enum perf_event {
+	PERF_CYCLES, PERF_INSTRUCTIONS, PERF_L1D_MISSES, PERF_LLC_MISSES, PERF_DTLB_MISSES, PERF_BRANCH_MISSES,
+	PERF_NUMEVENTS
+} perf_event_t;
+
+/* Group of counters. */
+typedef struct perf perf_t;
+
+/* Counts of one region. Counter not opened, or never scheduled on processor, is -1. */
+typedef struct perf_counts {
+	double count[PERF_NUMEVENTS];
+} perf_counts_t;
+
+
+/* Open counters of calling thread.
+ * Return NULL if no counter could be opened. */
+perf_t *perf_create(void);
+
+/* Close counters. */
+void perf_destroy(perf_t *perf);
+
+/* Reset counters to zero and start counting. */
+void perf_start(perf_t *perf);
+
+/* Stop counting, and put counts since 'perf_start()' into 'counts'. */
+void perf_stop(perf_t *perf, perf_counts_t *counts);
+
+/* Return name of event. */
+const char *perf_name(perf_event_t event);
+
+#endif
@@ -0,0 +1,134 @@
+/* Author: Marius Ingebrigtsen */
+#include "../common.h"
+#include "../gettime.h"
+#include "./pool.h"
+
+/* Below this, fibonacci is computed without spawning. */
+#define CUTOFF	12
+
+typedef struct fib {
+	pool_t	*pool;
+	int		n;
+	long	result;
+} fib_t;
+
+/* Array summed in parallel; each part adds into 'sums[part]', and parts are added after. */
+typedef struct sum {
+	int		*values;
+	long	*sums;
+	int		grain;
+} sum_t;
+
+
+static long fib_sequential(int n) {
+	return (n < 2) ? n : fib_sequential(n - 1) + fib_sequential(n - 2);
+}
+
+/* Spawn one half of recursion, compute other half, and sync; groups nest with recursion. */
+static void fib_task(fib_t *fib) {
+	pool_group_t	group;
+	fib_t			left, right;
+
+	if(fib->n < CUTOFF) {
+		fib->result = fib_sequential(fib->n);
+		return;
+	}
+	left.pool	= right.pool = fib->pool;
+	left.n		= fib->n - 1;
+	right.n		= fib->n - 2;
+
+	pool_group_init(&group);
+	pool_spawn(fib->pool, &group, (taskfunc_t)fib_task, &left);
+	fib_task(&right);
+	pool_sync(fib->pool, &group);
+
+	fib->result = left.result + right.result;
+}
+
+static void sum_range(sum_t *sum, int lo, int hi) {
+	long s = 0;
+
+	for(int i = lo; i < hi; i++) {
+		s += sum->values[i];
+	}
+	sum->sums[lo / sum->grain] = s;
+}
+
+static void assert_fib(pool_t *pool, int n) {
+	unsigned long long t1, t2, t3;
+	fib_t	fib;
+	long	expect;
+
+	fib.pool	= pool;
+	fib.n		= n;
+
+	t1 = gettime();
+	expect = fib_sequential(n);
+	t2 = gettime();
+	fib_task(&fib);
+	t3 = gettime();
+
+	if(fib.result != expect) {
+		fatal_error("Fibonacci of \'%d\'; \'%ld\', expected \'%ld\'. \n", n, fib.result, expect);
+	}
+	printf("Fibonacci of %d with %d workers; sequential %llu, spawn/sync %llu microsec. \n", n, pool_workers(pool), t2 - t1, t3 - t2);
+}
+
+static void assert_parallel_for(pool_t *pool, int num, int grain) {
+	unsigned long long t1, t2, t3;
+	sum_t	sum;
+	long	total = 0, expect = 0;
+
+	sum.values	= malloc(sizeof(int) * num);
+	sum.sums	= calloc(num / grain + 1, sizeof(long));
+	sum.grain	= grain;
+	if( (sum.values == NULL) || (sum.sums == NULL) ) {
+		fatal_error("Out of memory.");
+	}
+	for(int i = 0; i < num; i++) {
+		sum.values[i] = rand() % 1000;
+	}
+
+	t1 = gettime();
+	for(int i = 0; i < num; i++) {
+		expect += sum.values[i];
+	}
+	t2 = gettime();
+	/* Parts start at multiples of 'grain' only if 'num' splits evenly; power of 2 is used below. */
+	pool_parallel_for(pool, 0, num, grain, (rangefunc_t)sum_range, &sum);
+	for(int i = 0; i <= num / grain; i++) {
+		total += sum.sums[i];
+	}
+	t3 = gettime();
+
+	if(total != expect) {
+		fatal_error("Parallel sum of \'%d\'; \'%ld\', expected \'%ld\'. \n", num, total, expect);
+	}
+	printf("Sum of %d with %d workers; sequential %llu, parallel-for %llu microsec. \n", num, pool_workers(pool), t2 - t1, t3 - t2);
+
+	free(sum.values);
+	free(sum.sums);
+}
+
+int main(int argc, char **argv) {
+	pool_t	*pool;
+	int		n, maxworkers;
+
+	if(argc < 3) {
+		printf("Usage: %s <fibonacci-n> <max-workers> \n", *argv);
+		return -1;
+	}
+	n			= atoi(argv[1]);
+	maxworkers	= atoi(argv[2]);
+
+	for(int workers = 1; workers <= maxworkers; workers *= 2) {
+		pool = pool_create(workers);
+
+		assert_fib(pool, n);
+		assert_parallel_for(pool, 1 << 24, 1 << 12);
+		assert_parallel_for(pool, 1 << 10, 1);
+
+		pool_destroy(pool);
+	}
+	return 0;
+}
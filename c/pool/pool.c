@@ -0,0 +1,438 @@
+/* Author: Marius Ingebrigtsen */
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "../queue/queue.h"
+#include "pool.h"
+
+#define CACHELINE	64
+/* Initial number of slots in deque; doubled when full. */
+#define DEQUESIZE	256
+/* Capacity of queue for tasks spawned outside pool. When full, task is run by spawning thread. */
+#define INJECTSIZE	1024
+/* Finished tasks kept by each worker for reuse. */
+#define FREESIZE	256
+/* Failed searches for work before worker sleeps. */
+#define SPINS		64
+
+typedef struct task task_t;
+struct task {
+	taskfunc_t		func;		/* NULL for part of 'pool_parallel_for()'. */
+	rangefunc_t		range;
+	void			*arg;
+	int				lo, hi, grain;
+	pool_group_t	*group;
+	task_t			*next;		/* Free-list of worker. */
+};
+
+/* Circular array of deque. Arrays replaced by growth are kept in 'prev' until deque is destroyed,
+ * since a thief may still read from them. */
+typedef struct array array_t;
+struct array {
+	long			size;
+	array_t			*prev;
+	_Atomic(task_t*) slots[];
+};
+
+/* Chase-Lev deque (Le et al. 2013, C11 memory model).
+ * Owner pushes and takes at 'bottom', thieves steal at 'top'. */
+typedef struct deque {
+	_Alignas(CACHELINE) atomic_long	top;
+	_Alignas(CACHELINE) atomic_long	bottom;
+	_Atomic(array_t*)				array;
+} deque_t;
+
+typedef struct worker {
+	deque_t			deque;
+	pool_t			*pool;
+	pthread_t		thread;
+	task_t			*free;
+	int				num_free;
+	unsigned int	seed;
+} worker_t;
+
+struct pool {
+	worker_t		*workers;
+	int				num_workers;
+	queue_t			*inject;
+	atomic_int		sleepers, shutdown;
+	pthread_mutex_t	lock;
+	pthread_cond_t	wake;
+};
+
+/* Worker of calling thread, NULL for threads outside any pool. */
+static _Thread_local worker_t *self;
+
+
+/* Deque: */
+static array_t *array_create(long size, array_t *prev) {
+	array_t *array;
+
+	array = malloc(sizeof(array_t) + sizeof(_Atomic(task_t*)) * size);
+	if(array == NULL) {
+		fatal_error("Out of memory.");
+	}
+	array->size	= size;
+	array->prev	= prev;
+	return array;
+}
+
+static void deque_init(deque_t *deque) {
+	atomic_init(&deque->top, 0);
+	atomic_init(&deque->bottom, 0);
+	atomic_init(&deque->array, array_create(DEQUESIZE, NULL));
+}
+
+static void deque_destroy(deque_t *deque) {
+	array_t *array, *prev;
+
+	for(array = atomic_load(&deque->array); array != NULL; array = prev) {
+		prev = array->prev;
+		free(array);
+	}
+}
+
+/* Owner only. Copy tasks from 'top' to 'bottom' into array of double size. */
+static array_t *deque_grow(deque_t *deque, array_t *array, long top, long bottom) {
+	array_t *grown = array_create(array->size * 2, array);
+
+	for(long i = top; i < bottom; i++) {
+		atomic_store_explicit(&grown->slots[i & (grown->size - 1)],
+			atomic_load_explicit(&array->slots[i & (array->size - 1)], memory_order_relaxed), memory_order_relaxed);
+	}
+	atomic_store_explicit(&deque->array, grown, memory_order_release);
+	return grown;
+}
+
+/* Owner only. */
+static void deque_push(deque_t *deque, task_t *task) {
+	long	bottom	= atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	long	top		= atomic_load_explicit(&deque->top, memory_order_acquire);
+	array_t	*array	= atomic_load_explicit(&deque->array, memory_order_relaxed);
+
+	if(bottom - top > array->size - 1) {
+		array = deque_grow(deque, array, top, bottom);
+	}
+	atomic_store_explicit(&array->slots[bottom & (array->size - 1)], task, memory_order_relaxed);
+	/* Release store in stead of release fence; same cost, and visible to thread-sanitizer. */
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_release);
+}
+
+/* Owner only. Return newest task, or NULL if empty.
+ * Only last task can be contended with a thief, and is then claimed by compare-and-swap on 'top'. */
+static task_t *deque_take(deque_t *deque) {
+	long	bottom	= atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+	array_t	*array	= atomic_load_explicit(&deque->array, memory_order_relaxed);
+	long	top;
+	task_t	*task;
+
+	atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+	if(top > bottom) {	/* Empty. */
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+		return NULL;
+	}
+	task = atomic_load_explicit(&array->slots[bottom & (array->size - 1)], memory_order_relaxed);
+	if(top == bottom) {	/* Last task; race thieves for it. */
+		if( !atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed) ) {
+			task = NULL;
+		}
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+	}
+	return task;
+}
+
+/* Any thread. Return oldest task, or NULL if empty or lost race for it. */
+static task_t *deque_steal(deque_t *deque) {
+	long	top		= atomic_load_explicit(&deque->top, memory_order_acquire);
+	long	bottom;
+	array_t	*array;
+	task_t	*task;
+
+	atomic_thread_fence(memory_order_seq_cst);
+	bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+	if(top >= bottom) {
+		return NULL;
+	}
+	array	= atomic_load_explicit(&deque->array, memory_order_acquire);
+	task	= atomic_load_explicit(&array->slots[top & (array->size - 1)], memory_order_relaxed);
+	if( !atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed) ) {
+		return NULL;
+	}
+	return task;
+}
+
+static int deque_empty(deque_t *deque) {
+	return atomic_load(&deque->top) >= atomic_load(&deque->bottom);
+}
+
+
+/* Tasks: */
+static task_t *task_create(pool_group_t *group) {
+	task_t *task;
+
+	if( (self != NULL) && (self->free != NULL) ) {
+		task		= self->free;
+		self->free	= task->next;
+		self->num_free--;
+	} else {
+		task = malloc(sizeof(task_t));
+		if(task == NULL) {
+			fatal_error("Out of memory.");
+		}
+	}
+	task->group = group;
+	return task;
+}
+
+static void task_destroy(task_t *task) {
+	if( (self != NULL) && (self->num_free < FREESIZE) ) {
+		task->next	= self->free;
+		self->free	= task;
+		self->num_free++;
+	} else {
+		free(task);
+	}
+}
+
+static void range_run(pool_t *pool, pool_group_t *group, int lo, int hi, int grain, rangefunc_t func, void *arg);
+
+static void task_run(pool_t *pool, task_t *task) {
+	pool_group_t *group = task->group;
+
+	if(task->func != NULL) {
+		task->func(task->arg);
+	} else {
+		range_run(pool, group, task->lo, task->hi, task->grain, task->range, task->arg);
+	}
+	task_destroy(task);
+
+	atomic_fetch_sub_explicit(&group->pending, 1, memory_order_release);
+}
+
+/* Wake one sleeping worker, if any. Fence orders publication of task before reading 'sleepers';
+ * sleeping worker increments 'sleepers' before its last look for work, so either sees the other. */
+static void wake_worker(pool_t *pool) {
+	atomic_thread_fence(memory_order_seq_cst);
+	if(atomic_load_explicit(&pool->sleepers, memory_order_relaxed) > 0) {
+		pthread_mutex_lock(&pool->lock);
+		pthread_cond_signal(&pool->wake);
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+static void submit(pool_t *pool, task_t *task) {
+	atomic_fetch_add_explicit(&task->group->pending, 1, memory_order_relaxed);
+
+	if( (self != NULL) && (self->pool == pool) ) {
+		deque_push(&self->deque, task);
+	}
+	else if( !queue_addlast(pool->inject, task) ) {	/* Shared queue full; run in spawning thread. */
+		task_run(pool, task);
+		return;
+	}
+	wake_worker(pool);
+}
+
+/* Return task from own deque, shared queue, or deque of other worker starting at random, in that order. */
+static task_t *find_task(pool_t *pool) {
+	worker_t	*worker = ( (self != NULL) && (self->pool == pool) ) ? self : NULL;
+	task_t		*task;
+	int			start;
+
+	if( (worker != NULL) && ((task = deque_take(&worker->deque)) != NULL) ) {
+		return task;
+	}
+	if( (task = queue_popfirst(pool->inject)) != NULL ) {
+		return task;
+	}
+	start = (worker != NULL) ? (int)(rand_r(&worker->seed) % pool->num_workers) : 0;
+	for(int i = 0; i < pool->num_workers; i++) {
+		worker_t *victim = &pool->workers[(start + i) % pool->num_workers];
+
+		if( (victim != worker) && ((task = deque_steal(&victim->deque)) != NULL) ) {
+			return task;
+		}
+	}
+	return NULL;
+}
+
+static int has_task(pool_t *pool) {
+	if(queue_size(pool->inject) > 0) {
+		return 1;
+	}
+	for(int i = 0; i < pool->num_workers; i++) {
+		if( !deque_empty(&pool->workers[i].deque) ) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+/* Workers: */
+static void *worker_loop(worker_t *worker) {
+	pool_t	*pool = worker->pool;
+	task_t	*task;
+	int		spins = 0;
+
+	self = worker;
+
+	while( !atomic_load(&pool->shutdown) ) {
+		if( (task = find_task(pool)) != NULL ) {
+			task_run(pool, task);
+			spins = 0;
+		}
+		else if(++spins < SPINS) {
+			sched_yield();
+		}
+		else {	/* Sleep until task is spawned, or pool destroyed. */
+			pthread_mutex_lock(&pool->lock);
+			atomic_fetch_add(&pool->sleepers, 1);
+			atomic_thread_fence(memory_order_seq_cst);
+			if( !has_task(pool) && !atomic_load(&pool->shutdown) ) {
+				pthread_cond_wait(&pool->wake, &pool->lock);
+			}
+			atomic_fetch_sub(&pool->sleepers, 1);
+			pthread_mutex_unlock(&pool->lock);
+			spins = 0;
+		}
+	}
+	return NULL;
+}
+
+
+/* Pool Create & Destroy: */
+pool_t *pool_create(int workers) {
+	pool_t *pool;
+
+	if(workers <= 0) {
+		workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+		workers = (workers > 0) ? workers : 1;
+	}
+	pool = malloc(sizeof(pool_t));
+	if(pool == NULL) {
+		fatal_error("Out of memory.");
+	}
+	pool->workers = aligned_alloc(CACHELINE, sizeof(worker_t) * workers);
+	if(pool->workers == NULL) {
+		fatal_error("Out of memory.");
+	}
+	pool->num_workers	= workers;
+	pool->inject		= queue_create(INJECTSIZE);
+	atomic_init(&pool->sleepers, 0);
+	atomic_init(&pool->shutdown, 0);
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+
+	for(int i = 0; i < workers; i++) {
+		deque_init(&pool->workers[i].deque);
+		pool->workers[i].pool		= pool;
+		pool->workers[i].free		= NULL;
+		pool->workers[i].num_free	= 0;
+		pool->workers[i].seed		= (unsigned int)i + 1;
+	}
+	for(int i = 0; i < workers; i++) {
+		if(pthread_create(&pool->workers[i].thread, NULL, (void *(*)(void*))worker_loop, &pool->workers[i]) != 0) {
+			fatal_error("Unable to create thread.");
+		}
+	}
+	return pool;
+}
+
+void pool_destroy(pool_t *pool) {
+	task_t *task;
+
+	pthread_mutex_lock(&pool->lock);
+	atomic_store(&pool->shutdown, 1);
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	for(int i = 0; i < pool->num_workers; i++) {
+		pthread_join(pool->workers[i].thread, NULL);
+	}
+	for(int i = 0; i < pool->num_workers; i++) {
+		while( (task = pool->workers[i].free) != NULL ) {
+			pool->workers[i].free = task->next;
+			free(task);
+		}
+		deque_destroy(&pool->workers[i].deque);
+	}
+	queue_destroy(pool->inject, NULL);
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->wake);
+	free(pool->workers);
+	free(pool);
+}
+
+int pool_workers(pool_t *pool) {
+	return pool->num_workers;
+}
+
+
+/* Pool Spawn & Sync: */
+void pool_group_init(pool_group_t *group) {
+	atomic_init(&group->pending, 0);
+}
+
+void pool_spawn(pool_t *pool, pool_group_t *group, taskfunc_t func, void *arg) {
+	task_t *task = task_create(group);
+
+	task->func	= func;
+	task->arg	= arg;
+	submit(pool, task);
+}
+
+void pool_sync(pool_t *pool, pool_group_t *group) {
+	task_t *task;
+
+	while(atomic_load_explicit(&group->pending, memory_order_acquire) > 0) {
+		if( (task = find_task(pool)) != NULL ) {
+			task_run(pool, task);
+		} else {
+			sched_yield();
+		}
+	}
+}
+
+
+/* Pool Parallel-For: */
+/* Spawn upper half of range until at most 'grain' indexes remain, and run remaining lower part. */
+static void range_run(pool_t *pool, pool_group_t *group, int lo, int hi, int grain, rangefunc_t func, void *arg) {
+	task_t	*task;
+	int		mid;
+
+	while(hi - lo > grain) {
+		mid = lo + (hi - lo) / 2;
+
+		task		= task_create(group);
+		task->func	= NULL;
+		task->range	= func;
+		task->arg	= arg;
+		task->lo	= mid;
+		task->hi	= hi;
+		task->grain	= grain;
+		submit(pool, task);
+
+		hi = mid;
+	}
+	if(lo < hi) {
+		func(arg, lo, hi);
+	}
+}
+
+void pool_parallel_for(pool_t *pool, int lo, int hi, int grain, rangefunc_t func, void *arg) {
+	pool_group_t group;
+
+	if(grain <= 0) {
+		grain = (hi - lo) / (8 * pool->num_workers);
+		grain = (grain > 0) ? grain : 1;
+	}
+	pool_group_init(&group);
+	range_run(pool, &group, lo, hi, grain, func, arg);
+	pool_sync(pool, &group);
+}
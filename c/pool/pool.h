@@ -0,0 +1,55 @@
+/* Author: Marius Ingebrigtsen */
+#ifndef __POOL_H_
+#define __POOL_H_
+
+#include <stdatomic.h>
+
+#include "../common.h"
+
+/* Work-Stealing Thread-Pool Structure.
+ * Each worker keeps spawned tasks in its own Chase-Lev deque, and runs newest task first,
+ * so a worker forking recursively works on data still in its cache, without synchronising with other workers.
+ * An idle worker steals oldest task of a random worker, usually the largest piece of remaining work.
+ * Tasks spawned by threads outside pool are put in a shared queue for workers to take. */
+typedef struct pool pool_t;
+
+/* Function-pointer for task, called with argument given to 'pool_spawn()'. */
+typedef void (*taskfunc_t)(void *arg);
+
+/* Function-pointer for part of loop, called for every index from 'lo' to 'hi - 1'. */
+typedef void (*rangefunc_t)(void *arg, int lo, int hi);
+
+/* Group of spawned tasks waited for together by 'pool_sync()'.
+ * Declare on stack of spawning function, and initialise with 'pool_group_init()' before first spawn. */
+typedef struct pool_group {
+	atomic_int pending;
+} pool_group_t;
+
+
+/* Return new pool of 'workers' threads.
+ * Pass 0 to use one worker per online processor. */
+pool_t *pool_create(int workers);
+
+/* Stop workers and destroy pool.
+ * NOTE: Every group must be synced before destruction. */
+void pool_destroy(pool_t *pool);
+
+/* Return number of worker-threads in pool. */
+int pool_workers(pool_t *pool);
+
+/* Initialise empty group. */
+void pool_group_init(pool_group_t *group);
+
+/* Run 'func(arg)' as task of group, possibly in parallel with caller. */
+void pool_spawn(pool_t *pool, pool_group_t *group, taskfunc_t func, void *arg);
+
+/* Wait until every task of group is done.
+ * Waiting thread runs other tasks of pool meanwhile, so tasks may spawn and sync groups of their own. */
+void pool_sync(pool_t *pool, pool_group_t *group);
+
+/* Call 'func' for every index from 'lo' to 'hi - 1' in parallel, and return when every call is done.
+ * Range is split in halves until parts are at most 'grain' indexes, and each part is a task.
+ * Pass 0 as 'grain' to split into about 8 parts per worker. */
+void pool_parallel_for(pool_t *pool, int lo, int hi, int grain, rangefunc_t func, void *arg);
+
+#endif
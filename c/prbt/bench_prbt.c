@@ -0,0 +1,177 @@
+/* Author: Marius Ingebrigtsen */
+#include "../common.h"
+#include "../bench.h"
+#include "../rbt/rbt.h"
+#include "./prbt.h"
+
+#define START	1024		/* 2^10 */
+#define MAXELEM	1048576+1	/* 2^20 + 1 */
+#define WRITES	64			/* Inserts by writer while each snapshot is held. */
+
+typedef struct data {
+	int *key, *item;
+} data_t;
+
+/* State of one trial, passed to setup, trial and teardown by harness. */
+typedef struct trial {
+	prbt_t	*prbt;
+	rbt_t	*rbt;
+	data_t	*data, *extra;
+	int		elem;
+} trial_t;
+
+
+static int cmpint(int *a, int *b) {
+	return *a - *b;
+}
+
+static data_t *data_create(int num) {
+	data_t *data;
+
+	data = calloc(num, sizeof(data_t));
+	if(data == NULL) {
+		fatal_error("Out of memory.");
+	}
+
+	for(int i = 0; i < num; i++) {
+		data[i].key = new_integer(i);
+		data[i].item = new_integer(i);
+	}
+
+	return data;
+}
+
+static void data_destroy(data_t *data, int num) {
+	for(int i = 0; i < num; i++) {
+		free(data[i].key);
+		free(data[i].item);
+	}
+	free(data);
+}
+
+/* Insert into newest version, and destroy previous; nodes are private and mostly modified in place. */
+static prbt_t *prbt_replace(prbt_t *version, void *key, void *item) {
+	prbt_t *next;
+
+	next = prbt_insert(version, key, item);
+	prbt_destroy(version);
+
+	return next;
+}
+
+static void setup_insert(trial_t *trial) {
+	trial->prbt = prbt_create( (cmpfunc_t)cmpint );
+	trial->data = data_create(trial->elem);
+}
+
+static void teardown_insert(trial_t *trial) {
+	prbt_destroy(trial->prbt);
+	data_destroy(trial->data, trial->elem);
+}
+
+static void trial_insert(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		trial->prbt = prbt_replace(trial->prbt, trial->data[i].key, trial->data[i].item);
+	}
+}
+
+/* Persistent tree takes snapshot, and writer copies paths. */
+static void trial_snapshot(trial_t *trial) {
+	prbt_t *snapshot;
+
+	snapshot = prbt_snapshot(trial->prbt);
+	for(int i = 0; i < WRITES; i++) {
+		trial->prbt = prbt_replace(trial->prbt, trial->extra[i].key, trial->extra[i].item);
+	}
+	prbt_destroy(snapshot);
+}
+
+/* Rbt is copied in whole. */
+static void trial_copy(trial_t *trial) {
+	rbt_t			*copy;
+	rbt_iterator_t	*iterator;
+	int				*item;
+
+	copy = rbt_create( (cmpfunc_t)cmpint );
+	iterator = rbt_createiterator(trial->rbt);
+	while( (item = rbt_next(iterator)) != NULL ) {
+		rbt_insert(copy, item, item);
+	}
+	rbt_destroyiterator(iterator);
+
+	for(int i = 0; i < WRITES; i++) {
+		rbt_insert(trial->rbt, trial->extra[i].key, trial->extra[i].item);
+	}
+	rbt_destroy(copy, NULL, NULL);
+}
+
+static void assert_insert(char *bnch_file) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
+
+	file = bench_open(bnch_file, "PRBT Insert Benchmarks");
+
+	for(int elem = START; elem < MAXELEM; elem *= 2) {
+		trial.elem = elem;
+
+		bench_run(&stats, (benchfunc_t)setup_insert, (benchfunc_t)trial_insert, (benchfunc_t)teardown_insert, &trial, elem);
+		bench_write(file, elem, &stats);
+	}
+	bench_close(file);
+}
+
+/* Time for reader to get stable view of map, while writer performs 'WRITES' inserts; time is per snapshot.
+ * Every trial snapshots same tree, so it is filled once per set of elements. */
+static void assert_snapshot(char *bnch_file, int persistent) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
+	char			title[128];
+
+	sprintf(title, "%s Snapshot Benchmarks, %d writes per snapshot", persistent ? "PRBT" : "RBT Copy", WRITES);
+	file = bench_open(bnch_file, title);
+
+	for(int elem = START; elem < MAXELEM; elem *= 2) {
+		trial.elem	= elem;
+		trial.data	= data_create(elem);
+		trial.extra	= data_create(WRITES);
+		trial.prbt	= prbt_create( (cmpfunc_t)cmpint );
+		trial.rbt	= rbt_create( (cmpfunc_t)cmpint );
+
+		for(int i = 0; i < elem; i++) {
+			if(persistent) {
+				trial.prbt = prbt_replace(trial.prbt, trial.data[i].key, trial.data[i].item);
+			} else {
+				rbt_insert(trial.rbt, trial.data[i].key, trial.data[i].item);
+			}
+		}
+		/* Writes overwrite keys spread evenly over tree. */
+		for(int i = 0; i < WRITES; i++) {
+			*trial.extra[i].key = i * (elem / WRITES);
+		}
+
+		bench_run(&stats, NULL, persistent ? (benchfunc_t)trial_snapshot : (benchfunc_t)trial_copy, NULL, &trial, 1);
+		bench_write(file, elem, &stats);
+
+		prbt_destroy(trial.prbt);
+		rbt_destroy(trial.rbt, NULL, NULL);
+		data_destroy(trial.data, elem);
+		data_destroy(trial.extra, WRITES);
+	}
+	bench_close(file);
+}
+
+int main(int argc, char **argv) {
+
+	if(argc < 4) {
+		printf("Usage: %s <insert-file> <prbt-snapshot-file> <rbt-copy-file> \n", *argv);
+		return -1;
+	}
+
+	assert_insert(argv[1]);
+	assert_snapshot(argv[2], 1);
+	assert_snapshot(argv[3], 0);
+
+	return 0;
+}
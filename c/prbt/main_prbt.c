@@ -0,0 +1,125 @@
+/* Author: Marius Ingebrigtsen */
+#include <pthread.h>
+
+#include "../common.h"
+#include "./prbt.h"
+
+#define NUMELEM		65536
+#define NUMREADER	8
+
+typedef struct data {
+	int *key, *item;
+} data_t;
+
+/* Reader gets own snapshot of version holding keys [0, 'num'). */
+typedef struct work {
+	prbt_t	*snapshot;
+	int		num;
+} work_t;
+
+
+static int cmpint(int *a, int *b) {
+	return *a - *b;
+}
+
+static data_t *data_create(int num) {
+	data_t *data;
+
+	data = calloc(num, sizeof(data_t));
+	if(data == NULL) {
+		fatal_error("Out of memory.");
+	}
+
+	for(int i = 0; i < num; i++) {
+		data[i].key = new_integer(i);
+		data[i].item = new_integer(i);
+	}
+
+	return data;
+}
+
+/* Iterate and search snapshot repeatedly; content must not change under writer. */
+static void *work_read(work_t *work) {
+	prbt_iterator_t	*iterator;
+	int				*item, expect;
+
+	for(int r = 0; r < 4; r++) {
+		iterator = prbt_createiterator(work->snapshot);
+		expect = 0;
+
+		while( (item = prbt_next(iterator)) != NULL ) {
+			if(*item != expect) {
+				fatal_error("Snapshot of %d items changed; expected %d, got %d. \n", work->num, expect, *item);
+			}
+			expect++;
+		}
+		prbt_destroyiterator(iterator);
+
+		if( (expect != work->num) || (prbt_size(work->snapshot) != work->num) ) {
+			fatal_error("Snapshot of %d items iterated %d items. \n", work->num, expect);
+		}
+	}
+	prbt_destroy(work->snapshot);
+
+	return NULL;
+}
+
+int main(int argc, char **argv) {
+	pthread_t	readers[NUMREADER];
+	work_t		work[NUMREADER];
+	prbt_t		*version, *tmp;
+	data_t		*data;
+	int			num, k;
+
+	num = (argc > 1) ? atoi(argv[1]) : NUMELEM;
+	data = data_create(num);
+	version = prbt_create( (cmpfunc_t)cmpint );
+
+	/* Hand snapshot to new reader every 'num / NUMREADER' inserts, then keep mutating. */
+	k = 0;
+	for(int i = 0; i < num; i++) {
+		tmp = prbt_insert(version, data[i].key, data[i].item);
+		prbt_destroy(version);
+		version = tmp;
+
+		if( ((i + 1) % (num / NUMREADER) == 0) && (k < NUMREADER) ) {
+			work[k].snapshot	= prbt_snapshot(version);
+			work[k].num			= i + 1;
+
+			if(pthread_create(&readers[k], NULL, (void *(*)(void*))work_read, &work[k]) != 0) {
+				fatal_error("Couldn't create thread. ");
+			}
+			k++;
+		}
+	}
+
+	/* Remove every odd key while readers still iterate older versions. */
+	for(int i = 1; i < num; i += 2) {
+		tmp = prbt_remove(version, data[i].key);
+		if(prbt_size(tmp) != prbt_size(version) - 1) {
+			fatal_error("Key; \'%d\', not removed. \n", i);
+		}
+		prbt_destroy(version);
+		version = tmp;
+	}
+	for(int i = 0; i < num; i++) {
+		if( (prbt_search(version, data[i].key) != NULL) != (i % 2 == 0) ) {
+			fatal_error("Key; \'%d\', in wrong state after removal. \n", i);
+		}
+	}
+
+	for(int i = 0; i < k; i++) {
+		pthread_join(readers[i], NULL);
+	}
+	printf("%d snapshots of up to %d items stable under %d removals. \n", k, num, num / 2);
+
+	prbt_destroy(version);
+
+	for(int i = 0; i < num; i++) {
+		free(data[i].key);
+		free(data[i].item);
+	}
+	free(data);
+
+	return 0;
+}
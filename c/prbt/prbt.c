@@ -0,0 +1,397 @@
+/* Author: Marius Ingebrigtsen */
+/* Persistent Red-Black Tree implementation.
+ * Insert and remove are the iterative top-down algorithms of 'rbt/compact/rbt.c' (Julienne Walker),
+ * with copy-on-write of every node before it is modified.
+ * A node's reference-count is the number of links and versions referring to it;
+ * a node with count 1 is reachable only through the version under construction, and is modified in place.
+ * Shared nodes are copied, and the copy takes a reference to each child.
+ * NOTE: Counts are atomic, so versions can be destroyed concurrently with insert and remove on other versions. */
+
+#include <stdatomic.h>
+
+#include "prbt.h"
+
+/* Upper bound of red-black height for any number of nodes addressable in memory. */
+#define MAXHEIGHT	128
+
+#define IS_RED(node)	( ((node) != NULL) && (node)->red )
+
+typedef struct node node_t;
+struct node {
+	void		*key, *item;
+	node_t		*link[2];		/* Left and right child. */
+	atomic_int	refs;
+	char		red;
+};
+
+struct prbt {
+	node_t		*root;
+	cmpfunc_t	cmpfunc;
+	int			children;
+};
+
+
+/* PRBT Node References: */
+static node_t *node_create(void *key, void *item) {
+	node_t *node;
+
+	node = malloc(sizeof(node_t));
+	if(node == NULL) {
+		fatal_error("Out of memory.");
+	}
+	node->key		= key;
+	node->item		= item;
+	node->link[0]	= node->link[1] = NULL;
+	node->red		= 1;
+	atomic_init(&node->refs, 1);
+
+	return node;
+}
+
+static node_t *node_retain(node_t *node) {
+	if(node != NULL) {
+		atomic_fetch_add_explicit(&node->refs, 1, memory_order_relaxed);
+	}
+	return node;
+}
+
+/* Drop one reference, and free node with its subtree-references when none remain. */
+static void node_release(node_t *node) {
+	if(node == NULL) {
+		return;
+	}
+	if(atomic_fetch_sub_explicit(&node->refs, 1, memory_order_acq_rel) == 1) {
+		node_release(node->link[0]);
+		node_release(node->link[1]);
+		free(node);
+	}
+}
+
+/* Make node at 'link' private to version under construction, and return it.
+ * Node holding 'link' must already be private. */
+static node_t *node_own(node_t **link) {
+	node_t *node, *copy;
+
+	node = *link;
+
+	if( (node == NULL) || (atomic_load_explicit(&node->refs, memory_order_acquire) == 1) ) {
+		return node;
+	}
+	copy = node_create(node->key, node->item);
+	copy->link[0]	= node_retain(node->link[0]);
+	copy->link[1]	= node_retain(node->link[1]);
+	copy->red		= node->red;
+
+	node_release(node);
+	*link = copy;
+
+	return copy;
+}
+
+/* Return new handle to 'root', taking over one reference to it. */
+static prbt_t *version_create(node_t *root, cmpfunc_t cmpfunc, int children) {
+	prbt_t *version;
+
+	version = malloc(sizeof(prbt_t));
+	if(version == NULL) {
+		fatal_error("Out of memory.");
+	}
+	version->root		= root;
+	version->cmpfunc	= cmpfunc;
+	version->children	= children;
+
+	return version;
+}
+
+
+/* PRBT Create: */
+prbt_t *prbt_create(cmpfunc_t cmpfunc) {
+	return version_create(NULL, cmpfunc, 0);
+}
+
+/* PRBT Destroy: */
+void prbt_destroy(prbt_t *version) {
+	node_release(version->root);
+	free(version);
+}
+
+/* PRBT Snapshot: */
+prbt_t *prbt_snapshot(prbt_t *version) {
+	return version_create(node_retain(version->root), version->cmpfunc, version->children);
+}
+
+/* PRBT Size: */
+int prbt_size(prbt_t *version) {
+	return version->children;
+}
+
+/* PRBT Insert: */
+/* Rotate 'root' in direction 'dir' and recolor; new subtree-root is black with red child.
+ * Both nodes must be private. */
+static inline node_t *rotate_single(node_t *root, int dir) {
+	node_t *child;
+
+	child				= root->link[!dir];
+	root->link[!dir]	= child->link[dir];
+	child->link[dir]	= root;
+	root->red			= 1;
+	child->red			= 0;
+
+	return child;
+}
+
+static inline node_t *rotate_double(node_t *root, int dir) {
+	root->link[!dir] = rotate_single(root->link[!dir], !dir);
+
+	return rotate_single(root, dir);
+}
+
+prbt_t *prbt_insert(prbt_t *version, void *key, void *item) {
+	node_t	head, *great, *grand, *parent, *current;
+	int		dir, last, dir2, cmp, inserted;
+
+	head.link[0]	= NULL;
+	head.link[1]	= node_retain(version->root);
+	inserted		= 0;
+
+	if(head.link[1] == NULL) {
+		head.link[1] = node_create(key, item);
+		inserted = 1;
+	}
+	else {
+		great	= &head;
+		grand	= parent = NULL;
+		current	= node_own(&head.link[1]);
+		dir		= last = 0;
+
+		/* Only nodes on search-path, and children of split 4-nodes, are modified. */
+		for(;;) {
+			if(current == NULL) {
+				/* Insert new red leaf. */
+				parent->link[dir] = current = node_create(key, item);
+				inserted = 1;
+			}
+			else if( IS_RED(current->link[0]) && IS_RED(current->link[1]) ) {
+				/* Split 4-Node: */
+				current->red = 1;
+				node_own(&current->link[0])->red = 0;
+				node_own(&current->link[1])->red = 0;
+			}
+
+			/* Fix red violation between 'current' and 'parent'. */
+			if( IS_RED(current) && IS_RED(parent) ) {
+				dir2 = (great->link[1] == grand);
+
+				if(current == parent->link[last]) {
+					great->link[dir2] = rotate_single(grand, !last);
+				} else {
+					great->link[dir2] = rotate_double(grand, !last);
+				}
+			}
+
+			if(inserted) {
+				break;
+			}
+			cmp = version->cmpfunc(key, current->key);
+
+			if(cmp == 0) {
+				current->item = item;
+				break;
+			}
+			last	= dir;
+			dir		= (cmp > 0);
+
+			if(grand != NULL) {
+				great = grand;
+			}
+			grand	= parent;
+			parent	= current;
+			current	= node_own(&current->link[dir]);
+		}
+	}
+	if(IS_RED(head.link[1])) {
+		node_own(&head.link[1])->red = 0;
+	}
+
+	return version_create(head.link[1], version->cmpfunc, version->children + inserted);
+}
+
+/* PRBT Remove: */
+static node_t *node_search(prbt_t *version, void *key) {
+	node_t	*current;
+	int		cmp;
+
+	current = version->root;
+
+	while(current != NULL) {
+		cmp = version->cmpfunc(key, current->key);
+
+		if(cmp == 0) {
+			return current;
+		}
+		current = current->link[cmp > 0];
+	}
+	return NULL;
+}
+
+prbt_t *prbt_remove(prbt_t *version, void *key) {
+	node_t	head, *grand, *parent, *current, *found, *sibling, *top;
+	int		dir, last, dir2, cmp;
+
+	/* Avoid copying search-path when there is nothing to remove. */
+	if(node_search(version, key) == NULL) {
+		return prbt_snapshot(version);
+	}
+	head.link[0]	= NULL;
+	head.link[1]	= node_retain(version->root);
+	head.red		= 0;
+
+	current	= &head;
+	grand	= parent = found = NULL;
+	dir		= 1;
+
+	/* Push red node down to leaf-level, so removal never breaks black-height. */
+	while(current->link[dir] != NULL) {
+		last	= dir;
+		grand	= parent;
+		parent	= current;
+		current	= node_own(&current->link[dir]);
+
+		cmp = version->cmpfunc(key, current->key);
+		dir = (cmp > 0);
+
+		if(cmp == 0) {
+			found = current;
+		}
+
+		if( IS_RED(current) || IS_RED(current->link[dir]) ) {
+			continue;
+		}
+		if(IS_RED(current->link[!dir])) {
+			node_own(&current->link[!dir]);
+			parent->link[last] = rotate_single(current, dir);
+			parent = parent->link[last];
+			continue;
+		}
+		sibling = node_own(&parent->link[!last]);
+
+		if(sibling == NULL) {
+			continue;
+		}
+		if( !IS_RED(sibling->link[!last]) && !IS_RED(sibling->link[last]) ) {
+			/* Color Flip: */
+			parent->red		= 0;
+			sibling->red	= 1;
+			current->red	= 1;
+		}
+		else {
+			/* Children of 'sibling' are rotated or recolored below. */
+			node_own(&sibling->link[0]);
+			node_own(&sibling->link[1]);
+
+			dir2 = (grand->link[1] == parent);
+
+			if(IS_RED(sibling->link[last])) {
+				grand->link[dir2] = rotate_double(parent, last);
+			} else {
+				grand->link[dir2] = rotate_single(parent, last);
+			}
+			top = grand->link[dir2];
+
+			current->red = top->red = 1;
+			top->link[0]->red = 0;
+			top->link[1]->red = 0;
+		}
+	}
+
+	/* 'current' is private in-order neighbour of 'found'; splice 'current' out of tree,
+	 * and let 'found' hold its key and item in stead. Reference to child of 'current' moves to 'parent'. */
+	parent->link[parent->link[1] == current] = current->link[current->link[0] == NULL];
+
+	found->key	= current->key;
+	found->item	= current->item;
+	free(current);
+
+	if(IS_RED(head.link[1])) {
+		node_own(&head.link[1])->red = 0;
+	}
+
+	return version_create(head.link[1], version->cmpfunc, version->children - 1);
+}
+
+/* PRBT Search: */
+void *prbt_search(prbt_t *version, void *key) {
+	node_t *node;
+
+	node = node_search(version, key);
+	if(node == NULL) {
+		return NULL;
+	}
+	return node->item;
+}
+
+
+/* PRBT Iteration */
+/* Iterator Structure: */
+struct prbt_iterator {
+	prbt_t	*snapshot;
+	node_t	*stack[MAXHEIGHT];		/* Left-spine of nodes not yet visited. */
+	int		top;
+};
+
+static void iterator_pushleft(prbt_iterator_t *iterator, node_t *current) {
+	while(current != NULL) {
+		iterator->stack[iterator->top++] = current;
+		current = current->link[0];
+	}
+}
+
+/* PRBT Create Iterator: */
+prbt_iterator_t *prbt_createiterator(prbt_t *version) {
+	prbt_iterator_t *iterator;
+
+	iterator = malloc(sizeof(prbt_iterator_t));
+	if(iterator == NULL) {
+		fatal_error("Out of memory.");
+	}
+	iterator->snapshot = prbt_snapshot(version);
+
+	prbt_resetiterator(iterator);
+
+	return iterator;
+}
+
+/* PRBT Destroy Iterator: */
+void prbt_destroyiterator(prbt_iterator_t *iterator) {
+	prbt_destroy(iterator->snapshot);
+	free(iterator);
+}
+
+/* PRBT Has Next: */
+int prbt_hasnext(prbt_iterator_t *iterator) {
+	if(iterator->top == 0) {
+		return 0;
+	}
+	return 1;
+}
+
+/* PRBT Next: */
+void *prbt_next(prbt_iterator_t *iterator) {
+	node_t *current;
+
+	if(iterator->top == 0) {
+		return NULL;
+	}
+	current = iterator->stack[--iterator->top];
+
+	iterator_pushleft(iterator, current->link[1]);
+
+	return current->item;
+}
+
+/* PRBT Reset Iterator: */
+void prbt_resetiterator(prbt_iterator_t *iterator) {
+	iterator->top = 0;
+
+	iterator_pushleft(iterator, iterator->snapshot->root);
+}
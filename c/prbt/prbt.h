@@ -0,0 +1,67 @@
+/* Author: Marius Ingebrigtsen */
+#ifndef __PRBT_H_
+#define __PRBT_H_
+
+#include "../common.h"
+
+/* Persistent Red-Black Tree Structure.
+ * Every 'prbt_t' is a handle to an immutable version of the tree.
+ * Insert and remove leave the given version untouched and return a new version,
+ * which copies only the nodes on the search-path and shares every other node with older versions.
+ * Nodes are reference-counted, and freed when the last version referring to them is destroyed.
+ *
+ * Readers may hold and iterate a version in one thread while a writer keeps creating new versions in another,
+ * without locks; a snapshot costs O(1) in stead of a copy of the whole tree.
+ * NOTE: Keys and items are shared between versions and never deallocated by prbt. */
+typedef struct prbt prbt_t;
+
+
+/* Return new empty version. */
+prbt_t *prbt_create(cmpfunc_t cmpfunc);
+
+/* Destroy version, and free nodes no other version refers to.
+ * May be called from any thread, also while other versions are in use. */
+void prbt_destroy(prbt_t *version);
+
+/* Return new handle to same version in O(1).
+ * Handles are independent; each must be destroyed, and may be passed to and destroyed by another thread. */
+prbt_t *prbt_snapshot(prbt_t *version);
+
+/* Return number of items in version. */
+int prbt_size(prbt_t *version);
+
+/* Return new version with item inserted using cmpfunc to compare keys.
+ * If key is already in version, then item will overwrite existing value in new version.
+ * Compare 'prbt_size()' of versions to tell insert from overwrite. */
+prbt_t *prbt_insert(prbt_t *version, void *key, void *item);
+
+/* Return new version without item associated with key.
+ * If key is not in version, then new version is equal to given version. */
+prbt_t *prbt_remove(prbt_t *version, void *key);
+
+/* Search version using key and return item with key.
+ * Return NULL if item not in version. */
+void *prbt_search(prbt_t *version, void *key);
+
+
+/* Iteration: */
+typedef struct prbt_iterator prbt_iterator_t;
+
+/* Return iterator over version in ascending order of keys.
+ * Iterator holds its own snapshot, so version may be destroyed before iterator. */
+prbt_iterator_t *prbt_createiterator(prbt_t *version);
+
+/* Deallocates iterator and its snapshot. */
+void prbt_destroyiterator(prbt_iterator_t *iterator);
+
+/* Return 0 if iterator is exhausted, 1 otherwise. */
+int prbt_hasnext(prbt_iterator_t *iterator);
+
+/* Return next item in sequence of iteration, and iterate iterator.
+ * Return NULL if iterator exhausted. */
+void *prbt_next(prbt_iterator_t *iterator);
+
+/* Sets iterator to start of iteration. */
+void prbt_resetiterator(prbt_iterator_t *iterator);
+
+#endif
@@ -0,0 +1,141 @@
+/* Author: Marius Ingebrigtsen */
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <stdatomic.h>
+
+#include "../common.h"
+#include "./queue.h"
+
+/* Item added by producer; consumers check order of items from each producer. */
+typedef struct data {
+	int producer, seq;
+} data_t;
+
+/* Arguments for each thread. Producers add 'num' items each, consumers pop until every item is popped. */
+typedef struct work {
+	queue_t		*queue;
+	data_t		*data;
+	int			id, num, producers, spsc;
+	atomic_int	*popped;
+	int			*seen;		/* Number of items popped from each producer, by this consumer. */
+	long		total;
+} work_t;
+
+
+/* Wait for other threads when queue is full or empty. Yielding alone may reschedule same thread when threads outnumber cores. */
+static void backoff(int *attempts) {
+	if(++(*attempts) < 16) {
+		sched_yield();
+	} else {
+		usleep(1);
+	}
+}
+
+static void *work_produce(work_t *work) {
+	data_t	*data = &work->data[work->id * work->num];
+	int		attempts;
+
+	for(int i = 0; i < work->num; i++) {
+		data[i].producer	= work->id;
+		data[i].seq			= i;
+
+		attempts = 0;
+		while( !(work->spsc ? queue_spsc_addlast(work->queue, &data[i]) : queue_addlast(work->queue, &data[i])) ) {
+			backoff(&attempts);
+		}
+	}
+	return NULL;
+}
+
+static void *work_consume(work_t *work) {
+	data_t	*data;
+	int		total = work->num * work->producers, attempts = 0;
+
+	while(atomic_load(work->popped) < total) {
+		data = work->spsc ? queue_spsc_popfirst(work->queue) : queue_popfirst(work->queue);
+		if(data == NULL) {
+			backoff(&attempts);
+			continue;
+		}
+		attempts = 0;
+		/* Items from one producer are added in order, so any one consumer pops them in order. */
+		if(data->seq < work->seen[data->producer]) {
+			fatal_error("Item; \'%d\', of producer; \'%d\', popped after \'%d\'. \n", data->seq, data->producer, work->seen[data->producer]);
+		}
+		work->seen[data->producer] = data->seq + 1;
+		work->total += data->seq;
+		atomic_fetch_add(work->popped, 1);
+	}
+	return NULL;
+}
+
+static void apply_threads(int producers, int consumers, int num, int capacity, int spsc) {
+	pthread_t	tid[producers + consumers];
+	work_t		work[producers + consumers];
+	queue_t		*queue;
+	data_t		*data;
+	atomic_int	popped;
+	long		total = 0;
+
+	queue	= queue_create(capacity);
+	data	= calloc(producers * num, sizeof(data_t));
+	if(data == NULL) {
+		fatal_error("Out of memory.");
+	}
+	atomic_init(&popped, 0);
+
+	for(int t = 0; t < producers + consumers; t++) {
+		work[t].queue		= queue;
+		work[t].data		= data;
+		work[t].id			= t;
+		work[t].num			= num;
+		work[t].producers	= producers;
+		work[t].spsc		= spsc;
+		work[t].popped		= &popped;
+		work[t].total		= 0;
+		work[t].seen		= calloc(producers, sizeof(int));
+		if(work[t].seen == NULL) {
+			fatal_error("Out of memory.");
+		}
+
+		if(pthread_create(&tid[t], NULL, (void *(*)(void*))( (t < producers) ? work_produce : work_consume ), &work[t]) != 0) {
+			fatal_error("Unable to create thread.");
+		}
+	}
+	for(int t = 0; t < producers + consumers; t++) {
+		pthread_join(tid[t], NULL);
+		total += work[t].total;
+		free(work[t].seen);
+	}
+
+	/* Every item popped once; sum of sequence numbers over every producer. */
+	if( (total != (long)producers * num * (num - 1) / 2) || (queue_size(queue) != 0) || (queue_popfirst(queue) != NULL) ) {
+		fatal_error("Items lost or duplicated; sum \'%ld\', size \'%d\'. \n", total, queue_size(queue));
+	}
+	printf("%d producers and %d consumers%s moved %d items through queue of capacity %d. \n",
+			producers, consumers, spsc ? " (spsc)" : "", producers * num, queue_capacity(queue));
+
+	queue_destroy(queue, NULL);
+	free(data);
+}
+
+int main(int argc, char **argv) {
+	int num, threads;
+
+	if(argc < 3) {
+		printf("Usage: %s <value> <threads> \n", *argv);
+		return -1;
+	}
+	num		= atoi(argv[1]);
+	threads	= atoi(argv[2]);
+
+	apply_threads(1, 1, num, 1, 1);
+	apply_threads(1, 1, num, 64, 1);
+	apply_threads(1, 1, num, 64, 0);
+	apply_threads(threads, threads, num, 64, 0);
+	apply_threads(threads, 1, num, 1024, 0);
+	apply_threads(1, threads, num, 1024, 0);
+
+	return 0;
+}
@@ -0,0 +1,179 @@
+/* Author: Marius Ingebrigtsen */
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "queue.h"
+
+/* Producer and consumer positions are kept on separate cache-lines, so they don't invalidate each other. */
+#define CACHELINE	64
+
+/* Slot is ready for add at position 'pos' when 'sequence == pos', and ready for pop when 'sequence == pos + 1'.
+ * Pop sets 'sequence' to 'pos + capacity', the position of next lap's add into same slot. */
+typedef struct slot {
+	atomic_size_t	sequence;
+	void			*item;
+} slot_t;
+
+struct queue {
+	slot_t		*slots;
+	size_t		mask;
+	_Alignas(CACHELINE) atomic_size_t	tail;	/* Position of next add. */
+	_Alignas(CACHELINE) atomic_size_t	head;	/* Position of next pop. */
+};
+
+
+/* Queue Create: */
+queue_t *queue_create(int capacity) {
+	queue_t	*queue;
+	size_t	size;
+
+	if(capacity < 1) {
+		fatal_error("Queue capacity must be positive; \'%d\'. ", capacity);
+	}
+	/* At least 2 slots; with 1, sequence of a popped slot equals that of a filled slot on next lap. */
+	for(size = 2; size < (size_t)capacity; size *= 2);
+
+	queue = aligned_alloc(CACHELINE, sizeof(queue_t));
+	if(queue == NULL) {
+		fatal_error("Out of memory.");
+	}
+	queue->slots = malloc(sizeof(slot_t) * size);
+	if(queue->slots == NULL) {
+		fatal_error("Out of memory.");
+	}
+	for(size_t i = 0; i < size; i++) {
+		atomic_init(&queue->slots[i].sequence, i);
+		queue->slots[i].item = NULL;
+	}
+	queue->mask = size - 1;
+	atomic_init(&queue->tail, 0);
+	atomic_init(&queue->head, 0);
+
+	return queue;
+}
+
+/* Queue Destroy: */
+void queue_destroy(queue_t *queue, freefunc_t freefunc) {
+	void *item;
+
+	if(freefunc != NULL) {
+		while( (item = queue_popfirst(queue)) != NULL ) {
+			freefunc(item);
+		}
+	}
+	free(queue->slots);
+	free(queue);
+}
+
+/* Queue Capacity & Size: */
+int queue_capacity(queue_t *queue) {
+	return (int)(queue->mask + 1);
+}
+
+int queue_size(queue_t *queue) {
+	size_t head, tail;
+
+	head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+	return (tail > head) ? (int)(tail - head) : 0;
+}
+
+/* Queue Add-Last & Pop-First: */
+int queue_addlast(queue_t *queue, void *item) {
+	slot_t		*slot;
+	size_t		pos, seq;
+	intptr_t	diff;
+
+	pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	for(;;) {
+		slot = &queue->slots[pos & queue->mask];
+		seq	 = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+		diff = (intptr_t)seq - (intptr_t)pos;
+
+		if(diff == 0) {		/* Slot free; claim position, or retry with position of thread that did. */
+			if(atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+				break;
+			}
+		}
+		else if(diff < 0) {	/* Slot still holds item from last lap; queue is full. */
+			return 0;
+		}
+		else {				/* Another producer claimed position. */
+			pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+		}
+	}
+	slot->item = item;
+	atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+
+	return 1;
+}
+
+void *queue_popfirst(queue_t *queue) {
+	slot_t		*slot;
+	size_t		pos, seq;
+	intptr_t	diff;
+	void		*item;
+
+	pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	for(;;) {
+		slot = &queue->slots[pos & queue->mask];
+		seq	 = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+		diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+		if(diff == 0) {		/* Slot filled; claim position, or retry with position of thread that did. */
+			if(atomic_compare_exchange_weak_explicit(&queue->head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+				break;
+			}
+		}
+		else if(diff < 0) {	/* Slot not yet filled; queue is empty. */
+			return NULL;
+		}
+		else {				/* Another consumer claimed position. */
+			pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+		}
+	}
+	item = slot->item;
+	atomic_store_explicit(&slot->sequence, pos + queue->mask + 1, memory_order_release);
+
+	return item;
+}
+
+/* Queue Single-Producer & Single-Consumer: */
+/* Only one thread writes position, so claiming it is a plain store in stead of compare-and-swap. */
+int queue_spsc_addlast(queue_t *queue, void *item) {
+	slot_t	*slot;
+	size_t	pos;
+
+	pos	 = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	slot = &queue->slots[pos & queue->mask];
+
+	if(atomic_load_explicit(&slot->sequence, memory_order_acquire) != pos) {
+		return 0;
+	}
+	atomic_store_explicit(&queue->tail, pos + 1, memory_order_relaxed);
+
+	slot->item = item;
+	atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+
+	return 1;
+}
+
+void *queue_spsc_popfirst(queue_t *queue) {
+	slot_t	*slot;
+	size_t	pos;
+	void	*item;
+
+	pos	 = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	slot = &queue->slots[pos & queue->mask];
+
+	if(atomic_load_explicit(&slot->sequence, memory_order_acquire) != pos + 1) {
+		return NULL;
+	}
+	atomic_store_explicit(&queue->head, pos + 1, memory_order_relaxed);
+
+	item = slot->item;
+	atomic_store_explicit(&slot->sequence, pos + queue->mask + 1, memory_order_release);
+
+	return item;
+}
@@ -0,0 +1,49 @@
+/* Author: Marius Ingebrigtsen */
+#ifndef __QUEUE_H_
+#define __QUEUE_H_
+
+#include "../common.h"
+
+/* Lock-free Bounded Queue Structure (Vyukov).
+ * FIFO ring of fixed capacity, safe to add to and pop from by any number of threads concurrently.
+ * Each slot carries a sequence number telling whether it is ready for next add or next pop,
+ * so an add or pop costs one compare-and-swap on a shared position, and threads never wait on a lock.
+ * Adding to a full queue, or popping from an empty queue, fails in stead of blocking. */
+typedef struct queue queue_t;
+
+
+/* Return new queue holding at most 'capacity' items, rounded up to a power of 2, and at least 2. */
+queue_t *queue_create(int capacity);
+
+/* Destroy queue. Optional function-pointer for deallocating items left in queue.
+ * Pass NULL as argument if items are not to be deallocated.
+ * NOTE: Not thread-safe; no other thread may use queue during or after destruction. */
+void queue_destroy(queue_t *queue, freefunc_t freefunc);
+
+/* Return maximum number of items in queue. */
+int queue_capacity(queue_t *queue);
+
+/* Return number of items in queue.
+ * Under concurrent use value is a snapshot that may be outdated on return. */
+int queue_size(queue_t *queue);
+
+/* Add item to end of queue. Item must not be NULL.
+ * Return 1 if added, 0 if queue is full. */
+int queue_addlast(queue_t *queue, void *item);
+
+/* Remove and return first item of queue. NULL returned if queue is empty. */
+void *queue_popfirst(queue_t *queue);
+
+
+/* Single-Producer & Single-Consumer:
+ * Same as above, but without compare-and-swap, for queues where only one thread adds, or only one thread pops.
+ * 'queue_spsc_addlast()' may be mixed with 'queue_popfirst()' by many consumers, and 'queue_spsc_popfirst()' with 'queue_addlast()' by many producers,
+ * as long as each side using 'spsc' is used by one thread at a time. */
+
+/* Add item to end of queue, from the only producing thread. Return 1 if added, 0 if queue is full. */
+int queue_spsc_addlast(queue_t *queue, void *item);
+
+/* Remove and return first item of queue, from the only consuming thread. NULL returned if queue is empty. */
+void *queue_spsc_popfirst(queue_t *queue);
+
+#endif
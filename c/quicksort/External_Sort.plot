@@ -0,0 +1,10 @@
+set terminal pdf 
+set output "External_Sort.pdf" 
+set autoscale 
+set xlabel "Elements"
+set ylabel "Nanosec. per operation (median)"
+set key left
+
+set title "External Merge Sort"
+plot	"extsort.txt" w linespoints lw 2 t "External Sort"
+
@@ -0,0 +1,10 @@
+set terminal pdf 
+set output "Quicksort_Scaling.pdf" 
+set autoscale 
+set xlabel "Workers"
+set ylabel "Nanosec. per element (median)"
+set key left
+
+set title "Parallel Quicksort Thread-Scaling"
+plot	"scaling.txt" w linespoints lw 2 t "Parallel Quicksort"
+
@@ -2,10 +2,36 @@ set terminal pdf
 set output "Quicksort_vs_Qsort.pdf" 
 set autoscale 
 set xlabel "Elements"
-set ylabel "Time"
+set ylabel "Nanosec. per operation (median)"
 set key left
 
-set title "Quicksort vs. Qsort"
+set title "Quicksort vs. Qsort (Random Input)"
 plot	"quicksort.txt" w linespoints lw 2 t "Quicksort", \
-		"qsort.txt" w linespoints lw 2 t "Qsort"
+		"generic.txt" w linespoints lw 2 t "Generic Quicksort", \
+		"qsort.txt" w linespoints lw 2 t "Qsort", \
+		"radix.txt" w linespoints lw 2 t "Radix Sort"
+
+set title "Quicksort vs. Qsort (Sorted Input)"
+plot	"sorted_quicksort.txt" w linespoints lw 2 t "Quicksort", \
+		"sorted_generic.txt" w linespoints lw 2 t "Generic Quicksort", \
+		"sorted_qsort.txt" w linespoints lw 2 t "Qsort", \
+		"sorted_radix.txt" w linespoints lw 2 t "Radix Sort"
+
+set title "Quicksort vs. Qsort (Reversed Input)"
+plot	"reversed_quicksort.txt" w linespoints lw 2 t "Quicksort", \
+		"reversed_generic.txt" w linespoints lw 2 t "Generic Quicksort", \
+		"reversed_qsort.txt" w linespoints lw 2 t "Qsort", \
+		"reversed_radix.txt" w linespoints lw 2 t "Radix Sort"
+
+set title "Quicksort vs. Qsort (Few-Unique Input)"
+plot	"fewunique_quicksort.txt" w linespoints lw 2 t "Quicksort", \
+		"fewunique_generic.txt" w linespoints lw 2 t "Generic Quicksort", \
+		"fewunique_qsort.txt" w linespoints lw 2 t "Qsort", \
+		"fewunique_radix.txt" w linespoints lw 2 t "Radix Sort"
+
+set title "Quicksort vs. Qsort (Organ-Pipe Input)"
+plot	"organpipe_quicksort.txt" w linespoints lw 2 t "Quicksort", \
+		"organpipe_generic.txt" w linespoints lw 2 t "Generic Quicksort", \
+		"organpipe_qsort.txt" w linespoints lw 2 t "Qsort", \
+		"organpipe_radix.txt" w linespoints lw 2 t "Radix Sort"
 
@@ -1,14 +1,36 @@
 /* Author: Marius Ingebrigtsen */
 
-#include "../gettime.h"
+#include <string.h>
+
+#include "../bench.h"
 #include "../graph.h"
 #include "./quicksort.h"
-
-#include <math.h>
+#include "./extsort.h"
 
 #define START	1024	/* 2^10 */
 #define MAXELEM	1048577	/* 2^20 + 1 */
-#define REPEAT	10
+#define UNIQUE	16		/* Distinct values of few-unique distribution. */
+#define WORKERS	8		/* Most workers of parallel sort; doubled from 1. */
+#define RUNS	8		/* External sort is given memory for this part of input. */
+#define TOPK	100		/* Items sorted by partial sort. */
+
+/* Input distributions; random is 'rand() % num', the others are adversarial to naive quicksort. */
+typedef enum {
+	RANDOM, SORTED, REVERSED, FEWUNIQUE, ORGANPIPE, NUMDIST
+} dist_t;
+
+static const char *dist_names[NUMDIST]	= { "Random", "Sorted", "Reversed", "Few-Unique", "Organ-Pipe" };
+static const char *dist_prefix[NUMDIST]	= { "", "sorted_", "reversed_", "fewunique_", "organpipe_" };
+
+typedef void (*sortfunc_t)(int *array, int num);
+
+/* State of one trial, passed to setup, trial and teardown by harness. */
+typedef struct trial {
+	sortfunc_t	sort;
+	dist_t		dist;
+	pool_t		*pool;
+	int			*array, elem;
+} trial_t;
 
 
 static int *array_create(int idx) {
@@ -21,117 +43,274 @@ static int *array_create(int idx) {
 	return array;
 }
 
-static int *array_rand(int num) {
+static int *array_dist(dist_t dist, int num) {
 	int *array;
 
 	array = array_create(num);
 
 	for(int i = 0; i < num; i++) {
-		array[i] = rand() % num;
+		switch(dist) {
+			case RANDOM:	array[i] = rand() % num;					break;
+			case SORTED:	array[i] = i;								break;
+			case REVERSED:	array[i] = num - i;							break;
+			case FEWUNIQUE:	array[i] = rand() % UNIQUE;					break;
+			default:		array[i] = (i < num / 2) ? i : num - i;		break;
+		}
 	}
 	return array;
 }
 
-static void bench_quicksort(const char *bnch_file) {
-	unsigned long long t1, t2, sum, average;
-	FILE *f;
-	int *array;
+int cmpint(const void *a, const void *b) {
+	int *x = (int*)a, *y = (int*)b;
 
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Could not open file; \'%s\'", bnch_file);
-	}
-	fprintf(f, "# Elements, Time (in micro.sec.)\n");
+	return *x - *y;
+}
+
+static void qsort_int(int *array, int num) {
+	qsort(array, num, sizeof(int), cmpint);
+}
 
-	average = 0;
+/* Same comparison-function as 'qsort()', so difference is algorithm only. */
+static void quicksort_generic_int(int *array, int num) {
+	quicksort_generic(array, num, sizeof(int), (cmpfunc_t)cmpint);
+}
+
+/* Sorts compared, in order of file-arguments. */
+#define NUMSORT	4
+
+static const struct {
+	const char	*name;
+	sortfunc_t	sort;
+} sorts[NUMSORT] = {
+	{ "Quicksort",			quicksort },
+	{ "Generic Quicksort",	quicksort_generic_int },
+	{ "Qsort",				qsort_int },
+	{ "Radix Sort",			radix_sort }
+};
+
+static void setup(trial_t *trial) {
+	trial->array = array_dist(trial->dist, trial->elem);
+}
+
+static void teardown(trial_t *trial) {
+	free(trial->array);
+}
+
+static void trial_sort(trial_t *trial) {
+	trial->sort(trial->array, trial->elem);
+}
+
+static void trial_parallel(trial_t *trial) {
+	quicksort_parallel(trial->pool, trial->array, trial->elem);
+}
+
+static void trial_select(trial_t *trial) {
+	quickselect(trial->array, trial->elem, trial->elem / 2);
+}
+
+static void trial_partial(trial_t *trial) {
+	partial_sort(trial->array, trial->elem, TOPK);
+}
+
+/* Time 'func' on input of distribution for every set of elements. */
+static void bench_series(const char *bnch_file, const char *title, dist_t dist, benchfunc_t func, sortfunc_t sort) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
+
+	file = bench_open(bnch_file, title);
+
+	trial.dist = dist;
+	trial.sort = sort;
 
 	for(int elem = START; elem < MAXELEM; elem *= 2) {
-		printf("Sorting for %d elements... \n", elem);
+		trial.elem = elem;
+
+		bench_run(&stats, (benchfunc_t)setup, func, (benchfunc_t)teardown, &trial, elem);
+		bench_write(file, elem, &stats);
+	}
+	bench_close(file);
+}
 
-		sum = 0;
+static void bench_sort(sortfunc_t sort, dist_t dist, const char *bnch_file) {
+	char *title = concatenate_strings(2, dist_names[dist], " Input");
 
-		for(int r = 0; r < REPEAT; r++) {
-			array = array_rand(elem);
+	bench_series(bnch_file, title, dist, (benchfunc_t)trial_sort, sort);
+	free(title);
+}
+
+/* Parallel quicksort of largest random array by pool of 1, 2, 4, ... workers;
+ * sequential quicksort is baseline, in last row of random input of quicksort.
+ * Workers of pool are created before, and outlive, each trial, so 'bench_thread_start()' can't count them;
+ * hardware events are left out, as counts of calling thread alone would understate work of sort. */
+static void bench_scaling(const char *bnch_file) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
+	char			count[16], *title;
+
+	trial.dist = RANDOM;
+	trial.elem = MAXELEM - 1;
 
-			t1 = gettime();
-			quicksort(array, elem);
-			t2 = gettime();
+	snprintf(count, sizeof(count), "%d", trial.elem);
+	title	= concatenate_strings(3, "Parallel Quicksort of ", count, " Random Elements; elements is number of workers");
+	file	= bench_open(bnch_file, title);
 
-			sum += t2 - t1;
+	for(int workers = 1; workers <= WORKERS; workers *= 2) {
+		trial.pool = pool_create(workers);
 
-			free(array);
+		bench_run(&stats, (benchfunc_t)setup, (benchfunc_t)trial_parallel, (benchfunc_t)teardown, &trial, trial.elem);
+
+		for(perf_event_t e = 0; e < PERF_NUMEVENTS; e++) {
+			stats.counters[e] = -1;
 		}
-		average += sum / REPEAT;
+		bench_write(file, workers, &stats);
 
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
+		pool_destroy(trial.pool);
 	}
-	average /= log2(MAXELEM) - log2(START);
-	
-	fprintf(f, "# Overall average: \n%d\n", (int)average);
+	bench_close(file);
+	free(title);
+}
 
-	fclose(f);
+/* Selection of median, and partial sort of least 'TOPK', as for percentiles and top-k;
+ * full sort to compare with is random input of quicksort. */
+static void bench_select(const char *select_file, const char *partial_file) {
+	bench_series(select_file, "Random Input, Quickselect (Median)", RANDOM, (benchfunc_t)trial_select, NULL);
+	bench_series(partial_file, "Random Input, Partial Sort (Top 100)", RANDOM, (benchfunc_t)trial_partial, NULL);
 }
 
-int cmpint(const void *a, const void *b) {
-	int *x = (int*)a, *y = (int*)b;
+/* External sort of random integers, from file to file, with memory for 1 / 'RUNS' of input at a time.
+ * Input is written to file before, and output read and checked after, trial. */
+static const char *in_path = "extsort_input.tmp", *out_path = "extsort_output.tmp";
 
-	return *x - *y;
+static void setup_external(trial_t *trial) {
+	FILE *data;
+
+	setup(trial);
+
+	data = fopen(in_path, "wb");
+	if( (data == NULL) || (fwrite(trial->array, sizeof(int), trial->elem, data) != (size_t)trial->elem) ) {
+		fatal_error("Could not write file; \'%s\'", in_path);
+	}
+	fclose(data);
 }
 
-static void bench_qsort(const char *bnch_file) {
-	unsigned long long t1, t2, sum, average;
-	FILE *f;
-	int *array;
+static void teardown_external(trial_t *trial) {
+	FILE *data;
 
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Could not open file; \'%s\'", bnch_file);
+	data = fopen(out_path, "rb");
+	if( (data == NULL) || (fread(trial->array, sizeof(int), trial->elem, data) != (size_t)trial->elem) ) {
+		fatal_error("Could not read file; \'%s\'", out_path);
+	}
+	fclose(data);
+	for(int i = 1; i < trial->elem; i++) {
+		if(trial->array[i - 1] > trial->array[i]) {
+			fatal_error("External sort output not in order. ");
+		}
 	}
-	fprintf(f, "# Elements, Time (in micro.sec.)\n");
+	teardown(trial);
+}
 
-	average = 0;
+static void trial_external(trial_t *trial) {
+	external_sort(in_path, out_path, sizeof(int), (cmpfunc_t)cmpint, trial->elem * sizeof(int) / RUNS);
+}
 
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
-		printf("Sorting for %d elements... \n", elem);
+static void bench_external(const char *bnch_file) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
+	char			runs[16], *title;
 
-		sum = 0;
+	snprintf(runs, sizeof(runs), "%d", RUNS);
+	title	= concatenate_strings(3, "External Sort with Memory for 1/", runs, " of Input");
+	file	= bench_open(bnch_file, title);
 
-		for(int r = 0; r < REPEAT; r++) {
-			array = array_rand(elem);
+	trial.dist = RANDOM;
 
-			t1 = gettime();
-			qsort(array, elem, sizeof(int), cmpint);
-			t2 = gettime();
+	for(int elem = START; elem < MAXELEM; elem *= 2) {
+		trial.elem = elem;
 
-			sum += t2 - t1;
+		bench_run(&stats, (benchfunc_t)setup_external, (benchfunc_t)trial_external, (benchfunc_t)teardown_external, &trial, elem);
+		bench_write(file, elem, &stats);
+	}
+	bench_close(file);
+	free(title);
 
-			free(array);
-		}
-		average += sum / REPEAT;
+	remove(in_path);
+	remove(out_path);
+}
+
+/* Return copy of path with distribution-prefix put before file-name, e.g. 'sorted_quicksort.txt'. */
+static char *dist_path(dist_t dist, const char *path) {
+	const char	*name = strrchr(path, '/');
+	char		*dir, *file;
 
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
+	name = (name == NULL) ? path : name + 1;
+
+	dir = strndup(path, name - path);
+	if(dir == NULL) {
+		fatal_error("Out of memory.");
 	}
-	average /= log2(MAXELEM) - log2(START);
-	
-	fprintf(f, "# Overall average: \n%d\n", (int)average);
+	file = concatenate_strings(3, dir, dist_prefix[dist], name);
+	free(dir);
 
-	fclose(f);
+	return file;
 }
 
-static void bench_graph(const char *quicksort_file, const char *qsort_file) {
+/* One graph-plot per distribution, on separate pages of same pdf. */
+static void bench_graph(char *files[NUMSORT][NUMDIST]) {
 	graph_t *g;
-	graph_data_t gd[2];
+	graph_data_t gd[NUMSORT];
+	char *title;
 
 	g = graph_create("Quicksort_vs_Qsort");
 
-	graph_axislabel(g, "Elements", "Time");
+	graph_axislabel(g, "Elements", "Nanosec. per operation (median)");
+
+	for(dist_t dist = RANDOM; dist < NUMDIST; dist++) {
+		for(int s = 0; s < NUMSORT; s++) {
+			gd[s].csv	= files[s][dist];
+			gd[s].name	= sorts[s].name;
+		}
+		title = concatenate_strings(3, "Quicksort vs. Qsort (", dist_names[dist], " Input)");
+		graph_newplot(g, title, gd, NUMSORT);
+		free(title);
+	}
+	graph_dograph(g);
+
+	graph_destroy(g);
+}
+
+static void bench_graph_scaling(const char *scaling_file) {
+	graph_t *g;
+	graph_data_t gd;
+
+	g = graph_create("Quicksort_Scaling");
+
+	graph_axislabel(g, "Workers", "Nanosec. per element (median)");
+
+	gd.csv	= scaling_file;
+	gd.name	= "Parallel Quicksort";
+
+	graph_newplot(g, "Parallel Quicksort Thread-Scaling", &gd, 1);
+
+	graph_dograph(g);
+
+	graph_destroy(g);
+}
+
+static void bench_graph_external(const char *external_file) {
+	graph_t *g;
+	graph_data_t gd;
+
+	g = graph_create("External_Sort");
+
+	graph_axislabel(g, "Elements", "Nanosec. per operation (median)");
 
-	gd[0].csf	= quicksort_file;
-	gd[0].name	= "Quicksort";
-	gd[1].csf	= qsort_file;
-	gd[1].name	= "Qsort";
+	gd.csv	= external_file;
+	gd.name	= "External Sort";
 
-	graph_newplot(g, "Quicksort vs. Qsort", gd, 2);
+	graph_newplot(g, "External Merge Sort", &gd, 1);
 
 	graph_dograph(g);
 
@@ -139,15 +318,35 @@ static void bench_graph(const char *quicksort_file, const char *qsort_file) {
 }
 
 int main(int argc, const char **argv) {
-	if(argc < 3) {
-		printf("Usage: %s <quicksort-path> <qsort-path> \n", *argv);
+	char *files[NUMSORT][NUMDIST];
+
+	if(argc < NUMSORT + 5) {
+		printf("Usage: %s <quicksort-path> <generic-quicksort-path> <qsort-path> <radix-sort-path> <scaling-path> <external-sort-path> <select-path> <partial-sort-path> \n", *argv);
 		return -1;
 	}
-	bench_quicksort(argv[1]);
+	for(dist_t dist = RANDOM; dist < NUMDIST; dist++) {
+		for(int s = 0; s < NUMSORT; s++) {
+			files[s][dist] = dist_path(dist, argv[s + 1]);
+
+			bench_sort(sorts[s].sort, dist, files[s][dist]);
+		}
+	}
+	bench_graph(files);
 
-	bench_qsort(argv[2]);
+	bench_scaling(argv[NUMSORT + 1]);
 
-	bench_graph(argv[1], argv[2]);
+	bench_graph_scaling(argv[NUMSORT + 1]);
 
+	bench_external(argv[NUMSORT + 2]);
+
+	bench_graph_external(argv[NUMSORT + 2]);
+
+	bench_select(argv[NUMSORT + 3], argv[NUMSORT + 4]);
+
+	for(dist_t dist = RANDOM; dist < NUMDIST; dist++) {
+		for(int s = 0; s < NUMSORT; s++) {
+			free(files[s][dist]);
+		}
+	}
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,258 @@
+/* Author: Marius Ingebrigtsen */
+
+#include <limits.h>
+#include <string.h>
+
+#include "extsort.h"
+#include "quicksort.h"
+
+/* Least bytes of read- or write-buffer per run while merging; fewer runs are merged at once to keep it. */
+#define BLOCK	65536
+
+
+/* Sorted run of 'count' records at 'offset' of temporary file.
+ * Runs share one file, so number of runs is not limited by number of open files. */
+typedef struct run {
+	long	offset;
+	size_t	count;
+} run_t;
+
+/* Run being merged, read one buffer of records at a time. */
+typedef struct input {
+	run_t	run;		/* Part of run not yet read into buffer. */
+	char	*buf;
+	int		num, pos;	/* Records in buffer, and index of next. */
+} input_t;
+
+/* K-way merge. 'tree[0]' is index of input with least next record,
+ * and 'tree[1]' to 'tree[k - 1]' hold loser of match at each node of tree.
+ * Input 'i' is leaf 'k + i', so node 'n' has children '2n' and '2n + 1', and parent 'n / 2'. */
+typedef struct merge {
+	FILE		*f;
+	input_t		*inputs;
+	int			*tree, k, size, cap;
+	cmpfunc_t	cmp;
+} merge_t;
+
+
+static FILE *temporary_file(void) {
+	FILE *f = tmpfile();
+
+	if(f == NULL) {
+		fatal_error("Could not create temporary file for runs.");
+	}
+	return f;
+}
+
+static void write_records(FILE *f, char *buf, int size, size_t num) {
+	if(fwrite(buf, size, num, f) != num) {
+		fatal_error("Could not write %lu records. ", (unsigned long)num);
+	}
+}
+
+/* Spill Runs:
+ * Read and sort 'memory' bytes at a time, and append each as run to temporary file 'tmp'. */
+static run_t *spill_runs(FILE *in, FILE *tmp, int size, cmpfunc_t cmp, size_t memory, int *numruns) {
+	run_t	*runs = NULL;
+	char	*buf;
+	size_t	cap = memory / size, n;
+	int		max = 0;
+
+	cap = (cap < 2) ? 2 : ( (cap > INT_MAX) ? INT_MAX : cap );
+	buf = malloc(cap * size);
+	if(buf == NULL) {
+		fatal_error("Out of memory.");
+	}
+	*numruns = 0;
+
+	while( (n = fread(buf, size, cap, in)) > 0 ) {
+		quicksort_generic(buf, n, size, cmp);
+
+		if(*numruns == max) {
+			max		= (max == 0) ? 16 : max * 2;
+			runs	= realloc(runs, sizeof(run_t) * max);
+			if(runs == NULL) {
+				fatal_error("Out of memory.");
+			}
+		}
+		runs[*numruns].offset	= ftell(tmp);
+		runs[*numruns].count	= n;
+		(*numruns)++;
+
+		write_records(tmp, buf, size, n);
+	}
+	if(ferror(in)) {
+		fatal_error("Could not read input-file.");
+	}
+	free(buf);
+
+	return runs;
+}
+
+/* Loser Tree: */
+static void input_refill(merge_t *merge, input_t *input) {
+	size_t n = (input->run.count < (size_t)merge->cap) ? input->run.count : (size_t)merge->cap;
+
+	input->pos = 0;
+	input->num = 0;
+	if(n == 0) {
+		return;
+	}
+	if( (fseek(merge->f, input->run.offset, SEEK_SET) != 0) || (fread(input->buf, merge->size, n, merge->f) != n) ) {
+		fatal_error("Could not read run from temporary file.");
+	}
+	input->num			= n;
+	input->run.offset	+= n * merge->size;
+	input->run.count	-= n;
+}
+
+/* Return 1 if next record of input 'a' goes before next of input 'b'; an empty input goes after every other. */
+static inline int input_before(merge_t *merge, int a, int b) {
+	input_t *x = &merge->inputs[a], *y = &merge->inputs[b];
+
+	if(x->num == 0) {
+		return 0;
+	}
+	if(y->num == 0) {
+		return 1;
+	}
+	return merge->cmp(x->buf + (size_t)x->pos * merge->size, y->buf + (size_t)y->pos * merge->size) <= 0;
+}
+
+/* Play matches below 'node', store losers, and return winner. */
+static int tree_build(merge_t *merge, int node) {
+	int left, right;
+
+	if(node >= merge->k) {
+		return node - merge->k;
+	}
+	left	= tree_build(merge, 2 * node);
+	right	= tree_build(merge, 2 * node + 1);
+
+	if(input_before(merge, left, right)) {
+		merge->tree[node] = right;
+		return left;
+	}
+	merge->tree[node] = left;
+	return right;
+}
+
+/* Replay matches from leaf of input 'winner' to root, after its next record changed; log2(k) comparisons. */
+static void tree_replay(merge_t *merge, int winner) {
+	int tmp;
+
+	for(int node = (winner + merge->k) / 2; node > 0; node /= 2) {
+		if(input_before(merge, merge->tree[node], winner)) {
+			tmp					= merge->tree[node];
+			merge->tree[node]	= winner;
+			winner				= tmp;
+		}
+	}
+	merge->tree[0] = winner;
+}
+
+/* Merge Runs:
+ * Merge 'k' runs of file 'f' to end of 'out', splitting 'memory' into buffers for each run and for output.
+ * Return merged run. */
+static run_t merge_runs(FILE *f, run_t *runs, int k, FILE *out, int size, cmpfunc_t cmp, size_t memory) {
+	merge_t	merge;
+	input_t	*input;
+	run_t	merged;
+	char	*outbuf;
+	size_t	cap = memory / ((size_t)(k + 1) * size);
+	int		num = 0;
+
+	merge.f		= f;
+	merge.k		= k;
+	merge.size	= size;
+	merge.cmp	= cmp;
+	merge.cap	= (cap < 1) ? 1 : ( (cap > INT_MAX) ? INT_MAX : cap );
+	merge.inputs	= calloc(k, sizeof(input_t));
+	merge.tree	= calloc(k, sizeof(int));
+	outbuf		= malloc((size_t)merge.cap * size);
+	if( (merge.inputs == NULL) || (merge.tree == NULL) || (outbuf == NULL) ) {
+		fatal_error("Out of memory.");
+	}
+	merged.offset	= ftell(out);
+	merged.count	= 0;
+
+	for(int i = 0; i < k; i++) {
+		merge.inputs[i].run	= runs[i];
+		merge.inputs[i].buf	= malloc((size_t)merge.cap * size);
+		if(merge.inputs[i].buf == NULL) {
+			fatal_error("Out of memory.");
+		}
+		merged.count += runs[i].count;
+		input_refill(&merge, &merge.inputs[i]);
+	}
+	merge.tree[0] = tree_build(&merge, 1);
+
+	for(;;) {
+		input = &merge.inputs[merge.tree[0]];
+		if(input->num == 0) {	/* Winner is empty, so every input is. */
+			break;
+		}
+		memcpy(outbuf + (size_t)num * size, input->buf + (size_t)input->pos * size, size);
+		if(++num == merge.cap) {
+			write_records(out, outbuf, size, num);
+			num = 0;
+		}
+		if(++input->pos == input->num) {
+			input_refill(&merge, input);
+		}
+		tree_replay(&merge, merge.tree[0]);
+	}
+	write_records(out, outbuf, size, num);
+
+	for(int i = 0; i < k; i++) {
+		free(merge.inputs[i].buf);
+	}
+	free(merge.inputs);
+	free(merge.tree);
+	free(outbuf);
+
+	return merged;
+}
+
+/* External Sort: */
+void external_sort(const char *in_path, const char *out_path, int size, cmpfunc_t cmp, size_t memory) {
+	FILE	*in, *out, *tmp, *next;
+	run_t	*runs;
+	int		numruns, fanin, k;
+
+	in = fopen(in_path, "rb");
+	if(in == NULL) {
+		fatal_error("Could not open file; \'%s\'. ", in_path);
+	}
+	tmp		= temporary_file();
+	runs	= spill_runs(in, tmp, size, cmp, memory, &numruns);
+	fclose(in);
+
+	/* Each pass merges groups of 'fanin' runs into next temporary file, until rest can be merged at once. */
+	fanin = memory / BLOCK - 1;
+	fanin = (fanin < 2) ? 2 : fanin;
+
+	while(numruns > fanin) {
+		next = temporary_file();
+		k = 0;
+		for(int i = 0; i < numruns; i += fanin) {
+			runs[k++] = merge_runs(tmp, &runs[i], (numruns - i < fanin) ? numruns - i : fanin, next, size, cmp, memory);
+		}
+		fclose(tmp);
+		tmp		= next;
+		numruns	= k;
+	}
+
+	out = fopen(out_path, "wb");
+	if(out == NULL) {
+		fatal_error("Could not open file; \'%s\'. ", out_path);
+	}
+	if(numruns > 0) {
+		merge_runs(tmp, runs, numruns, out, size, cmp, memory);
+	}
+	if(fclose(out) != 0) {
+		fatal_error("Could not close file; \'%s\'. ", out_path);
+	}
+	fclose(tmp);
+	free(runs);
+}
@@ -0,0 +1,16 @@
+/* Author: Marius Ingebrigtsen */
+
+#ifndef __EXTSORT_H_
+#define __EXTSORT_H_
+
+#include "../common.h"
+
+/* Sort file at 'in_path' of records of 'size' bytes by 'cmp', writing sorted records to file at 'out_path'.
+ * At most about 'memory' bytes are used, so file can be larger than memory:
+ * runs of 'memory' bytes are sorted by 'quicksort_generic()' and spilled to temporary files,
+ * then merged by a loser tree, with reads and writes in large blocks.
+ * If more runs than fit in memory with a block each, groups of runs are merged to longer runs first.
+ * NOTE: 'in_path' and 'out_path' must differ. */
+void external_sort(const char *in_path, const char *out_path, int size, cmpfunc_t cmp, size_t memory);
+
+#endif
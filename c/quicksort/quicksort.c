@@ -1,45 +1,340 @@
 /* Author: Marius Ingebrigtsen */
 
+#include <string.h>
+
 #include "quicksort.h"
 
+#define INT_LESS(a, b)	( (a) < (b) )
+
+/* Bits per radix sort digit, values of digit, and digits per 'int'. */
+#define RADIX_BITS		8
+#define RADIX			(1 << RADIX_BITS)
+#define DIGITS			( (int)(sizeof(int) * 8) / RADIX_BITS )
+
+/* Address of item 'i' in generic array. */
+#define ITEM(i)			( array + (size_t)(i) * size )
+
 
-/* Choose right-most item as pivot. 
- * Sort all items less than pivot to the left, and vice versa to the right. 
- * Return index number of pivot-item. */
-static int partition(int *array, int low, int high) {
-	int pivot, pividx, tmp;
+QUICKSORT_DEFINE(int_sort, int, INT_LESS)
+QUICKSELECT_DEFINE(int_sort, int, INT_LESS)
 
-	pivot	= array[high];
-	pividx	= low;
+/* Part of array sorted by one task of parallel sort; 'depth' and 'leftmost' as for 'int_sort_intro_sort()'. */
+typedef struct sort_task {
+	pool_t	*pool;
+	int		*array, num, depth, leftmost;
+} sort_task_t;
+
+
+/* Quicksort algorithm. */
+void quicksort(int *array, int num) {
+	int_sort(array, num);
+}
+
+void quickselect(int *array, int num, int k) {
+	int_sort_select(array, num, k);
+}
+
+void partial_sort(int *array, int num, int k) {
+	int_sort_partial_sort(array, num, k);
+}
 
-	for(int left = low; left < high; left++) {
-		if(array[left] < pivot) {
-			tmp				= array[left];
-			array[left]		= array[pividx];
-			array[pividx]	= tmp;
+/* Parallel Quicksort:
+ * Partition as 'int_sort_intro_sort()', then spawn left part and sort right part, and sync.
+ * Tasks of parts are on stack of spawner, which outlives them since it syncs before return.
+ * First partitions are sequential, but they are linear time, and work halves at each level. */
+static void parallel_sort(sort_task_t *task) {
+	pool_group_t	group;
+	sort_task_t		left, right;
+	int				*array = task->array, num = task->num, lt, gt;
+
+	if( (num <= QUICKSORT_GRAIN) || (task->depth == 0) ) {
+		int_sort_intro_sort(array, num, task->depth, task->leftmost);
+		return;
+	}
+	int_sort_swap(&array[0], &array[int_sort_choose_pivot(array, num)]);
+	if( (!task->leftmost) && (array[-1] == array[0]) ) {
+		int_sort_partition(array, num, &lt, &gt);
+	}
+	else {
+		lt = gt = int_sort_block_partition(array, num);
+	}
+
+	left.pool		= right.pool = task->pool;
+	left.depth		= right.depth = task->depth - 1;
+	left.array		= array;
+	left.num		= lt;
+	left.leftmost	= task->leftmost;
+	right.array		= &array[gt + 1];
+	right.num		= num - gt - 1;
+	right.leftmost	= 0;
+
+	pool_group_init(&group);
+	pool_spawn(task->pool, &group, (taskfunc_t)parallel_sort, &left);
+	parallel_sort(&right);
+	pool_sync(task->pool, &group);
+}
+
+void quicksort_parallel(pool_t *pool, int *array, int num) {
+	sort_task_t task;
+
+	task.pool		= pool;
+	task.array		= array;
+	task.num		= num;
+	task.depth		= 0;
+	task.leftmost	= 1;
+
+	for(int n = num; n > 1; n /= 2) {
+		task.depth += 2;
+	}
+	parallel_sort(&task);
+}
 
-			pividx++;
+/* Generic Quicksort:
+ * Same introsort as 'QUICKSORT_DEFINE()', but item size and comparison are known only at run-time.
+ * Comparison result tells equal items apart with no extra call, so partition is always three-way.
+ * Block partition would save little here, as calls through 'cmp' cost more than mispredictions. */
+static inline void swap_generic(char *a, char *b, int size) {
+	unsigned long align = (unsigned long)a | (unsigned long)b | (unsigned long)size;
+
+	if(align % sizeof(long) == 0) {
+		for(long *x = (long*)a, *y = (long*)b, *end = (long*)(a + size); x < end; x++, y++) {
+			long tmp = *x;
+			*x = *y;
+			*y = tmp;
+		}
+	}
+	else if(align % sizeof(int) == 0) {
+		for(int *x = (int*)a, *y = (int*)b, *end = (int*)(a + size); x < end; x++, y++) {
+			int tmp = *x;
+			*x = *y;
+			*y = tmp;
 		}
 	}
-	array[high]		= array[pividx];
-	array[pividx]	= pivot;
+	else {
+		for(char *end = a + size; a < end; a++, b++) {
+			char tmp = *a;
+			*a = *b;
+			*b = tmp;
+		}
+	}
+}
+
+/* Swap 'num' items from 'a' with 'num' items from 'b'. */
+static inline void swap_range_generic(char *a, char *b, int num, int size) {
+	for(int i = 0; i < num; i++) {
+		swap_generic(a + (size_t)i * size, b + (size_t)i * size, size);
+	}
+}
 
-	return pividx;
+static void insertion_generic(char *array, int num, int size, cmpfunc_t cmp) {
+	for(int i = 1; i < num; i++) {
+		for(int j = i; (j > 0) && (cmp(ITEM(j), ITEM(j - 1)) < 0); j--) {
+			swap_generic(ITEM(j), ITEM(j - 1), size);
+		}
+	}
 }
 
-/* Recursively sort section-by-section. */
-static void _quicksort(int *array, int low, int high) {
-	int pivot;
+static void sift_down_generic(char *array, int root, int num, int size, cmpfunc_t cmp) {
+	int child;
+
+	while( (child = 2 * root + 1) < num ) {
+		if( (child + 1 < num) && (cmp(ITEM(child), ITEM(child + 1)) < 0) ) {
+			child++;
+		}
+		if(cmp(ITEM(root), ITEM(child)) >= 0) {
+			return;
+		}
+		swap_generic(ITEM(root), ITEM(child), size);
+		root = child;
+	}
+}
 
-	if(low < high) {
-		pivot = partition(array, low, high);
+static void heap_sort_generic(char *array, int num, int size, cmpfunc_t cmp) {
+	for(int i = num / 2 - 1; i >= 0; i--) {
+		sift_down_generic(array, i, num, size, cmp);
+	}
+	for(int i = num - 1; i > 0; i--) {
+		swap_generic(ITEM(0), ITEM(i), size);
+		sift_down_generic(array, 0, i, size, cmp);
+	}
+}
 
-		_quicksort(array, low, pivot - 1);
-		_quicksort(array, pivot + 1, high);
+static inline int median_generic(char *array, int a, int b, int c, int size, cmpfunc_t cmp) {
+	if(cmp(ITEM(a), ITEM(b)) < 0) {
+		return (cmp(ITEM(b), ITEM(c)) < 0) ? b : ( (cmp(ITEM(a), ITEM(c)) < 0) ? c : a );
 	}
+	return (cmp(ITEM(a), ITEM(c)) < 0) ? a : ( (cmp(ITEM(b), ITEM(c)) < 0) ? c : b );
 }
 
-/* Quicksort algorithm. */
-void quicksort(int *array, int num) {
-	_quicksort(array, 0, num - 1);
+static int choose_pivot_generic(char *array, int num, int size, cmpfunc_t cmp) {
+	int mid = num / 2, last = num - 1, step;
+
+	if(num <= QUICKSORT_NINTHER) {
+		return median_generic(array, 1, mid, last, size, cmp);
+	}
+	step = num / 8;
+	return median_generic(array,
+			median_generic(array, 0, step, 2 * step, size, cmp),
+			median_generic(array, mid - step, mid, mid + step, size, cmp),
+			median_generic(array, last - 2 * step, last - step, last, size, cmp), size, cmp);
+}
+
+/* Three-way partition around 'ITEM(0)' (Bentley & McIlroy).
+ * One comparison per item, whose result both places item and tells if it is equal to pivot.
+ * Equal items are gathered at both ends while scanning, and swapped into middle after. */
+static void partition_generic(char *array, int num, int size, cmpfunc_t cmp, int *lt, int *gt) {
+	int a = 1, b = 1, c = num - 1, d = num - 1, r, n;
+
+	for(;;) {
+		while( (b <= c) && ((r = cmp(ITEM(b), ITEM(0))) <= 0) ) {
+			if(r == 0) {
+				swap_generic(ITEM(a++), ITEM(b), size);
+			}
+			b++;
+		}
+		while( (b <= c) && ((r = cmp(ITEM(c), ITEM(0))) >= 0) ) {
+			if(r == 0) {
+				swap_generic(ITEM(c), ITEM(d--), size);
+			}
+			c--;
+		}
+		if(b > c) {
+			break;
+		}
+		swap_generic(ITEM(b++), ITEM(c--), size);
+	}
+
+	/* Move equal items, and pivot, from ends to middle. */
+	n = (a < b - a) ? a : b - a;
+	swap_range_generic(ITEM(0), ITEM(b - n), n, size);
+	n = (d - c < num - 1 - d) ? d - c : num - 1 - d;
+	swap_range_generic(ITEM(b), ITEM(num - n), n, size);
+
+	*lt = b - a;
+	*gt = num - (d - c) - 1;
+}
+
+static void intro_sort_generic(char *array, int num, int depth, int size, cmpfunc_t cmp) {
+	int lt, gt;
+
+	while(num > QUICKSORT_INSERTION) {
+		if(depth-- == 0) {
+			heap_sort_generic(array, num, size, cmp);
+			return;
+		}
+		swap_generic(ITEM(0), ITEM(choose_pivot_generic(array, num, size, cmp)), size);
+		partition_generic(array, num, size, cmp, &lt, &gt);
+
+		if(lt < num - gt - 1) {
+			intro_sort_generic(array, lt, depth, size, cmp);
+			array	+= (size_t)(gt + 1) * size;
+			num		-= gt + 1;
+		} else {
+			intro_sort_generic(ITEM(gt + 1), num - gt - 1, depth, size, cmp);
+			num = lt;
+		}
+	}
+	insertion_generic(array, num, size, cmp);
+}
+
+void quicksort_generic(void *array, int num, int size, cmpfunc_t cmp) {
+	int depth = 0;
+
+	for(int n = num; n > 1; n /= 2) {
+		depth += 2;
+	}
+	intro_sort_generic(array, num, depth, size, cmp);
+}
+
+/* Generic Quickselect: */
+void quickselect_generic(void *items, int num, int size, cmpfunc_t cmp, int k) {
+	char	*array = items;
+	int		depth = 0, lt, gt;
+
+	if( (k < 0) || (k >= num) ) {
+		return;
+	}
+	for(int n = num; n > 1; n /= 2) {
+		depth += 2;
+	}
+	while(num > QUICKSORT_INSERTION) {
+		if(depth-- == 0) {
+			heap_sort_generic(array, num, size, cmp);
+			return;
+		}
+		swap_generic(ITEM(0), ITEM(choose_pivot_generic(array, num, size, cmp)), size);
+		partition_generic(array, num, size, cmp, &lt, &gt);
+
+		if(k < lt) {
+			num = lt;
+		}
+		else if(k > gt) {
+			array	+= (size_t)(gt + 1) * size;
+			num		-= gt + 1;
+			k		-= gt + 1;
+		}
+		else {
+			return;
+		}
+	}
+	insertion_generic(array, num, size, cmp);
+}
+
+void partial_sort_generic(void *array, int num, int size, cmpfunc_t cmp, int k) {
+	if(k < num) {
+		quickselect_generic(array, num, size, cmp, k);
+		num = k;
+	}
+	quicksort_generic(array, num, size, cmp);
+}
+
+/* Radix Sort: */
+static inline unsigned int radix_digit(int item, int d) {
+	/* Sign-bit flipped, so negative integers come before positive. */
+	return ( ((unsigned int)item ^ (1u << (sizeof(int) * 8 - 1))) >> (d * RADIX_BITS) ) & (RADIX - 1);
+}
+
+void radix_sort(int *array, int num) {
+	int		count[DIGITS][RADIX], *buffer, *from = array, *to, *tmp, offset, c;
+
+	if(num <= RADIX_MIN) {
+		quicksort(array, num);
+		return;
+	}
+	buffer = malloc(sizeof(int) * num);
+	if(buffer == NULL) {
+		fatal_error("Out of memory.");
+	}
+
+	/* Histograms of every digit in one pass. */
+	memset(count, 0, sizeof(count));
+	for(int i = 0; i < num; i++) {
+		for(int d = 0; d < DIGITS; d++) {
+			count[d][radix_digit(array[i], d)]++;
+		}
+	}
+
+	to = buffer;
+	for(int d = 0; d < DIGITS; d++) {
+		if(count[d][radix_digit(from[0], d)] == num) {	/* Same digit in every item; pass would move nothing. */
+			continue;
+		}
+		/* Count of each digit-value to index of its first item. */
+		offset = 0;
+		for(int v = 0; v < RADIX; v++) {
+			c = count[d][v];
+			count[d][v] = offset;
+			offset += c;
+		}
+		for(int i = 0; i < num; i++) {
+			to[count[d][radix_digit(from[i], d)]++] = from[i];
+		}
+		tmp		= from;
+		from	= to;
+		to		= tmp;
+	}
+	if(from != array) {
+		memcpy(array, from, sizeof(int) * num);
+	}
+	free(buffer);
 }
\ No newline at end of file
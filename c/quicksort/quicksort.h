@@ -4,8 +4,311 @@
 #define __QUICKSORT_H_
 
 #include "../common.h"
+#include "../pool/pool.h"
+
+/* Partitions of at most this many items are insertion sorted. */
+#define QUICKSORT_INSERTION	16
+/* Partitions of more than this many items choose pivot as ninther, in stead of median of three. */
+#define QUICKSORT_NINTHER	128
+/* Items compared per block in block partition; offsets must fit in 'unsigned char'. */
+#define QUICKSORT_BLOCK		64
+/* Parallel sort sorts parts of at most this many items sequentially, as one task. */
+#define QUICKSORT_GRAIN		16384
+/* Radix sort of at most this many items is quicksort in stead, as histograms cost more than sorting. */
+#define RADIX_MIN			256
+
 
 /* Takes an array of size 'num' and sorts content. */
 void quicksort(int *array, int num);
 
+/* Takes an array of size 'num' and sorts content with workers of 'pool'.
+ * Each partition step spawns sorting of one part as task, and sorts other part itself;
+ * parts of at most 'QUICKSORT_GRAIN' items are sorted sequentially as by 'quicksort()'. */
+void quicksort_parallel(pool_t *pool, int *array, int num);
+
+/* Rearrange array of size 'num' so 'array[k]' is item that would be there if sorted,
+ * items before it are not greater, and items after not less (introselect); O(n) average and O(n log n) worst case. */
+void quickselect(int *array, int num, int k);
+
+/* Rearrange array of size 'num' so first 'k' items are least 'k' items, sorted; rest are in no order.
+ * O(n + k log k), in stead of O(n log n) to sort all. */
+void partial_sort(int *array, int num, int k);
+
+/* Takes an array of size 'num' and sorts content by least significant digit radix sort.
+ * Four passes of 8-bit digits, each stable scatter into other of two buffers; O(n) time and O(n) extra memory.
+ * Passes of a digit equal in every item are skipped. Arrays of at most 'RADIX_MIN' items are quicksorted. */
+void radix_sort(int *array, int num);
+
+/* Takes an array of 'num' items, each 'size' bytes, and sorts content by 'cmp', as 'qsort()'.
+ * 'cmp' is given pointers to two items, and returns less than, equal to or greater than 0. */
+void quicksort_generic(void *array, int num, int size, cmpfunc_t cmp);
+
+/* As 'quickselect()' and 'partial_sort()', for items and comparison as 'quicksort_generic()'. */
+void quickselect_generic(void *array, int num, int size, cmpfunc_t cmp, int k);
+void partial_sort_generic(void *array, int num, int size, cmpfunc_t cmp, int k);
+
+/* Define 'static void name(type *array, int num)', sorting items of 'type' by 'less'.
+ * 'less(a, b)' is an expression or macro on two items (not pointers) that is true if 'a' goes before 'b',
+ * e.g. '#define KEY_LESS(a, b) ((a).key < (b).key)' for structs.
+ * Comparisons are inlined, so no function is called per comparison as with 'qsort()' or 'quicksort_generic()'.
+ * 
+ * Introspective sort (Musser); quicksort with median of three or ninther pivot,
+ * recursing into smaller part, insertion sort for small partitions, and heapsort when recursion gets too deep.
+ * Partitions by branchless block partition (Edelkamp & Weiss), so random data causes no branch mispredictions;
+ * a pivot equal to item before partition, an earlier pivot, means many equal items, and those are partitioned three-way.
+ * Not stable. */
+#define QUICKSORT_DEFINE(name, type, less)												\
+																						\
+static inline void name##_swap(type *a, type *b) {										\
+	type tmp = *a;																		\
+	*a = *b;																			\
+	*b = tmp;																			\
+}																						\
+																						\
+static void name##_insertion_sort(type *array, int num) {								\
+	for(int i = 1; i < num; i++) {														\
+		type item = array[i];															\
+		int j;																			\
+																						\
+		for(j = i; (j > 0) && less(item, array[j - 1]); j--) {						\
+			array[j] = array[j - 1];													\
+		}																				\
+		array[j] = item;																\
+	}																					\
+}																						\
+																						\
+static void name##_sift_down(type *array, int root, int num) {							\
+	int child;																			\
+																						\
+	while( (child = 2 * root + 1) < num ) {												\
+		if( (child + 1 < num) && less(array[child], array[child + 1]) ) {				\
+			child++;																	\
+		}																				\
+		if( !less(array[root], array[child]) ) {										\
+			return;																		\
+		}																				\
+		name##_swap(&array[root], &array[child]);										\
+		root = child;																	\
+	}																					\
+}																						\
+																						\
+static void name##_heap_sort(type *array, int num) {									\
+	for(int i = num / 2 - 1; i >= 0; i--) {												\
+		name##_sift_down(array, i, num);												\
+	}																					\
+	for(int i = num - 1; i > 0; i--) {													\
+		name##_swap(&array[0], &array[i]);												\
+		name##_sift_down(array, 0, i);													\
+	}																					\
+}																						\
+																						\
+static inline int name##_median_of_three(type *array, int a, int b, int c) {			\
+	if( less(array[a], array[b]) ) {													\
+		return less(array[b], array[c]) ? b : ( less(array[a], array[c]) ? c : a );	\
+	}																					\
+	return less(array[a], array[c]) ? a : ( less(array[b], array[c]) ? c : b );		\
+}																						\
+																						\
+static int name##_choose_pivot(type *array, int num) {									\
+	int mid = num / 2, last = num - 1, step;											\
+																						\
+	if(num <= QUICKSORT_NINTHER) {														\
+		return name##_median_of_three(array, 1, mid, last);								\
+	}																					\
+	step = num / 8;																		\
+	return name##_median_of_three(array,												\
+			name##_median_of_three(array, 0, step, 2 * step),							\
+			name##_median_of_three(array, mid - step, mid, mid + step),					\
+			name##_median_of_three(array, last - 2 * step, last - step, last));			\
+}																						\
+																						\
+/* Three-way partition around 'array[0]' (Bentley & McIlroy); equal items gathered	\
+ * at both ends, and swapped into middle after. */										\
+static void name##_partition(type *array, int num, int *lt, int *gt) {					\
+	type pivot = array[0];																\
+	int i = 0, j = num, p = 0, q = num;													\
+																						\
+	for(;;) {																			\
+		while( less(array[++i], pivot) ) {												\
+			if(i == num - 1) {															\
+				break;																	\
+			}																			\
+		}																				\
+		while( less(pivot, array[--j]) ) {												\
+			if(j == 0) {																\
+				break;																	\
+			}																			\
+		}																				\
+		if( (i == j) && !less(array[i], pivot) && !less(pivot, array[i]) ) {			\
+			name##_swap(&array[++p], &array[i]);										\
+		}																				\
+		if(i >= j) {																	\
+			break;																		\
+		}																				\
+		name##_swap(&array[i], &array[j]);												\
+		if( !less(array[i], pivot) && !less(pivot, array[i]) ) {						\
+			name##_swap(&array[++p], &array[i]);										\
+		}																				\
+		if( !less(array[j], pivot) && !less(pivot, array[j]) ) {						\
+			name##_swap(&array[--q], &array[j]);										\
+		}																				\
+	}																					\
+	i = j + 1;																			\
+	for(int k = 0; k <= p; k++) {														\
+		name##_swap(&array[k], &array[j--]);											\
+	}																					\
+	for(int k = num - 1; k >= q; k--) {													\
+		name##_swap(&array[k], &array[i++]);											\
+	}																					\
+	*lt = j + 1;																		\
+	*gt = i - 1;																		\
+}																						\
+																						\
+/* Two-way block partition around 'array[0]'; comparison outcomes are added to		\
+ * offset counts in stead of branched on, and misplaced items swapped pairwise after.	\
+ * Return index of pivot; items before are less, and items after not less. */			\
+static int name##_block_partition(type *array, int num) {								\
+	unsigned char	offl[QUICKSORT_BLOCK], offr[QUICKSORT_BLOCK];						\
+	type			pivot = array[0];													\
+	type			*l = &array[1];														\
+	type			*r = &array[num - 1];												\
+	int				numl = 0, numr = 0, startl = 0, startr = 0, n;						\
+																						\
+	while(r - l + 1 > 2 * QUICKSORT_BLOCK) {											\
+		if(numl == 0) {																	\
+			startl = 0;																	\
+			for(int i = 0; i < QUICKSORT_BLOCK; i++) {									\
+				offl[numl] = i;															\
+				numl += !less(l[i], pivot);												\
+			}																			\
+		}																				\
+		if(numr == 0) {																	\
+			startr = 0;																	\
+			for(int i = 0; i < QUICKSORT_BLOCK; i++) {									\
+				offr[numr] = i;															\
+				numr += less(*(r - i), pivot);											\
+			}																			\
+		}																				\
+		n = (numl < numr) ? numl : numr;												\
+		for(int k = 0; k < n; k++) {													\
+			name##_swap(&l[offl[startl + k]], r - offr[startr + k]);					\
+		}																				\
+		numl	-= n;																	\
+		numr	-= n;																	\
+		startl	+= n;																	\
+		startr	+= n;																	\
+		if(numl == 0) {																	\
+			l += QUICKSORT_BLOCK;														\
+		}																				\
+		if(numr == 0) {																	\
+			r -= QUICKSORT_BLOCK;														\
+		}																				\
+	}																					\
+	/* Items before 'l' and after 'r' are in place, also in a half-done block. */		\
+	while(l <= r) {																		\
+		if( less(*l, pivot) ) {															\
+			l++;																		\
+		}																				\
+		else if( !less(*r, pivot) ) {													\
+			r--;																		\
+		}																				\
+		else {																			\
+			name##_swap(l++, r--);														\
+		}																				\
+	}																					\
+	n = l - array - 1;																	\
+	name##_swap(&array[0], &array[n]);													\
+																						\
+	return n;																			\
+}																						\
+																						\
+/* Unless 'leftmost', 'array[-1]' is an earlier pivot no greater than any item. */		\
+static void name##_intro_sort(type *array, int num, int depth, int leftmost) {			\
+	int lt, gt;																			\
+																						\
+	while(num > QUICKSORT_INSERTION) {													\
+		if(depth-- == 0) {																\
+			name##_heap_sort(array, num);												\
+			return;																		\
+		}																				\
+		name##_swap(&array[0], &array[name##_choose_pivot(array, num)]);				\
+		if( (!leftmost) && !less(array[-1], array[0]) ) {								\
+			name##_partition(array, num, &lt, &gt);										\
+		}																				\
+		else {																			\
+			lt = gt = name##_block_partition(array, num);								\
+		}																				\
+		if(lt < num - gt - 1) {															\
+			name##_intro_sort(array, lt, depth, leftmost);								\
+			array	+= gt + 1;															\
+			num		-= gt + 1;															\
+			leftmost = 0;																\
+		} else {																		\
+			name##_intro_sort(&array[gt + 1], num - gt - 1, depth, 0);					\
+			num = lt;																	\
+		}																				\
+	}																					\
+	name##_insertion_sort(array, num);													\
+}																						\
+																						\
+static void name(type *array, int num) {												\
+	int depth = 0;																		\
+																						\
+	for(int n = num; n > 1; n /= 2) {													\
+		depth += 2;																		\
+	}																					\
+	name##_intro_sort(array, num, depth, 1);											\
+}
+
+/* Define 'static void name##_select(type *array, int num, int k)' and
+ * 'static void name##_partial_sort(type *array, int num, int k)', as 'quickselect()' and 'partial_sort()'.
+ * Must follow 'QUICKSORT_DEFINE()' of same 'name', 'type' and 'less', whose partitions are used. */
+#define QUICKSELECT_DEFINE(name, type, less)											\
+																						\
+/* Partition as 'name##_intro_sort()', but only keep on with part holding 'k'. */		\
+static void name##_select(type *array, int num, int k) {								\
+	int depth = 0, leftmost = 1, lt, gt;												\
+																						\
+	if( (k < 0) || (k >= num) ) {														\
+		return;																			\
+	}																					\
+	for(int n = num; n > 1; n /= 2) {													\
+		depth += 2;																		\
+	}																					\
+	while(num > QUICKSORT_INSERTION) {													\
+		if(depth-- == 0) {																\
+			name##_heap_sort(array, num);												\
+			return;																		\
+		}																				\
+		name##_swap(&array[0], &array[name##_choose_pivot(array, num)]);				\
+		if( (!leftmost) && !less(array[-1], array[0]) ) {								\
+			name##_partition(array, num, &lt, &gt);										\
+		}																				\
+		else {																			\
+			lt = gt = name##_block_partition(array, num);								\
+		}																				\
+		if(k < lt) {																	\
+			num = lt;																	\
+		}																				\
+		else if(k > gt) {																\
+			array	+= gt + 1;															\
+			num		-= gt + 1;															\
+			k		-= gt + 1;															\
+			leftmost = 0;																\
+		}																				\
+		else {																			\
+			return;																		\
+		}																				\
+	}																					\
+	name##_insertion_sort(array, num);													\
+}																						\
+																						\
+static void name##_partial_sort(type *array, int num, int k) {							\
+	if(k < num) {																		\
+		name##_select(array, num, k);													\
+		num = k;																		\
+	}																					\
+	name(array, num);																	\
+}
+
 #endif
\ No newline at end of file
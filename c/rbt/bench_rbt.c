@@ -1,18 +1,28 @@
 /* Author: Marius Ingebrigtsen */
-#include <math.h>
-
 #include "../common.h"
-#include "../gettime.h"
+#include "../bench.h"
 #include "./rbt.h"
+#include "./rbt_inline.h"
 
 #define START	1024		/* 2^10 */
 #define MAXELEM	1048576+1	/* 2^20 + 1 */
-#define REPEAT	10
+
+RBT_DEFINE(rbt_int, int)
 
 typedef struct data {
 	int *key, *item;
 } data_t;
 
+/* State of one trial, passed to setup, trial and teardown by harness.
+ * 'keys' are keys of 'data' in random order, and 'items' are items found for them. */
+typedef struct trial {
+	rbt_t		*rbt;
+	rbt_int_t	*inline_rbt;
+	data_t		*data;
+	void		**keys, **items;
+	int			elem;
+} trial_t;
+
 
 static int cmpint(int *a, int *b) {
 	return *a - *b;
@@ -34,303 +44,250 @@ static data_t *data_create(int num) {
 	return data;
 }
 
-static data_t *insert_data(rbt_t *rbt, int num) {
-	data_t *data;
+static void setup_empty(trial_t *trial) {
+	trial->rbt = rbt_create( (cmpfunc_t)cmpint );
+	trial->data = data_create(trial->elem);
+}
 
-	data = data_create(num);
+static void setup_filled(trial_t *trial) {
+	setup_empty(trial);
 
-	for(int i = 0; i < num; i++) {
-		if( !rbt_insert(rbt, data[i].key, data[i].item) ) {
+	for(int i = 0; i < trial->elem; i++) {
+		if(!rbt_insert(trial->rbt, trial->data[i].key, trial->data[i].item)) {
 			fatal_error("Duplicate insert.");
 		}
 	}
+}
 
-	return data;
+static void setup_sorted(trial_t *trial) {
+	setup_filled(trial);
+	rbt_sort(trial->rbt);
 }
 
-static void assert_insert(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE	*f;
-	rbt_t	*rbt;
-	data_t	*data;
+static void setup_shuffled(trial_t *trial) {
+	void	*tmp;
+	int		j;
+
+	setup_filled(trial);
 
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
+	trial->keys = malloc(sizeof(void*) * trial->elem);
+	trial->items = malloc(sizeof(void*) * trial->elem);
+	if( (trial->keys == NULL) || (trial->items == NULL) ) {
 		fatal_error("Out of memory.");
 	}
-	fprintf(f, "# RBT Insert Benchmarks \n# Elements, Time (microsec. average for %d trials per set of elements) \n", REPEAT);
-
-	average = 0;
-
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
-
-		sum = 0;
-
-		for(int r = 0; r < REPEAT; r++) {
-
-			rbt = rbt_create( (cmpfunc_t)cmpint );
-			data = data_create(elem);
-
-			t1 = gettime();
-			for(int i = 0; i < elem; i++) {
-				rbt_insert(rbt, data[i].key, data[i].item);
-			}
-			t2 = gettime();
-
-			sum += t2 - t1;
-
-			free(data);
-			rbt_destroy(rbt, free, free);
-		}
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
-
-		average += sum / REPEAT;
+	for(int i = 0; i < trial->elem; i++) {
+		trial->keys[i] = trial->data[i].key;
+	}
+	for(int i = trial->elem - 1; i > 0; i--) {
+		j = rand() % (i + 1);
+		tmp = trial->keys[i];	trial->keys[i] = trial->keys[j];	trial->keys[j] = tmp;
 	}
-	num_elem_set = log2(MAXELEM) - log2(START);
-	fprintf(f, "\n# Overall average for each set of elements with %d trials: \n%d", REPEAT, (int)(average / num_elem_set) );
-
-	fclose(f);
 }
 
-static void assert_search(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE	*f;
-	rbt_t	*rbt;
-	data_t	*data;
-
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
+static void setup_inline_empty(trial_t *trial) {
+	trial->inline_rbt = rbt_int_create();
+	trial->keys = malloc(sizeof(void*) * trial->elem);
+	if(trial->keys == NULL) {
 		fatal_error("Out of memory.");
 	}
-	fprintf(f, "# RBT Search Benchmarks \n# Elements, Time (microsec. average for %d trials per set of elements) \n", REPEAT);
-
-	average = 0;
-
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
-
-		sum = 0;
-
-		rbt = rbt_create( (cmpfunc_t)cmpint );
-		data = insert_data(rbt, elem);
-
-		for(int r = 0; r < REPEAT; r++) {
-
-			t1 = gettime();
-			for(int i = 0; i < elem; i++) {
-				if(rbt_search(rbt, data[i].key) == NULL) {
-					fatal_error("Value not found.");
-				}
-			}
-			t2 = gettime();
+	for(int i = 0; i < trial->elem; i++) {
+		trial->keys[i] = new_integer(i);
+	}
+}
 
-			sum += t2 - t1;
+static void setup_inline_filled(trial_t *trial) {
+	setup_inline_empty(trial);
 
+	for(int i = 0; i < trial->elem; i++) {
+		if( !rbt_int_insert(trial->inline_rbt, i, trial->keys[i]) ) {
+			fatal_error("Duplicate insert.");
 		}
-		free(data);
-		rbt_destroy(rbt, free, free);
-
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
-
-		average += sum / REPEAT;
 	}
-	num_elem_set = log2(MAXELEM) - log2(START);
-	fprintf(f, "\n# Overall average for each set of elements with %d trials: \n%d", REPEAT, (int)(average / num_elem_set) );
-
-	fclose(f);
 }
 
-static void assert_sort(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE	*f;
-	rbt_t	*rbt;
+static void teardown(trial_t *trial) {
+	free(trial->data);
+	rbt_destroy(trial->rbt, free, free);
+}
 
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Out of memory.");
+static void teardown_shuffled(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		if(trial->items[i] == NULL) {
+			fatal_error("Value not found.");
+		}
 	}
-	fprintf(f, "# RBT Sort Benchmarks \n# Elements, Time (microsec. average for %d trials per set of elements) \n", REPEAT);
-
-	average = 0;
-
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
-
-		sum = 0;
+	free(trial->keys);
+	free(trial->items);
+	teardown(trial);
+}
 
-		for(int r = 0; r < REPEAT; r++) {
+/* Keys removed from tree by trial are not freed by it, so free every key and item of data. */
+static void teardown_removed(trial_t *trial) {
+	rbt_destroy(trial->rbt, NULL, NULL);
 
-			rbt = rbt_create( (cmpfunc_t)cmpint );
-			free(insert_data(rbt, elem));
+	for(int i = 0; i < trial->elem; i++) {
+		free(trial->data[i].key);
+		free(trial->data[i].item);
+	}
+	free(trial->data);
+}
 
-			t1 = gettime();
-			rbt_sort(rbt);
-			t2 = gettime();
+/* Inline tree holds items, not keys, so 'keys' is only freed, not its integers. */
+static void teardown_inline(trial_t *trial) {
+	free(trial->keys);
+	rbt_int_destroy(trial->inline_rbt, free);
+}
 
-			sum += t2 - t1;
+static void trial_insert(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		rbt_insert(trial->rbt, trial->data[i].key, trial->data[i].item);
+	}
+}
 
-			rbt_destroy(rbt, free, free);
+static void trial_search(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		if(rbt_search(trial->rbt, trial->data[i].key) == NULL) {
+			fatal_error("Value not found.");
 		}
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
-
-		average += sum / REPEAT;
 	}
-	num_elem_set = log2(MAXELEM) - log2(START);
-	fprintf(f, "\n# Overall average for each set of elements with %d trials: \n%d", REPEAT, (int)(average / num_elem_set) );
-
-	fclose(f);
 }
 
-static void assert_remove(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE	*f;
-	rbt_t	*rbt;
-	data_t	*data;
+static void trial_sort(trial_t *trial) {
+	rbt_sort(trial->rbt);
+}
 
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Out of memory.");
+static void trial_remove(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		if( !rbt_remove(trial->rbt, trial->data[i].key, free, free) ) {
+			fatal_error("Key not in structure.");
+		}
 	}
-	fprintf(f, "# RBT Remove Benchmarks \n# Elements, Time (microsec. average for %d trials per set of elements) \n", REPEAT);
-
-	average = 0;
-
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
-
-		sum = 0;
-
-		for(int r = 0; r < REPEAT; r++) {
-
-			rbt = rbt_create( (cmpfunc_t)cmpint );
-			data = insert_data(rbt, elem);
-
-			t1 = gettime();
-			for(int i = 0; i < elem; i++) {
-				if( !rbt_remove(rbt, data[i].key, free, free) ) {
-					fatal_error("Key not in structure.");
-				}
-			}
-			t2 = gettime();
-
-			sum += t2 - t1;
+}
 
-			free(data);
-			rbt_destroy(rbt, free, free);
+/* Items at every power of two of sorted tree. */
+static void trial_getitem(trial_t *trial) {
+	for(int i = 1; i < trial->elem; i *= 2) {
+		if(rbt_getitem(trial->rbt, i) == NULL) {
+			fatal_error("\'%d\' out of bounds.", i);
 		}
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
-
-		average += sum / REPEAT;
 	}
-	num_elem_set = log2(MAXELEM) - log2(START);
-	fprintf(f, "\n# Overall average for each set of elements with %d trials: \n%d", REPEAT, (int)(average / num_elem_set) );
-
-	fclose(f);
 }
 
-static void assert_getitem(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE *f;
-	rbt_t *rbt;
+static void trial_iterator(trial_t *trial) {
+	rbt_iterator_t *iterator = rbt_createiterator(trial->rbt);
 
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Out of memory.");
+	while(rbt_next(iterator) != NULL) {
 	}
-	fprintf(f, "# RBT Get-Item Benchmarks \n# Elements, Time (microsec. average for %d trials per set of elements) \n", REPEAT);
-
-	average = 0;
-
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
-
-		printf("\'%d\' elements... \n", elem);
-
-		sum = 0;
+	rbt_destroyiterator(iterator);
+}
 
-		rbt = rbt_create( (cmpfunc_t)cmpint );
-		free(insert_data(rbt, elem));
-		rbt_sort(rbt);
+/* Ascending keys, as in most ingest; rbt_insert descends from root, rbt_append starts from finger at largest node.
+ * Compare with insert series, which inserts same ascending keys. */
+static void trial_append(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		rbt_append(trial->rbt, trial->data[i].key, trial->data[i].item);
+	}
+}
 
-		for(int r = 0; r < REPEAT; r++) {
+/* Keys probed in random order, so each level of each descent is a likely cache-miss;
+ * rbt_search descends once per key, rbt_search_many interleaves descents. */
+static void trial_search_random(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		trial->items[i] = rbt_search(trial->rbt, trial->keys[i]);
+	}
+}
 
+static void trial_search_many(trial_t *trial) {
+	rbt_search_many(trial->rbt, trial->keys, trial->items, trial->elem);
+}
 
-			t1 = gettime();
-			for(int i = 1; i < elem; i *= 2) {
-				if(rbt_getitem(rbt, i) == NULL) {
-					fatal_error("\'%d\' out of bounds.", i);
-				}
-			}
-			t2 = gettime();
+/* Inline-Key Benchmarks: */
+/* Same keys and order as above, but stored in node and compared directly. */
+static void trial_inline_insert(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		rbt_int_insert(trial->inline_rbt, i, trial->keys[i]);
+	}
+}
 
-			sum += t2 - t1;
+static void trial_inline_search(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		if(rbt_int_search(trial->inline_rbt, i) == NULL) {
+			fatal_error("Value not found.");
 		}
-		rbt_destroy(rbt, free, free);
-
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
-
-		average += sum / REPEAT;
 	}
-	num_elem_set = log2(MAXELEM) - log2(START);
-	fprintf(f, "\n# Overall average for each set of elements with %d trials: \n%d", REPEAT, (int)(average / num_elem_set) );
-
-	fclose(f);
 }
 
-static void assert_iterator(char *bnch_file) {
-	unsigned long long t1, t2, sum, average, num_elem_set;
-	FILE	*f;
-	rbt_t	*rbt;
-	rbt_iterator_t *iterator;
-
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Out of memory.");
+/* Oldest quarter of keys expires at once, e.g. a window of timestamps;
+ * rbt_remove once per key, against one rbt_remove_range. Building tree is not timed. */
+static void trial_remove_quarter(trial_t *trial) {
+	for(int i = 0; i < trial->elem / 4; i++) {
+		rbt_remove(trial->rbt, trial->data[i].key, NULL, NULL);
 	}
-	fprintf(f, "# RBT Iterator Benchmarks \n# Elements, Time (microsec. average for %d trials per set of elements) \n", REPEAT);
+}
 
-	average = 0;
+static void trial_remove_range(trial_t *trial) {
+	int lo = 0, hi = trial->elem / 4 - 1;
 
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
+	if(rbt_remove_range(trial->rbt, &lo, &hi, NULL, NULL) != hi - lo + 1) {
+		fatal_error("Wrong number of items removed.");
+	}
+}
 
-		sum = 0;
+/* Number of operations done by trial of set of elements. */
+static long ops_all(int elem) {
+	return elem;
+}
 
-		rbt = rbt_create( (cmpfunc_t)cmpint );
-		free(insert_data(rbt, elem));
+static long ops_quarter(int elem) {
+	return elem / 4;
+}
 
-		for(int r = 0; r < REPEAT; r++) {
-			iterator = rbt_createiterator(rbt);
+static long ops_doubling(int elem) {
+	long ops = 0;
 
-			t1 = gettime();
-			while(rbt_next(iterator) != NULL) {
-			}
-			t2 = gettime();
+	for(int i = 1; i < elem; i *= 2) {
+		ops++;
+	}
+	return ops;
+}
 
-			sum += t2 - t1;
+/* Time 'func' for every set of elements. */
+static void assert_series(char *bnch_file, char *title, benchfunc_t setup, benchfunc_t func, benchfunc_t teardown, long (*ops)(int elem)) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
 
-			rbt_destroyiterator(iterator);
-		}
-		rbt_destroy(rbt, free, free);
+	file = bench_open(bnch_file, title);
 
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT) );
+	for(int elem = START; elem < MAXELEM; elem *= 2) {
+		trial.elem = elem;
 
-		average += sum / REPEAT;
+		bench_run(&stats, setup, func, teardown, &trial, ops(elem));
+		bench_write(file, elem, &stats);
 	}
-	num_elem_set = log2(MAXELEM) - log2(START);
-	fprintf(f, "\n# Overall average for each set of elements with %d trials: \n%d", REPEAT, (int)(average / num_elem_set) );
-
-	fclose(f);
+	bench_close(file);
 }
 
 int main(int argc, char **argv) {
 	
-	if(argc < 7) {
-		printf("Usage: %s <insert-file> <search-file> <sort-file> <remove-file> <getitem-file> <iterator-file> \n", *argv);
+	if(argc < 14) {
+		printf("Usage: %s <insert-file> <search-file> <sort-file> <remove-file> <getitem-file> <iterator-file> <inline-insert-file> <inline-search-file> <append-file> <search-random-file> <search-many-file> <remove-quarter-file> <remove-range-file> \n", *argv);
 		return -1;
 	}
 	
-	assert_insert(argv[1]);
-	assert_search(argv[2]);
-	assert_sort(argv[3]);
-	assert_remove(argv[4]);
-	assert_getitem(argv[5]);
-	assert_iterator(argv[6]);
+	assert_series(argv[1], "RBT Insert Benchmarks", (benchfunc_t)setup_empty, (benchfunc_t)trial_insert, (benchfunc_t)teardown, ops_all);
+	assert_series(argv[2], "RBT Search Benchmarks", (benchfunc_t)setup_filled, (benchfunc_t)trial_search, (benchfunc_t)teardown, ops_all);
+	assert_series(argv[3], "RBT Sort Benchmarks", (benchfunc_t)setup_filled, (benchfunc_t)trial_sort, (benchfunc_t)teardown, ops_all);
+	assert_series(argv[4], "RBT Remove Benchmarks", (benchfunc_t)setup_filled, (benchfunc_t)trial_remove, (benchfunc_t)teardown, ops_all);
+	assert_series(argv[5], "RBT Get-Item Benchmarks", (benchfunc_t)setup_sorted, (benchfunc_t)trial_getitem, (benchfunc_t)teardown, ops_doubling);
+	assert_series(argv[6], "RBT Iterator Benchmarks", (benchfunc_t)setup_filled, (benchfunc_t)trial_iterator, (benchfunc_t)teardown, ops_all);
+	assert_series(argv[7], "RBT Inline-Key Insert Benchmarks", (benchfunc_t)setup_inline_empty, (benchfunc_t)trial_inline_insert, (benchfunc_t)teardown_inline, ops_all);
+	assert_series(argv[8], "RBT Inline-Key Search Benchmarks", (benchfunc_t)setup_inline_filled, (benchfunc_t)trial_inline_search, (benchfunc_t)teardown_inline, ops_all);
+	assert_series(argv[9], "RBT Append Benchmarks, ascending keys", (benchfunc_t)setup_empty, (benchfunc_t)trial_append, (benchfunc_t)teardown, ops_all);
+	assert_series(argv[10], "RBT Search Benchmarks, keys in random order", (benchfunc_t)setup_shuffled, (benchfunc_t)trial_search_random, (benchfunc_t)teardown_shuffled, ops_all);
+	assert_series(argv[11], "RBT Search Many Benchmarks, keys in random order", (benchfunc_t)setup_shuffled, (benchfunc_t)trial_search_many, (benchfunc_t)teardown_shuffled, ops_all);
+	assert_series(argv[12], "RBT Remove Benchmarks, oldest quarter of keys", (benchfunc_t)setup_filled, (benchfunc_t)trial_remove_quarter, (benchfunc_t)teardown_removed, ops_quarter);
+	assert_series(argv[13], "RBT Remove Range Benchmarks, oldest quarter of keys", (benchfunc_t)setup_filled, (benchfunc_t)trial_remove_range, (benchfunc_t)teardown_removed, ops_quarter);
 	
 	return 0;
 }
\ No newline at end of file
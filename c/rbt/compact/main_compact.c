@@ -0,0 +1,181 @@
+/* Author: Marius Ingebrigtsen */
+#include "../../common.h"
+#include "../rbt.h"
+
+#define KEYS	4096	/* Keys drawn from [0, KEYS), so inserts overwrite and removes hit and miss. */
+#define RANGE	64		/* Widest interval removed by range-removal. */
+#define BATCH	32		/* Keys per batched search. */
+
+/* Model of rbt; 'model[k]' is index of item with key 'k', or -1 if key not in rbt. */
+static int model[KEYS], keys[KEYS], *items, num;
+
+
+static int cmpint(int *a, int *b) {
+	return (*a > *b) - (*a < *b);
+}
+
+static int model_size(void) {
+	int size = 0;
+
+	for(int k = 0; k < KEYS; k++) {
+		size += (model[k] >= 0);
+	}
+	return size;
+}
+
+static int *model_item(int k) {
+	return (model[k] >= 0) ? &items[model[k]] : NULL;
+}
+
+static void apply_insert(rbt_t *rbt, int k, int i) {
+	int inserted = rbt_insert(rbt, &keys[k], &items[i]);
+
+	if(inserted != (model[k] < 0)) {
+		fatal_error("Insert; key \'%d\' returned \'%d\'. \n", k, inserted);
+	}
+	model[k] = i;
+}
+
+static void apply_remove(rbt_t *rbt, int k, int pop) {
+	int *item, removed;
+
+	if(pop) {
+		item = rbt_pop(rbt, &keys[k], NULL);
+		if(item != model_item(k)) {
+			fatal_error("Pop; key \'%d\' returned wrong item. \n", k);
+		}
+	} else {
+		removed = rbt_remove(rbt, &keys[k], NULL, NULL);
+		if(removed != (model[k] >= 0)) {
+			fatal_error("Remove; key \'%d\' returned \'%d\'. \n", k, removed);
+		}
+	}
+	model[k] = -1;
+}
+
+static void apply_remove_range(rbt_t *rbt, int lo, int hi) {
+	int removed, expect = 0;
+
+	for(int k = lo; k <= hi; k++) {
+		expect += (model[k] >= 0);
+		model[k] = -1;
+	}
+	removed = rbt_remove_range(rbt, &keys[lo], &keys[hi], NULL, NULL);
+	if(removed != expect) {
+		fatal_error("Range [%d, %d]; removed \'%d\', expected \'%d\'. \n", lo, hi, removed, expect);
+	}
+}
+
+static void apply_search_many(rbt_t *rbt) {
+	void	*batch[BATCH], *found[BATCH];
+	int		k[BATCH];
+
+	for(int i = 0; i < BATCH; i++) {
+		k[i]		= rand() % KEYS;
+		batch[i]	= &keys[k[i]];
+	}
+	rbt_search_many(rbt, batch, found, BATCH);
+
+	for(int i = 0; i < BATCH; i++) {
+		if(found[i] != model_item(k[i])) {
+			fatal_error("Batched search; key \'%d\' found wrong item. \n", k[i]);
+		}
+	}
+}
+
+/* Check every key by search, and sorted iteration against model. */
+static void apply_check(rbt_t *rbt, char *title) {
+	rbt_iterator_t	*iterator;
+	int				*item, k;
+
+	if(rbt_size(rbt, 1) != model_size()) {
+		fatal_error("%s; size \'%d\', expected \'%d\'. \n", title, rbt_size(rbt, 1), model_size());
+	}
+	for(k = 0; k < KEYS; k++) {
+		if(rbt_search(rbt, &keys[k]) != model_item(k)) {
+			fatal_error("%s; search for key \'%d\' found wrong item. \n", title, k);
+		}
+	}
+
+	rbt_sort(rbt);
+	iterator = rbt_createiterator(rbt);
+
+	for(k = 0; rbt_hasnext(iterator); k++) {
+		item = rbt_next(iterator);
+		while( (k < KEYS) && (model[k] < 0) ) {
+			k++;
+		}
+		if( (k == KEYS) || (item != &items[model[k]]) ) {
+			fatal_error("%s; iteration out of order at key \'%d\'. \n", title, k);
+		}
+	}
+	rbt_destroyiterator(iterator);
+
+	printf("%s; %d items agree with model. \n", title, rbt_size(rbt, 1));
+}
+
+int main(int argc, char **argv) {
+	rbt_t	*rbt;
+	int		op, k, hi;
+
+	if(argc < 2) {
+		printf("Usage: %s <operations> \n", *argv);
+		return -1;
+	}
+	num = atoi(argv[1]);
+
+	items = malloc(sizeof(int) * (num + KEYS));
+	if(items == NULL) {
+		fatal_error("Out of memory.");
+	}
+	for(k = 0; k < KEYS; k++) {
+		keys[k]		= k;
+		model[k]	= -1;
+	}
+	rbt = rbt_create( (cmpfunc_t)cmpint );
+
+	/* Ascending appends, then every other key removed, so later inserts land between. */
+	for(k = 0; k < KEYS; k++) {
+		items[k] = k;
+		if(rbt_append(rbt, &keys[k], &items[k]) != 1) {
+			fatal_error("Append; key \'%d\' not inserted. \n", k);
+		}
+		model[k] = k;
+	}
+	for(k = 1; k < KEYS; k += 2) {
+		apply_remove(rbt, k, k % 4 == 1);
+	}
+	apply_check(rbt, "Append & Remove");
+
+	for(int i = 0; i < num; i++) {
+		items[KEYS + i]	= KEYS + i;
+		op				= rand() % 16;
+		k				= rand() % KEYS;
+
+		if(op < 8) {
+			apply_insert(rbt, k, KEYS + i);
+		}
+		else if(op < 11) {
+			apply_remove(rbt, k, 0);
+		}
+		else if(op < 14) {
+			apply_remove(rbt, k, 1);
+		}
+		else if(op < 15) {
+			hi = k + rand() % RANGE;
+			apply_remove_range(rbt, k, (hi < KEYS) ? hi : KEYS - 1);
+		}
+		else {
+			apply_search_many(rbt);
+		}
+		if(rbt_size(rbt, 1) != model_size()) {
+			fatal_error("Operation \'%d\'; size \'%d\', expected \'%d\'. \n", i, rbt_size(rbt, 1), model_size());
+		}
+	}
+	apply_check(rbt, "Random Operations");
+
+	rbt_destroy(rbt, NULL, NULL);
+	free(items);
+
+	return 0;
+}
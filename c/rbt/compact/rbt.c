@@ -0,0 +1,889 @@
+/* Author: Marius Ingebrigtsen */
+/* Compact Red-Black Tree implementation.
+ * Nodes live in one pool and refer to each other with 32-bit indexes in stead of pointers,
+ * and the color is packed into spare bit of 'prev'-index; a node is 32 bytes with no malloc-overhead.
+ * Insert and remove are iterative top-down (Julienne Walker), so no parent-pointers or recursion are needed.
+ * NOTE: Pool is re-allocated as it grows, so a node is always referred to by index and never by address. */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbt.h"
+#include "../../plot.h"
+
+#define NIL			0			/* Index of NULL-node; always black without children. */
+#define FAKEROOT	1			/* Index of pseudo-root used by top-down insert and remove. */
+#define INITSIZE	64			/* Initial number of nodes in pool. */
+#define MAXNODES	0x7fffffff	/* 2^31 - 1; largest index fitting in 'prev'. */
+#define SEARCH_GROUP	16		/* Number of lookups interleaved by search_many. */
+
+/* Access node in pool by index. Requires 'rbt' in scope. */
+#define N(ref)		(rbt->nodes[(ref)])
+#define IS_RED(ref)	(N(ref).red)
+
+typedef uint32_t ref_t;
+
+typedef struct node node_t;
+struct node {
+	void		*key, *item;
+	ref_t		link[2];		/* Left and right child. */
+	ref_t		next;			/* Iteration-sequence, or free-list when node is unused. */
+	uint32_t	prev : 31;
+	uint32_t	red : 1;
+};
+
+struct rbt {
+	node_t		*nodes;
+	ref_t		root, head, freelist;
+	uint32_t	used, capacity;
+	ref_t		*spine;			/* Path from root to largest node; finger for rbt_append. Empty when invalid. */
+	int			spinelen, spinecap;
+	cmpfunc_t	cmpfunc;
+	int			children;
+};
+
+
+/* RBT Create: */
+rbt_t *rbt_create(cmpfunc_t cmpfunc) {
+	rbt_t *rbt;
+
+	rbt = calloc(1, sizeof(rbt_t));
+	if(rbt == NULL) {
+		fatal_error("Out of memory.\n");
+	}
+	rbt->nodes = calloc(INITSIZE, sizeof(node_t));
+	if(rbt->nodes == NULL) {
+		fatal_error("Out of memory.\n");
+	}
+	rbt->capacity	= INITSIZE;
+	rbt->used		= FAKEROOT + 1;
+	rbt->cmpfunc	= cmpfunc;
+
+	return rbt;
+}
+
+/* RBT Destroy: */
+/* Every node in use is in iteration-sequence, so destruction walks sequence in stead of tree. */
+void rbt_destroy(rbt_t *rbt, freefunc_t freekey, freefunc_t freeitem) {
+	for(ref_t current = rbt->head; current != NIL; current = N(current).next) {
+		if(freekey != NULL) {
+			freekey(N(current).key);
+		}
+		if(freeitem != NULL) {
+			freeitem(N(current).item);
+		}
+	}
+	free(rbt->nodes);
+	free(rbt->spine);
+	free(rbt);
+}
+
+/* RBT Size: */
+static void _rbt_depth(rbt_t *rbt, ref_t current, int *depth, int level) {
+	if(current == NIL) {
+		return;
+	}
+	*depth = (level > *depth) ? level : *depth;
+	_rbt_depth(rbt, N(current).link[0], depth, level + 1);
+	_rbt_depth(rbt, N(current).link[1], depth, level + 1);
+}
+
+int rbt_size(rbt_t *rbt, int size) {
+	int depth;
+
+	if(size) {
+		return rbt->children;
+	}
+	depth = 0;
+
+	_rbt_depth(rbt, rbt->root, &depth, 0);
+
+	return depth;
+}
+
+/* RBT Node Pool: */
+/* Return index of unused node, linked first in iteration-sequence. */
+static ref_t node_create(rbt_t *rbt, void *key, void *item) {
+	ref_t ref;
+
+	if(rbt->freelist != NIL) {
+		ref = rbt->freelist;
+		rbt->freelist = N(ref).next;
+	} else {
+		if(rbt->used >= rbt->capacity) {
+			if(rbt->capacity > MAXNODES / 2) {
+				fatal_error("Number of nodes exceeds limit of compact rbt.");
+			}
+			rbt->capacity *= 2;
+			rbt->nodes = realloc(rbt->nodes, sizeof(node_t) * rbt->capacity);
+			if(rbt->nodes == NULL) {
+				fatal_error("Out of memory.\n");
+			}
+		}
+		ref = rbt->used++;
+	}
+	N(ref).key		= key;
+	N(ref).item		= item;
+	N(ref).link[0]	= N(ref).link[1] = NIL;
+	N(ref).red		= 1;
+	N(ref).prev		= NIL;
+	N(ref).next		= rbt->head;
+
+	if(rbt->head != NIL) {
+		N(rbt->head).prev = ref;
+	}
+	rbt->head = ref;
+
+	return ref;
+}
+
+static void node_destroy(rbt_t *rbt, ref_t ref, freefunc_t freekey, freefunc_t freeitem) {
+	if(freekey != NULL) {
+		freekey(N(ref).key);
+	}
+	if(freeitem != NULL) {
+		freeitem(N(ref).item);
+	}
+	N(ref).next		= rbt->freelist;
+	rbt->freelist	= ref;
+}
+
+/* Remove node from iteration-sequence. */
+static void sequence_unlink(rbt_t *rbt, ref_t ref) {
+	if(N(ref).prev != NIL) {
+		N(N(ref).prev).next = N(ref).next;
+	} else {
+		rbt->head = N(ref).next;
+	}
+	if(N(ref).next != NIL) {
+		N(N(ref).next).prev = N(ref).prev;
+	}
+}
+
+/* Put node 'new' at position of 'old' in iteration-sequence. */
+static void sequence_replace(rbt_t *rbt, ref_t old, ref_t new) {
+	N(new).prev = N(old).prev;
+	N(new).next = N(old).next;
+
+	if(N(new).prev != NIL) {
+		N(N(new).prev).next = new;
+	} else {
+		rbt->head = new;
+	}
+	if(N(new).next != NIL) {
+		N(N(new).next).prev = new;
+	}
+}
+
+/* RBT Insert: */
+/* Rotate 'root' in direction 'dir' and recolor; new subtree-root is black with red child. */
+static inline ref_t rotate_single(rbt_t *rbt, ref_t root, int dir) {
+	ref_t child;
+
+	child				= N(root).link[!dir];
+	N(root).link[!dir]	= N(child).link[dir];
+	N(child).link[dir]	= root;
+	N(root).red			= 1;
+	N(child).red		= 0;
+
+	return child;
+}
+
+static inline ref_t rotate_double(rbt_t *rbt, ref_t root, int dir) {
+	N(root).link[!dir] = rotate_single(rbt, N(root).link[!dir], !dir);
+
+	return rotate_single(rbt, root, dir);
+}
+
+int rbt_insert(rbt_t *rbt, void *key, void *item) {
+	ref_t	great, grand, parent, current, new;
+	int		dir, last, cmp;
+
+	new = NIL;
+	rbt->spinelen = 0;
+
+	if(rbt->root == NIL) {
+		rbt->root = new = node_create(rbt, key, item);
+	}
+	else {
+		N(FAKEROOT).link[0]	= NIL;
+		N(FAKEROOT).link[1]	= rbt->root;
+
+		great	= FAKEROOT;
+		grand	= parent = NIL;
+		current	= rbt->root;
+		dir		= last = 0;
+
+		for(;;) {
+			if(current == NIL) {
+				/* Insert new red leaf. */
+				current = new = node_create(rbt, key, item);
+				N(parent).link[dir] = new;
+			}
+			else if( IS_RED(N(current).link[0]) && IS_RED(N(current).link[1]) ) {
+				/* Split 4-Node: */
+				N(current).red = 1;
+				N(N(current).link[0]).red = N(N(current).link[1]).red = 0;
+			}
+
+			/* Fix red violation between 'current' and 'parent'. */
+			if( IS_RED(current) && IS_RED(parent) ) {
+				int dir2 = (N(great).link[1] == grand);
+
+				if(current == N(parent).link[last]) {
+					N(great).link[dir2] = rotate_single(rbt, grand, !last);
+				} else {
+					N(great).link[dir2] = rotate_double(rbt, grand, !last);
+				}
+			}
+
+			if(new != NIL) {
+				break;
+			}
+			cmp = rbt->cmpfunc(key, N(current).key);
+
+			if(cmp == 0) {
+				N(current).item = item;
+				break;
+			}
+			last	= dir;
+			dir		= (cmp > 0);
+
+			if(grand != NIL) {
+				great = grand;
+			}
+			grand	= parent;
+			parent	= current;
+			current	= N(current).link[dir];
+		}
+		rbt->root = N(FAKEROOT).link[1];
+	}
+	N(rbt->root).red = 0;
+
+	if(new == NIL) {
+		return 0;
+	}
+	rbt->children++;
+
+	return 1;
+}
+
+/* RBT Append: */
+static void spine_push(rbt_t *rbt, ref_t ref) {
+	if(rbt->spinelen == rbt->spinecap) {
+		rbt->spinecap = (rbt->spinecap == 0) ? 32 : rbt->spinecap * 2;
+		rbt->spine = realloc(rbt->spine, sizeof(ref_t) * rbt->spinecap);
+		if(rbt->spine == NULL) {
+			fatal_error("Out of memory.\n");
+		}
+	}
+	rbt->spine[rbt->spinelen++] = ref;
+}
+
+int rbt_append(rbt_t *rbt, void *key, void *item) {
+	ref_t	last, parent, grand, uncle, new;
+	int		cmp, i;
+
+	if(rbt->root == NIL) {
+		return rbt_insert(rbt, key, item);
+	}
+	if(rbt->spinelen == 0) {
+		for(ref_t current = rbt->root; current != NIL; current = N(current).link[1]) {
+			spine_push(rbt, current);
+		}
+	}
+	last = rbt->spine[rbt->spinelen - 1];
+	cmp = rbt->cmpfunc(key, N(last).key);
+
+	if(cmp < 0) {
+		return rbt_insert(rbt, key, item);
+	} else if(cmp == 0) {
+		N(last).item = item;
+		return 0;
+	}
+	new = node_create(rbt, key, item);
+	N(last).link[1] = new;
+	spine_push(rbt, new);
+	rbt->children++;
+
+	/* Bottom-up fix of red violation along spine; every node is right child of its parent. */
+	for(i = rbt->spinelen - 1; (i > 0) && IS_RED(rbt->spine[i - 1]); i -= 2) {
+		parent	= rbt->spine[i - 1];	/* Red, so not root. */
+		grand	= rbt->spine[i - 2];
+		uncle	= N(grand).link[0];
+
+		if(IS_RED(uncle)) {
+			N(parent).red = N(uncle).red = 0;
+			N(grand).red = 1;
+			continue;
+		}
+		/* Right-Right Case: */
+		rotate_single(rbt, grand, 0);
+
+		if(i == 2) {
+			rbt->root = parent;
+		} else {
+			N(rbt->spine[i - 3]).link[1] = parent;
+		}
+		/* Rotated node leaves spine. */
+		memmove(&rbt->spine[i - 2], &rbt->spine[i - 1], sizeof(ref_t) * (rbt->spinelen - i + 1));
+		rbt->spinelen--;
+		break;
+	}
+	N(rbt->root).red = 0;
+
+	return 1;
+}
+
+/* RBT Remove & Pop: */
+/* Remove node with key from tree and iteration-sequence.
+ * Return index of node now holding removed key and item, or NIL if key not in rbt. */
+static ref_t rbt_unlink(rbt_t *rbt, void *key) {
+	ref_t	grand, parent, current, found, sibling, top;
+	int		dir, last, dir2, cmp;
+	void	*tmp;
+
+	if(rbt->root == NIL) {
+		return NIL;
+	}
+	rbt->spinelen = 0;
+
+	N(FAKEROOT).link[0]	= NIL;
+	N(FAKEROOT).link[1]	= rbt->root;
+	N(FAKEROOT).red		= 0;
+
+	current	= FAKEROOT;
+	grand	= parent = found = NIL;
+	dir		= 1;
+
+	/* Push red node down to leaf-level, so removal never breaks black-height. */
+	while(N(current).link[dir] != NIL) {
+		last	= dir;
+		grand	= parent;
+		parent	= current;
+		current	= N(current).link[dir];
+
+		cmp = rbt->cmpfunc(key, N(current).key);
+		dir = (cmp > 0);
+
+		if(cmp == 0) {
+			found = current;
+		}
+
+		if( IS_RED(current) || IS_RED(N(current).link[dir]) ) {
+			continue;
+		}
+		if(IS_RED(N(current).link[!dir])) {
+			N(parent).link[last] = rotate_single(rbt, current, dir);
+			parent = N(parent).link[last];
+			continue;
+		}
+		sibling = N(parent).link[!last];
+
+		if(sibling == NIL) {
+			continue;
+		}
+		if( !IS_RED(N(sibling).link[!last]) && !IS_RED(N(sibling).link[last]) ) {
+			/* Color Flip: */
+			N(parent).red	= 0;
+			N(sibling).red	= 1;
+			N(current).red	= 1;
+		}
+		else {
+			dir2 = (N(grand).link[1] == parent);
+
+			if(IS_RED(N(sibling).link[last])) {
+				N(grand).link[dir2] = rotate_double(rbt, parent, last);
+			} else {
+				N(grand).link[dir2] = rotate_single(rbt, parent, last);
+			}
+			top = N(grand).link[dir2];
+
+			N(current).red = N(top).red = 1;
+			N(N(top).link[0]).red = 0;
+			N(N(top).link[1]).red = 0;
+		}
+	}
+
+	if(found != NIL) {
+		/* 'current' is in-order neighbour of 'found'; splice 'current' out of tree,
+		 * and let 'found' hold its key and item in stead. */
+		N(parent).link[N(parent).link[1] == current] = N(current).link[N(current).link[0] == NIL];
+
+		sequence_unlink(rbt, found);
+		if(found != current) {
+			sequence_replace(rbt, current, found);
+
+			tmp = N(found).key;		N(found).key	= N(current).key;	N(current).key	= tmp;
+			tmp = N(found).item;	N(found).item	= N(current).item;	N(current).item	= tmp;
+		}
+		rbt->children--;
+	}
+	rbt->root = N(FAKEROOT).link[1];
+	if(rbt->root != NIL) {
+		N(rbt->root).red = 0;
+	}
+
+	return (found == NIL) ? NIL : current;
+}
+
+int rbt_remove(rbt_t *rbt, void *key, freefunc_t freekey, freefunc_t freeitem) {
+	ref_t removed;
+
+	removed = rbt_unlink(rbt, key);
+	if(removed == NIL) {
+		return 0;
+	}
+	node_destroy(rbt, removed, freekey, freeitem);
+
+	return 1;
+}
+
+void *rbt_pop(rbt_t *rbt, void *key, freefunc_t freekey) {
+	ref_t	removed;
+	void	*item;
+
+	removed = rbt_unlink(rbt, key);
+	if(removed == NIL) {
+		return NULL;
+	}
+	item = N(removed).item;
+	node_destroy(rbt, removed, freekey, NULL);
+
+	return item;
+}
+
+/* RBT Remove Range: */
+/* Black-height of tree; number of black nodes on every path from root down to leaf. */
+static int tree_blackheight(rbt_t *rbt, ref_t root) {
+	int height;
+
+	for(height = 0; root != NIL; root = N(root).link[0]) {
+		height += !IS_RED(root);
+	}
+	return height;
+}
+
+/* Descend spine of 'root' in direction 'dir' to black node with black-height 'hother', and replace it by red 'middle'
+ * with that node and 'other' as subtrees. A red violation this creates is rotated away on way back up (Blelloch et al.),
+ * and black-height of 'root' is kept. Cost is difference in black-height. */
+static ref_t join_spine(rbt_t *rbt, ref_t root, int hroot, ref_t middle, ref_t other, int hother, int dir) {
+	ref_t child;
+
+	if( !IS_RED(root) && (hroot == hother) ) {
+		N(middle).red			= 1;
+		N(middle).link[!dir]	= root;
+		N(middle).link[dir]		= other;
+		return middle;
+	}
+	child = join_spine(rbt, N(root).link[dir], hroot - !IS_RED(root), middle, other, hother, dir);
+	N(root).link[dir] = child;
+
+	if( !IS_RED(root) && IS_RED(child) && IS_RED(N(child).link[dir]) ) {
+		N(N(child).link[dir]).red	= 0;
+		N(root).link[dir]			= N(child).link[!dir];
+		N(child).link[!dir]			= root;
+		return child;
+	}
+	return root;
+}
+
+/* Return tree of nodes in 'left', 'middle' and 'right', where every key in 'left' is less than key of 'middle',
+ * and key of 'middle' is less than every key in 'right'; black-height of joined tree is returned in 'height'.
+ * Roots are made black first, so 'middle' always goes in red between two black subtrees. Root of joined tree may be red. */
+static ref_t subtree_join(rbt_t *rbt, ref_t left, int hleft, ref_t middle, ref_t right, int hright, int *height) {
+	if(IS_RED(left)) {
+		N(left).red = 0;
+		hleft++;
+	}
+	if(IS_RED(right)) {
+		N(right).red = 0;
+		hright++;
+	}
+	if(hleft > hright) {
+		*height = hleft;
+		return join_spine(rbt, left, hleft, middle, right, hright, 1);
+	}
+	if(hright > hleft) {
+		*height = hright;
+		return join_spine(rbt, right, hright, middle, left, hleft, 0);
+	}
+	N(middle).red		= 1;
+	N(middle).link[0]	= left;
+	N(middle).link[1]	= right;
+	*height				= hleft;
+
+	return middle;
+}
+
+/* Split tree at 'key' into 'left' with keys less than key, or less than or equal if 'inclusive', and 'right' with remaining keys.
+ * Each node on search-path is joined onto its side with subtree hanging off path; black-heights of joined trees increase,
+ * so cost of joins telescopes to O(log n). */
+static void subtree_split(rbt_t *rbt, ref_t root, int height, void *key, int inclusive, ref_t *left, int *hleft, ref_t *right, int *hright) {
+	ref_t	part;
+	int		hpart, hchild, cmp;
+
+	if(root == NIL) {
+		*left	= *right	= NIL;
+		*hleft	= *hright	= 0;
+		return;
+	}
+	hchild	= height - !IS_RED(root);
+	cmp		= rbt->cmpfunc(key, N(root).key);
+
+	if( (cmp > 0) || (inclusive && (cmp == 0)) ) {
+		subtree_split(rbt, N(root).link[1], hchild, key, inclusive, &part, &hpart, right, hright);
+		*left = subtree_join(rbt, N(root).link[0], hchild, root, part, hpart, hleft);
+	} else {
+		subtree_split(rbt, N(root).link[0], hchild, key, inclusive, left, hleft, &part, &hpart);
+		*right = subtree_join(rbt, part, hpart, root, N(root).link[1], hchild, hright);
+	}
+}
+
+/* Join trees where every key in 'left' is less than every key in 'right'; smallest node of 'right' is split off as middle. */
+static ref_t subtree_join_adjacent(rbt_t *rbt, ref_t left, int hleft, ref_t right, int hright, int *height) {
+	ref_t	middle;
+	int		hmiddle;
+
+	if(right == NIL) {
+		*height = hleft;
+		return left;
+	}
+	for(middle = right; N(middle).link[0] != NIL; middle = N(middle).link[0]);
+
+	subtree_split(rbt, right, hright, N(middle).key, 1, &middle, &hmiddle, &right, &hright);
+
+	return subtree_join(rbt, left, hleft, middle, right, hright, height);
+}
+
+/* Unlink and destroy every node in subtree, and return number of nodes. Subtree is balanced, so recursion is shallow. */
+static int subtree_destroy(rbt_t *rbt, ref_t root, freefunc_t freekey, freefunc_t freeitem) {
+	int num;
+
+	if(root == NIL) {
+		return 0;
+	}
+	num = 1 + subtree_destroy(rbt, N(root).link[0], freekey, freeitem) + subtree_destroy(rbt, N(root).link[1], freekey, freeitem);
+
+	sequence_unlink(rbt, root);
+	node_destroy(rbt, root, freekey, freeitem);
+
+	return num;
+}
+
+int rbt_remove_range(rbt_t *rbt, void *lo, void *hi, freefunc_t freekey, freefunc_t freeitem) {
+	ref_t	left, middle, right;
+	int		hleft, hmiddle, hright, height, removed;
+
+	if( (rbt->root == NIL) || (rbt->cmpfunc(lo, hi) > 0) ) {
+		return 0;
+	}
+	rbt->spinelen = 0;
+
+	subtree_split(rbt, rbt->root, tree_blackheight(rbt, rbt->root), lo, 0, &left, &hleft, &middle, &hmiddle);
+	subtree_split(rbt, middle, hmiddle, hi, 1, &middle, &hmiddle, &right, &hright);
+
+	removed = subtree_destroy(rbt, middle, freekey, freeitem);
+
+	rbt->root = subtree_join_adjacent(rbt, left, hleft, right, hright, &height);
+	N(rbt->root).red = 0;
+	rbt->children -= removed;
+
+	return removed;
+}
+
+/* RBT Search: */
+void *rbt_search(rbt_t *rbt, void *key) {
+	ref_t	current;
+	int		cmp;
+
+	current = rbt->root;
+
+	while(current != NIL) {
+		cmp = rbt->cmpfunc(key, N(current).key);
+
+		if(cmp == 0) {
+			return N(current).item;
+		}
+		current = N(current).link[cmp > 0];
+	}
+	return NULL;
+}
+
+/* RBT Search Many: */
+/* Lookups in group advance one step per turn in round-robin, and prefetch what their next turn reads;
+ * cache-misses of up to SEARCH_GROUP independent descents overlap in stead of stalling one after another.
+ * Each lookup alternates between loading key of node, and comparing and moving to child. */
+void rbt_search_many(rbt_t *rbt, void **keys, void **items, int num) {
+	ref_t	current[SEARCH_GROUP];
+	int		index[SEARCH_GROUP];		/* Index of key searched for in slot, or -1 when slot is free. */
+	char	keyloaded[SEARCH_GROUP];
+	int		next, active, cmp;
+
+	if(rbt->root == NIL) {
+		for(int i = 0; i < num; i++) {
+			items[i] = NULL;
+		}
+		return;
+	}
+	for(int s = 0; s < SEARCH_GROUP; s++) {
+		index[s] = -1;
+	}
+	next = active = 0;
+
+	while( (active > 0) || (next < num) ) {
+		for(int s = 0; s < SEARCH_GROUP; s++) {
+			if(index[s] < 0) {
+				if(next == num) {
+					continue;
+				}
+				/* Start next lookup at root. */
+				index[s]		= next;
+				items[next]		= NULL;
+				current[s]		= rbt->root;
+				keyloaded[s]	= 0;
+				__builtin_prefetch(keys[next]);
+				next++;
+				active++;
+				continue;
+			}
+			if(!keyloaded[s]) {
+				__builtin_prefetch(N(current[s]).key);
+				keyloaded[s] = 1;
+				continue;
+			}
+			cmp = rbt->cmpfunc(keys[index[s]], N(current[s]).key);
+
+			if(cmp == 0) {
+				items[index[s]] = N(current[s]).item;
+				index[s] = -1;
+				active--;
+				continue;
+			}
+			current[s] = N(current[s]).link[cmp > 0];
+
+			if(current[s] == NIL) {
+				index[s] = -1;
+				active--;
+				continue;
+			}
+			__builtin_prefetch(&N(current[s]));
+			keyloaded[s] = 0;
+		}
+	}
+}
+
+/* RBT Print: */
+static char *rbt_color(rbt_t *rbt, ref_t ref) {
+	return IS_RED(ref) ? "red" : "black";
+}
+
+static void _rbt_print(rbt_t *rbt, ref_t current, plot_t *plot, strfunc_t strfunc) {
+	static long int NULL_ID = 2;
+	char	*color;
+	ref_t	child;
+
+	if(current == NIL) {
+		return;
+	}
+	color = rbt_color(rbt, current);
+
+	for(int dir = 0; dir < 2; dir++) {
+		child = N(current).link[dir];
+
+		if(child != NIL) {
+			plot_addlink2(plot, &N(current), &N(child), strfunc(N(current).item), strfunc(N(child).item), color, rbt_color(rbt, child));
+
+			_rbt_print(rbt, child, plot, strfunc);
+
+		} else {
+			plot_addlink2(plot, &N(current), (void*)NULL_ID++, strfunc(N(current).item), "NULL", color, "white");
+		}
+	}
+}
+
+void rbt_print(rbt_t *rbt, strfunc_t strfunc) {
+	plot_t *plot;
+
+	plot = plot_create("rbt");
+
+	_rbt_print(rbt, rbt->root, plot, strfunc);
+
+	plot_doplot(plot);
+
+	plot_destroy(plot);
+}
+
+/* RBT Get Item: */
+static void *rbt_edgeitem(rbt_t *rbt, int dir) {
+	ref_t current;
+
+	current = rbt->root;
+	while(N(current).link[dir] != NIL) {
+		current = N(current).link[dir];
+	}
+	return N(current).item;
+}
+
+void *rbt_getitem(rbt_t *rbt, int n) {
+	ref_t current;
+
+	if( (n < 0) ||
+		(n >= rbt->children) ||
+		(rbt->head == NIL) ) {
+
+		return NULL;
+	} else if(n == 0) {
+		return rbt_edgeitem(rbt, 0);
+	} else if(n == (rbt->children - 1)) {
+		return rbt_edgeitem(rbt, 1);
+	}
+	current = rbt->head;
+
+	for(int i = 0; i < n; i++) {
+		current = N(current).next;
+	}
+
+	return N(current).item;
+}
+
+/* RBT Sort: */
+static int issorted(rbt_t *rbt) {
+	for(ref_t current = rbt->head; (current != NIL) && (N(current).next != NIL); current = N(current).next) {
+		if(rbt->cmpfunc(N(current).key, N(N(current).next).key) > 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static ref_t split(rbt_t *rbt, ref_t head) {
+	ref_t slow, fast, ndhead;
+
+	slow = head;
+	fast = N(head).next;
+
+	while( (fast != NIL) && (N(fast).next != NIL) ) {
+		slow = N(slow).next;
+		fast = N(N(fast).next).next;
+	}
+
+	ndhead = N(slow).next;
+	N(slow).next = NIL;
+
+	return ndhead;
+}
+
+static ref_t merge(rbt_t *rbt, ref_t a, ref_t b) {
+	ref_t head, tail;
+
+	if(rbt->cmpfunc(N(a).key, N(b).key) < 0) {
+		head = a;
+		a = N(a).next;
+	} else {
+		head = b;
+		b = N(b).next;
+	}
+	tail = head;
+
+	while( (a != NIL) && (b != NIL) ) {
+		if(rbt->cmpfunc(N(a).key, N(b).key) < 0) {
+			N(tail).next = a;
+			a = N(a).next;
+		} else {
+			N(tail).next = b;
+			b = N(b).next;
+		}
+		tail = N(tail).next;
+	}
+
+	N(tail).next = (a == NIL) ? b : a;
+
+	return head;
+}
+
+static ref_t _mergesort(rbt_t *rbt, ref_t head) {
+	ref_t ndhead;
+
+	if( (head == NIL) || (N(head).next == NIL) ) {
+		return head;
+	}
+	ndhead	= split(rbt, head);
+
+	head	= _mergesort(rbt, head);
+	ndhead	= _mergesort(rbt, ndhead);
+
+	return merge(rbt, head, ndhead);
+}
+
+void rbt_sort(rbt_t *rbt) {
+	ref_t prev;
+
+	if(issorted(rbt)) {
+		return;
+	}
+	rbt->head = _mergesort(rbt, rbt->head);
+
+	/* Mergesort only follows 'next'; restore 'prev'. */
+	prev = NIL;
+	for(ref_t current = rbt->head; current != NIL; current = N(current).next) {
+		N(current).prev = prev;
+		prev = current;
+	}
+}
+
+
+/* Iterator-structure: */
+struct rbt_iterator {
+	rbt_t	*rbt;
+	ref_t	head, current;
+};
+
+/* RBT Create Iterator: */
+rbt_iterator_t *rbt_createiterator(rbt_t *rbt) {
+	rbt_iterator_t *iterator;
+
+	iterator = calloc(1, sizeof(rbt_iterator_t));
+	if(iterator == NULL) {
+		fatal_error("Out of memory.\n");
+	}
+	iterator->rbt		= rbt;
+	iterator->head		= rbt->head;
+	iterator->current	= iterator->head;
+
+	return iterator;
+}
+
+/* RBT Destroy Iterator: */
+void rbt_destroyiterator(rbt_iterator_t *iterator) {
+	free(iterator);
+}
+
+/* RTB Has Next: */
+int rbt_hasnext(rbt_iterator_t *iterator) {
+	if(iterator->current == NIL) {
+		return 0;
+	}
+	return 1;
+}
+
+/* RBT Next: */
+void *rbt_next(rbt_iterator_t *iterator) {
+	rbt_t	*rbt;
+	void	*item;
+
+	if(iterator->current == NIL) {
+		return NULL;
+	}
+	rbt = iterator->rbt;
+
+	item = N(iterator->current).item;
+	iterator->current = N(iterator->current).next;
+
+	return item;
+}
+
+/* RBT Reset Iterator: */
+void rbt_resetiterator(rbt_iterator_t *iterator) {
+	iterator->current = iterator->head;
+}
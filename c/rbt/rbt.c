@@ -1,6 +1,13 @@
+#include <string.h>
+
 #include "rbt.h"
 #include "../plot.h"
+#include "../mergesort.h"
+
+#define IS_RED(node)	( ((node) != NULL) && ((node)->color == RED) )
 
+/* Number of lookups interleaved by search_many. */
+#define SEARCH_GROUP	16
 
 typedef enum {
 	RED, BLACK
@@ -9,12 +16,15 @@ typedef enum {
 typedef struct node node_t;
 struct node {
 	void	*key, *item;
-	node_t	*left, *right, *next;
+	node_t	*link[2];		/* Left and right child. */
+	node_t	*next, *prev;	/* Iteration-sequence. */
 	color_t	color;
 };
 
 struct rbt {
 	node_t		*root, *head;
+	node_t		**spine;			/* Path from root to largest node; finger for rbt_append. Empty when invalid. */
+	int			spinelen, spinecap;
 	cmpfunc_t	cmpfunc;
 	int			children;
 };
@@ -34,59 +44,25 @@ rbt_t *rbt_create(cmpfunc_t cmpfunc) {
 }
 
 /* RBT Destroy: */
-static void _rbt_destroy_keys_items(node_t *current, freefunc_t freekey, freefunc_t freeitem) {
-	if(current == NULL) {
-		return;
-	}
-	_rbt_destroy_keys_items(current->left, freekey, freeitem);
-	_rbt_destroy_keys_items(current->right, freekey, freeitem);
-	
-	freekey(current->key);
-	freeitem(current->item);
-	free(current);
-}
-
-static void _rbt_destroy_keys(node_t *current, freefunc_t freekey) {
-	if(current == NULL) {
-		return;
-	}
-	_rbt_destroy_keys(current->left, freekey);
-	_rbt_destroy_keys(current->right, freekey);
-	
-	freekey(current->key);
-	free(current);
-}
+/* Every node is in iteration-sequence, so destruction walks sequence in stead of tree; no recursion on deep trees. */
+void rbt_destroy(rbt_t *rbt, freefunc_t freekey, freefunc_t freeitem) {
+	node_t *current, *tmp;
 
-static void _rbt_destroy_items(node_t *current, freefunc_t freeitem) {
-	if(current == NULL) {
-		return;
-	}
-	_rbt_destroy_items(current->left, freeitem);
-	_rbt_destroy_items(current->right, freeitem);
-	
-	freeitem(current->item);
-	free(current);
-}
+	current = rbt->head;
 
-static void _rbt_destroy(node_t *current) {
-	if(current == NULL) {
-		return;
-	}
-	_rbt_destroy(current->left);
-	_rbt_destroy(current->right);
-	free(current);
-}
+	while(current != NULL) {
+		tmp		= current;
+		current	= current->next;
 
-void rbt_destroy(rbt_t *rbt, freefunc_t freekey, freefunc_t freeitem) {
-	if( (freekey != NULL) && (freeitem != NULL) ) {
-		_rbt_destroy_keys_items(rbt->root, freekey, freeitem);
-	} else if(freekey != NULL) {
-		_rbt_destroy_keys(rbt->root, freekey);
-	} else if(freeitem != NULL) {
-		_rbt_destroy_items(rbt->root, freeitem);
-	} else {
-		_rbt_destroy(rbt->root);
+		if(freekey != NULL) {
+			freekey(tmp->key);
+		}
+		if(freeitem != NULL) {
+			freeitem(tmp->item);
+		}
+		free(tmp);
 	}
+	free(rbt->spine);
 	free(rbt);
 }
 
@@ -96,8 +72,8 @@ static void _rbt_depth(node_t *current, int *depth, int level) {
 		return;
 	}
 	*depth = (level > *depth) ? level : *depth;
-	_rbt_depth(current->left, depth, level + 1);
-	_rbt_depth(current->right, depth, level + 1);
+	_rbt_depth(current->link[0], depth, level + 1);
+	_rbt_depth(current->link[1], depth, level + 1);
 }
 
 int rbt_size(rbt_t *rbt, int size) {
@@ -114,123 +90,308 @@ int rbt_size(rbt_t *rbt, int size) {
 }
 
 /* RBT Insert: */
-static inline node_t *node_create(void *key, void *item, node_t *next) {
+/* Return new red node, linked first in iteration-sequence. */
+static inline node_t *node_create(rbt_t *rbt, void *key, void *item) {
 	node_t *node;
 
-	node = calloc(1, sizeof(node_t));
+	node = malloc(sizeof(node_t));
 	if(node == NULL) {
 		fatal_error("Out of memory.\n");
 	}
-	node->key	= key;
-	node->item	= item;
-	node->color	= RED;
-	node->next	= next;
+	node->key		= key;
+	node->item		= item;
+	node->link[0]	= node->link[1] = NULL;
+	node->color		= RED;
+	node->prev		= NULL;
+	node->next		= rbt->head;
+
+	if(rbt->head != NULL) {
+		rbt->head->prev = node;
+	}
+	rbt->head = node;
 
 	return node;
 }
 
-static inline node_t *rotate_left(node_t *node) {
+/* Rotate 'root' in direction 'dir' and recolor; new subtree-root is black with red child. */
+static inline node_t *rotate_single(node_t *root, int dir) {
 	node_t *child;
 
-	child		= node->right;
-	node->right	= child->left;
-	child->left	= node;
+	child				= root->link[!dir];
+	root->link[!dir]	= child->link[dir];
+	child->link[dir]	= root;
+	root->color			= RED;
+	child->color		= BLACK;
 
 	return child;
 }
 
-static inline node_t *rotate_right(node_t *node) {
-	node_t *child;
-
-	child		= node->left;
-	node->left	= child->right;
-	child->right= node;
+static inline node_t *rotate_double(node_t *root, int dir) {
+	root->link[!dir] = rotate_single(root->link[!dir], !dir);
 
-	return child;
+	return rotate_single(root, dir);
 }
 
-static node_t *_rbt_insert(node_t *current, void *key, void *item, node_t **head, cmpfunc_t cmpfunc, int fromright, int *added) {
-	int cmp;
+/* Top-down insertion (Julienne Walker); 4-nodes are split on way down, so no path back up is needed. */
+int rbt_insert(rbt_t *rbt, void *key, void *item) {
+	node_t	head = {0};		/* Pseudo-root. */
+	node_t	*great, *grand, *parent, *current, *new;
+	int		dir, last, dir2, cmp;
 
-	if(current == NULL) {
-		*head = node_create(key, item, *head);
-		return *head;
-	}
-	else if( (current->left != NULL) && (current->right != NULL) && 
-			 (current->left->color == RED) && (current->right->color == RED) ) {
+	new = NULL;
+	rbt->spinelen = 0;
 
-		current->color = RED;
-		current->left->color = current->right->color = BLACK;
+	if(rbt->root == NULL) {
+		rbt->root = new = node_create(rbt, key, item);
 	}
-	cmp = cmpfunc(key, current->key);
+	else {
+		head.link[1] = rbt->root;
 
-	if(cmp < 0) {
+		great	= &head;
+		grand	= parent = NULL;
+		current	= rbt->root;
+		dir		= last = 0;
 
-		current->left = _rbt_insert(current->left, key, item, head, cmpfunc, 0, added);
+		for(;;) {
+			if(current == NULL) {
+				/* Insert new red leaf. */
+				parent->link[dir] = current = new = node_create(rbt, key, item);
+			}
+			else if( IS_RED(current->link[0]) && IS_RED(current->link[1]) ) {
+				/* Split 4-Node: */
+				current->color = RED;
+				current->link[0]->color = current->link[1]->color = BLACK;
+			}
 
-		/* Left-Left Case: */
-		if( (current->left->left != NULL) && 
-			(current->left->color == RED) && 
-			(current->left->left->color == RED) ) {
+			/* Fix red violation between 'current' and 'parent'. */
+			if( IS_RED(current) && IS_RED(parent) ) {
+				dir2 = (great->link[1] == grand);
 
-			current = rotate_right(current);
-			current->color = BLACK;
-			current->right->color = RED;
+				if(current == parent->link[last]) {
+					great->link[dir2] = rotate_single(grand, !last);
+				} else {
+					great->link[dir2] = rotate_double(grand, !last);
+				}
+			}
+
+			if(new != NULL) {
+				break;
+			}
+			cmp = rbt->cmpfunc(key, current->key);
+
+			if(cmp == 0) {
+				current->item = item;
+				break;
+			}
+			last	= dir;
+			dir		= (cmp > 0);
+
+			if(grand != NULL) {
+				great = grand;
+			}
+			grand	= parent;
+			parent	= current;
+			current	= current->link[dir];
 		}
-		/* Right-Left Case: */
-		else if((fromright) && 
-				(current->color == RED) && 
-				(current->left->color == RED) ) {
-			
-			current = rotate_right(current);
+		rbt->root = head.link[1];
+	}
+	rbt->root->color = BLACK;
+
+	if(new == NULL) {
+		return 0;
+	}
+	rbt->children++;
+
+	return 1;
+}
+
+/* RBT Append: */
+static void spine_push(rbt_t *rbt, node_t *node) {
+	if(rbt->spinelen == rbt->spinecap) {
+		rbt->spinecap = (rbt->spinecap == 0) ? 32 : rbt->spinecap * 2;
+		rbt->spine = realloc(rbt->spine, sizeof(node_t*) * rbt->spinecap);
+		if(rbt->spine == NULL) {
+			fatal_error("Out of memory.\n");
 		}
+	}
+	rbt->spine[rbt->spinelen++] = node;
+}
 
-	} else if(cmp > 0) {
+int rbt_append(rbt_t *rbt, void *key, void *item) {
+	node_t	*last, *parent, *grand, *uncle;
+	int		cmp, i;
 
-		current->right = _rbt_insert(current->right, key, item, head, cmpfunc, 1, added);
+	if(rbt->root == NULL) {
+		return rbt_insert(rbt, key, item);
+	}
+	if(rbt->spinelen == 0) {
+		for(node_t *current = rbt->root; current != NULL; current = current->link[1]) {
+			spine_push(rbt, current);
+		}
+	}
+	last = rbt->spine[rbt->spinelen - 1];
+	cmp = rbt->cmpfunc(key, last->key);
 
-		/* Right-Right Case: */
-		if( (current->right->right != NULL) && 
-			(current->right->color == RED) && 
-			(current->right->right->color == RED) ) {
+	if(cmp < 0) {
+		return rbt_insert(rbt, key, item);
+	} else if(cmp == 0) {
+		last->item = item;
+		return 0;
+	}
+	last->link[1] = node_create(rbt, key, item);
+	spine_push(rbt, last->link[1]);
+	rbt->children++;
 
-			current = rotate_left(current);
-			current->color = BLACK;
-			current->left->color = RED;
+	/* Bottom-up fix of red violation along spine; every node is right child of its parent. */
+	for(i = rbt->spinelen - 1; (i > 0) && IS_RED(rbt->spine[i - 1]); i -= 2) {
+		parent	= rbt->spine[i - 1];	/* Red, so not root. */
+		grand	= rbt->spine[i - 2];
+		uncle	= grand->link[0];
+
+		if(IS_RED(uncle)) {
+			parent->color = uncle->color = BLACK;
+			grand->color = RED;
+			continue;
 		}
-		/* Left-Right Case: */
-		else if((!fromright) && 
-				(current->color == RED) && 
-				(current->right->color == RED) ) {
+		/* Right-Right Case: */
+		rotate_single(grand, 0);
 
-			current = rotate_left(current);
+		if(i == 2) {
+			rbt->root = parent;
+		} else {
+			rbt->spine[i - 3]->link[1] = parent;
 		}
+		/* Rotated node leaves spine. */
+		memmove(&rbt->spine[i - 2], &rbt->spine[i - 1], sizeof(node_t*) * (rbt->spinelen - i + 1));
+		rbt->spinelen--;
+		break;
+	}
+	rbt->root->color = BLACK;
 
+	return 1;
+}
+
+/* Red Black Tree; Remove & Pop: */
+/* Remove node from iteration-sequence. */
+static void sequence_unlink(rbt_t *rbt, node_t *node) {
+	if(node->prev != NULL) {
+		node->prev->next = node->next;
 	} else {
-		*added = 0;
-		current->item = item;
+		rbt->head = node->next;
+	}
+	if(node->next != NULL) {
+		node->next->prev = node->prev;
 	}
-	return current;
 }
 
-int rbt_insert(rbt_t *rbt, void *key, void *item) {
-	int added;
+/* Put node 'new' at position of 'old' in iteration-sequence. */
+static void sequence_replace(rbt_t *rbt, node_t *old, node_t *new) {
+	new->prev = old->prev;
+	new->next = old->next;
 
-	added = 1;
+	if(new->prev != NULL) {
+		new->prev->next = new;
+	} else {
+		rbt->head = new;
+	}
+	if(new->next != NULL) {
+		new->next->prev = new;
+	}
+}
 
-	rbt->root = _rbt_insert(rbt->root, key, item, &rbt->head, rbt->cmpfunc, 0, &added);
-	rbt->root->color = BLACK;
+/* Top-down removal (Julienne Walker); red node is pushed down to leaf-level, so removal never breaks black-height.
+ * Return node unlinked from tree and iteration-sequence, holding removed key and item; NULL if key not in rbt. */
+static node_t *rbt_unlink(rbt_t *rbt, void *key) {
+	node_t	head = {0};		/* Pseudo-root. */
+	node_t	*grand, *parent, *current, *found, *sibling, *top;
+	int		dir, last, dir2, cmp;
+	void	*tmp;
 
-	if(added) {
-		rbt->children++;
+	if(rbt->root == NULL) {
+		return NULL;
 	}
-	return added;
+	rbt->spinelen = 0;
+
+	head.link[1]	= rbt->root;
+	head.color		= BLACK;
+
+	current	= &head;
+	grand	= parent = found = NULL;
+	dir		= 1;
+
+	while(current->link[dir] != NULL) {
+		last	= dir;
+		grand	= parent;
+		parent	= current;
+		current	= current->link[dir];
+
+		cmp = rbt->cmpfunc(key, current->key);
+		dir = (cmp > 0);
+
+		if(cmp == 0) {
+			found = current;
+		}
+
+		if( IS_RED(current) || IS_RED(current->link[dir]) ) {
+			continue;
+		}
+		if(IS_RED(current->link[!dir])) {
+			parent->link[last] = rotate_single(current, dir);
+			parent = parent->link[last];
+			continue;
+		}
+		sibling = parent->link[!last];
+
+		if(sibling == NULL) {
+			continue;
+		}
+		if( !IS_RED(sibling->link[!last]) && !IS_RED(sibling->link[last]) ) {
+			/* Color Flip: */
+			parent->color	= BLACK;
+			sibling->color	= RED;
+			current->color	= RED;
+		}
+		else {
+			dir2 = (grand->link[1] == parent);
+
+			if(IS_RED(sibling->link[last])) {
+				grand->link[dir2] = rotate_double(parent, last);
+			} else {
+				grand->link[dir2] = rotate_single(parent, last);
+			}
+			top = grand->link[dir2];
+
+			current->color = top->color = RED;
+			top->link[0]->color = BLACK;
+			top->link[1]->color = BLACK;
+		}
+	}
+
+	if(found != NULL) {
+		/* 'current' is in-order neighbour of 'found'; splice 'current' out of tree,
+		 * and let 'found' hold its key and item in stead. */
+		parent->link[parent->link[1] == current] = current->link[current->link[0] == NULL];
+
+		sequence_unlink(rbt, found);
+		if(found != current) {
+			sequence_replace(rbt, current, found);
+
+			tmp = found->key;	found->key	= current->key;		current->key	= tmp;
+			tmp = found->item;	found->item	= current->item;	current->item	= tmp;
+		}
+		rbt->children--;
+	}
+	rbt->root = head.link[1];
+	if(rbt->root != NULL) {
+		rbt->root->color = BLACK;
+	}
+
+	return (found == NULL) ? NULL : current;
 }
 
-/* Red Black Tree; Remove & Pop: */
 static void node_destroy(node_t *node, freefunc_t freekey, freefunc_t freeitem) {
 	if(freekey != NULL) {
-			freekey(node->key);
+		freekey(node->key);
 	}
 	if(freeitem != NULL) {
 		freeitem(node->item);
@@ -238,147 +399,252 @@ static void node_destroy(node_t *node, freefunc_t freekey, freefunc_t freeitem)
 	free(node);
 }
 
-static node_t *_percolate(node_t *current, int leftrotate, int fromright, freefunc_t freekey, freefunc_t freeitem) {
-	node_t *tmp;
+int rbt_remove(rbt_t *rbt, void *key, freefunc_t freekey, freefunc_t freeitem) {
+	node_t *removed;
 
-	/* Split 4-Node: */
-	if( (current->left != NULL) && (current->right != NULL) && 
-		(current->left->color == RED) && (current->right->color == RED) ){
-		current->color = RED;
-		current->left->color = current->right->color = BLACK;
+	removed = rbt_unlink(rbt, key);
+	if(removed == NULL) {
+		return 0;
 	}
+	node_destroy(removed, freekey, freeitem);
 
-	/* Exit-Strategy: */
-	else if(current->left == NULL) {	/* Above 'if'-statement cannot be true if any of these are also, therefore 'else if'. */
-		tmp = current->right;
-		node_destroy(current, freekey, freeitem);
-		return tmp;
-	}
-	else if(current->right == NULL) {
-		tmp = current->left;
-		node_destroy(current, freekey, freeitem);
-		return tmp;
-	}
+	return 1;
+}
 
-	/* Percolation / Trickle Down: */
-	else if(leftrotate) {
-		current = rotate_left(current);	/* Rotate removal-node down left. */
-		current->left = _percolate(current->left, 0, fromright, freekey, freeitem);	/* Recursive follow of node with right-rotation next. */
+void *rbt_pop(rbt_t *rbt, void *key, freefunc_t freekey) {
+	node_t	*removed;
+	void	*item;
 
-		/* Left-Left Case: */	/* NOTE: Unsure whether or not percolation upwards will generate a leaf-node in stead of deleted node. */
-		if( (current->left->left != NULL) && 
-			(current->left->color == RED) && 
-			(current->left->left->color == RED) ) {
+	removed = rbt_unlink(rbt, key);
+	if(removed == NULL) {
+		return NULL;
+	}
+	item = removed->item;
+	node_destroy(removed, freekey, NULL);
 
-			current = rotate_right(current);
-			current->color = BLACK;
-			current->right->color = RED;
-		}
-		/* Right-Left Case: */
-		else if((fromright) && 
-				(current->color == RED) && 
-				(current->left->color == RED) ) {
+	return item;
+}
 
-			current = rotate_right(current);
-		}
+/* RBT Remove Range: */
+/* Black-height of tree; number of black nodes on every path from root down to leaf. */
+static int tree_blackheight(node_t *root) {
+	int height;
+
+	for(height = 0; root != NULL; root = root->link[0]) {
+		height += (root->color == BLACK);
 	}
-	else {
-		current = rotate_right(current);	/* Rotate removal-node down right. */
-		current->right = _percolate(current->right, 1, fromright, freekey, freeitem);	/* Recursive follow of node with left-rotation next. */
+	return height;
+}
 
-		/* Right-Right Case: */
-		if( (current->right->right != NULL) && 
-			(current->right->color == RED) && 
-			(current->right->right->color == RED) ) {
+/* Descend spine of 'root' in direction 'dir' to black node with black-height 'hother', and replace it by red 'middle'
+ * with that node and 'other' as subtrees. A red violation this creates is rotated away on way back up (Blelloch et al.),
+ * and black-height of 'root' is kept. Cost is difference in black-height. */
+static node_t *join_spine(node_t *root, int hroot, node_t *middle, node_t *other, int hother, int dir) {
+	node_t *child;
 
-			current = rotate_left(current);
-			current->color = BLACK;
-			current->left->color = RED;
-		}
-		/* Left-Right Case: */
-		else if((!fromright) && 
-				(current->color == RED) && 
-				(current->right->color == RED) ) {
+	if( !IS_RED(root) && (hroot == hother) ) {
+		middle->color		= RED;
+		middle->link[!dir]	= root;
+		middle->link[dir]	= other;
+		return middle;
+	}
+	root->link[dir] = join_spine(root->link[dir], hroot - !IS_RED(root), middle, other, hother, dir);
+	child = root->link[dir];
 
-			current = rotate_left(current);
-		}
+	if( !IS_RED(root) && IS_RED(child) && IS_RED(child->link[dir]) ) {
+		child->link[dir]->color	= BLACK;
+		root->link[dir]			= child->link[!dir];
+		child->link[!dir]		= root;
+		return child;
 	}
-	
-	return current;
+	return root;
+}
+
+/* Return tree of nodes in 'left', 'middle' and 'right', where every key in 'left' is less than key of 'middle',
+ * and key of 'middle' is less than every key in 'right'; black-height of joined tree is returned in 'height'.
+ * Roots are made black first, so 'middle' always goes in red between two black subtrees. Root of joined tree may be red. */
+static node_t *subtree_join(node_t *left, int hleft, node_t *middle, node_t *right, int hright, int *height) {
+	if(IS_RED(left)) {
+		left->color = BLACK;
+		hleft++;
+	}
+	if(IS_RED(right)) {
+		right->color = BLACK;
+		hright++;
+	}
+	if(hleft > hright) {
+		*height = hleft;
+		return join_spine(left, hleft, middle, right, hright, 1);
+	}
+	if(hright > hleft) {
+		*height = hright;
+		return join_spine(right, hright, middle, left, hleft, 0);
+	}
+	middle->color	= RED;
+	middle->link[0]	= left;
+	middle->link[1]	= right;
+	*height			= hleft;
+
+	return middle;
 }
 
-static node_t *_rbt_remove(node_t *current, void *key, cmpfunc_t cmpfunc, freefunc_t freekey, freefunc_t freeitem, void **item) {
-	int cmp;
+/* Split tree at 'key' into 'left' with keys less than key, or less than or equal if 'inclusive', and 'right' with remaining keys.
+ * Each node on search-path is joined onto its side with subtree hanging off path; black-heights of joined trees increase,
+ * so cost of joins telescopes to O(log n). */
+static void subtree_split(rbt_t *rbt, node_t *root, int height, void *key, int inclusive, node_t **left, int *hleft, node_t **right, int *hright) {
+	node_t	*part;
+	int		hpart, hchild, cmp;
 
-	if(current == NULL) {
-		return NULL;
+	if(root == NULL) {
+		*left	= *right	= NULL;
+		*hleft	= *hright	= 0;
+		return;
 	}
-	cmp = cmpfunc(key, current->key);
+	hchild	= height - !IS_RED(root);
+	cmp		= rbt->cmpfunc(key, root->key);
 
-	if(cmp < 0) {
-		current->left = _rbt_remove(current->left, key, cmpfunc, freekey, freeitem, item);
-	} else if(cmp > 0) {
-		current->right = _rbt_remove(current->right, key, cmpfunc, freekey, freeitem, item);
+	if( (cmp > 0) || (inclusive && (cmp == 0)) ) {
+		subtree_split(rbt, root->link[1], hchild, key, inclusive, &part, &hpart, right, hright);
+		*left = subtree_join(root->link[0], hchild, root, part, hpart, hleft);
 	} else {
-		*item = current->item;
-		current = _percolate(current, 0, 0, freekey, freeitem);
+		subtree_split(rbt, root->link[0], hchild, key, inclusive, left, hleft, &part, &hpart);
+		*right = subtree_join(part, hpart, root, root->link[1], hchild, hright);
 	}
-
-	return current;
 }
 
-int rbt_remove(rbt_t *rbt, void *key, freefunc_t freekey, freefunc_t freeitem) {
-	void *item;
-
-	item = NULL;
+/* Join trees where every key in 'left' is less than every key in 'right'; smallest node of 'right' is split off as middle. */
+static node_t *subtree_join_adjacent(rbt_t *rbt, node_t *left, int hleft, node_t *right, int hright, int *height) {
+	node_t	*middle;
+	int		hmiddle;
 
-	rbt->root = _rbt_remove(rbt->root, key, rbt->cmpfunc, freekey, freeitem, &item);
-	if(rbt->root != NULL) {
-		rbt->root->color = BLACK;
+	if(right == NULL) {
+		*height = hleft;
+		return left;
 	}
-	if(item != NULL) {
-		rbt->children--;
+	for(middle = right; middle->link[0] != NULL; middle = middle->link[0]);
+
+	subtree_split(rbt, right, hright, middle->key, 1, &middle, &hmiddle, &right, &hright);
+
+	return subtree_join(left, hleft, middle, right, hright, height);
+}
+
+/* Unlink and destroy every node in subtree, and return number of nodes. Subtree is balanced, so recursion is shallow. */
+static int subtree_destroy(rbt_t *rbt, node_t *root, freefunc_t freekey, freefunc_t freeitem) {
+	int num;
+
+	if(root == NULL) {
+		return 0;
 	}
+	num = 1 + subtree_destroy(rbt, root->link[0], freekey, freeitem) + subtree_destroy(rbt, root->link[1], freekey, freeitem);
+
+	sequence_unlink(rbt, root);
+	node_destroy(root, freekey, freeitem);
 
-	return (item == NULL) ? 0 : 1;
+	return num;
 }
 
-void *rbt_pop(rbt_t *rbt, void *key, freefunc_t freekey) {
-	void *item;
+int rbt_remove_range(rbt_t *rbt, void *lo, void *hi, freefunc_t freekey, freefunc_t freeitem) {
+	node_t	*left, *middle, *right;
+	int		hleft, hmiddle, hright, height, removed;
 
-	item = NULL;
+	if( (rbt->root == NULL) || (rbt->cmpfunc(lo, hi) > 0) ) {
+		return 0;
+	}
+	rbt->spinelen = 0;
+
+	subtree_split(rbt, rbt->root, tree_blackheight(rbt->root), lo, 0, &left, &hleft, &middle, &hmiddle);
+	subtree_split(rbt, middle, hmiddle, hi, 1, &middle, &hmiddle, &right, &hright);
+
+	removed = subtree_destroy(rbt, middle, freekey, freeitem);
 
-	rbt->root = _rbt_remove(rbt->root, key, rbt->cmpfunc, freekey, NULL, &item);
+	rbt->root = subtree_join_adjacent(rbt, left, hleft, right, hright, &height);
 	if(rbt->root != NULL) {
 		rbt->root->color = BLACK;
 	}
-	if(item != NULL) {
-		rbt->children--;
-	}
+	rbt->children -= removed;
 
-	return item;
+	return removed;
 }
 
 /* RBT Search: */
-static void *_rbt_search(node_t *current, void *key, cmpfunc_t cmpfunc) {
-	int cmp;
+void *rbt_search(rbt_t *rbt, void *key) {
+	node_t	*current;
+	int		cmp;
 
-	if(current == NULL) {
-		return NULL;
-	}
-	cmp = cmpfunc(key, current->key);
+	current = rbt->root;
 
-	if(cmp < 0) {
-		return _rbt_search(current->left, key, cmpfunc);
-	} else if(cmp > 0) {
-		return _rbt_search(current->right, key, cmpfunc);
-	} else {
-		return current->item;
+	while(current != NULL) {
+		cmp = rbt->cmpfunc(key, current->key);
+
+		if(cmp == 0) {
+			return current->item;
+		}
+		current = current->link[cmp > 0];
 	}
+	return NULL;
 }
 
-void *rbt_search(rbt_t *rbt, void *key) {
-	return _rbt_search(rbt->root, key, rbt->cmpfunc);
+/* RBT Search Many: */
+/* Lookups in group advance one step per turn in round-robin, and prefetch what their next turn reads;
+ * cache-misses of up to SEARCH_GROUP independent descents overlap in stead of stalling one after another.
+ * Each lookup alternates between loading key of node, and comparing and moving to child. */
+void rbt_search_many(rbt_t *rbt, void **keys, void **items, int num) {
+	node_t	*current[SEARCH_GROUP];
+	int		index[SEARCH_GROUP];		/* Index of key searched for in slot, or -1 when slot is free. */
+	char	keyloaded[SEARCH_GROUP];
+	int		next, active, cmp;
+
+	if(rbt->root == NULL) {
+		for(int i = 0; i < num; i++) {
+			items[i] = NULL;
+		}
+		return;
+	}
+	for(int s = 0; s < SEARCH_GROUP; s++) {
+		index[s] = -1;
+	}
+	next = active = 0;
+
+	while( (active > 0) || (next < num) ) {
+		for(int s = 0; s < SEARCH_GROUP; s++) {
+			if(index[s] < 0) {
+				if(next == num) {
+					continue;
+				}
+				/* Start next lookup at root. */
+				index[s]		= next;
+				items[next]		= NULL;
+				current[s]		= rbt->root;
+				keyloaded[s]	= 0;
+				__builtin_prefetch(keys[next]);
+				next++;
+				active++;
+				continue;
+			}
+			if(!keyloaded[s]) {
+				__builtin_prefetch(current[s]->key);
+				keyloaded[s] = 1;
+				continue;
+			}
+			cmp = rbt->cmpfunc(keys[index[s]], current[s]->key);
+
+			if(cmp == 0) {
+				items[index[s]] = current[s]->item;
+				index[s] = -1;
+				active--;
+				continue;
+			}
+			current[s] = current[s]->link[cmp > 0];
+
+			if(current[s] == NULL) {
+				index[s] = -1;
+				active--;
+				continue;
+			}
+			__builtin_prefetch(current[s]);
+			keyloaded[s] = 0;
+		}
+	}
 }
 
 /* RBT Print: */
@@ -402,19 +668,19 @@ static void _rbt_print(node_t *current, plot_t *plot, strfunc_t strfunc) {
 	}
 	color = rbt_color(current);
 
-	if(current->left != NULL) {
-		plot_addlink2(plot, current, current->left, strfunc(current->item), strfunc(current->left->item), color, rbt_color(current->left));
+	if(current->link[0] != NULL) {
+		plot_addlink2(plot, current, current->link[0], strfunc(current->item), strfunc(current->link[0]->item), color, rbt_color(current->link[0]));
 		
-		_rbt_print(current->left, plot, strfunc);
+		_rbt_print(current->link[0], plot, strfunc);
 
 	} else {
 		plot_addlink2(plot, current, (void*)NULL_ID++, strfunc(current->item), "NULL", color, "white");
 	}
 
-	if(current->right != NULL) {
-		plot_addlink2(plot, current, current->right, strfunc(current->item), strfunc(current->right->item), color, rbt_color(current->right));
+	if(current->link[1] != NULL) {
+		plot_addlink2(plot, current, current->link[1], strfunc(current->item), strfunc(current->link[1]->item), color, rbt_color(current->link[1]));
 		
-		_rbt_print(current->right, plot, strfunc);
+		_rbt_print(current->link[1], plot, strfunc);
 	
 	} else {
 		plot_addlink2(plot, current, (void*)NULL_ID++, strfunc(current->item), "NULL", color, "white");
@@ -440,7 +706,7 @@ static void *rbt_firstitem(node_t *current) {
 	item = NULL;
 	while(current != NULL) {
 		item = current->item;
-		current = current->left;
+		current = current->link[0];
 	}
 	return item;
 }
@@ -451,92 +717,11 @@ static void *rbt_lastitem(node_t *current) {
 	item = NULL;
 	while(current != NULL) {
 		item = current->item;
-		current = current->right;
+		current = current->link[1];
 	}
 	return item;
 }
 
-static int issorted(node_t *head, cmpfunc_t cmpfunc) {
-	node_t *current, *cmpnode;/*  ØKSJDNFOIGNWPITNGPJNRGLJWNTG PROBLEM*/
-
-	current = head;
-
-	while(current != NULL) {
-		cmpnode = current->next;
-		while(cmpnode != NULL) {
-			if(cmpfunc(current->key, cmpnode->key) > 0) {
-				return 0;
-			}
-			cmpnode = cmpnode->next;
-		}
-		current = current->next;
-	}
-	return 1;
-}
-
-static node_t *split(node_t *head) {
-	node_t *slow, *fast, *ndhead;
-
-	slow = head;
-	fast = head->next;
-
-	while( (fast != NULL) && (fast->next != NULL) ) {
-		slow = slow->next;
-		fast = fast->next->next;
-	}
-
-	ndhead = slow->next;
-	slow->next = NULL;
-
-	return ndhead;
-}
-
-static node_t *merge(node_t *a, node_t *b, cmpfunc_t cmpfunc) {
-	node_t *head, *tail;
-
-	if(cmpfunc(a->key, b->key) < 0) {
-		head = a;
-		a = a->next;
-	} else {
-		head = b;
-		b = b->next;
-	}
-	tail = head;
-
-	while( (a != NULL) && (b != NULL) ) {
-		if(cmpfunc(a->key, b->key) < 0) {
-			tail->next = a;
-			a = a->next;
-		} else {
-			tail->next = b;
-			b = b->next;
-		}
-		tail = tail->next;
-	}
-
-	if(a == NULL) {
-		tail->next = b;
-	} else {
-		tail->next = a;
-	}
-
-	return head;
-}
-
-static node_t *_mergesort(node_t *head, cmpfunc_t cmpfunc) {
-	node_t *ndhead;
-
-	if( (head == NULL) || (head->next == NULL) ) {
-		return head;
-	}
-	ndhead	= split(head);
-
-	head	= _mergesort(head, cmpfunc);
-	ndhead	= _mergesort(ndhead, cmpfunc);
-
-	return merge(head, ndhead, cmpfunc);
-}
-
 void *rbt_getitem(rbt_t *rbt, int n) {
 	node_t *current;
 
@@ -560,9 +745,18 @@ void *rbt_getitem(rbt_t *rbt, int n) {
 }
 
 /* RBT Sort: */
+MERGESORT_DEFINE(node_sort, node_t, next, key)
+
 void rbt_sort(rbt_t *rbt) {
-	if( !issorted(rbt->head, rbt->cmpfunc) ) {
-		rbt->head = _mergesort(rbt->head, rbt->cmpfunc);
+	node_t *prev;
+
+	rbt->head = node_sort(rbt->head, rbt->cmpfunc);
+
+	/* Mergesort only follows 'next'; restore 'prev'. */
+	prev = NULL;
+	for(node_t *current = rbt->head; current != NULL; current = current->next) {
+		current->prev = prev;
+		prev = current;
 	}
 }
 
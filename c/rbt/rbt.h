@@ -26,10 +26,21 @@ int rbt_size(rbt_t *rbt, int size);
  * Return 1 if inserted, 0 if overwritten. */
 int rbt_insert(rbt_t *rbt, void *key, void *item);
 
+/* Insert item with key expected to be greater than every key in rbt, e.g. ascending keys. 
+ * Starts from finger at largest node in stead of root, so sequence of appends costs amortised O(1) per item. 
+ * If key is less than largest key, then item is inserted with rbt_insert. 
+ * Return 1 if inserted, 0 if overwritten. */
+int rbt_append(rbt_t *rbt, void *key, void *item);
+
 /* Search rbt using key and return item with key. 
  * Return NULL if item not in rbt. */
 void *rbt_search(rbt_t *rbt, void *key);
 
+/* Search rbt for each of 'num' keys, and store item with keys[i] in items[i], or NULL if key not in rbt. 
+ * Lookups are interleaved and prefetch their next node, so memory latency of independent descents overlaps; 
+ * for large trees faster than calling rbt_search for each key. */
+void rbt_search_many(rbt_t *rbt, void **keys, void **items, int num);
+
 /* Remove item associated with key. 
  * Return 1 if removed, 0 if key not associated with item. 
  * Optional function-pointers for deallocation of key and item, pass NULL to avoid deallocation. */
@@ -40,6 +51,13 @@ int rbt_remove(rbt_t *rbt, void *key, freefunc_t freekey, freefunc_t freeitem);
  * Optional function-pointers for deallocation of key and item, pass NULL to avoid deallocation. */
 void *rbt_pop(rbt_t *rbt, void *key, freefunc_t freekey);
 
+/* Remove every item with key from 'lo' to 'hi', both inclusive, e.g. a window of old timestamps. 
+ * Tree is split around interval and remaining parts joined, so cost is O(log n + k) for k removed items, 
+ * in stead of O(k log n) for k separate removes. 
+ * Return number of items removed. 
+ * Optional function-pointers for deallocation of keys and items, pass NULL to avoid deallocation. */
+int rbt_remove_range(rbt_t *rbt, void *lo, void *hi, freefunc_t freekey, freefunc_t freeitem);
+
 /* Print rbt-structure using plot-library with string-representations of items using provided function-pointer. */
 void rbt_print(rbt_t *rbt, strfunc_t strfunc);
 
@@ -0,0 +1,372 @@
+/* Author: Marius Ingebrigtsen */
+
+#ifndef __RBT_INLINE_H_
+#define __RBT_INLINE_H_
+
+#include "../common.h"
+
+/* Inline-Key Red-Black Tree Generator.
+ * RBT_DEFINE(name, keytype) defines 'name_t', a red-black tree with scalar keys of 'keytype' stored in the node,
+ * and compared directly with '<' in stead of through cmpfunc_t and a key-pointer.
+ * Insert and remove are iterative top-down (Julienne Walker), as in 'compact/rbt.c'.
+ *
+ * Generated functions, all 'static inline':
+ *
+ * name_t *name_create(void);
+ * void name_destroy(name_t *tree, freefunc_t freeitem);			Optional deallocation of items, pass NULL to avoid.
+ * int name_size(name_t *tree);
+ * int name_insert(name_t *tree, keytype key, void *item);			Return 1 if inserted, 0 if item overwritten.
+ * void *name_search(name_t *tree, keytype key);					Return NULL if key not in tree.
+ * int name_remove(name_t *tree, keytype key, freefunc_t freeitem);	Return 1 if removed, 0 if key not in tree.
+ * void *name_pop(name_t *tree, keytype key);						Return NULL if key not in tree.
+ *
+ * name_iterator_t *name_createiterator(name_t *tree);				Iteration is in ascending order of keys.
+ * void name_destroyiterator(name_iterator_t *iterator);
+ * int name_hasnext(name_iterator_t *iterator);
+ * void *name_next(name_iterator_t *iterator);
+ * void name_resetiterator(name_iterator_t *iterator);
+ *
+ * Usage:
+ * '''
+ * RBT_DEFINE(rbt_int, int)
+ *
+ * rbt_int_t *rbt = rbt_int_create();
+ * rbt_int_insert(rbt, 42, item);
+ * '''
+ */
+
+/* Upper bound of red-black height for any number of nodes addressable in memory. */
+#define RBT_INLINE_MAXHEIGHT 128
+
+#define RBT_DEFINE(name, keytype)																\
+																								\
+typedef struct name##_node name##_node_t;														\
+struct name##_node {																			\
+	keytype			key;																		\
+	void			*item;																		\
+	name##_node_t	*link[2];																	\
+	char			red;																		\
+};																								\
+																								\
+typedef struct name {																			\
+	name##_node_t	*root;																		\
+	int				children;																	\
+} name##_t;																						\
+																								\
+static inline int name##_isred(name##_node_t *node) {											\
+	return (node != NULL) && node->red;															\
+}																								\
+																								\
+static inline name##_t *name##_create(void) {													\
+	name##_t *tree;																				\
+																								\
+	tree = calloc(1, sizeof(name##_t));															\
+	if(tree == NULL) {																			\
+		fatal_error("Out of memory.");															\
+	}																							\
+	return tree;																				\
+}																								\
+																								\
+/* Destroy without recursion by rotating left children up until none remain. */				\
+static inline void name##_destroy(name##_t *tree, freefunc_t freeitem) {						\
+	name##_node_t *current, *tmp;																\
+																								\
+	current = tree->root;																		\
+																								\
+	while(current != NULL) {																	\
+		if(current->link[0] != NULL) {															\
+			tmp					= current->link[0];												\
+			current->link[0]	= tmp->link[1];													\
+			tmp->link[1]		= current;														\
+			current				= tmp;															\
+		} else {																				\
+			tmp		= current;																	\
+			current	= current->link[1];															\
+			if(freeitem != NULL) {																\
+				freeitem(tmp->item);															\
+			}																					\
+			free(tmp);																			\
+		}																						\
+	}																							\
+	free(tree);																					\
+}																								\
+																								\
+static inline int name##_size(name##_t *tree) {													\
+	return tree->children;																		\
+}																								\
+																								\
+/* Rotate 'root' in direction 'dir' and recolor; new subtree-root is black with red child. */	\
+static inline name##_node_t *name##_rotate_single(name##_node_t *root, int dir) {				\
+	name##_node_t *child;																		\
+																								\
+	child				= root->link[!dir];														\
+	root->link[!dir]	= child->link[dir];														\
+	child->link[dir]	= root;																	\
+	root->red			= 1;																	\
+	child->red			= 0;																	\
+																								\
+	return child;																				\
+}																								\
+																								\
+static inline name##_node_t *name##_rotate_double(name##_node_t *root, int dir) {				\
+	root->link[!dir] = name##_rotate_single(root->link[!dir], !dir);							\
+																								\
+	return name##_rotate_single(root, dir);														\
+}																								\
+																								\
+static inline int name##_insert(name##_t *tree, keytype key, void *item) {						\
+	name##_node_t	head = {0};																	\
+	name##_node_t	*great, *grand, *parent, *current, *new;									\
+	int				dir, last, dir2;															\
+																								\
+	new = NULL;																					\
+																								\
+	if(tree->root == NULL) {																	\
+		new = malloc(sizeof(name##_node_t));													\
+		if(new == NULL) {																		\
+			fatal_error("Out of memory.");														\
+		}																						\
+		new->key		= key;																	\
+		new->item		= item;																	\
+		new->link[0]	= new->link[1] = NULL;													\
+		tree->root		= new;																	\
+	}																							\
+	else {																						\
+		head.link[1] = tree->root;																\
+																								\
+		great	= &head;																		\
+		grand	= parent = NULL;																\
+		current	= tree->root;																	\
+		dir		= last = 0;																		\
+																								\
+		for(;;) {																				\
+			if(current == NULL) {																\
+				current = new = malloc(sizeof(name##_node_t));									\
+				if(new == NULL) {																\
+					fatal_error("Out of memory.");												\
+				}																				\
+				new->key		= key;															\
+				new->item		= item;															\
+				new->link[0]	= new->link[1] = NULL;											\
+				new->red		= 1;															\
+				parent->link[dir] = new;														\
+			}																					\
+			else if( name##_isred(current->link[0]) && name##_isred(current->link[1]) ) {		\
+				current->red = 1;																\
+				current->link[0]->red = current->link[1]->red = 0;								\
+			}																					\
+			if( name##_isred(current) && name##_isred(parent) ) {								\
+				dir2 = (great->link[1] == grand);												\
+																								\
+				if(current == parent->link[last]) {												\
+					great->link[dir2] = name##_rotate_single(grand, !last);						\
+				} else {																		\
+					great->link[dir2] = name##_rotate_double(grand, !last);						\
+				}																				\
+			}																					\
+			if(new != NULL) {																	\
+				break;																			\
+			}																					\
+			if(key == current->key) {															\
+				current->item = item;															\
+				break;																			\
+			}																					\
+			last	= dir;																		\
+			dir		= (current->key < key);														\
+																								\
+			if(grand != NULL) {																	\
+				great = grand;																	\
+			}																					\
+			grand	= parent;																	\
+			parent	= current;																	\
+			current	= current->link[dir];														\
+		}																						\
+		tree->root = head.link[1];																\
+	}																							\
+	tree->root->red = 0;																		\
+																								\
+	if(new == NULL) {																			\
+		return 0;																				\
+	}																							\
+	tree->children++;																			\
+																								\
+	return 1;																					\
+}																								\
+																								\
+static inline void *name##_search(name##_t *tree, keytype key) {								\
+	name##_node_t *current;																		\
+																								\
+	current = tree->root;																		\
+																								\
+	while(current != NULL) {																	\
+		if(key == current->key) {																\
+			return current->item;																\
+		}																						\
+		current = current->link[current->key < key];											\
+	}																							\
+	return NULL;																				\
+}																								\
+																								\
+/* Remove node with key from tree. Return unlinked node holding removed item, or NULL if key not in tree. */	\
+static inline name##_node_t *name##_unlink(name##_t *tree, keytype key) {						\
+	name##_node_t	head = {0};																	\
+	name##_node_t	*grand, *parent, *current, *found, *sibling, *top;							\
+	int				dir, last, dir2;															\
+																								\
+	if(tree->root == NULL) {																	\
+		return NULL;																			\
+	}																							\
+	head.link[1] = tree->root;																	\
+																								\
+	current	= &head;																			\
+	grand	= parent = found = NULL;															\
+	dir		= 1;																				\
+																								\
+	while(current->link[dir] != NULL) {															\
+		last	= dir;																			\
+		grand	= parent;																		\
+		parent	= current;																		\
+		current	= current->link[dir];															\
+		dir		= (current->key < key);															\
+																								\
+		if(key == current->key) {																\
+			found = current;																	\
+		}																						\
+		if( name##_isred(current) || name##_isred(current->link[dir]) ) {						\
+			continue;																			\
+		}																						\
+		if(name##_isred(current->link[!dir])) {													\
+			parent->link[last] = name##_rotate_single(current, dir);							\
+			parent = parent->link[last];														\
+			continue;																			\
+		}																						\
+		sibling = parent->link[!last];															\
+																								\
+		if(sibling == NULL) {																	\
+			continue;																			\
+		}																						\
+		if( !name##_isred(sibling->link[!last]) && !name##_isred(sibling->link[last]) ) {		\
+			parent->red		= 0;																\
+			sibling->red	= 1;																\
+			current->red	= 1;																\
+		}																						\
+		else {																					\
+			dir2 = (grand->link[1] == parent);													\
+																								\
+			if(name##_isred(sibling->link[last])) {												\
+				grand->link[dir2] = name##_rotate_double(parent, last);							\
+			} else {																			\
+				grand->link[dir2] = name##_rotate_single(parent, last);							\
+			}																					\
+			top = grand->link[dir2];															\
+																								\
+			current->red = top->red = 1;														\
+			top->link[0]->red = 0;																\
+			top->link[1]->red = 0;																\
+		}																						\
+	}																							\
+																								\
+	if(found != NULL) {																			\
+		/* 'current' is in-order neighbour of 'found'; move its key and item into 'found'. */	\
+		parent->link[parent->link[1] == current] = current->link[current->link[0] == NULL];		\
+																								\
+		if(found != current) {																	\
+			void *item;																			\
+																								\
+			item		= found->item;															\
+			found->key	= current->key;															\
+			found->item	= current->item;														\
+			current->item = item;																\
+		}																						\
+		tree->children--;																		\
+	}																							\
+	tree->root = head.link[1];																	\
+	if(tree->root != NULL) {																	\
+		tree->root->red = 0;																	\
+	}																							\
+																								\
+	return (found == NULL) ? NULL : current;													\
+}																								\
+																								\
+static inline int name##_remove(name##_t *tree, keytype key, freefunc_t freeitem) {				\
+	name##_node_t *removed;																		\
+																								\
+	removed = name##_unlink(tree, key);															\
+	if(removed == NULL) {																		\
+		return 0;																				\
+	}																							\
+	if(freeitem != NULL) {																		\
+		freeitem(removed->item);																\
+	}																							\
+	free(removed);																				\
+																								\
+	return 1;																					\
+}																								\
+																								\
+static inline void *name##_pop(name##_t *tree, keytype key) {									\
+	name##_node_t	*removed;																	\
+	void			*item;																		\
+																								\
+	removed = name##_unlink(tree, key);															\
+	if(removed == NULL) {																		\
+		return NULL;																			\
+	}																							\
+	item = removed->item;																		\
+	free(removed);																				\
+																								\
+	return item;																				\
+}																								\
+																								\
+/* In-order iteration with explicit stack of left-spine. */									\
+typedef struct name##_iterator {																\
+	name##_t		*tree;																		\
+	name##_node_t	*stack[RBT_INLINE_MAXHEIGHT];												\
+	int				top;																		\
+} name##_iterator_t;																			\
+																								\
+static inline void name##_pushleft(name##_iterator_t *iterator, name##_node_t *current) {		\
+	while(current != NULL) {																	\
+		iterator->stack[iterator->top++] = current;												\
+		current = current->link[0];																\
+	}																							\
+}																								\
+																								\
+static inline void name##_resetiterator(name##_iterator_t *iterator) {							\
+	iterator->top = 0;																			\
+	name##_pushleft(iterator, iterator->tree->root);											\
+}																								\
+																								\
+static inline name##_iterator_t *name##_createiterator(name##_t *tree) {						\
+	name##_iterator_t *iterator;																\
+																								\
+	iterator = malloc(sizeof(name##_iterator_t));												\
+	if(iterator == NULL) {																		\
+		fatal_error("Out of memory.");															\
+	}																							\
+	iterator->tree = tree;																		\
+	name##_resetiterator(iterator);																\
+																								\
+	return iterator;																			\
+}																								\
+																								\
+static inline void name##_destroyiterator(name##_iterator_t *iterator) {						\
+	free(iterator);																				\
+}																								\
+																								\
+static inline int name##_hasnext(name##_iterator_t *iterator) {									\
+	return (iterator->top > 0) ? 1 : 0;															\
+}																								\
+																								\
+static inline void *name##_next(name##_iterator_t *iterator) {									\
+	name##_node_t *current;																		\
+																								\
+	if(iterator->top == 0) {																	\
+		return NULL;																			\
+	}																							\
+	current = iterator->stack[--iterator->top];													\
+	name##_pushleft(iterator, current->link[1]);												\
+																								\
+	return current->item;																		\
+}
+
+#endif
@@ -0,0 +1,220 @@
+/* Author: Marius Ingebrigtsen */
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../common.h"
+#include "../bench.h"
+#include "../rbt/rbt.h"
+#include "./skiplist.h"
+
+#define NUMELEM	262144	/* 2^18 */
+
+typedef struct data {
+	int *key, *item;
+} data_t;
+
+/* Ordered map under benchmark. RBT is serialised by 'lock', skip-list is used without. */
+typedef struct bench {
+	skiplist_t		*skiplist;
+	rbt_t			*rbt;
+	pthread_mutex_t	lock;
+	data_t			*data;
+} bench_t;
+
+/* Arguments for each worker-thread. Thread works on every 'stride'-th entry from 'offset'. */
+typedef struct work work_t;
+
+typedef void *(*workfunc_t)(work_t*);
+
+struct work {
+	bench_t		*bench;
+	workfunc_t	func;
+	int			offset, stride;
+};
+
+/* State of one trial, passed to setup, trial and teardown by harness.
+ * 'func' is run by 'threads' concurrently; 'fill', if not NULL, fills structure untimed by 'maxthreads' first. */
+typedef struct trial {
+	bench_t		bench;
+	workfunc_t	func, fill;
+	int			threads, maxthreads;
+} trial_t;
+
+
+static int cmpint(int *a, int *b) {
+	return *a - *b;
+}
+
+/* Keys are shuffled, so concurrent inserts are not all appended to the same end. */
+static data_t *data_create(int num) {
+	data_t	*data, tmp;
+	int		k;
+
+	data = calloc(num, sizeof(data_t));
+	if(data == NULL) {
+		fatal_error("Out of memory.");
+	}
+
+	for(int i = 0; i < num; i++) {
+		data[i].key = new_integer(i);
+		data[i].item = new_integer(i);
+	}
+	for(int i = num - 1; i > 0; i--) {
+		k		= rand() % (i + 1);
+		tmp		= data[i];
+		data[i]	= data[k];
+		data[k]	= tmp;
+	}
+
+	return data;
+}
+
+static void *skiplist_inserts(work_t *work) {
+	data_t *data = work->bench->data;
+
+	for(int i = work->offset; i < NUMELEM; i += work->stride) {
+		skiplist_insert(work->bench->skiplist, data[i].key, data[i].item);
+	}
+	return NULL;
+}
+
+static void *skiplist_searches(work_t *work) {
+	data_t *data = work->bench->data;
+
+	for(int i = work->offset; i < NUMELEM; i += work->stride) {
+		if(skiplist_search(work->bench->skiplist, data[i].key) == NULL) {
+			fatal_error("Value not found.");
+		}
+	}
+	return NULL;
+}
+
+static void *rbt_inserts(work_t *work) {
+	data_t *data = work->bench->data;
+
+	for(int i = work->offset; i < NUMELEM; i += work->stride) {
+		pthread_mutex_lock(&work->bench->lock);
+		rbt_insert(work->bench->rbt, data[i].key, data[i].item);
+		pthread_mutex_unlock(&work->bench->lock);
+	}
+	return NULL;
+}
+
+static void *rbt_searches(work_t *work) {
+	data_t	*data = work->bench->data;
+	void	*item;
+
+	for(int i = work->offset; i < NUMELEM; i += work->stride) {
+		pthread_mutex_lock(&work->bench->lock);
+		item = rbt_search(work->bench->rbt, data[i].key);
+		pthread_mutex_unlock(&work->bench->lock);
+
+		if(item == NULL) {
+			fatal_error("Value not found.");
+		}
+	}
+	return NULL;
+}
+
+/* Worker-thread; counts its own hardware events, as counters of harness count only the thread that created it. */
+static void *work_thread(work_t *work) {
+	perf_t *counters = bench_thread_start();
+
+	work->func(work);
+	bench_thread_stop(counters);
+
+	return NULL;
+}
+
+/* Run 'threads' running 'func' concurrently, and wait for them. */
+static void run_threads(bench_t *bench, int threads, workfunc_t func) {
+	pthread_t	tid[threads];
+	work_t		work[threads];
+
+	for(int t = 0; t < threads; t++) {
+		work[t].bench	= bench;
+		work[t].func	= func;
+		work[t].offset	= t;
+		work[t].stride	= threads;
+
+		if(pthread_create(&tid[t], NULL, (void *(*)(void*))work_thread, &work[t]) != 0) {
+			fatal_error("Unable to create thread.");
+		}
+	}
+	for(int t = 0; t < threads; t++) {
+		pthread_join(tid[t], NULL);
+	}
+}
+
+static void setup(trial_t *trial) {
+	trial->bench.skiplist	= skiplist_create( (cmpfunc_t)cmpint );
+	trial->bench.rbt		= rbt_create( (cmpfunc_t)cmpint );
+
+	if(trial->fill != NULL) {
+		run_threads(&trial->bench, (trial->fill == skiplist_inserts) ? trial->maxthreads : 1, trial->fill);
+	}
+}
+
+static void teardown(trial_t *trial) {
+	skiplist_destroy(trial->bench.skiplist, NULL, NULL);
+	rbt_destroy(trial->bench.rbt, NULL, NULL);
+}
+
+static void trial_threads(trial_t *trial) {
+	run_threads(&trial->bench, trial->threads, trial->func);
+}
+
+/* Benchmark 'func' by 1, 2, 4, ... 'maxthreads' threads; time is per element, so per operation of all threads. */
+static void assert_threads(char *bnch_file, char *title, int maxthreads, workfunc_t func, workfunc_t fill) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
+	char			*series, count[16];
+
+	snprintf(count, sizeof(count), "%d", NUMELEM);
+	series	= concatenate_strings(4, title, " Benchmarks with ", count, " elements; elements is number of threads");
+	file	= bench_open(bnch_file, series);
+
+	pthread_mutex_init(&trial.bench.lock, NULL);
+	trial.bench.data	= data_create(NUMELEM);
+	trial.func			= func;
+	trial.fill			= fill;
+	trial.maxthreads	= maxthreads;
+
+	for(int threads = 1; threads <= maxthreads; threads *= 2) {
+		trial.threads = threads;
+
+		bench_run(&stats, (benchfunc_t)setup, (benchfunc_t)trial_threads, (benchfunc_t)teardown, &trial, NUMELEM);
+		bench_write(file, threads, &stats);
+	}
+
+	for(int i = 0; i < NUMELEM; i++) {
+		free(trial.bench.data[i].key);
+		free(trial.bench.data[i].item);
+	}
+	free(trial.bench.data);
+	pthread_mutex_destroy(&trial.bench.lock);
+
+	bench_close(file);
+	free(series);
+}
+
+int main(int argc, char **argv) {
+	int maxthreads;
+
+	if(argc < 5) {
+		printf("Usage: %s <skiplist-insert-file> <rbt-insert-file> <skiplist-search-file> <rbt-search-file> [max-threads] \n", *argv);
+		return -1;
+	}
+	maxthreads = (argc > 5) ? atoi(argv[5]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(maxthreads < 1) {
+		maxthreads = 1;
+	}
+
+	assert_threads(argv[1], "Skip-List Insert", maxthreads, skiplist_inserts, NULL);
+	assert_threads(argv[2], "Mutex RBT Insert", maxthreads, rbt_inserts, NULL);
+	assert_threads(argv[3], "Skip-List Search", maxthreads, skiplist_searches, skiplist_inserts);
+	assert_threads(argv[4], "Mutex RBT Search", maxthreads, rbt_searches, rbt_inserts);
+
+	return 0;
+}
@@ -0,0 +1,239 @@
+/* Author: Marius Ingebrigtsen */
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "../common.h"
+#include "./skiplist.h"
+
+#define ROUNDS	64		/* Rounds of concurrent overwrites and pops. */
+#define KEYS	16		/* Keys contended in each round. */
+#define WRITES	256		/* Inserts of each key per round. */
+
+typedef struct data {
+	int *key, *item;
+} data_t;
+
+/* Arguments for each worker-thread. Thread works on every 'stride'-th entry from 'offset'. */
+typedef struct work {
+	skiplist_t	*skiplist;
+	data_t		*data;
+	int			num, offset, stride;
+} work_t;
+
+
+/* Arguments for threads overwriting and popping same keys.
+ * Each key has one inserter, so only its own next insert displaces its item, and last item of round is never displaced. */
+typedef struct race {
+	skiplist_t	*skiplist;
+	int			*keys, *items;	/* Item 'w' of key 'k' is 'items[k * WRITES + w]'. */
+	atomic_int	*popped;		/* Times each item was popped. */
+	atomic_int	*inserting;		/* Number of inserters not done; pops go on until last insert. */
+	int			id, inserters;
+} race_t;
+
+
+static int cmpint(int *a, int *b) {
+	return *a - *b;
+}
+
+static data_t *data_create(int num) {
+	data_t *data;
+
+	data = calloc(num, sizeof(data_t));
+	if(data == NULL) {
+		fatal_error("Out of memory.");
+	}
+
+	for(int i = 0; i < num; i++) {
+		data[i].key = new_integer(i);
+		data[i].item = new_integer(i);
+	}
+
+	return data;
+}
+
+static void *work_insert(work_t *work) {
+	for(int i = work->offset; i < work->num; i += work->stride) {
+		if( !skiplist_insert(work->skiplist, work->data[i].key, work->data[i].item) ) {
+			fatal_error("Key; \'%d\', inserted twice. \n", *work->data[i].key);
+		}
+	}
+	return NULL;
+}
+
+/* Remove every odd key, while searching that every even key remains. */
+static void *work_remove(work_t *work) {
+	for(int i = work->offset; i < work->num; i += work->stride) {
+		if( (i % 2 == 1) && !skiplist_remove(work->skiplist, work->data[i].key, free, free) ) {
+			fatal_error("Key; \'%d\', not removed. \n", i);
+		}
+		if( (i % 2 == 0) && (skiplist_search(work->skiplist, work->data[i].key) == NULL) ) {
+			fatal_error("Key; \'%d\', not in structure. \n", i);
+		}
+	}
+	return NULL;
+}
+
+static void apply_threads(skiplist_t *skiplist, data_t *data, int num, int threads, void *(*func)(work_t*)) {
+	pthread_t	tid[threads];
+	work_t		work[threads];
+
+	for(int t = 0; t < threads; t++) {
+		work[t].skiplist= skiplist;
+		work[t].data	= data;
+		work[t].num		= num;
+		work[t].offset	= t;
+		work[t].stride	= threads;
+
+		if(pthread_create(&tid[t], NULL, (void *(*)(void*))func, &work[t]) != 0) {
+			fatal_error("Unable to create thread.");
+		}
+	}
+	for(int t = 0; t < threads; t++) {
+		pthread_join(tid[t], NULL);
+	}
+}
+
+static void *race_insert(race_t *race) {
+	for(int w = 0; w < WRITES; w++) {
+		for(int k = race->id; k < KEYS; k += race->inserters) {
+			skiplist_insert(race->skiplist, &race->keys[k], &race->items[k * WRITES + w]);
+		}
+	}
+	atomic_fetch_sub(race->inserting, 1);
+
+	return NULL;
+}
+
+static void *race_pop(race_t *race) {
+	unsigned int	seed = race->id;
+	int				*item;
+
+	while(atomic_load(race->inserting) > 0) {
+		item = skiplist_pop(race->skiplist, &race->keys[rand_r(&seed) % KEYS], NULL);
+		if(item != NULL) {
+			atomic_fetch_add(&race->popped[item - race->items], 1);
+		}
+	}
+	return NULL;
+}
+
+/* Overwrite keys while other threads pop them.
+ * An overwrite of a node being popped must either hand its item to the pop, or insert a new node,
+ * so every item is popped at most once, never both popped and left in skip-list, and last insert of each key is never lost. */
+static void apply_overwrite_pop(int threads) {
+	skiplist_t	*skiplist;
+	pthread_t	tid[threads + 1];
+	race_t		race[threads + 1];
+	atomic_int	popped[KEYS * WRITES], inserting;
+	int			keys[KEYS], items[KEYS * WRITES], *item, inserters;
+
+	skiplist	= skiplist_create( (cmpfunc_t)cmpint );
+	inserters	= (threads > 1) ? threads / 2 : 1;
+
+	for(int k = 0; k < KEYS; k++) {
+		keys[k] = k;
+	}
+	for(int i = 0; i < KEYS * WRITES; i++) {
+		items[i] = i;
+	}
+
+	for(int round = 0; round < ROUNDS; round++) {
+		for(int i = 0; i < KEYS * WRITES; i++) {
+			atomic_init(&popped[i], 0);
+		}
+		atomic_init(&inserting, inserters);
+		for(int t = 0; t <= threads; t++) {
+			race[t].skiplist	= skiplist;
+			race[t].keys		= keys;
+			race[t].items		= items;
+			race[t].popped		= popped;
+			race[t].inserting	= &inserting;
+			race[t].id			= (t < inserters) ? t : round * threads + t;
+			race[t].inserters	= inserters;
+
+			if(pthread_create(&tid[t], NULL, (t < inserters) ? (void *(*)(void*))race_insert : (void *(*)(void*))race_pop, &race[t]) != 0) {
+				fatal_error("Unable to create thread.");
+			}
+		}
+		for(int t = 0; t <= threads; t++) {
+			pthread_join(tid[t], NULL);
+		}
+
+		for(int k = 0; k < KEYS; k++) {
+			item = skiplist_pop(skiplist, &keys[k], NULL);
+			if(item != NULL) {
+				atomic_fetch_add(&popped[item - items], 1);
+			}
+			if(atomic_load(&popped[k * WRITES + WRITES - 1]) != 1) {
+				fatal_error("Key; \'%d\', lost its last insert in round \'%d\'. \n", k, round);
+			}
+		}
+		for(int i = 0; i < KEYS * WRITES; i++) {
+			if(atomic_load(&popped[i]) > 1) {
+				fatal_error("Item; \'%d\', popped \'%d\' times in round \'%d\'. \n", i, atomic_load(&popped[i]), round);
+			}
+		}
+	}
+	if(skiplist_size(skiplist) != 0) {
+		fatal_error("Size; '%d', after every key popped. ", skiplist_size(skiplist));
+	}
+	skiplist_destroy(skiplist, NULL, NULL);
+
+	printf("\nOverwrites racing pops lost no inserts in \'%d\' rounds. \n", ROUNDS);
+}
+
+static void apply_iteration(skiplist_t *skiplist, int num) {
+	skiplist_iterator_t	*iterator;
+	int					*item, expect;
+
+	iterator = skiplist_createiterator(skiplist);
+
+	for(expect = 0; (item = skiplist_next(iterator)) != NULL; expect += 2) {
+		if(*item != expect) {
+			fatal_error("Iteration out of order; \'%d\', expected \'%d\'. \n", *item, expect);
+		}
+	}
+	if(expect != num + (num % 2)) {
+		fatal_error("Iteration ended at; \'%d\', expected \'%d\'. \n", expect, num + (num % 2));
+	}
+	skiplist_destroyiterator(iterator);
+
+	printf("\nIteration is ordered. \n");
+}
+
+int main(int argc, char **argv) {
+	skiplist_t	*skiplist;
+	data_t		*data;
+	int			num, threads;
+
+	if(argc < 3) {
+		printf("Usage: %s <value> <threads> \n", *argv);
+		return -1;
+	}
+	num		= atoi(argv[1]);
+	threads	= atoi(argv[2]);
+
+	skiplist = skiplist_create( (cmpfunc_t)cmpint );
+	data = data_create(num);
+
+	apply_threads(skiplist, data, num, threads, work_insert);
+	if(skiplist_size(skiplist) != num) {
+		fatal_error("Size; \'%d\', unequal to inserts; \'%d\'. ", skiplist_size(skiplist), num);
+	}
+	printf("\nAll \'%d\' insertions completed with \'%d\' threads. \n", num, threads);
+
+	apply_threads(skiplist, data, num, threads, work_remove);
+	if(skiplist_size(skiplist) != num - (num / 2)) {
+		fatal_error("Size; \'%d\', unequal to remaining; \'%d\'. ", skiplist_size(skiplist), num - (num / 2));
+	}
+	printf("\nAll removals completed. \n");
+
+	apply_iteration(skiplist, num);
+	apply_overwrite_pop(threads);
+
+	skiplist_destroy(skiplist, free, free);
+	free(data);
+
+	return 0;
+}
@@ -0,0 +1,670 @@
+/* Author: Marius Ingebrigtsen */
+/* Skip-List implementation is lock-free, with CAS on links of every level (Fraser / Herlihy & Shavit).
+ * A node is removed by marking the lowest bit of its own next-pointers, top level first;
+ * whoever marks level 0 has removed the node, and any traversal unlinks marked nodes it passes. */
+#include "skiplist.h"
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define MAXLEVEL	16	/* Maximum number of levels; enough for 4^16 entries. */
+#define RETIRES		64	/* Number of retired nodes between each attempt to advance epoch. */
+
+/* Marked-pointer helpers. Lowest bit in next-pointer marks owner-node as removed. */
+#define MARKED(ptr)	((ptr) & (uintptr_t)1)
+#define MARK(ptr)	((ptr) | (uintptr_t)1)
+#define PTR(ptr)	((node_t*)((ptr) & ~(uintptr_t)1))
+
+
+typedef struct node node_t;
+struct node {
+	void			*key;
+	_Atomic(void*)	item;
+	node_t			*retired;			/* Link in limbo-list once removed. */
+	freefunc_t		freekey, freeitem;	/* Deallocation deferred until reclamation. */
+	atomic_int		refs;				/* Inserting and removing thread each release node once. */
+	int				height;
+	_Atomic(uintptr_t) next[];
+};
+
+/* Epoch-based reclamation:
+ * Each thread announces global epoch when entering an operation.
+ * Epoch only advances when all active threads have announced current epoch,
+ * so nodes retired in epoch 'e' are unreachable by every thread once epoch 'e + 2' is reached.
+ * Record of a thread is released when it exits, and reused by next new thread, so records don't grow with thread churn. */
+typedef struct thread thread_t;
+struct thread {
+	atomic_ulong	epoch;
+	atomic_int		active;
+	atomic_int		owned;			/* 0 once owner-thread exited; record is free for reuse. */
+	int				nesting, retires;
+	unsigned int	seed;			/* Random level generation. */
+	node_t			*limbo[3];		/* Retired nodes, indexed by epoch modulo 3. */
+	unsigned long	limboepoch[3];
+	skiplist_t		*skiplist;
+	thread_t		*next;
+};
+
+/* Retired nodes of an exited thread, freed by 'epoch_advance()' once two epochs past 'epoch'. */
+typedef struct orphan orphan_t;
+struct orphan {
+	node_t			*limbo;
+	unsigned long	epoch;
+	orphan_t		*next;
+};
+
+struct skiplist {
+	node_t			*head;
+	cmpfunc_t		cmpfunc;
+	atomic_int		children;
+	atomic_ulong	epoch;
+	_Atomic(thread_t*) threads;
+	_Atomic(orphan_t*) orphans;
+	pthread_key_t	threadkey;
+};
+
+static void thread_exit(thread_t *thread);
+
+
+/* Skip-List Create: */
+static node_t *node_create(void *key, void *item, int height) {
+	node_t *node;
+
+	node = malloc(sizeof(node_t) + sizeof(_Atomic(uintptr_t)) * height);
+	if(node == NULL) {
+		fatal_error("Out of memory.\n");
+	}
+	node->key		= key;
+	node->retired	= NULL;
+	node->freekey	= node->freeitem = NULL;
+	node->height	= height;
+	atomic_init(&node->item, item);
+	atomic_init(&node->refs, 2);
+
+	for(int i = 0; i < height; i++) {
+		atomic_init(&node->next[i], (uintptr_t)NULL);
+	}
+	return node;
+}
+
+skiplist_t *skiplist_create(cmpfunc_t cmpfunc) {
+	skiplist_t *skiplist;
+
+	skiplist = calloc(1, sizeof(skiplist_t));
+	if(skiplist == NULL) {
+		fatal_error("Out of memory.\n");
+	}
+	if(pthread_key_create(&skiplist->threadkey, (void (*)(void*))thread_exit) != 0) {
+		fatal_error("Unable to create thread-key in function %s. ", __func__);
+	}
+	skiplist->head		= node_create(NULL, NULL, MAXLEVEL);
+	skiplist->cmpfunc	= cmpfunc;
+	atomic_init(&skiplist->children, 0);
+	atomic_init(&skiplist->epoch, 0);
+	atomic_init(&skiplist->threads, NULL);
+	atomic_init(&skiplist->orphans, NULL);
+
+	return skiplist;
+}
+
+/* Skip-List Destroy: */
+static void node_destroy(node_t *node, freefunc_t freekey, freefunc_t freeitem) {
+	if(freekey != NULL) {
+		freekey(node->key);
+	}
+	if(freeitem != NULL) {
+		freeitem(atomic_load_explicit(&node->item, memory_order_relaxed));
+	}
+	free(node);
+}
+
+static void limbo_destroy(node_t *current) {
+	node_t *tmp;
+
+	while(current != NULL) {
+		tmp = current;
+		current = current->retired;
+		node_destroy(tmp, tmp->freekey, tmp->freeitem);
+	}
+}
+
+void skiplist_destroy(skiplist_t *skiplist, freefunc_t freekey, freefunc_t freeitem) {
+	node_t		*current, *tmp;
+	thread_t	*thread, *tmpthread;
+	orphan_t	*orphan, *tmporphan;
+
+	current = PTR(atomic_load(&skiplist->head->next[0]));
+
+	while(current != NULL) {
+		tmp = current;
+		current = PTR(atomic_load(&current->next[0]));
+
+		if(MARKED(atomic_load(&tmp->next[0]))) {	/* Removed, and freed from limbo below. */
+			continue;
+		}
+		node_destroy(tmp, freekey, freeitem);
+	}
+	free(skiplist->head);
+
+	thread = atomic_load(&skiplist->threads);
+
+	while(thread != NULL) {
+		for(int i = 0; i < 3; i++) {
+			limbo_destroy(thread->limbo[i]);
+		}
+		tmpthread = thread;
+		thread = thread->next;
+		free(tmpthread);
+	}
+	orphan = atomic_load(&skiplist->orphans);
+
+	while(orphan != NULL) {
+		limbo_destroy(orphan->limbo);
+		tmporphan = orphan;
+		orphan = orphan->next;
+		free(tmporphan);
+	}
+	/* Deleted key calls no destructor, so threads exiting later don't touch freed records. */
+	pthread_key_delete(skiplist->threadkey);
+	free(skiplist);
+}
+
+/* Skip-List Size: */
+int skiplist_size(skiplist_t *skiplist) {
+	return atomic_load(&skiplist->children);
+}
+
+/* Epoch-Based Reclamation: */
+/* Return calling thread's record, registering thread on first call.
+ * Record released by an exited thread is taken before a new one is allocated. */
+static thread_t *thread_get(skiplist_t *skiplist) {
+	thread_t	*thread, *head;
+	int			owned;
+
+	thread = pthread_getspecific(skiplist->threadkey);
+	if(thread != NULL) {
+		return thread;
+	}
+	for(thread = atomic_load(&skiplist->threads); thread != NULL; thread = thread->next) {
+		owned = 0;
+		if( atomic_compare_exchange_strong(&thread->owned, &owned, 1) ) {
+			break;
+		}
+	}
+	if(thread == NULL) {
+		thread = calloc(1, sizeof(thread_t));
+		if(thread == NULL) {
+			fatal_error("Out of memory.\n");
+		}
+		thread->seed		= (unsigned int)(uintptr_t)thread ^ 0x9e3779b9;
+		thread->skiplist	= skiplist;
+		atomic_init(&thread->epoch, 0);
+		atomic_init(&thread->active, 0);
+		atomic_init(&thread->owned, 1);
+
+		head = atomic_load(&skiplist->threads);
+		do {
+			thread->next = head;
+		} while( !atomic_compare_exchange_weak(&skiplist->threads, &head, thread) );
+	}
+
+	if(pthread_setspecific(skiplist->threadkey, thread) != 0) {
+		fatal_error("Unable to register thread in function %s. ", __func__);
+	}
+	return thread;
+}
+
+/* Destructor of thread-key, called as owner-thread exits.
+ * Its limbo-lists are only emptied by itself, so they are handed to skip-list as one orphan, and record is released. */
+static void thread_exit(thread_t *thread) {
+	skiplist_t		*skiplist = thread->skiplist;
+	orphan_t		*orphan;
+	node_t			*limbo = NULL, *tail;
+	unsigned long	epoch = 0;
+
+	for(int i = 0; i < 3; i++) {
+		if(thread->limbo[i] == NULL) {
+			continue;
+		}
+		for(tail = thread->limbo[i]; tail->retired != NULL; tail = tail->retired);
+		tail->retired = limbo;
+		limbo = thread->limbo[i];
+		epoch = (thread->limboepoch[i] > epoch) ? thread->limboepoch[i] : epoch;
+		thread->limbo[i] = NULL;
+	}
+	if(limbo != NULL) {
+		orphan = malloc(sizeof(orphan_t));
+		if(orphan == NULL) {
+			fatal_error("Out of memory.\n");
+		}
+		orphan->limbo	= limbo;
+		orphan->epoch	= epoch;
+		orphan->next	= atomic_load(&skiplist->orphans);
+
+		while( !atomic_compare_exchange_weak(&skiplist->orphans, &orphan->next, orphan) );
+	}
+	thread->nesting = 0;
+	atomic_store(&thread->active, 0);
+	atomic_store_explicit(&thread->owned, 0, memory_order_release);
+}
+
+/* Free orphans retired two or more epochs before 'epoch', and put back the rest.
+ * Whole list is taken at once, so concurrent callers never free the same orphan. */
+static void orphan_collect(skiplist_t *skiplist, unsigned long epoch) {
+	orphan_t *orphan, *next, *keep = NULL, *last = NULL;
+
+	if(atomic_load(&skiplist->orphans) == NULL) {
+		return;
+	}
+	for(orphan = atomic_exchange(&skiplist->orphans, NULL); orphan != NULL; orphan = next) {
+		next = orphan->next;
+
+		if(orphan->epoch + 2 <= epoch) {
+			limbo_destroy(orphan->limbo);
+			free(orphan);
+			continue;
+		}
+		orphan->next = keep;
+		keep = orphan;
+		last = (last == NULL) ? orphan : last;
+	}
+	if(keep != NULL) {
+		last->next = atomic_load(&skiplist->orphans);
+		while( !atomic_compare_exchange_weak(&skiplist->orphans, &last->next, keep) );
+	}
+}
+
+/* Free limbo-lists retired two or more epochs before 'epoch'. */
+static void limbo_collect(thread_t *thread, unsigned long epoch) {
+	for(int i = 0; i < 3; i++) {
+		if( (thread->limbo[i] != NULL) && (thread->limboepoch[i] + 2 <= epoch) ) {
+			limbo_destroy(thread->limbo[i]);
+			thread->limbo[i] = NULL;
+		}
+	}
+}
+
+static thread_t *epoch_enter(skiplist_t *skiplist) {
+	thread_t		*thread;
+	unsigned long	epoch;
+
+	thread = thread_get(skiplist);
+
+	if(thread->nesting++ > 0) {
+		return thread;
+	}
+	epoch = atomic_load(&skiplist->epoch);
+
+	atomic_store(&thread->epoch, epoch);
+	atomic_store(&thread->active, 1);
+	/* Announcement must be visible before any node is read. */
+	atomic_thread_fence(memory_order_seq_cst);
+
+	limbo_collect(thread, epoch);
+
+	return thread;
+}
+
+static void epoch_exit(thread_t *thread) {
+	if(--thread->nesting > 0) {
+		return;
+	}
+	atomic_store_explicit(&thread->active, 0, memory_order_release);
+}
+
+/* Advance global epoch if every active thread has announced it. */
+static void epoch_advance(skiplist_t *skiplist) {
+	thread_t		*thread;
+	unsigned long	epoch;
+
+	epoch = atomic_load(&skiplist->epoch);
+
+	for(thread = atomic_load(&skiplist->threads); thread != NULL; thread = thread->next) {
+		if( atomic_load(&thread->active) && (atomic_load(&thread->epoch) != epoch) ) {
+			return;
+		}
+	}
+	if( atomic_compare_exchange_strong(&skiplist->epoch, &epoch, epoch + 1) ) {
+		orphan_collect(skiplist, epoch + 1);
+	}
+}
+
+/* Put unlinked node in limbo for deallocation when no thread can reach it. */
+static void epoch_retire(skiplist_t *skiplist, thread_t *thread, node_t *node) {
+	unsigned long	epoch;
+	int				slot;
+
+	epoch	= atomic_load(&skiplist->epoch);
+	slot	= epoch % 3;
+
+	if(thread->limboepoch[slot] != epoch) {	/* Slot holds nodes from 3 or more epochs ago. */
+		limbo_destroy(thread->limbo[slot]);
+		thread->limbo[slot]		= NULL;
+		thread->limboepoch[slot]= epoch;
+	}
+	node->retired		= thread->limbo[slot];
+	thread->limbo[slot]	= node;
+
+	if(++thread->retires >= RETIRES) {
+		thread->retires = 0;
+		epoch_advance(skiplist);
+	}
+}
+
+/* Release inserting or removing thread's reference; last one retires node. */
+static void node_release(skiplist_t *skiplist, thread_t *thread, node_t *node) {
+	if(atomic_fetch_sub(&node->refs, 1) == 1) {
+		epoch_retire(skiplist, thread, node);
+	}
+}
+
+/* Skip-List Find: */
+/* Fill 'preds' and 'succs' with nodes before and after key on every level,
+ * unlinking marked nodes on the way.
+ * Return 1 if 'succs[0]' has key, 0 otherwise. */
+static int skiplist_find(skiplist_t *skiplist, void *key, node_t **preds, node_t **succs) {
+	node_t		*pred, *current;
+	uintptr_t	succ, expected;
+
+retry:
+	pred = skiplist->head;
+
+	for(int level = MAXLEVEL - 1; level >= 0; level--) {
+		current = PTR(atomic_load(&pred->next[level]));
+
+		while(current != NULL) {
+			succ = atomic_load(&current->next[level]);
+
+			/* Unlink marked node. Fails if 'pred' was marked or changed meanwhile. */
+			if(MARKED(succ)) {
+				expected = (uintptr_t)current;
+				if( !atomic_compare_exchange_strong(&pred->next[level], &expected, (uintptr_t)PTR(succ)) ) {
+					goto retry;
+				}
+				current = PTR(succ);
+				continue;
+			}
+			if(skiplist->cmpfunc(current->key, key) >= 0) {
+				break;
+			}
+			pred	= current;
+			current	= PTR(succ);
+		}
+		preds[level] = pred;
+		succs[level] = current;
+	}
+	return (succs[0] != NULL) && (skiplist->cmpfunc(succs[0]->key, key) == 0);
+}
+
+/* Skip-List Insert: */
+static inline int random_level(thread_t *thread) {
+	int height;
+
+	/* Xorshift; each further level with probability 1/4. */
+	thread->seed ^= thread->seed << 13;
+	thread->seed ^= thread->seed >> 17;
+	thread->seed ^= thread->seed << 5;
+
+	for(height = 1; (height < MAXLEVEL) && ((thread->seed >> (2 * height)) & 3) == 0; height++) {
+	}
+	return height;
+}
+
+int skiplist_insert(skiplist_t *skiplist, void *key, void *item) {
+	node_t		*preds[MAXLEVEL], *succs[MAXLEVEL], *node;
+	thread_t	*thread;
+	uintptr_t	expected, next;
+	void		*previous, *mine;
+	int			height;
+
+	thread	= epoch_enter(skiplist);
+	height	= random_level(thread);
+	node	= NULL;
+
+	/* Link level 0; node is in skip-list once this succeeds. */
+	for(;;) {
+		if(skiplist_find(skiplist, key, preds, succs)) {
+			previous = atomic_exchange(&succs[0]->item, item);
+
+			/* If node was removed meanwhile, item may be stored in node no longer in skip-list.
+			 * Unless a pop already took it, so overwrite came first, take item back and insert new node. */
+			mine = item;
+			if( !MARKED(atomic_load(&succs[0]->next[0])) ||
+				!atomic_compare_exchange_strong(&succs[0]->item, &mine, previous) ) {
+				free(node);	/* Never published. */
+				epoch_exit(thread);
+				return 0;
+			}
+			continue;
+		}
+		if(node == NULL) {
+			node = node_create(key, item, height);
+		}
+		for(int i = 0; i < height; i++) {
+			atomic_store_explicit(&node->next[i], (uintptr_t)succs[i], memory_order_relaxed);
+		}
+		expected = (uintptr_t)succs[0];
+		if(atomic_compare_exchange_strong(&preds[0]->next[0], &expected, (uintptr_t)node)) {
+			break;
+		}
+	}
+	atomic_fetch_add(&skiplist->children, 1);
+
+	/* Link upper levels. Stop if node is removed meanwhile. */
+	for(int i = 1; i < height; i++) {
+		for(;;) {
+			expected = (uintptr_t)succs[i];
+			if(atomic_compare_exchange_strong(&preds[i]->next[i], &expected, (uintptr_t)node)) {
+				break;
+			}
+			if( !skiplist_find(skiplist, key, preds, succs) || (succs[0] != node) ) {
+				goto done;
+			}
+			next = atomic_load(&node->next[i]);
+			if( MARKED(next) ||
+				!atomic_compare_exchange_strong(&node->next[i], &next, (uintptr_t)succs[i]) ) {
+				goto done;
+			}
+		}
+	}
+
+done:
+	/* If removed while linking, upper levels may have been linked after remover unlinked node. */
+	if(MARKED(atomic_load(&node->next[0]))) {
+		skiplist_find(skiplist, key, preds, succs);
+	}
+	node_release(skiplist, thread, node);
+	epoch_exit(thread);
+
+	return 1;
+}
+
+/* Skip-List Search: */
+void *skiplist_search(skiplist_t *skiplist, void *key) {
+	thread_t	*thread;
+	node_t		*pred, *current;
+	uintptr_t	succ;
+	void		*item;
+	int			cmp;
+
+	thread	= epoch_enter(skiplist);
+	item	= NULL;
+	pred	= skiplist->head;
+
+	/* Search does not unlink, it only steps past marked nodes. */
+	for(int level = MAXLEVEL - 1; level >= 0; level--) {
+		current = PTR(atomic_load(&pred->next[level]));
+
+		while(current != NULL) {
+			succ = atomic_load(&current->next[level]);
+
+			if(MARKED(succ)) {
+				current = PTR(succ);
+				continue;
+			}
+			cmp = skiplist->cmpfunc(current->key, key);
+
+			if(cmp < 0) {
+				pred	= current;
+				current	= PTR(succ);
+			} else {
+				if(cmp == 0) {
+					item = atomic_load(&current->item);
+					goto done;
+				}
+				break;
+			}
+		}
+	}
+
+done:
+	epoch_exit(thread);
+
+	return item;
+}
+
+/* Skip-List Remove & Pop: */
+/* Logically remove node with key, then unlink it.
+ * Return removed node, or NULL if key not in skip-list. */
+static node_t *skiplist_unlink(skiplist_t *skiplist, void *key) {
+	node_t		*preds[MAXLEVEL], *succs[MAXLEVEL], *node;
+	uintptr_t	succ;
+
+	if( !skiplist_find(skiplist, key, preds, succs) ) {
+		return NULL;
+	}
+	node = succs[0];
+
+	/* Mark upper levels top-down. */
+	for(int level = node->height - 1; level >= 1; level--) {
+		succ = atomic_load(&node->next[level]);
+		while( !MARKED(succ) ) {
+			atomic_compare_exchange_weak(&node->next[level], &succ, MARK(succ));
+		}
+	}
+
+	/* Marking level 0 decides which thread removed node. */
+	succ = atomic_load(&node->next[0]);
+	for(;;) {
+		if(MARKED(succ)) {
+			return NULL;
+		}
+		if(atomic_compare_exchange_weak(&node->next[0], &succ, MARK(succ))) {
+			break;
+		}
+	}
+	atomic_fetch_sub(&skiplist->children, 1);
+
+	/* Physically unlink from every level. */
+	skiplist_find(skiplist, key, preds, succs);
+
+	return node;
+}
+
+int skiplist_remove(skiplist_t *skiplist, void *key, freefunc_t freekey, freefunc_t freeitem) {
+	thread_t	*thread;
+	node_t		*node;
+
+	thread = epoch_enter(skiplist);
+
+	node = skiplist_unlink(skiplist, key);
+	if(node != NULL) {
+		node->freekey	= freekey;
+		node->freeitem	= freeitem;
+		node_release(skiplist, thread, node);
+	}
+	epoch_exit(thread);
+
+	return (node == NULL) ? 0 : 1;
+}
+
+void *skiplist_pop(skiplist_t *skiplist, void *key, freefunc_t freekey) {
+	thread_t	*thread;
+	node_t		*node;
+	void		*item;
+
+	thread	= epoch_enter(skiplist);
+	item	= NULL;
+
+	node = skiplist_unlink(skiplist, key);
+	if(node != NULL) {
+		/* Take item, so an insert overwriting removed node knows whether its item was popped. */
+		item			= atomic_exchange(&node->item, NULL);
+		node->freekey	= freekey;
+		node_release(skiplist, thread, node);
+	}
+	epoch_exit(thread);
+
+	return item;
+}
+
+
+/* Iterator-structure: */
+struct skiplist_iterator {
+	skiplist_t	*skiplist;
+	thread_t	*thread;
+	node_t		*current;
+};
+
+/* Step past removed nodes on level 0. */
+static inline node_t *skip_marked(node_t *current) {
+	while( (current != NULL) && MARKED(atomic_load(&current->next[0])) ) {
+		current = PTR(atomic_load(&current->next[0]));
+	}
+	return current;
+}
+
+/* Skip-List Create Iterator: */
+skiplist_iterator_t *skiplist_createiterator(skiplist_t *skiplist) {
+	skiplist_iterator_t *iterator;
+
+	iterator = calloc(1, sizeof(skiplist_iterator_t));
+	if(iterator == NULL) {
+		fatal_error("Out of memory.\n");
+	}
+	iterator->skiplist	= skiplist;
+	/* Stay in epoch for lifetime of iterator, so 'current' is never reclaimed. */
+	iterator->thread	= epoch_enter(skiplist);
+	iterator->current	= PTR(atomic_load(&skiplist->head->next[0]));
+
+	return iterator;
+}
+
+/* Skip-List Destroy Iterator: */
+void skiplist_destroyiterator(skiplist_iterator_t *iterator) {
+	epoch_exit(iterator->thread);
+	free(iterator);
+}
+
+/* Skip-List Has Next: */
+int skiplist_hasnext(skiplist_iterator_t *iterator) {
+	iterator->current = skip_marked(iterator->current);
+
+	if(iterator->current == NULL) {
+		return 0;
+	}
+	return 1;
+}
+
+/* Skip-List Next: */
+void *skiplist_next(skiplist_iterator_t *iterator) {
+	void *item;
+
+	do {	/* Item taken by concurrent pop is skipped as removed. */
+		iterator->current = skip_marked(iterator->current);
+
+		if(iterator->current == NULL) {
+			return NULL;
+		}
+		item = atomic_load(&iterator->current->item);
+		iterator->current = PTR(atomic_load(&iterator->current->next[0]));
+	} while(item == NULL);
+
+	return item;
+}
+
+/* Skip-List Reset Iterator: */
+void skiplist_resetiterator(skiplist_iterator_t *iterator) {
+	iterator->current = PTR(atomic_load(&iterator->skiplist->head->next[0]));
+}
@@ -0,0 +1,76 @@
+/* Author: Marius Ingebrigtsen */
+#ifndef __SKIPLIST_H_
+#define __SKIPLIST_H_
+
+#include "../common.h"
+
+/* Lock-free Skip-List Structure. 
+ * Ordered map with same interface as rbt.h. 
+ * Insert, search, remove and iteration are safe to call concurrently from any number of threads. 
+ * Removed nodes are reclaimed with epoch-based reclamation, 
+ * so deallocation of removed keys and items is deferred until no thread can still observe them. */
+typedef struct skiplist skiplist_t;
+/* Function-pointer for deallocation of keys and items. */
+typedef void (*freefunc_t)(void*);
+
+
+/* Return new skip-list. 
+ * NOTE: Each skip-list holds a thread-specific key for its records of threads, 
+ * so at most PTHREAD_KEYS_MAX (1024 on glibc) skip-lists, less keys used elsewhere, can exist at once. 
+ * Record of a thread, and its nodes awaiting reclamation, are handed back when thread exits. */
+skiplist_t *skiplist_create(cmpfunc_t cmpfunc);
+
+/* Destroy skip-list, and nodes awaiting reclamation. 
+ * If function pointer is not NULL, then keys and items is destroyed using given function. 
+ * NOTE: Not thread-safe; no other thread may use skip-list during or after destruction. */
+void skiplist_destroy(skiplist_t *skiplist, freefunc_t freekey, freefunc_t freeitem);
+
+/* Return number of items in skip-list. 
+ * Under concurrent modification value is a snapshot that may be outdated on return. */
+int skiplist_size(skiplist_t *skiplist);
+
+/* Insert item using cmpfunc to compare keys. 
+ * If key is already in skip-list, then item will overwrite existing value. 
+ * Return 1 if inserted, 0 if overwritten. */
+int skiplist_insert(skiplist_t *skiplist, void *key, void *item);
+
+/* Search skip-list using key and return item with key. 
+ * Return NULL if item not in skip-list. */
+void *skiplist_search(skiplist_t *skiplist, void *key);
+
+/* Remove item associated with key. 
+ * Return 1 if removed, 0 if key not associated with item. 
+ * Optional function-pointers for deallocation of key and item, pass NULL to avoid deallocation. 
+ * Deallocation happens once no concurrent thread may hold reference to the removed node. 
+ * Pass NULL for items that other threads may keep using after a search. */
+int skiplist_remove(skiplist_t *skiplist, void *key, freefunc_t freekey, freefunc_t freeitem);
+
+/* Remove and return item associated with key. 
+ * Return NULL if key not associated with item. 
+ * Optional function-pointer for deallocation of key, pass NULL to avoid deallocation. */
+void *skiplist_pop(skiplist_t *skiplist, void *key, freefunc_t freekey);
+
+
+/* Iteration: */
+typedef struct skiplist_iterator skiplist_iterator_t;
+
+/* Return iterator over skip-list in ascending order of keys. 
+ * Iteration is weakly consistent; items inserted or removed concurrently may or may not be observed. 
+ * NOTE: Iterator holds back reclamation of removed nodes until destroyed, 
+ * and must be destroyed by the same thread that created it. */
+skiplist_iterator_t *skiplist_createiterator(skiplist_t *skiplist);
+
+/* Deallocates iterator. */
+void skiplist_destroyiterator(skiplist_iterator_t *iterator);
+
+/* Return 0 if iterator is exhausted, 1 otherwise. */
+int skiplist_hasnext(skiplist_iterator_t *iterator);
+
+/* Return next item in sequence of iteration, and iterate iterator. 
+ * Return NULL if iterator exhausted. */
+void *skiplist_next(skiplist_iterator_t *iterator);
+
+/* Sets iterator to start of iteration. */
+void skiplist_resetiterator(skiplist_iterator_t *iterator);
+
+#endif
@@ -1,7 +1,7 @@
 #include <math.h>
 
 #include "../common.h"
-#include "../gettime.h"
+#include "../bench.h"
 #include "./splay.h"
 
 typedef struct data {
@@ -10,7 +10,22 @@ typedef struct data {
 
 #define START	1024		/* 2^10 */
 #define MAXELEM	1048576+1	/* 2^20 + 1 */
-#define REPEAT	10			/* For average calculation. */
+
+#define ZIPF_S	1.0			/* Skew of Zipf-distribution. */
+#define WSSIZE	256			/* Number of keys in working-set. */
+#define WSPHASE	16			/* Number of times working-set shifts during access-sequence. */
+
+/* Access-pattern. Fill 'access' with 'num' indexes into data of 'elem' entries. */
+typedef void (*patternfunc_t)(int *access, int num, int elem);
+
+/* State of one trial, passed to setup, trial and teardown by harness. */
+typedef struct trial {
+	splay_t			*splay;
+	splay_mode_t	mode;
+	patternfunc_t	pattern;
+	data_t			*data;
+	int				*access, elem;
+} trial_t;
 
 
 static int cmpint(int *a, int *b) {
@@ -33,120 +48,170 @@ static data_t *data_create(int num) {
 	return data;
 }
 
-static data_t *insert_data(splay_t *splay, int num) {
-	data_t *data;
+/* Return random permutation of indexes [0, num), so skewed access does not favour neighbouring keys. */
+static int *permutation_create(int num) {
+	int *perm, tmp, k;
 
-	data = data_create(num);
+	perm = new_array(num, sizeof(int));
 
 	for(int i = 0; i < num; i++) {
-		if( !splay_insert(splay, data[i].key, data[i].item) ) {
-			fatal_error("Duplicate insert.");
-		}
+		perm[i] = i;
 	}
-
-	return data;
-}
-
-static void assert_insert(char *bnch_file) {
-	unsigned long long t1, t2, average, sum;
-	FILE	*f;
-	splay_t	*splay;
-	data_t	*data;
-
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Couldn't open file; %s. ", bnch_file);
+	for(int i = num - 1; i > 0; i--) {
+		k		= rand() % (i + 1);
+		tmp		= perm[i];
+		perm[i]	= perm[k];
+		perm[k]	= tmp;
 	}
-	fprintf(f, "Splay Insert\nElements, Time (microsec. average with %d number of repeats)\n\n", REPEAT);
-
-	average = 0;
-
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
+	return perm;
+}
 
-		sum = 0;
+/* Zipf-distributed access; rank 'r' is accessed with probability proportional to 1 / r^ZIPF_S. */
+static void pattern_zipf(int *access, int num, int elem) {
+	double	*cdf, sum, u;
+	int		*perm, low, high, mid;
 
-		for(int r = 0; r < REPEAT; r++) {
+	cdf		= new_array(elem, sizeof(double));
+	perm	= permutation_create(elem);
 
-			splay = splay_create( (cmpfunc_t)cmpint );
-			data = data_create(elem);
+	sum = 0;
+	for(int i = 0; i < elem; i++) {
+		sum += 1.0 / pow(i + 1, ZIPF_S);
+		cdf[i] = sum;
+	}
 
-			t1 = gettime();
-			for(int i = 0; i < elem; i++) {
-				splay_insert(splay, data[i].key, data[i].item);
+	for(int i = 0; i < num; i++) {
+		u = ((double)rand() / ((double)RAND_MAX + 1)) * sum;
+
+		/* Binary search for first rank with cumulative weight above 'u'. */
+		low = 0;
+		high = elem - 1;
+		while(low < high) {
+			mid = low + (high - low) / 2;
+			if(cdf[mid] <= u) {
+				low = mid + 1;
+			} else {
+				high = mid;
 			}
-			t2 = gettime();
+		}
+		access[i] = perm[low];
+	}
+	free(perm);
+	free(cdf);
+}
 
-			sum += t2 - t1;
+/* Uniform access within a working-set of WSSIZE keys, which moves to other keys WSPHASE times. */
+static void pattern_workingset(int *access, int num, int elem) {
+	int *perm, size, phase, start;
 
-			free(data);
-			splay_destroy(splay, free, free);
-		}
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT));
+	perm	= permutation_create(elem);
+	size	= (WSSIZE < elem) ? WSSIZE : elem;
+	phase	= (num / WSPHASE > 0) ? num / WSPHASE : 1;
+	start	= 0;
 
-		average += sum / REPEAT;
+	for(int i = 0; i < num; i++) {
+		if(i % phase == 0) {
+			start = rand() % (elem - size + 1);
+		}
+		access[i] = perm[start + (rand() % size)];
 	}
-	average /= log2(MAXELEM) - log2(START);
-
-	fprintf(f, "Overall average; \n%d\n", (int)average);
+	free(perm);
+}
 
-	fclose(f);
+static void setup_empty(trial_t *trial) {
+	trial->splay	= splay_create( (cmpfunc_t)cmpint );
+	trial->data		= data_create(trial->elem);
+	trial->access	= NULL;
 }
 
-static void assert_search(char *bnch_file) {
-	unsigned long long t1, t2, average, sum;
-	FILE	*f;
-	splay_t	*splay;
-	data_t	*data;
-
-	f = fopen(bnch_file, "w");
-	if(f == NULL) {
-		fatal_error("Couldn't open file; %s. ", bnch_file);
+static void setup_filled(trial_t *trial) {
+	setup_empty(trial);
+	splay_setmode(trial->splay, trial->mode);
+
+	for(int i = 0; i < trial->elem; i++) {
+		if( !splay_insert(trial->splay, trial->data[i].key, trial->data[i].item) ) {
+			fatal_error("Duplicate insert.");
+		}
 	}
-	fprintf(f, "Splay Search\nElements, Time (microsec. average with %d number of repeats)\n\n", REPEAT);
+	if(trial->pattern != NULL) {
+		trial->access = new_array(trial->elem, sizeof(int));
+		trial->pattern(trial->access, trial->elem, trial->elem);
+	}
+}
 
-	average = 0;
+static void teardown(trial_t *trial) {
+	free(trial->access);
+	free(trial->data);
+	splay_destroy(trial->splay, free, free);
+}
 
-	for(int elem = START; elem < MAXELEM; elem *= 2) {
+static void trial_insert(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		splay_insert(trial->splay, trial->data[i].key, trial->data[i].item);
+	}
+}
 
-		sum = 0;
+static void trial_search(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		if( splay_search(trial->splay, trial->data[i].key) == NULL) {
+			fatal_error("Value not found.");
+		}
+	}
+}
 
-		for(int r = 0; r < REPEAT; r++) {
+static void trial_access(trial_t *trial) {
+	for(int i = 0; i < trial->elem; i++) {
+		if( splay_search(trial->splay, trial->data[trial->access[i]].key) == NULL) {
+			fatal_error("Value not found.");
+		}
+	}
+}
 
-			splay = splay_create( (cmpfunc_t)cmpint );
-			data = insert_data(splay, elem);
+/* Time 'func' for every set of elements; trials that search are set up with filled tree, and access-pattern if given. */
+static void assert_trials(char *bnch_file, char *title, splay_mode_t mode, patternfunc_t pattern, benchfunc_t setup, benchfunc_t func) {
+	bench_file_t	*file;
+	bench_stats_t	stats;
+	trial_t			trial;
 
-			t1 = gettime();
-			for(int i = 0; i < elem; i++) {
-				if( splay_search(splay, data[i].key) == NULL) {
-					fatal_error("Value not found.");
-				}
-			}
-			t2 = gettime();
+	file = bench_open(bnch_file, title);
 
-			sum += t2 - t1;
+	trial.mode		= mode;
+	trial.pattern	= pattern;
 
-			free(data);
-			splay_destroy(splay, free, free);
-		}
-		fprintf(f, "%d, %d\n", elem, (int)(sum / REPEAT));
+	for(int elem = START; elem < MAXELEM; elem *= 2) {
+		trial.elem = elem;
 
-		average += sum / REPEAT;
+		bench_run(&stats, setup, func, (benchfunc_t)teardown, &trial, elem);
+		bench_write(file, elem, &stats);
 	}
-	average /= log2(MAXELEM) - log2(START);
+	bench_close(file);
+}
+
+static void assert_insert(char *bnch_file) {
+	assert_trials(bnch_file, "Splay Insert", SPLAY_FULL, NULL, (benchfunc_t)setup_empty, (benchfunc_t)trial_insert);
+}
 
-	fprintf(f, "Overall average; \n%d\n", (int)average);
+static void assert_search(char *bnch_file) {
+	assert_trials(bnch_file, "Splay Search", SPLAY_FULL, NULL, (benchfunc_t)setup_filled, (benchfunc_t)trial_search);
+}
 
-	fclose(f);
+static void assert_access(char *bnch_file, char *title, splay_mode_t mode, patternfunc_t pattern) {
+	assert_trials(bnch_file, title, mode, pattern, (benchfunc_t)setup_filled, (benchfunc_t)trial_access);
 }
 
 int main(int argc, char **argv) {
 	
-	if(argc < 3) {
-		printf("Usage: %s <result-file-insert> <result-file-search> \n", *argv);
+	if(argc < 7) {
+		printf("Usage: %s <result-file-insert> <result-file-search> <zipf-full> <zipf-semi> <workingset-full> <workingset-semi> \n", *argv);
+		return -1;
 	}
 
 	assert_insert(argv[1]);
 	assert_search(argv[2]);
+	assert_access(argv[3], "Splay Zipf Search (Full Splay)", SPLAY_FULL, pattern_zipf);
+	assert_access(argv[4], "Splay Zipf Search (Semi Splay)", SPLAY_SEMI, pattern_zipf);
+	assert_access(argv[5], "Splay Working-Set Search (Full Splay)", SPLAY_FULL, pattern_workingset);
+	assert_access(argv[6], "Splay Working-Set Search (Semi Splay)", SPLAY_SEMI, pattern_workingset);
 
 	return 0;
 }
\ No newline at end of file
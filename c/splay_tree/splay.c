@@ -1,9 +1,13 @@
 /* Author: Marius Ingebrigtsen */
-/* NOTE: Recursive descent in a splay tree may resolve into a linked list and cause stackoverflow. */
+/* NOTE: Splaying is iterative; top-down for full splay, and bottom-up over a recorded access-path for semi-splay. 
+ * A splay tree may still resolve into a linked list, so no function traversing the tree recursively is used on the access-paths. */
 
 #include "splay.h"
 #include "../plot.h"
 
+/* Initial capacity of access-path used by semi-splay. */
+#define PATHSIZE 64
+
 
 typedef struct node node_t;
 struct node {
@@ -13,7 +17,9 @@ struct node {
 
 typedef struct splay {
 	node_t		*root, *head;
-	int			children;
+	node_t		**path;		/* Access-path from root recorded for semi-splay. */
+	int			children, pathsize;
+	splay_mode_t mode;
 	cmpfunc_t	cmpfunc;
 } splay_t;
 
@@ -26,66 +32,37 @@ splay_t *splay_create(cmpfunc_t cmpfunc) {
 	if(splay == NULL) {
 		fatal_error("Out of memory.");
 	}
-	splay->cmpfunc = cmpfunc;
+	splay->cmpfunc	= cmpfunc;
+	splay->mode		= SPLAY_FULL;
 
 	return splay;
 }
 
-/* Splay Destroy: */
-static void _splay_destroy_key_item(node_t *current, freefunc_t freekey, freefunc_t freeitem) {
-	if(current == NULL) {
-		return;
-	}
-	printf("%d\n", *(int*)current->item);
-	_splay_destroy_key_item(current->left, freekey, freeitem);
-	_splay_destroy_key_item(current->right, freekey, freeitem);
-	
-	freekey(current->key);
-	freeitem(current->item);
-	free(current);
+/* Splay Set Mode: */
+void splay_setmode(splay_t *splay, splay_mode_t mode) {
+	splay->mode = mode;
 }
 
-static void _splay_destroy_key(node_t *current, freefunc_t freekey) {
-	if(current == NULL) {
-		return;
-	}
-	_splay_destroy_key(current->left, freekey);
-	_splay_destroy_key(current->right, freekey);
-
-	freekey(current->key);
-	free(current);
-}
+/* Splay Destroy: */
+/* Every node is linked in 'head'-list, so destruction walks the list in stead of the (possibly degenerate) tree. */
+void splay_destroy(splay_t *splay, freefunc_t freekey, freefunc_t freeitem) {
+	node_t *current, *tmp;
 
-static void _splay_destroy_item(node_t *current, freefunc_t freeitem) {
-	if(current == NULL) {
-		return;
-	}
-	_splay_destroy_item(current->left, freeitem);
-	_splay_destroy_item(current->right, freeitem);
+	current = splay->head;
 
-	freeitem(current->item);
-	free(current);
-}
+	while(current != NULL) {
+		tmp = current;
+		current = current->next;
 
-static void _splay_destroy(node_t *current) {
-	if(current == NULL) {
-		return;
-	}
-	_splay_destroy(current->left);
-	_splay_destroy(current->right);
-	free(current);
-}
-
-void splay_destroy(splay_t *splay, freefunc_t freekey, freefunc_t freeitem) {
-	if(freekey && freeitem) {
-		_splay_destroy_key_item(splay->root, freekey, freeitem);
-	} else if(freekey) {
-		_splay_destroy_key(splay->root, freekey);
-	} else if(freeitem) {
-		_splay_destroy_item(splay->root, freekey);
-	} else {
-		_splay_destroy(splay->root);
+		if(freekey != NULL) {
+			freekey(tmp->key);
+		}
+		if(freeitem != NULL) {
+			freeitem(tmp->item);
+		}
+		free(tmp);
 	}
+	free(splay->path);
 	free(splay);
 }
 
@@ -115,8 +92,8 @@ int splay_size(splay_t *splay) {
 	return splay->children;
 }
 
-/* Splay Insert: */
-static node_t *rotate_left(node_t *current) {
+/* Splay Rotations: */
+static inline node_t *rotate_left(node_t *current) {
 	node_t *child;
 
 	child = current->right;
@@ -126,17 +103,138 @@ static node_t *rotate_left(node_t *current) {
 	return child;
 }
 
-static node_t *rotate_right(node_t *current) {
+static inline node_t *rotate_right(node_t *current) {
 	node_t *child;
 
 	child = current->left;
-	child->right = current->left;
+	current->left = child->right;
 	child->right = current;
 
 	return child;
 }
 
-static node_t *node_create(void *key, void *item, node_t *left, node_t *right, node_t *head) {
+/* Top-Down Splay: */
+/* Splay node with key, or last node on search-path for key, to root of subtree. 
+ * Left- and right-trees are assembled under 'header' while descending, 
+ * and re-attached under the new root when descent ends. */
+static node_t *splay_topdown(node_t *current, void *key, cmpfunc_t cmpfunc) {
+	node_t	header, *left, *right;
+	int		cmp;
+
+	if(current == NULL) {
+		return NULL;
+	}
+	header.left = header.right = NULL;
+	left = right = &header;
+
+	for(;;) {
+		cmp = cmpfunc(key, current->key);
+
+		if(cmp < 0) {
+			if(current->left == NULL) {
+				break;
+			}
+			/* Left-Left Case: */
+			if(cmpfunc(key, current->left->key) < 0) {
+				current = rotate_right(current);
+				if(current->left == NULL) {
+					break;
+				}
+			}
+			/* Link current into right-tree. */
+			right->left	= current;
+			right		= current;
+			current		= current->left;
+		}
+		else if(cmp > 0) {
+			if(current->right == NULL) {
+				break;
+			}
+			/* Right-Right Case: */
+			if(cmpfunc(key, current->right->key) > 0) {
+				current = rotate_left(current);
+				if(current->right == NULL) {
+					break;
+				}
+			}
+			/* Link current into left-tree. */
+			left->right	= current;
+			left		= current;
+			current		= current->right;
+		}
+		else {
+			break;
+		}
+	}
+	/* Assemble: */
+	left->right		= current->left;
+	right->left		= current->right;
+	current->left	= header.right;
+	current->right	= header.left;
+
+	return current;
+}
+
+/* Semi-Splay: */
+static inline void path_push(splay_t *splay, int depth, node_t *node) {
+	if(depth >= splay->pathsize) {
+		splay->pathsize	= (splay->pathsize == 0) ? PATHSIZE : splay->pathsize * 2;
+		splay->path		= realloc(splay->path, sizeof(node_t*) * splay->pathsize);
+		if(splay->path == NULL) {
+			fatal_error("Out of memory.");
+		}
+	}
+	splay->path[depth] = node;
+}
+
+/* Replace 'old' with 'new' as child of 'parent', or as root if 'parent' is NULL. */
+static inline void relink(splay_t *splay, node_t *parent, node_t *old, node_t *new) {
+	if(parent == NULL) {
+		splay->root = new;
+	} else if(parent->left == old) {
+		parent->left = new;
+	} else {
+		parent->right = new;
+	}
+}
+
+/* Semi-splay node at 'path[depth]' upwards. 
+ * Zig-Zag is as in a full splay, but Zig-Zig rotates only parent over grandparent 
+ * and continues from parent, which leaves accessed node about half-way to root. */
+static void splay_semi(splay_t *splay, int depth) {
+	node_t **path, *x, *y, *z, *top;
+
+	path = splay->path;
+
+	while(depth >= 2) {
+		x = path[depth];
+		y = path[depth-1];
+		z = path[depth-2];
+
+		if(z->left == y) {
+			if(y->left == x) {		/* Left-Left Case: */
+				top = rotate_right(z);
+			} else {				/* Left-Right Case: */
+				z->left	= rotate_left(y);
+				top		= rotate_right(z);
+			}
+		} else {
+			if(y->right == x) {		/* Right-Right Case: */
+				top = rotate_left(z);
+			} else {				/* Right-Left Case: */
+				z->right= rotate_right(y);
+				top		= rotate_left(z);
+			}
+		}
+		relink(splay, (depth >= 3) ? path[depth-3] : NULL, z, top);
+
+		path[depth-2] = top;
+		depth -= 2;
+	}
+}
+
+/* Splay Insert: */
+static inline node_t *node_create(void *key, void *item, node_t *left, node_t *right, node_t *head) {
 	node_t *node;
 
 	node = malloc(sizeof(node_t));
@@ -152,89 +250,86 @@ static node_t *node_create(void *key, void *item, node_t *left, node_t *right, n
 	return node;
 }
 
-static node_t *_splay_insert(node_t *current, node_t **head, cmpfunc_t cmpfunc, void *key, void *item, int *inserted) {
-	int cmp;
+static int splay_insert_full(splay_t *splay, void *key, void *item) {
+	node_t	*root;
+	int		cmp;
 
-	if(current == NULL) {
-		*head = node_create(key, item, NULL, NULL, *head);
-		return *head;
+	if(splay->root == NULL) {
+		splay->root = splay->head = node_create(key, item, NULL, NULL, splay->head);
+		return 1;
 	}
-	cmp = cmpfunc(key, current->key);
-
-	if(cmp < 0) {
-
-		if(current->left == NULL) {
-			current->left = node_create(key, item, NULL, NULL, *head);
-			*head = current->left;
-			current = rotate_right(current);
+	root = splay_topdown(splay->root, key, splay->cmpfunc);
+	cmp = splay->cmpfunc(key, root->key);
 
-			return current;
-		}
-		cmp = cmpfunc(key, current->left->key);
-
-		if(cmp < 0) {		/* Left-Left Case: */
-
-			current->left->left = _splay_insert(current->left->left, head, cmpfunc, key, item, inserted);
-
-			current = rotate_right(current);
-			current = rotate_right(current);
-		}
-		else if(cmp > 0) {	/* Left-Right Case: */
-
-			current->left->right = _splay_insert(current->left->right, head, cmpfunc, key, item, inserted);
-
-			current->left = rotate_left(current->left);
-			current = rotate_right(current);
-		}
-		else {	/* Key exists. */
-			current->left->item = item;
-			*inserted = 0;
-		}
+	if(cmp < 0) {		/* New root with old root as right child. */
+		splay->head = node_create(key, item, root->left, root, splay->head);
+		root->left	= NULL;
+	}
+	else if(cmp > 0) {	/* New root with old root as left child. */
+		splay->head = node_create(key, item, root, root->right, splay->head);
+		root->right	= NULL;
 	}
-	else if(cmp > 0) {
+	else {				/* Key exists. */
+		root->item	= item;
+		splay->root	= root;
+		return 0;
+	}
+	splay->root = splay->head;
 
-		if(current->right == NULL) {
-			current->right = node_create(key, item, NULL, NULL, *head);
-			*head = current->right;
-			current = rotate_left(current);
+	return 1;
+}
 
-			return current;
-		}
-		cmp = cmpfunc(key, current->right->key);
+static int splay_insert_semi(splay_t *splay, void *key, void *item) {
+	node_t	*current, *node;
+	int		cmp, depth;
 
-		if(cmp < 0) {		/* Right-Left Case: */
+	if(splay->root == NULL) {
+		splay->root = splay->head = node_create(key, item, NULL, NULL, splay->head);
+		return 1;
+	}
+	current	= splay->root;
+	depth	= -1;
 
-			current->right->left = _splay_insert(current->right->left, head, cmpfunc, key, item, inserted);
+	for(;;) {
+		path_push(splay, ++depth, current);
+		cmp = splay->cmpfunc(key, current->key);
 
-			current->right = rotate_right(current->right);
-			current = rotate_left(current);
+		if(cmp < 0) {
+			if(current->left == NULL) {
+				current->left = node = node_create(key, item, NULL, NULL, splay->head);
+				break;
+			}
+			current = current->left;
 		}
-		else if(cmp > 0) {	/* Right-Right Case: */
-
-			current->right->right = _splay_insert(current->right->right, head, cmpfunc, key, item, inserted);
-
-			current = rotate_left(current);
-			current = rotate_left(current);
+		else if(cmp > 0) {
+			if(current->right == NULL) {
+				current->right = node = node_create(key, item, NULL, NULL, splay->head);
+				break;
+			}
+			current = current->right;
 		}
-		else {				/* Key exists. */
+		else {	/* Key exists. */
 			current->item = item;
-			*inserted = 0;
+			splay_semi(splay, depth);
+			return 0;
 		}
 	}
-	else {	/* Key exists. */
-		current->item = item;
-		*inserted = 0;
-	}
+	splay->head = node;
 
-	return current;
+	path_push(splay, ++depth, node);
+	splay_semi(splay, depth);
+
+	return 1;
 }
 
 int splay_insert(splay_t *splay, void *key, void *item) {
 	int inserted;
 
-	inserted = 1;
-
-	splay->root = _splay_insert(splay->root, &splay->head, splay->cmpfunc, key, item, &inserted);
+	if(splay->mode == SPLAY_SEMI) {
+		inserted = splay_insert_semi(splay, key, item);
+	} else {
+		inserted = splay_insert_full(splay, key, item);
+	}
 
 	if(inserted) {
 		splay->children++;
@@ -244,80 +339,53 @@ int splay_insert(splay_t *splay, void *key, void *item) {
 }
 
 /* Splay Search: */
-static void _splay_search(node_t *current, void *key, cmpfunc_t cmpfunc, void **item) {
-	int cmp;
-
-	if(current == NULL) {
-		return;
+static void *splay_search_full(splay_t *splay, void *key) {
+	if(splay->root == NULL) {
+		return NULL;
 	}
-	cmp = cmpfunc(key, current->key);
-
-	if(cmp < 0) {
-
-		if(current->left == NULL) {
-			return;
-		}
-		cmp = cmpfunc(key, current->left->key);
-
-		if(cmp < 0) {		/* Left-Left Case. */
-			_splay_search(current->left->left, key, cmpfunc, item);
+	splay->root = splay_topdown(splay->root, key, splay->cmpfunc);
 
-			if(*item != NULL) {
-				current = rotate_right(current);
-				current = rotate_right(current);
-			}
-
-		} else if(cmp > 0) {/* Left-Right Case. */
-			_splay_search(current->left->right, key, cmpfunc, item);
-
-			if(*item != NULL) {
-				current->left = rotate_left(current->left);
-				current = rotate_right(current);
-			}
-
-		} else {			/* Left is target. */
-			*item = current->item;
-		}
-
-	} else if(cmp > 0) {
-
-		if(current->right == NULL) {
-			return;
-		}
-		cmp = cmpfunc(key, current->right->key);
-
-		if(cmp < 0) {		/* Right-Left Case. */
-			_splay_search(current->right->left, key, cmpfunc, item);
-
-			if(*item != NULL) {
-				current->right = rotate_right(current->right);
-				current = rotate_left(current);
-			}
-
-		} else if(cmp > 0) {/* Right-Right Case. */
-			_splay_search(current->right->right, key, cmpfunc, item);
-
-			if(*item != NULL) {
-				current = rotate_left(current);
-				current = rotate_left(current);
-			}
+	if(splay->cmpfunc(key, splay->root->key) == 0) {
+		return splay->root->item;
+	}
+	return NULL;
+}
 
-		} else {			/* Right is target. */
-			*item = current->item;
+static void *splay_search_semi(splay_t *splay, void *key) {
+	node_t	*current;
+	void	*item;
+	int		cmp, depth;
+
+	item	= NULL;
+	current	= splay->root;
+	depth	= -1;
+
+	while(current != NULL) {
+		path_push(splay, ++depth, current);
+		cmp = splay->cmpfunc(key, current->key);
+
+		if(cmp < 0) {
+			current = current->left;
+		} else if(cmp > 0) {
+			current = current->right;
+		} else {
+			item = current->item;
+			break;
 		}
-
-	} else {
-		*item = current->item;
 	}
+	/* Semi-splay found node, or last node on search-path if not found. */
+	if(depth >= 0) {
+		splay_semi(splay, depth);
+	}
+
+	return item;
 }
 
 void *splay_search(splay_t *splay, void *key) {
-	void *item;
-
-	item = NULL;
-	_splay_search(splay->root, key, splay->cmpfunc, &item);
-
-	return item;
+	if(splay->mode == SPLAY_SEMI) {
+		return splay_search_semi(splay, key);
+	}
+	return splay_search_full(splay, key);
 }
 
 /* Splay Print: */
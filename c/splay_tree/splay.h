@@ -8,10 +8,20 @@ typedef struct splay splay_t;
 /* Function-pointer for deallocation of keys and items. */
 typedef void (*freefunc_t)(void*);
 
+/* Splaying strategy used on search and insert. 
+ * SPLAY_FULL:	Top-down splay; accessed node becomes root. 
+ * SPLAY_SEMI:	Semi-splay; accessed node moved about half-way towards root, with fewer rotations per access. */
+typedef enum {
+	SPLAY_FULL, SPLAY_SEMI
+} splay_mode_t;
+
 
 /* Create new splay-tree. */
 splay_t *splay_create(cmpfunc_t cmpfunc);
 
+/* Set splaying strategy of splay-tree. Default after creation is SPLAY_FULL. */
+void splay_setmode(splay_t *splay, splay_mode_t mode);
+
 /* Destroy memory allocation for splay-tree. 
  * Destroy keys and/or items with provided function-pointers. 
  * Keys and/or items not destroyed if NULL is passed as function-pointer arguments. */
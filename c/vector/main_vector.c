@@ -0,0 +1,248 @@
+/* Author: Marius Ingebrigtsen */
+#include <string.h>
+
+#include "../common.h"
+#include "./vector.h"
+
+
+static int cmpint(int *a, int *b) {
+	return (*a > *b) - (*a < *b);
+}
+
+/* Even keys in [0, 2 * num), so odd keys are searched for and missed. */
+static int *data_create(int num) {
+	int *data;
+
+	data = malloc(sizeof(int) * (num + 1));
+	if(data == NULL) {
+		fatal_error("Out of memory.");
+	}
+	for(int i = 0; i < num; i++) {
+		data[i] = 2 * (rand() % (num + 1));
+	}
+	return data;
+}
+
+static vector_t *vector_fill(int *data, int num) {
+	vector_t *vector = vector_create( (cmpfunc_t)cmpint );
+
+	for(int i = 0; i < num; i++) {
+		vector_append(vector, &data[i]);
+	}
+	return vector;
+}
+
+/* Check get, set and pop at and past both bounds. */
+static void assert_access(int *data, int num) {
+	vector_t	*vector = vector_fill(data, num);
+	int			item = -1;
+
+	if( (vector_size(vector) != num) || (vector_capacity(vector) < num) ) {
+		fatal_error("Append; size \'%d\', capacity \'%d\', expected \'%d\'. \n", vector_size(vector), vector_capacity(vector), num);
+	}
+	for(int i = 0; i < num; i++) {
+		if(vector_get(vector, i) != &data[i]) {
+			fatal_error("Get; wrong item at \'%d\'. \n", i);
+		}
+	}
+	if( (vector_get(vector, -1) != NULL) || (vector_get(vector, num) != NULL) ||
+		(vector_set(vector, -1, &item) != NULL) || (vector_set(vector, num, &item) != NULL) ) {
+		fatal_error("Get or set out of bounds returned item. \n");
+	}
+	if( (num > 0) && ((vector_set(vector, num - 1, &item) != &data[num - 1]) || (vector_get(vector, num - 1) != &item)) ) {
+		fatal_error("Set; wrong item at \'%d\'. \n", num - 1);
+	}
+	if( (num > 0) && (vector_pop(vector) != &item) ) {
+		fatal_error("Pop; wrong item. \n");
+	}
+	for(int i = num - 2; i >= 0; i--) {
+		if(vector_pop(vector) != &data[i]) {
+			fatal_error("Pop; wrong item at \'%d\'. \n", i);
+		}
+	}
+	if( (vector_size(vector) != 0) || (vector_pop(vector) != NULL) ) {
+		fatal_error("Pop; empty vector returned item. \n");
+	}
+	printf("Access; %d items. \n", num);
+	vector_destroy(vector, NULL);
+}
+
+/* Sort vector and check keys come in order of 'qsort()'. */
+static void assert_sort(int *data, int num, char *title) {
+	vector_t	*vector = vector_fill(data, num);
+	int			*expect;
+
+	expect = malloc(sizeof(int) * (num + 1));
+	if(expect == NULL) {
+		fatal_error("Out of memory.");
+	}
+	memcpy(expect, data, sizeof(int) * num);
+	qsort(expect, num, sizeof(int), (int (*)(const void*, const void*))cmpint);
+
+	vector_sort(vector);
+
+	if(vector_size(vector) != num) {
+		fatal_error("%s; size \'%d\' after sort, expected \'%d\'. \n", title, vector_size(vector), num);
+	}
+	for(int i = 0; i < num; i++) {
+		if(*(int*)vector_get(vector, i) != expect[i]) {
+			fatal_error("%s; \'%d\' at \'%d\', expected \'%d\'. \n", title, *(int*)vector_get(vector, i), i, expect[i]);
+		}
+	}
+	printf("%s; %d items in order. \n", title, num);
+
+	vector_destroy(vector, NULL);
+	free(expect);
+}
+
+/* Sort random, sorted, reversed, equal and organ-pipe keys; patterns that degrade quicksort without introsort. */
+static void assert_sorts(int *data, int num) {
+	int *keys;
+
+	keys = malloc(sizeof(int) * (num + 1));
+	if(keys == NULL) {
+		fatal_error("Out of memory.");
+	}
+	assert_sort(data, num, "Sort random");
+
+	for(int i = 0; i < num; i++) {
+		keys[i] = i;
+	}
+	assert_sort(keys, num, "Sort sorted");
+
+	for(int i = 0; i < num; i++) {
+		keys[i] = num - i;
+	}
+	assert_sort(keys, num, "Sort reversed");
+
+	for(int i = 0; i < num; i++) {
+		keys[i] = 7;
+	}
+	assert_sort(keys, num, "Sort equal");
+
+	for(int i = 0; i < num; i++) {
+		keys[i] = (i < num / 2) ? i : num - i;
+	}
+	assert_sort(keys, num, "Sort organ-pipe");
+
+	free(keys);
+}
+
+/* Search sorted vector for every key in it, and for odd keys not in it. */
+static void assert_search(int *data, int num) {
+	vector_t	*vector = vector_fill(data, num);
+	int			key, i, hits = 0;
+
+	vector_sort(vector);
+
+	for(int k = 0; k < num; k++) {
+		i = vector_search(vector, &data[k]);
+		if( (i < 0) || (*(int*)vector_get(vector, i) != data[k]) ) {
+			fatal_error("Search; key \'%d\' missed, returned \'%d\'. \n", data[k], i);
+		}
+		hits++;
+	}
+	for(key = -1; key <= 2 * num + 1; key += 2) {
+		if( (i = vector_search(vector, &key)) != -1 ) {
+			fatal_error("Search; key \'%d\' not in vector, returned \'%d\'. \n", key, i);
+		}
+	}
+	printf("Search; %d hits, %d misses. \n", hits, num + 2);
+	vector_destroy(vector, NULL);
+
+	vector = vector_create( (cmpfunc_t)cmpint );
+	if(vector_search(vector, &key) != -1) {
+		fatal_error("Search; empty vector returned index. \n");
+	}
+	vector_destroy(vector, NULL);
+}
+
+/* Reserved capacity is not reallocated while appending up to it, and shrink fits capacity to size. */
+static void assert_capacity(int *data, int num) {
+	vector_t	*vector = vector_create( (cmpfunc_t)cmpint );
+	void		**array;
+
+	vector_reserve(vector, num);
+	array = vector_array(vector);
+	if(vector_capacity(vector) < num) {
+		fatal_error("Reserve; capacity \'%d\', expected at least \'%d\'. \n", vector_capacity(vector), num);
+	}
+	for(int i = 0; i < num; i++) {
+		vector_append(vector, &data[i]);
+	}
+	if( (num > 0) && (vector_array(vector) != array) ) {
+		fatal_error("Reserve; array reallocated by appending reserved items. \n");
+	}
+
+	vector_reserve(vector, num / 2);
+	if(vector_capacity(vector) < num) {
+		fatal_error("Reserve; capacity reduced to \'%d\'. \n", vector_capacity(vector));
+	}
+
+	for(int i = 0; i < num / 2; i++) {
+		vector_pop(vector);
+	}
+	vector_shrink(vector);
+	if(vector_capacity(vector) != num - num / 2) {
+		fatal_error("Shrink; capacity \'%d\', expected \'%d\'. \n", vector_capacity(vector), num - num / 2);
+	}
+	for(int i = 0; i < num - num / 2; i++) {
+		if(vector_get(vector, i) != &data[i]) {
+			fatal_error("Shrink; wrong item at \'%d\'. \n", i);
+		}
+	}
+	vector_append(vector, &data[0]);
+	if(vector_size(vector) != num - num / 2 + 1) {
+		fatal_error("Shrink; append after shrink lost item. \n");
+	}
+	printf("Capacity; %d reserved, shrunk to %d. \n", num, num - num / 2);
+	vector_destroy(vector, NULL);
+}
+
+/* Released array holds items in order, outlives vector, and is caller's to free, also when empty. */
+static void assert_release(int *data, int num) {
+	vector_t	*vector = vector_fill(data, num);
+	int			**array;
+
+	array = (int**)vector_release(vector);
+	if(array == NULL) {
+		fatal_error("Release; returned NULL. \n");
+	}
+	for(int i = 0; i < num; i++) {
+		if(array[i] != &data[i]) {
+			fatal_error("Release; wrong item at \'%d\'. \n", i);
+		}
+	}
+	free(array);
+
+	vector = vector_create(NULL);
+	array = (int**)vector_release(vector);
+	if(array == NULL) {
+		fatal_error("Release; empty vector returned NULL. \n");
+	}
+	free(array);
+
+	printf("Release; %d items. \n", num);
+}
+
+int main(int argc, char **argv) {
+	int *data, num;
+
+	if(argc < 2) {
+		printf("Usage: %s <value> \n", *argv);
+		return -1;
+	}
+	num = atoi(argv[1]);
+
+	data = data_create(num);
+
+	assert_access(data, num);
+	assert_sorts(data, num);
+	assert_search(data, num);
+	assert_capacity(data, num);
+	assert_release(data, num);
+
+	free(data);
+
+	return 0;
+}
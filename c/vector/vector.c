@@ -0,0 +1,250 @@
+/* Author: Marius Ingebrigtsen */
+#include "vector.h"
+
+/* Capacity of first allocation. */
+#define INITSIZE	16
+/* Partitions of at most this many items are insertion sorted. */
+#define INSERTION	16
+
+struct vector {
+	void		**items;
+	int			num_items, capacity;
+	cmpfunc_t	cmpfunc;
+};
+
+
+/* Vector Create: */
+vector_t *vector_create(cmpfunc_t cmpfunc) {
+	vector_t *vector = malloc(sizeof(vector_t));
+	if(vector == NULL) {
+		fatal_error("Out of memory.");
+	}
+	vector->items		= NULL;
+	vector->num_items	= vector->capacity = 0;
+	vector->cmpfunc		= cmpfunc;
+	return vector;
+}
+
+/* Vector Destroy: */
+void vector_destroy(vector_t *vector, freefunc_t freefunc) {
+	if(freefunc != NULL) {
+		for(int i = 0; i < vector->num_items; i++) {
+			freefunc(vector->items[i]);
+		}
+	}
+	free(vector->items);
+	free(vector);
+}
+
+/* Vector Size & Capacity: */
+int vector_size(vector_t *vector) {
+	return vector->num_items;
+}
+
+int vector_capacity(vector_t *vector) {
+	return vector->capacity;
+}
+
+/* Vector Reserve & Shrink: */
+static void resize(vector_t *vector, int capacity) {
+	void **items;
+
+	items = realloc(vector->items, sizeof(void*) * (capacity > 0 ? capacity : 1));
+	if(items == NULL) {
+		fatal_error("Out of memory.");
+	}
+	vector->items		= items;
+	vector->capacity	= capacity;
+}
+
+void vector_reserve(vector_t *vector, int capacity) {
+	if(capacity > vector->capacity) {
+		resize(vector, capacity);
+	}
+}
+
+void vector_shrink(vector_t *vector) {
+	if(vector->num_items < vector->capacity) {
+		resize(vector, vector->num_items);
+	}
+}
+
+/* Vector Append & Pop: */
+void vector_append(vector_t *vector, void *item) {
+	if(vector->num_items == vector->capacity) {
+		resize(vector, (vector->capacity < INITSIZE) ? INITSIZE : vector->capacity * 2);
+	}
+	vector->items[vector->num_items++] = item;
+}
+
+void *vector_pop(vector_t *vector) {
+	if(vector->num_items == 0) {
+		return NULL;
+	}
+	return vector->items[--vector->num_items];
+}
+
+/* Vector Get & Set: */
+void *vector_get(vector_t *vector, int i) {
+	if( (i < 0) || (i >= vector->num_items) ) {
+		return NULL;
+	}
+	return vector->items[i];
+}
+
+void *vector_set(vector_t *vector, int i, void *item) {
+	void *old;
+
+	if( (i < 0) || (i >= vector->num_items) ) {
+		return NULL;
+	}
+	old = vector->items[i];
+	vector->items[i] = item;
+	return old;
+}
+
+/* Vector Sort: */
+static inline void swap(void **a, void **b) {
+	void *tmp = *a;
+	*a = *b;
+	*b = tmp;
+}
+
+static void insertion_sort(void **items, int n, cmpfunc_t cmpfunc) {
+	for(int i = 1; i < n; i++) {
+		void	*item = items[i];
+		int		j;
+
+		for(j = i; (j > 0) && (cmpfunc(item, items[j - 1]) < 0); j--) {
+			items[j] = items[j - 1];
+		}
+		items[j] = item;
+	}
+}
+
+static void sift_down(void **items, int root, int n, cmpfunc_t cmpfunc) {
+	int child;
+
+	while( (child = 2 * root + 1) < n ) {
+		if( (child + 1 < n) && (cmpfunc(items[child], items[child + 1]) < 0) ) {
+			child++;
+		}
+		if(cmpfunc(items[root], items[child]) >= 0) {
+			return;
+		}
+		swap(&items[root], &items[child]);
+		root = child;
+	}
+}
+
+static void heap_sort(void **items, int n, cmpfunc_t cmpfunc) {
+	for(int i = n / 2 - 1; i >= 0; i--) {
+		sift_down(items, i, n, cmpfunc);
+	}
+	for(int i = n - 1; i > 0; i--) {
+		swap(&items[0], &items[i]);
+		sift_down(items, 0, i, cmpfunc);
+	}
+}
+
+/* Order first, middle and last item, and leave median at 'items[n - 2]' as pivot.
+ * First and last item then bound both scans of partition. */
+static void *median_of_three(void **items, int n, cmpfunc_t cmpfunc) {
+	void **lo = &items[0], **mid = &items[n / 2], **hi = &items[n - 1];
+
+	if(cmpfunc(*mid, *lo) < 0) {
+		swap(mid, lo);
+	}
+	if(cmpfunc(*hi, *mid) < 0) {
+		swap(hi, mid);
+		if(cmpfunc(*mid, *lo) < 0) {
+			swap(mid, lo);
+		}
+	}
+	swap(mid, &items[n - 2]);
+	return items[n - 2];
+}
+
+/* Quicksort larger partitions, recursing on smaller part and looping on larger, so stack depth is O(log n).
+ * When 'depth' runs out partitions are unbalanced, and rest is heapsorted. */
+static void intro_sort(void **items, int n, int depth, cmpfunc_t cmpfunc) {
+	void	*pivot;
+	int		i, j;
+
+	while(n > INSERTION) {
+		if(depth-- == 0) {
+			heap_sort(items, n, cmpfunc);
+			return;
+		}
+		pivot = median_of_three(items, n, cmpfunc);
+
+		i = 0;
+		j = n - 2;
+		for(;;) {
+			while(cmpfunc(items[++i], pivot) < 0);
+			while(cmpfunc(pivot, items[--j]) < 0);
+			if(i >= j) {
+				break;
+			}
+			swap(&items[i], &items[j]);
+		}
+		swap(&items[i], &items[n - 2]);
+
+		/* Items before 'i' are less or equal to pivot, after 'i' greater or equal. */
+		if(i < n - i - 1) {
+			intro_sort(items, i, depth, cmpfunc);
+			items	+= i + 1;
+			n		-= i + 1;
+		} else {
+			intro_sort(&items[i + 1], n - i - 1, depth, cmpfunc);
+			n = i;
+		}
+	}
+	insertion_sort(items, n, cmpfunc);
+}
+
+void vector_sort(vector_t *vector) {
+	int depth = 0;
+
+	for(int n = vector->num_items; n > 1; n /= 2) {
+		depth += 2;
+	}
+	intro_sort(vector->items, vector->num_items, depth, vector->cmpfunc);
+}
+
+/* Vector Search: */
+int vector_search(vector_t *vector, void *item) {
+	int lo = 0, hi = vector->num_items, mid, cmp;
+
+	while(lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		cmp = vector->cmpfunc(vector->items[mid], item);
+
+		if(cmp == 0) {
+			return mid;
+		} else if(cmp < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return -1;
+}
+
+/* Vector Array & Release: */
+void **vector_array(vector_t *vector) {
+	return vector->items;
+}
+
+void **vector_release(vector_t *vector) {
+	void **items;
+
+	vector_shrink(vector);
+	if(vector->items == NULL) {
+		resize(vector, 0);
+	}
+	items = vector->items;
+	free(vector);
+
+	return items;
+}
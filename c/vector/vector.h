@@ -0,0 +1,63 @@
+/* Author: Marius Ingebrigtsen */
+#ifndef __VECTOR_H_
+#define __VECTOR_H_
+
+#include "../common.h"
+
+/* Vector Structure.
+ * Contiguous, dynamically sized array of items, growing geometrically when full,
+ * so appending costs amortised O(1) and iteration reads consecutive memory. */
+typedef struct vector vector_t;
+
+
+/* NOTE:
+ * All functions allocating memory handles errors interally by terminating program with call to 'fatal_error'-function defined in common.h. */
+
+/* Return new, empty vector using 'cmpfunc' to compare items in 'vector_sort()' and 'vector_search()'.
+ * Pass NULL if vector is never sorted or searched. */
+vector_t *vector_create(cmpfunc_t cmpfunc);
+
+/* Destroy vector. Optional function-pointer for deallocating items in vector.
+ * Pass NULL as argument if items are not to be deallocated. */
+void vector_destroy(vector_t *vector, freefunc_t freefunc);
+
+/* Return number of items in vector. */
+int vector_size(vector_t *vector);
+
+/* Return number of items vector holds before reallocation. */
+int vector_capacity(vector_t *vector);
+
+/* Make room for at least 'capacity' items, e.g. when number of items to append is known in advance. */
+void vector_reserve(vector_t *vector, int capacity);
+
+/* Reduce capacity to number of items in vector. */
+void vector_shrink(vector_t *vector);
+
+/* Add item to end of vector. */
+void vector_append(vector_t *vector, void *item);
+
+/* Remove and return last item of vector. NULL returned if vector is empty. */
+void *vector_pop(vector_t *vector);
+
+/* Return item at index 'i'. NULL returned if 'i' is out of bounds. */
+void *vector_get(vector_t *vector, int i);
+
+/* Replace item at index 'i' and return replaced item. NULL returned if 'i' is out of bounds. */
+void *vector_set(vector_t *vector, int i, void *item);
+
+/* Sort items in vector in place using 'cmpfunc' from 'vector_create()'.
+ * Introsort; quicksort falling back to heapsort on bad partitions, O(n log n) worst case. Not stable. */
+void vector_sort(vector_t *vector);
+
+/* Binary search sorted vector for item and return index of an item equal to it.
+ * Return -1 if item not in vector. */
+int vector_search(vector_t *vector, void *item);
+
+/* Return underlying array of items, valid until next append, reserve or shrink. */
+void **vector_array(vector_t *vector);
+
+/* Destroy vector, but not its array of items, and return array.
+ * Array is shrunk to fit number of items, and is to be deallocated with 'free()'. */
+void **vector_release(vector_t *vector);
+
+#endif